@@ -0,0 +1,550 @@
+/*
+ * Amazon FreeRTOS MQTT Echo Demo V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_crypto_benchmark.c
+ * @brief Self-tests and cycle counts for the crypto used by TLS.
+ *
+ * The task runs the mbedTLS self-tests for AES, GCM and SHA-256, which go
+ * through the replacement modules in lib/crypto, and then times AES-128
+ * blocks, AES-128-GCM records and SHA-256 over a buffer the size of a TLS
+ * record fragment.
+ *
+ * It then checks the P-256 comb table in flash, see aws_ecp_p256_table.c,
+ * against the table mbedTLS computes at run time, and times a
+ * multiplication of the generator with each.  That multiplication is the
+ * bulk of both the ECDHE key generation and the ECDSA signature of a
+ * handshake.  Each figure is the fastest of several runs, so that
+ * interrupts and task switches do not show in it.
+ *
+ * Cycles are read from the DWT cycle counter on Cortex-M3/M4/M7 and from the
+ * time stamp counter on x86.  Elsewhere they are estimated from the tick
+ * count, which is far too coarse for anything but long runs.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* mbedTLS includes. */
+#include "mbedtls/aes.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ecp.h"
+
+/* Crypto includes. */
+#include "aws_crypto_accelerator.h"
+
+/* Demo includes. */
+#include "aws_demo_config.h"
+#include "aws_crypto_benchmark.h"
+
+#if defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ )
+    #define benchmarkDEMCR                 ( *( volatile uint32_t * ) 0xE000EDFCUL )
+    #define benchmarkDWT_CTRL              ( *( volatile uint32_t * ) 0xE0001000UL )
+    #define benchmarkDWT_CYCCNT            ( *( volatile uint32_t * ) 0xE0001004UL )
+    #define benchmarkDEMCR_TRCENA          ( 1UL << 24 )
+    #define benchmarkDWT_CTRL_CYCCNTENA    ( 1UL << 0 )
+#elif defined( __x86_64__ ) || defined( __i386__ )
+    #include <x86intrin.h>
+#endif
+
+/**
+ * @brief Length of the data processed by each run, that of a full TLS record
+ * when a maximum fragment length of 1024 has been negotiated.
+ */
+#define benchmarkDATA_LENGTH        ( 1024 )
+
+/**
+ * @brief Number of runs of each measurement, of which the fastest is kept.
+ */
+#define benchmarkRUNS               ( 16 )
+
+/**
+ * @brief Length of the additional data of a TLS 1.2 record.
+ */
+#define benchmarkAAD_LENGTH         ( 13 )
+
+/**
+ * @brief Length of the GCM nonce and tag used by TLS.
+ */
+#define benchmarkNONCE_LENGTH       ( 12 )
+#define benchmarkTAG_LENGTH         ( 16 )
+
+/**
+ * @brief Number of random scalars multiplied through both P-256 comb tables
+ * before they are timed.
+ */
+#define benchmarkECP_CHECKS         ( 8 )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A piece of work to time.
+ *
+ * @return 0 on success, or an mbedTLS error code.
+ */
+typedef int ( * BenchmarkFunction_t )( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Starts the cycle counter, if it needs starting.
+ */
+static void prvStartCycleCounter( void );
+
+/**
+ * @brief Reads the cycle counter.
+ */
+static uint32_t prvGetCycles( void );
+
+/**
+ * @brief Runs a function benchmarkRUNS times.
+ *
+ * @param[in] xFunction The function to time.
+ * @param[out] pulFastest The cycle count of the fastest run.
+ *
+ * @return 0 if every run succeeded, or the error of the first that failed.
+ */
+static int prvTimeFastestRun( BenchmarkFunction_t xFunction,
+                              uint32_t * pulFastest );
+
+/**
+ * @brief Runs a function benchmarkRUNS times and prints the fastest run in
+ * cycles per byte.
+ */
+static void prvMeasure( const char * pcName,
+                        BenchmarkFunction_t xFunction );
+
+/**
+ * @brief Runs a function benchmarkRUNS times and prints the fastest run in
+ * cycles.
+ */
+static void prvMeasureOperation( const char * pcName,
+                                 BenchmarkFunction_t xFunction );
+
+/**
+ * @brief Random number generator handed to mbedTLS by the ECP benchmark.
+ *
+ * It only picks benchmark scalars and randomizes coordinates, so it is a
+ * linear congruential generator rather than a DRBG.
+ */
+static int prvRandom( void * pvContext,
+                      unsigned char * pucOutput,
+                      size_t xLength );
+
+/**
+ * @brief Loads P-256 into xRuntimeGroup so that ecp_mul_comb() computes its
+ * own comb table for the generator, as stock mbedTLS does.
+ *
+ * Clearing the group id hides the table in flash from
+ * mbedtls_ecp_fixed_base_table().  The arithmetic does not depend on the id.
+ */
+static int prvLoadRuntimeGroup( void );
+
+/**
+ * @brief Multiplies random scalars by the generator with both comb tables
+ * and compares the results.
+ *
+ * @return 0 if they all match, or an mbedTLS error code.
+ */
+static int prvCheckEcpTables( void );
+
+/*
+ * The pieces of work timed.
+ */
+static int prvAesEncrypt( void );
+static int prvGcmEncrypt( void );
+static int prvGcmDecrypt( void );
+static int prvSha256( void );
+static int prvEcpFlashTable( void );
+static int prvEcpRuntimeTableNewGroup( void );
+static int prvEcpRuntimeTableSameGroup( void );
+
+/**
+ * @brief Implements the task that runs the self-tests and the benchmarks.
+ */
+static void prvCryptoBenchmarkTask( void * pvParameters );
+/*-----------------------------------------------------------*/
+
+/*
+ * The data and contexts are static to keep them off the task stack.
+ */
+static uint8_t ucKey[ 16 ] = { 0 };
+static uint8_t ucNonce[ benchmarkNONCE_LENGTH ] = { 0 };
+static uint8_t ucAdditionalData[ benchmarkAAD_LENGTH ] = { 0 };
+static uint8_t ucTag[ benchmarkTAG_LENGTH ];
+static uint8_t ucPlaintext[ benchmarkDATA_LENGTH ] = { 0 };
+static uint8_t ucCiphertext[ benchmarkDATA_LENGTH ];
+static uint8_t ucDecrypted[ benchmarkDATA_LENGTH ];
+static uint8_t ucDigest[ 32 ];
+static mbedtls_aes_context xAesContext;
+static mbedtls_gcm_context xGcmContext;
+static mbedtls_ecp_group xGroup;
+static mbedtls_ecp_group xRuntimeGroup;
+static mbedtls_ecp_point xPoint;
+static mbedtls_ecp_point xRuntimePoint;
+static mbedtls_mpi xScalar;
+static uint32_t ulRandomState = 1UL;
+/*-----------------------------------------------------------*/
+
+static void prvStartCycleCounter( void )
+{
+    #if defined( benchmarkDWT_CYCCNT )
+        benchmarkDEMCR |= benchmarkDEMCR_TRCENA;
+        benchmarkDWT_CYCCNT = 0;
+        benchmarkDWT_CTRL |= benchmarkDWT_CTRL_CYCCNTENA;
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetCycles( void )
+{
+    #if defined( benchmarkDWT_CYCCNT )
+        return benchmarkDWT_CYCCNT;
+    #elif defined( __x86_64__ ) || defined( __i386__ )
+        return ( uint32_t ) __rdtsc();
+    #else
+        return ( uint32_t ) xTaskGetTickCount() * ( configCPU_CLOCK_HZ / configTICK_RATE_HZ );
+    #endif
+}
+/*-----------------------------------------------------------*/
+
+static int prvTimeFastestRun( BenchmarkFunction_t xFunction,
+                              uint32_t * pulFastest )
+{
+    uint32_t ulStart, ulCycles;
+    int iResult = 0;
+    BaseType_t xRun;
+
+    *pulFastest = UINT32_MAX;
+
+    for( xRun = 0; ( xRun < benchmarkRUNS ) && ( iResult == 0 ); xRun++ )
+    {
+        ulStart = prvGetCycles();
+        iResult = xFunction();
+        ulCycles = prvGetCycles() - ulStart;
+
+        if( ulCycles < *pulFastest )
+        {
+            *pulFastest = ulCycles;
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasure( const char * pcName,
+                        BenchmarkFunction_t xFunction )
+{
+    uint32_t ulFastest;
+    int iResult;
+
+    iResult = prvTimeFastestRun( xFunction, &ulFastest );
+
+    if( iResult == 0 )
+    {
+        configPRINTF( ( "%s: %u.%02u cycles per byte\r\n",
+                        pcName,
+                        ( unsigned ) ( ulFastest / benchmarkDATA_LENGTH ),
+                        ( unsigned ) ( ( ( ulFastest * 100UL ) / benchmarkDATA_LENGTH ) % 100UL ) ) );
+    }
+    else
+    {
+        configPRINTF( ( "%s: failed with %d\r\n", pcName, iResult ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasureOperation( const char * pcName,
+                                 BenchmarkFunction_t xFunction )
+{
+    uint32_t ulFastest;
+    int iResult;
+
+    iResult = prvTimeFastestRun( xFunction, &ulFastest );
+
+    if( iResult == 0 )
+    {
+        configPRINTF( ( "%s: %u cycles\r\n", pcName, ( unsigned ) ulFastest ) );
+    }
+    else
+    {
+        configPRINTF( ( "%s: failed with %d\r\n", pcName, iResult ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int prvRandom( void * pvContext,
+                      unsigned char * pucOutput,
+                      size_t xLength )
+{
+    /* Remove compiler warnings about unused parameters. */
+    ( void ) pvContext;
+
+    while( xLength-- > 0 )
+    {
+        ulRandomState = ( ulRandomState * 1103515245UL ) + 12345UL;
+        *pucOutput++ = ( unsigned char ) ( ulRandomState >> 16 );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int prvLoadRuntimeGroup( void )
+{
+    int iResult;
+
+    iResult = mbedtls_ecp_group_load( &xRuntimeGroup, MBEDTLS_ECP_DP_SECP256R1 );
+    xRuntimeGroup.id = MBEDTLS_ECP_DP_NONE;
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvCheckEcpTables( void )
+{
+    int iResult = 0;
+    BaseType_t xCheck;
+
+    for( xCheck = 0; ( xCheck < benchmarkECP_CHECKS ) && ( iResult == 0 ); xCheck++ )
+    {
+        iResult = mbedtls_mpi_fill_random( &xScalar, 32, prvRandom, NULL );
+
+        if( iResult == 0 )
+        {
+            iResult = mbedtls_mpi_mod_mpi( &xScalar, &xScalar, &xGroup.N );
+        }
+
+        if( iResult == 0 )
+        {
+            iResult = mbedtls_ecp_mul( &xGroup, &xPoint, &xScalar, &xGroup.G, prvRandom, NULL );
+        }
+
+        if( iResult == 0 )
+        {
+            iResult = mbedtls_ecp_mul( &xRuntimeGroup, &xRuntimePoint, &xScalar, &xRuntimeGroup.G, prvRandom, NULL );
+        }
+
+        if( iResult == 0 )
+        {
+            iResult = mbedtls_ecp_point_cmp( &xPoint, &xRuntimePoint );
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvAesEncrypt( void )
+{
+    int iResult = 0;
+    size_t xOffset;
+
+    for( xOffset = 0; ( xOffset < benchmarkDATA_LENGTH ) && ( iResult == 0 ); xOffset += 16 )
+    {
+        iResult = mbedtls_aes_crypt_ecb( &xAesContext,
+                                         MBEDTLS_AES_ENCRYPT,
+                                         ucPlaintext + xOffset,
+                                         ucCiphertext + xOffset );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvGcmEncrypt( void )
+{
+    return mbedtls_gcm_crypt_and_tag( &xGcmContext,
+                                      MBEDTLS_GCM_ENCRYPT,
+                                      benchmarkDATA_LENGTH,
+                                      ucNonce,
+                                      sizeof( ucNonce ),
+                                      ucAdditionalData,
+                                      sizeof( ucAdditionalData ),
+                                      ucPlaintext,
+                                      ucCiphertext,
+                                      sizeof( ucTag ),
+                                      ucTag );
+}
+/*-----------------------------------------------------------*/
+
+static int prvGcmDecrypt( void )
+{
+    /* Relies on prvGcmEncrypt() having run last. */
+    return mbedtls_gcm_auth_decrypt( &xGcmContext,
+                                     benchmarkDATA_LENGTH,
+                                     ucNonce,
+                                     sizeof( ucNonce ),
+                                     ucAdditionalData,
+                                     sizeof( ucAdditionalData ),
+                                     ucTag,
+                                     sizeof( ucTag ),
+                                     ucCiphertext,
+                                     ucDecrypted );
+}
+/*-----------------------------------------------------------*/
+
+static int prvSha256( void )
+{
+    return mbedtls_sha256_ret( ucPlaintext, benchmarkDATA_LENGTH, ucDigest, 0 );
+}
+/*-----------------------------------------------------------*/
+
+static int prvEcpFlashTable( void )
+{
+    return mbedtls_ecp_mul( &xGroup, &xPoint, &xScalar, &xGroup.G, prvRandom, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static int prvEcpRuntimeTableNewGroup( void )
+{
+    int iResult;
+
+    /* Each handshake generates its ECDHE key on a newly loaded group, so
+     * the table is computed every time. */
+    mbedtls_ecp_group_free( &xRuntimeGroup );
+    iResult = prvLoadRuntimeGroup();
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_ecp_mul( &xRuntimeGroup, &xRuntimePoint, &xScalar, &xRuntimeGroup.G, prvRandom, NULL );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static int prvEcpRuntimeTableSameGroup( void )
+{
+    /* A signing key that stays loaded keeps the table of its group, so only
+     * the first signature computes it. */
+    return mbedtls_ecp_mul( &xRuntimeGroup, &xRuntimePoint, &xScalar, &xRuntimeGroup.G, prvRandom, NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCryptoBenchmarkTask( void * pvParameters )
+{
+    int iResult;
+
+    /* Remove compiler warnings about unused parameters. */
+    ( void ) pvParameters;
+
+    iResult = mbedtls_aes_self_test( 0 );
+    configPRINTF( ( "AES self-test %s.\r\n", ( iResult == 0 ) ? "passed" : "FAILED" ) );
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_gcm_self_test( 0 );
+        configPRINTF( ( "GCM self-test %s.\r\n", ( iResult == 0 ) ? "passed" : "FAILED" ) );
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_sha256_self_test( 0 );
+        configPRINTF( ( "SHA-256 self-test %s.\r\n", ( iResult == 0 ) ? "passed" : "FAILED" ) );
+    }
+
+    if( iResult == 0 )
+    {
+        configPRINTF( ( "Timing the %s.\r\n",
+                        ( CRYPTO_GetAccelerator() == NULL ) ? "software kernels" : "crypto accelerator" ) );
+
+        prvStartCycleCounter();
+
+        mbedtls_aes_init( &xAesContext );
+        mbedtls_gcm_init( &xGcmContext );
+
+        iResult = mbedtls_aes_setkey_enc( &xAesContext, ucKey, 128 );
+
+        if( iResult == 0 )
+        {
+            iResult = mbedtls_gcm_setkey( &xGcmContext, MBEDTLS_CIPHER_ID_AES, ucKey, 128 );
+        }
+
+        if( iResult == 0 )
+        {
+            prvMeasure( "AES-128 encrypt", prvAesEncrypt );
+            prvMeasure( "AES-128-GCM encrypt", prvGcmEncrypt );
+            prvMeasure( "AES-128-GCM decrypt", prvGcmDecrypt );
+            prvMeasure( "SHA-256", prvSha256 );
+        }
+        else
+        {
+            configPRINTF( ( "Setting the benchmark key failed with %d.\r\n", iResult ) );
+        }
+
+        mbedtls_gcm_free( &xGcmContext );
+        mbedtls_aes_free( &xAesContext );
+
+        mbedtls_ecp_group_init( &xGroup );
+        mbedtls_ecp_group_init( &xRuntimeGroup );
+        mbedtls_ecp_point_init( &xPoint );
+        mbedtls_ecp_point_init( &xRuntimePoint );
+        mbedtls_mpi_init( &xScalar );
+
+        iResult = mbedtls_ecp_group_load( &xGroup, MBEDTLS_ECP_DP_SECP256R1 );
+
+        if( iResult == 0 )
+        {
+            iResult = prvLoadRuntimeGroup();
+        }
+
+        if( iResult == 0 )
+        {
+            iResult = prvCheckEcpTables();
+            configPRINTF( ( "P-256 comb table check %s.\r\n", ( iResult == 0 ) ? "passed" : "FAILED" ) );
+        }
+
+        if( iResult == 0 )
+        {
+            prvMeasureOperation( "P-256 k*G, table in flash", prvEcpFlashTable );
+            prvMeasureOperation( "P-256 k*G, table computed on a new group", prvEcpRuntimeTableNewGroup );
+            prvMeasureOperation( "P-256 k*G, table kept by the group", prvEcpRuntimeTableSameGroup );
+        }
+
+        mbedtls_mpi_free( &xScalar );
+        mbedtls_ecp_point_free( &xRuntimePoint );
+        mbedtls_ecp_point_free( &xPoint );
+        mbedtls_ecp_group_free( &xRuntimeGroup );
+        mbedtls_ecp_group_free( &xGroup );
+    }
+
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vStartCryptoBenchmarkDemo( void )
+{
+    configPRINTF( ( "Creating Crypto Benchmark Task...\r\n" ) );
+
+    ( void ) xTaskCreate( prvCryptoBenchmarkTask,                     /* The function that implements the demo task. */
+                          "CryptoBench",                              /* The name to assign to the task being created. */
+                          democonfigCRYPTO_BENCHMARK_TASK_STACK_SIZE, /* The size, in WORDS (not bytes), of the stack to allocate for the task being created. */
+                          NULL,                                       /* The task parameter is not being used. */
+                          democonfigCRYPTO_BENCHMARK_TASK_PRIORITY,   /* The priority at which the task being created will run. */
+                          NULL );                                     /* Not storing the task's handle. */
+}
+/*-----------------------------------------------------------*/
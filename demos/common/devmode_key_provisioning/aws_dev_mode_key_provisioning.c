@@ -53,6 +53,9 @@
 /* Key provisioning includes. */
 #include "aws_dev_mode_key_provisioning.h"
 
+/* TLS includes. */
+#include "aws_tls.h"
+
 /* mbedTLS includes. */
 #include "mbedtls/base64.h"
 /*-----------------------------------------------------------*/
@@ -415,6 +418,12 @@ void vAlternateKeyProvisioning( ProvisioningParams_t * xParams )
         xResult = xProvisionDevice( xSession, xParams );
     }
 
+    /* Connections made from now on must use the new credentials. */
+    if( xResult == CKR_OK )
+    {
+        TLS_ClearClientCredential();
+    }
+
     pxFunctionList->C_CloseSession( xSession );
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,40 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef _AWS_CRYPTO_BENCHMARK_H_
+#define _AWS_CRYPTO_BENCHMARK_H_
+
+#include "aws_demo.h"
+
+/**
+ * @brief Starts a task that runs the mbedTLS self-tests for AES, GCM and
+ * SHA-256 and then prints the cost of each in CPU cycles per byte.
+ *
+ * The numbers are for whatever crypto accelerator is registered with
+ * CRYPTO_SetAccelerator() when the task runs, or for the software kernels.
+ */
+demoDECLARE_DEMO( vStartCryptoBenchmarkDemo );
+
+#endif /* _AWS_CRYPTO_BENCHMARK_H_ */
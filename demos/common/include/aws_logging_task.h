@@ -31,8 +31,10 @@
 #endif
 
 /*
- * Called once to create the logging task and queue.  Must be called before any
- * calls to vLoggingPrintf().
+ * Called once to create the logging task and the buffer it reads messages
+ * from.  Must be called before any calls to vLoggingPrintf().  The buffer is
+ * uxQueueLength times configLOGGING_MAX_MESSAGE_LENGTH bytes, rounded down to
+ * a power of two.
  */
 BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
                                    UBaseType_t uxPriority,
@@ -44,8 +46,20 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
  * output directly, others will use a logging task to allow log message to be
  * output in the background should the output device be too slow for output to
  * be performed inline.
+ *
+ * The logging task implementation formats the message later, in the logging
+ * task, so pcFormat must stay valid after the call returns, as a string
+ * literal does.  String arguments are copied.
  */
 void vLoggingPrintf( const char * pcFormat,
                      ... );
 
+/*
+ * As vLoggingPrintf(), but can be called from an interrupt that is allowed to
+ * call interrupt safe FreeRTOS API functions.  The message is output from the
+ * logging task, with "ISR" as its task name.
+ */
+void vLoggingPrintfFromISR( const char * pcFormat,
+                            ... );
+
 #endif /* AWS_LOGGING_TASK_H */
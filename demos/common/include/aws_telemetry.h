@@ -0,0 +1,70 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef _AWS_TELEMETRY_H_
+#define _AWS_TELEMETRY_H_
+
+/* MQTT includes. */
+#include "aws_mqtt_agent.h"
+
+/**
+ * @brief Starts a task that publishes a snapshot of the CPU and memory use
+ * of the device every democonfigTELEMETRY_PERIOD.
+ *
+ * Snapshots are published with QoS 0 to "freertos/telemetry/" followed by
+ * clientcredentialIOT_THING_NAME, through an MQTT client the caller has
+ * already connected.  Each is a CBOR map with these keys:
+ *
+ * - "up": the tick count.
+ * - "rt": the run time counter, which counts at the rate of the run time
+ *   statistics clock and wraps at 32 bits.
+ * - "heap": [ free bytes, least free bytes ever ].
+ * - "pool": one [ buffer size, buffers, in use, most ever in use ] per size
+ *   class of the buffer pool.
+ * - "tasks": one [ name, number, priority, state, run time, least free stack
+ *   bytes ever ] per task.  The state is an eTaskState value.
+ *
+ * The run time of each task counts in the same unit as "rt", so the CPU use
+ * of a task between two snapshots is the difference of its run time divided
+ * by the difference of "rt", both taken modulo 2^32.
+ *
+ * @param[in] xMQTTHandle The connected MQTT client to publish with.  It must
+ * stay connected until vTelemetryStop() returns.
+ *
+ * @return pdPASS if the task was created, pdFAIL if it is already running
+ * or could not be created.
+ */
+BaseType_t xTelemetryStart( MQTTAgentHandle_t xMQTTHandle );
+
+/**
+ * @brief Stops the task started by xTelemetryStart().
+ *
+ * It returns once the task has finished any publish in progress and been
+ * deleted, so the MQTT client can be disconnected straight after.  It does
+ * nothing if the task is not running.
+ */
+void vTelemetryStop( void );
+
+#endif /* _AWS_TELEMETRY_H_ */
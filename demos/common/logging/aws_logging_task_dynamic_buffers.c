@@ -25,12 +25,30 @@
 
 
 /*
+ * Log messages are written to a ring buffer that is allocated once, when the
+ * logging task is created, and read back by the logging task.  A message is
+ * stored unformatted: the pointer to its format string, followed by a copy of
+ * its arguments.  The logging task formats it just before it is output, so
+ * neither the heap nor vsnprintf() is used by the task that logs.
+ *
+ * A writer reserves room for its message in a critical section that only
+ * moves the head of the ring, then copies the message with interrupts
+ * enabled and marks it complete.  Messages that do not fit are counted and
+ * reported by the logging task rather than blocking the writer, so
+ * vLoggingPrintfFromISR() can log from an interrupt.
+ *
+ * With configLOGGING_OUTPUT_BINARY set to 1 the logging task does not format
+ * messages at all.  It outputs each one as a binary frame holding the
+ * address of its format string, the tick count, the number of the task that
+ * logged it and its arguments as captured.  tools/binary_log_decoder rebuilds
+ * the text from those frames and the ELF file of the firmware, which holds
+ * the format strings.  Frames are COBS encoded and end with a zero byte, so
+ * the decoder can pick up a stream at any point.
  */
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 
 /* Logging includes. */
 #include "aws_logging_task.h"
@@ -38,6 +56,7 @@
 /* Standard includes. */
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <string.h>
 
 /* Sanity check all the definitions required by this file are set. */
@@ -53,8 +72,138 @@
     #error configLOGGING_INCLUDE_TIME_AND_TASK_NAME must be defined in FreeRTOSConfig.h to use this logging file.  Set configLOGGING_INCLUDE_TIME_AND_TASK_NAME to 1 to prepend a time stamp, message number and the name of the calling task to each logged message.  Otherwise set to 0.
 #endif
 
-/* A block time of 0 just means don't block. */
-#define loggingDONT_BLOCK    0
+#ifndef configLOGGING_OUTPUT_BINARY
+    #define configLOGGING_OUTPUT_BINARY    0
+#endif
+
+#if ( configLOGGING_OUTPUT_BINARY == 1 )
+    #ifndef configPRINT_BINARY
+        #error configPRINT_BINARY( pucData, xLength ) must be defined in FreeRTOSConfig.h to set configLOGGING_OUTPUT_BINARY to 1.  Set configPRINT_BINARY( pucData, xLength ) to a function that outputs xLength bytes, which may include zero bytes.
+    #endif
+
+    #if ( configUSE_TRACE_FACILITY != 1 )
+        #error configUSE_TRACE_FACILITY must be set to 1 in FreeRTOSConfig.h to set configLOGGING_OUTPUT_BINARY to 1, as binary frames identify tasks by their task number.
+    #endif
+#endif
+
+/*
+ * States of a record in the ring buffer.  A padding record fills the end of
+ * the ring when the next record does not fit there, and is skipped.
+ */
+#define loggingRECORD_BUSY           ( ( uint8_t ) 0 )
+#define loggingRECORD_READY          ( ( uint8_t ) 1 )
+#define loggingRECORD_PADDING        ( ( uint8_t ) 2 )
+
+/* Set in the flags of a record that is output without the message number,
+ * time stamp and task name. */
+#define loggingFLAG_NO_PREFIX        ( ( uint8_t ) 0x01 )
+
+/* Records start on this boundary, so the pointer in the record header and
+ * the state of a padding record can always be written. */
+#define loggingALIGNMENT             ( ( size_t ) portBYTE_ALIGNMENT )
+#define loggingALIGN( xLength )      ( ( ( xLength ) + loggingALIGNMENT - 1 ) & ~( loggingALIGNMENT - 1 ) )
+
+/* The largest record a single message can take. */
+#define loggingMAX_RECORD_LENGTH     loggingALIGN( sizeof( LoggingRecord_t ) + configLOGGING_MAX_MESSAGE_LENGTH )
+
+/* Longest conversion specifier handled, such as "%-08.*lx" once the '*' has
+ * been replaced by its value. */
+#define loggingMAX_SPECIFIER_LENGTH  ( 24 )
+
+/*
+ * Types of binary frame, the first byte of each frame before it is encoded.
+ * All fields are in the byte order of the target.
+ *
+ * loggingFRAME_STREAM: a version byte (loggingSTREAM_VERSION), the sizes of
+ * int, long, long long, size_t, intmax_t, ptrdiff_t, double, long double and
+ * void * in bytes, the uint16_t 0x0102 to give the byte order, and the
+ * address of xLoggingTaskInitialize(), which the decoder compares with the
+ * ELF file to relocate format string addresses, then the uint32_t number of
+ * the message that follows.
+ *
+ * loggingFRAME_TASK: a uint16_t task number, then the name of the task with
+ * its terminating NULL.  Sent before the first message of each task.
+ *
+ * loggingFRAME_MESSAGE: the message flags, a uint16_t task number, a
+ * uint32_t tick count, the address of the format string, then the arguments
+ * as prvCaptureArguments() stored them.
+ *
+ * loggingFRAME_DROPPED: a uint32_t count of messages dropped since the last
+ * such frame.
+ */
+#define loggingFRAME_STREAM          ( ( uint8_t ) 0 )
+#define loggingFRAME_TASK            ( ( uint8_t ) 1 )
+#define loggingFRAME_MESSAGE         ( ( uint8_t ) 2 )
+#define loggingFRAME_DROPPED         ( ( uint8_t ) 3 )
+#define loggingSTREAM_VERSION        ( ( uint8_t ) 1 )
+
+/* The stream frame is sent again after this many frames, and the task names
+ * with it, so that a decoder started late can still decode the stream. */
+#define loggingSTREAM_FRAME_INTERVAL ( 128 )
+
+/* Longest frame, a message with its arguments, before encoding. */
+#define loggingMAX_FRAME_LENGTH      ( 8 + sizeof( void * ) + configLOGGING_MAX_MESSAGE_LENGTH )
+
+/* COBS adds one byte for every 254, one at the start, and the frame ends
+ * with a zero byte. */
+#define loggingMAX_ENCODED_LENGTH    ( loggingMAX_FRAME_LENGTH + ( loggingMAX_FRAME_LENGTH / 254 ) + 2 )
+
+/* Task numbers that fit in the bitmap of names already sent.  Tasks with a
+ * higher number have their name sent before each of their messages. */
+#define loggingMAX_NAMED_TASKS       ( 64 )
+
+/*-----------------------------------------------------------*/
+
+/*
+ * The header of a message in the ring buffer.  The arguments of the message
+ * follow it, in the order the format string consumes them: each number as
+ * the type it was passed as, and each string as a copy that includes its
+ * terminating NULL.
+ */
+typedef struct LoggingRecord
+{
+    volatile uint8_t ucState;    /* One of the loggingRECORD_ values.  Must come first, see loggingRECORD_PADDING. */
+    uint8_t ucFlags;             /* loggingFLAG_ bits. */
+    uint16_t usLength;           /* Length of the record, including the header and the alignment padding. */
+    uint16_t usArgumentsLength;  /* Number of bytes of arguments that follow the header. */
+    uint16_t usTaskNumber;       /* Task number of the writer, only used by binary output.  0 for an interrupt or before the scheduler starts. */
+    uint32_t ulMessageNumber;
+    TickType_t xTimeStamp;
+    const char * pcFormat;
+    char cTaskName[ configMAX_TASK_NAME_LEN ];
+} LoggingRecord_t;
+
+/*
+ * How a conversion specifier reads its argument.
+ */
+typedef enum LoggingArgument
+{
+    eLoggingPercent,    /* "%%", which has no argument. */
+    eLoggingInt,        /* Also char and short, which are promoted to int. */
+    eLoggingLong,
+    eLoggingLongLong,
+    eLoggingSize,
+    eLoggingIntMax,
+    eLoggingPtrDiff,
+    eLoggingDouble,     /* Also float, which is promoted to double. */
+    eLoggingLongDouble,
+    eLoggingPointer,
+    eLoggingString,
+    eLoggingCount,      /* "%n", whose pointer is never written through. */
+    eLoggingInvalid
+} LoggingArgument_t;
+
+/*
+ * A conversion specifier, as parsed by prvParseSpecifier().
+ */
+typedef struct LoggingSpecifier
+{
+    size_t xLength;            /* Number of characters, including the '%'. */
+    LoggingArgument_t xArgument;
+    BaseType_t xStars;         /* Number of '*' for the width and precision, each of which takes an int argument first. */
+    BaseType_t xPrecisionStar; /* pdTRUE if the precision is given by an argument. */
+    int32_t lPrecision;        /* The precision, or -1 if there is none or it is given by an argument. */
+} LoggingSpecifier_t;
 
 /*-----------------------------------------------------------*/
 
@@ -64,21 +213,106 @@
  * outputting the log message having to wait for the message to be completely
  * written.  Using a separate task also serialises access to the output port.
  *
- * The structure of this task is very simple; it blocks on a queue to wait for
- * a pointer to a string, sending any received strings to a macro that performs
- * the actual output.  The macro is port specific, so implemented outside of
- * this file.  This version uses dynamic memory, so the buffer that contained
- * the log message is freed after it has been output.
+ * The task sleeps until a writer notifies it, then formats and outputs every
+ * complete record in the ring buffer, in order.  The output itself is
+ * performed by a macro that is port specific, so implemented outside of this
+ * file.
  */
 static void prvLoggingTask( void * pvParameters );
 
+/*
+ * Parses the conversion specifier that starts at pcSpecifier, which points
+ * to a '%'.
+ */
+static void prvParseSpecifier( const char * pcSpecifier,
+                               LoggingSpecifier_t * pxSpecifier );
+
+/*
+ * Copies the arguments of pcFormat into pucArguments, which is xLength bytes
+ * long, and returns the number of bytes used.  Arguments that do not fit are
+ * dropped, and the output of the message stops where they were.
+ */
+static size_t prvCaptureArguments( const char * pcFormat,
+                                   va_list xArgs,
+                                   uint8_t * pucArguments,
+                                   size_t xLength );
+
+/*
+ * Copies a message into the ring buffer and wakes the logging task.
+ */
+static void prvWriteRecord( const char * pcFormat,
+                            uint8_t ucFlags,
+                            const uint8_t * pucArguments,
+                            size_t xArgumentsLength,
+                            BaseType_t xFromISR );
+
+#if ( configLOGGING_OUTPUT_BINARY == 1 )
+
+/*
+ * COBS encodes a frame into ucEncodedFrame and outputs it.
+ */
+    static void prvSendFrame( const uint8_t * pucFrame,
+                              size_t xLength );
+
+/*
+ * Outputs a record as a message frame, preceded by the stream frame and
+ * the name of its task when they are due.
+ */
+    static void prvSendRecord( const LoggingRecord_t * pxRecord );
+
+#else
+
+/*
+ * Formats a record into cOutputBuffer.
+ */
+    static void prvFormatRecord( const LoggingRecord_t * pxRecord );
+
+#endif /* if ( configLOGGING_OUTPUT_BINARY == 1 ) */
+
+/*
+ * Outputs the number of messages dropped since the last call, if any.
+ */
+static void prvReportDroppedMessages( void );
+
 /*-----------------------------------------------------------*/
 
 /*
- * The queue used to pass pointers to log messages from the task that created
- * the message to the task that will performs the output.
+ * The ring buffer, and the task that reads it.  xHead and xTail count bytes
+ * from the creation of the ring, so they are reduced modulo the ring size,
+ * which is a power of two, before use.  xHead is only changed in a critical
+ * section, and xTail only by the logging task.
  */
-static QueueHandle_t xQueue = NULL;
+static uint8_t * pucRing = NULL;
+static size_t xRingSize = 0;
+static volatile size_t xHead = 0;
+static volatile size_t xTail = 0;
+static TaskHandle_t xLoggingTask = NULL;
+
+/* Count of the messages that did not fit in the ring buffer, and of those
+ * already reported. */
+static volatile uint32_t ulDroppedMessages = 0;
+static uint32_t ulReportedDroppedMessages = 0;
+
+/* Number of the next message, used as the first field of the prefix. */
+static uint32_t ulMessageNumber = 0;
+
+#if ( configLOGGING_OUTPUT_BINARY == 1 )
+
+/* Only used by the logging task, to build and encode one frame at a time. */
+    static uint8_t ucFrame[ loggingMAX_FRAME_LENGTH ];
+    static uint8_t ucEncodedFrame[ loggingMAX_ENCODED_LENGTH ];
+
+/* Frames sent since the last stream frame, and the bitmap of the task
+ * numbers whose name was sent since then. */
+    static uint32_t ulFramesSinceStreamFrame = loggingSTREAM_FRAME_INTERVAL;
+    static uint32_t ulNamedTasks[ loggingMAX_NAMED_TASKS / 32 ];
+
+#else
+
+/* Only used by the logging task, to format one message at a time. */
+    static char cOutputBuffer[ configLOGGING_MAX_MESSAGE_LENGTH ];
+
+#endif /* if ( configLOGGING_OUTPUT_BINARY == 1 ) */
 
 /*-----------------------------------------------------------*/
 
@@ -87,23 +321,36 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
                                    UBaseType_t uxQueueLength )
 {
     BaseType_t xReturn = pdFAIL;
+    size_t xRequestedSize = ( size_t ) uxQueueLength * configLOGGING_MAX_MESSAGE_LENGTH;
 
     /* Ensure the logging task has not been created already. */
-    if( xQueue == NULL )
+    if( pucRing == NULL )
     {
-        /* Create the queue used to pass pointers to strings to the logging task. */
-        xQueue = xQueueCreate( uxQueueLength, sizeof( char ** ) );
+        /* Size the ring after the queue of uxQueueLength full length strings
+         * it replaces, rounded down to a power of two so the head and tail
+         * can wrap with a mask.  Messages are stored unformatted, so usually
+         * more of them fit than the queue held. */
+        for( xRingSize = loggingALIGNMENT; ( xRingSize << 1 ) <= xRequestedSize; xRingSize <<= 1 )
+        {
+        }
 
-        if( xQueue != NULL )
+        if( xRingSize >= loggingMAX_RECORD_LENGTH )
         {
-            if( xTaskCreate( prvLoggingTask, "Logging", usStackSize, NULL, uxPriority, NULL ) == pdPASS )
+            /* Allocated once, so the heap does not fragment. */
+            pucRing = pvPortMalloc( xRingSize );
+        }
+
+        if( pucRing != NULL )
+        {
+            if( xTaskCreate( prvLoggingTask, "Logging", usStackSize, NULL, uxPriority, &xLoggingTask ) == pdPASS )
             {
                 xReturn = pdPASS;
             }
             else
             {
-                /* Could not create the task, so delete the queue again. */
-                vQueueDelete( xQueue );
+                /* Could not create the task, so free the ring again. */
+                vPortFree( pucRing );
+                pucRing = NULL;
             }
         }
     }
@@ -114,141 +361,958 @@ BaseType_t xLoggingTaskInitialize( uint16_t usStackSize,
 
 static void prvLoggingTask( void * pvParameters )
 {
-    char * pcReceivedString = NULL;
+    const LoggingRecord_t * pxRecord;
+    size_t xOffset;
+
+    /* Remove compiler warnings about unused parameters. */
+    ( void ) pvParameters;
 
     for( ; ; )
     {
-        /* Block to wait for the next string to print. */
-        if( xQueueReceive( xQueue, &pcReceivedString, portMAX_DELAY ) == pdPASS )
+        /* Block to wait for a writer to complete a record. */
+        ( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+        while( xTail != xHead )
         {
-            configPRINT_STRING( pcReceivedString );
-            vPortFree( ( void * ) pcReceivedString );
+            xOffset = xTail & ( xRingSize - 1 );
+            pxRecord = ( const LoggingRecord_t * ) &pucRing[ xOffset ];
+
+            if( pxRecord->ucState == loggingRECORD_PADDING )
+            {
+                xTail += xRingSize - xOffset;
+            }
+            else if( pxRecord->ucState == loggingRECORD_READY )
+            {
+                #if ( configLOGGING_OUTPUT_BINARY == 1 )
+                    {
+                        prvSendRecord( pxRecord );
+                    }
+                #else
+                    {
+                        prvFormatRecord( pxRecord );
+                        configPRINT_STRING( cOutputBuffer );
+                    }
+                #endif
+
+                /* Only now can writers reuse the record. */
+                xTail += pxRecord->usLength;
+            }
+            else
+            {
+                /* A writer is still copying this record.  It notifies this
+                 * task once it is done. */
+                break;
+            }
         }
+
+        /* Messages are dropped when the ring is full, so after those that
+         * are in it. */
+        prvReportDroppedMessages();
     }
 }
 /*-----------------------------------------------------------*/
 
-/*!
- * \brief Formats a string to be printed and sends it
- * to the print queue.
- *
- * Appends the message number, time (in ticks), and task
- * that called vLoggingPrintf to the beginning of each
- * print statement.
- *
- */
-void vLoggingPrintf( const char * pcFormat,
-                     ... )
+static void prvReportDroppedMessages( void )
 {
-    size_t xLength = 0;
-    int32_t xLength2 = 0;
-    va_list args;
-    char * pcPrintString = NULL;
+    uint32_t ulDropped = ulDroppedMessages;
 
-    /* The queue is created by xLoggingTaskInitialize().  Check
-     * xLoggingTaskInitialize() has been called. */
-    configASSERT( xQueue );
+    if( ulDropped != ulReportedDroppedMessages )
+    {
+        #if ( configLOGGING_OUTPUT_BINARY == 1 )
+            {
+                uint32_t ulCount = ulDropped - ulReportedDroppedMessages;
+
+                ucFrame[ 0 ] = loggingFRAME_DROPPED;
+                memcpy( &ucFrame[ 1 ], &ulCount, sizeof( ulCount ) );
+                prvSendFrame( ucFrame, 1 + sizeof( ulCount ) );
+            }
+        #else
+            {
+                ( void ) snprintf( cOutputBuffer, sizeof( cOutputBuffer ), "[Logging] %lu messages dropped, the log buffer was full.\r\n",
+                                   ( unsigned long ) ( ulDropped - ulReportedDroppedMessages ) );
+                configPRINT_STRING( cOutputBuffer );
+            }
+        #endif
+
+        ulReportedDroppedMessages = ulDropped;
+    }
+}
+/*-----------------------------------------------------------*/
 
-    /* Allocate a buffer to hold the log message. */
-    pcPrintString = pvPortMalloc( configLOGGING_MAX_MESSAGE_LENGTH );
+#if ( configLOGGING_OUTPUT_BINARY == 1 )
 
-    if( pcPrintString != NULL )
+    static void prvSendFrame( const uint8_t * pucFrame,
+                              size_t xLength )
     {
-        /* There are a variable number of parameters. */
-        va_start( args, pcFormat );
+        size_t xIn, xOut = 1, xCode = 0;
 
-        if( strcmp( pcFormat, "\n" ) != 0 )
+        /* Each zero byte is replaced by the distance to the next one, the
+         * first distance being at the start.  Runs of 254 non zero bytes get
+         * a distance of their own. */
+        for( xIn = 0; xIn < xLength; xIn++ )
         {
-            #if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 )
+            if( pucFrame[ xIn ] == 0 )
+            {
+                ucEncodedFrame[ xCode ] = ( uint8_t ) ( xOut - xCode );
+                xCode = xOut++;
+            }
+            else
+            {
+                ucEncodedFrame[ xOut++ ] = pucFrame[ xIn ];
+
+                if( ( xOut - xCode ) == 0xFF )
                 {
-                    const char * pcTaskName;
-                    const char * pcNoTask = "None";
-                    static BaseType_t xMessageNumber = 0;
+                    ucEncodedFrame[ xCode ] = 0xFF;
+                    xCode = xOut++;
+                }
+            }
+        }
 
-                    /* Add a time stamp and the name of the calling task to the
-                     * start of the log. */
-                    if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
-                    {
-                        pcTaskName = pcTaskGetName( NULL );
-                    }
-                    else
-                    {
-                        pcTaskName = pcNoTask;
-                    }
+        ucEncodedFrame[ xCode ] = ( uint8_t ) ( xOut - xCode );
+        ucEncodedFrame[ xOut++ ] = 0;
+
+        configPRINT_BINARY( ucEncodedFrame, xOut );
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvSendRecord( const LoggingRecord_t * pxRecord )
+    {
+        const uint16_t usByteOrder = 0x0102;
+        const void * pvAnchor = ( const void * ) xLoggingTaskInitialize;
+        uint32_t ulTick = ( uint32_t ) pxRecord->xTimeStamp;
+        size_t xLength, xNameLength;
+        uint16_t usTaskNumber = pxRecord->usTaskNumber;
+        BaseType_t xNamed = pdFALSE;
+
+        if( ulFramesSinceStreamFrame >= loggingSTREAM_FRAME_INTERVAL )
+        {
+            ucFrame[ 0 ] = loggingFRAME_STREAM;
+            ucFrame[ 1 ] = loggingSTREAM_VERSION;
+            ucFrame[ 2 ] = ( uint8_t ) sizeof( int );
+            ucFrame[ 3 ] = ( uint8_t ) sizeof( long );
+            ucFrame[ 4 ] = ( uint8_t ) sizeof( long long );
+            ucFrame[ 5 ] = ( uint8_t ) sizeof( size_t );
+            ucFrame[ 6 ] = ( uint8_t ) sizeof( intmax_t );
+            ucFrame[ 7 ] = ( uint8_t ) sizeof( ptrdiff_t );
+            ucFrame[ 8 ] = ( uint8_t ) sizeof( double );
+            ucFrame[ 9 ] = ( uint8_t ) sizeof( long double );
+            ucFrame[ 10 ] = ( uint8_t ) sizeof( void * );
+            memcpy( &ucFrame[ 11 ], &usByteOrder, sizeof( usByteOrder ) );
+            memcpy( &ucFrame[ 13 ], &pvAnchor, sizeof( pvAnchor ) );
+            memcpy( &ucFrame[ 13 + sizeof( pvAnchor ) ], &pxRecord->ulMessageNumber, sizeof( pxRecord->ulMessageNumber ) );
+            prvSendFrame( ucFrame, 13 + sizeof( pvAnchor ) + sizeof( pxRecord->ulMessageNumber ) );
+
+            ulFramesSinceStreamFrame = 0;
+            memset( ulNamedTasks, 0, sizeof( ulNamedTasks ) );
+        }
+
+        /* Task number 0 stands for both interrupts and the time before the
+         * scheduler starts, so its name is sent every time. */
+        if( ( usTaskNumber != 0 ) && ( usTaskNumber < loggingMAX_NAMED_TASKS ) )
+        {
+            xNamed = ( ( ulNamedTasks[ usTaskNumber / 32 ] & ( 1UL << ( usTaskNumber % 32 ) ) ) != 0 ) ? pdTRUE : pdFALSE;
+            ulNamedTasks[ usTaskNumber / 32 ] |= 1UL << ( usTaskNumber % 32 );
+        }
+
+        if( xNamed == pdFALSE )
+        {
+            xNameLength = strlen( pxRecord->cTaskName ) + 1;
+            ucFrame[ 0 ] = loggingFRAME_TASK;
+            memcpy( &ucFrame[ 1 ], &usTaskNumber, sizeof( usTaskNumber ) );
+            memcpy( &ucFrame[ 3 ], pxRecord->cTaskName, xNameLength );
+            prvSendFrame( ucFrame, 3 + xNameLength );
+            ulFramesSinceStreamFrame++;
+        }
+
+        ucFrame[ 0 ] = loggingFRAME_MESSAGE;
+        ucFrame[ 1 ] = pxRecord->ucFlags;
+        memcpy( &ucFrame[ 2 ], &usTaskNumber, sizeof( usTaskNumber ) );
+        memcpy( &ucFrame[ 4 ], &ulTick, sizeof( ulTick ) );
+        memcpy( &ucFrame[ 8 ], &pxRecord->pcFormat, sizeof( pxRecord->pcFormat ) );
+        xLength = 8 + sizeof( pxRecord->pcFormat );
+        memcpy( &ucFrame[ xLength ], pxRecord + 1, pxRecord->usArgumentsLength );
+        xLength += pxRecord->usArgumentsLength;
+        prvSendFrame( ucFrame, xLength );
+        ulFramesSinceStreamFrame++;
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* if ( configLOGGING_OUTPUT_BINARY == 1 ) */
+
+static void prvParseSpecifier( const char * pcSpecifier,
+                               LoggingSpecifier_t * pxSpecifier )
+{
+    const char * pcNext = pcSpecifier + 1;
+    char cLength = '\0';
+    BaseType_t xLongLong = pdFALSE;
+
+    pxSpecifier->xStars = 0;
+    pxSpecifier->xPrecisionStar = pdFALSE;
+    pxSpecifier->lPrecision = -1;
+
+    /* Flags. */
+    while( ( *pcNext != '\0' ) && ( strchr( "-+ #0", *pcNext ) != NULL ) )
+    {
+        pcNext++;
+    }
+
+    /* Width. */
+    if( *pcNext == '*' )
+    {
+        pxSpecifier->xStars++;
+        pcNext++;
+    }
+    else
+    {
+        while( ( *pcNext >= '0' ) && ( *pcNext <= '9' ) )
+        {
+            pcNext++;
+        }
+    }
+
+    /* Precision. */
+    if( *pcNext == '.' )
+    {
+        pcNext++;
+
+        if( *pcNext == '*' )
+        {
+            pxSpecifier->xStars++;
+            pxSpecifier->xPrecisionStar = pdTRUE;
+            pcNext++;
+        }
+        else
+        {
+            pxSpecifier->lPrecision = 0;
+
+            while( ( *pcNext >= '0' ) && ( *pcNext <= '9' ) )
+            {
+                pxSpecifier->lPrecision = ( pxSpecifier->lPrecision * 10 ) + ( *pcNext - '0' );
+                pcNext++;
+            }
+        }
+    }
+
+    /* Length modifier.  "hh" and "h" change nothing, as char and short are
+     * promoted to int. */
+    if( ( *pcNext != '\0' ) && ( strchr( "hlzjtL", *pcNext ) != NULL ) )
+    {
+        cLength = *pcNext;
+        pcNext++;
+
+        if( ( *pcNext == cLength ) && ( ( cLength == 'h' ) || ( cLength == 'l' ) ) )
+        {
+            xLongLong = ( cLength == 'l' ) ? pdTRUE : pdFALSE;
+            pcNext++;
+        }
+    }
+
+    switch( *pcNext )
+    {
+        case '%':
+            pxSpecifier->xArgument = eLoggingPercent;
+            break;
+
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+
+            if( xLongLong == pdTRUE )
+            {
+                pxSpecifier->xArgument = eLoggingLongLong;
+            }
+            else if( cLength == 'l' )
+            {
+                pxSpecifier->xArgument = eLoggingLong;
+            }
+            else if( cLength == 'z' )
+            {
+                pxSpecifier->xArgument = eLoggingSize;
+            }
+            else if( cLength == 'j' )
+            {
+                pxSpecifier->xArgument = eLoggingIntMax;
+            }
+            else if( cLength == 't' )
+            {
+                pxSpecifier->xArgument = eLoggingPtrDiff;
+            }
+            else
+            {
+                pxSpecifier->xArgument = eLoggingInt;
+            }
+
+            break;
+
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            pxSpecifier->xArgument = ( cLength == 'L' ) ? eLoggingLongDouble : eLoggingDouble;
+            break;
+
+        case 'p':
+            pxSpecifier->xArgument = eLoggingPointer;
+            break;
+
+        case 's':
+            pxSpecifier->xArgument = eLoggingString;
+            break;
+
+        case 'n':
+            pxSpecifier->xArgument = eLoggingCount;
+            break;
+
+        default:
+            pxSpecifier->xArgument = eLoggingInvalid;
+            break;
+    }
+
+    if( pxSpecifier->xArgument != eLoggingInvalid )
+    {
+        pcNext++;
+    }
+
+    pxSpecifier->xLength = ( size_t ) ( pcNext - pcSpecifier );
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvCaptureArguments( const char * pcFormat,
+                                   va_list xArgs,
+                                   uint8_t * pucArguments,
+                                   size_t xLength )
+{
+    LoggingSpecifier_t xSpecifier;
+    size_t xUsed = 0, xSize, xCopied;
+    BaseType_t xStar, xFull = pdFALSE;
+    int32_t lPrecision;
+    const char * pcString;
+
+    /* Union of the values an argument can have, so each can be copied with
+     * one memcpy() of the size of its type. */
+    union
+    {
+        int iInt;
+        long lLong;
+        long long llLongLong;
+        size_t xSize;
+        intmax_t xIntMax;
+        ptrdiff_t xPtrDiff;
+        double dDouble;
+        long double ldLongDouble;
+        void * pvPointer;
+    } xValue;
+
+    while( ( *pcFormat != '\0' ) && ( xFull == pdFALSE ) )
+    {
+        if( *pcFormat != '%' )
+        {
+            pcFormat++;
+            continue;
+        }
+
+        prvParseSpecifier( pcFormat, &xSpecifier );
+        pcFormat += xSpecifier.xLength;
+
+        if( xSpecifier.xArgument == eLoggingInvalid )
+        {
+            /* The output stops at the same place. */
+            break;
+        }
+
+        /* The width and the precision, if given by arguments, come first.
+         * A negative precision means there is none. */
+        lPrecision = xSpecifier.lPrecision;
+
+        for( xStar = 0; ( xStar < xSpecifier.xStars ) && ( xFull == pdFALSE ); xStar++ )
+        {
+            xValue.iInt = va_arg( xArgs, int );
+
+            if( ( xStar == ( xSpecifier.xStars - 1 ) ) && ( xSpecifier.xPrecisionStar == pdTRUE ) )
+            {
+                lPrecision = ( int32_t ) xValue.iInt;
+            }
+
+            if( ( xLength - xUsed ) >= sizeof( int ) )
+            {
+                memcpy( &pucArguments[ xUsed ], &xValue, sizeof( int ) );
+                xUsed += sizeof( int );
+            }
+            else
+            {
+                xFull = pdTRUE;
+            }
+        }
+
+        if( xFull == pdTRUE )
+        {
+            break;
+        }
+
+        xSize = 0;
+
+        switch( xSpecifier.xArgument )
+        {
+            case eLoggingInt:
+                xValue.iInt = va_arg( xArgs, int );
+                xSize = sizeof( int );
+                break;
+
+            case eLoggingLong:
+                xValue.lLong = va_arg( xArgs, long );
+                xSize = sizeof( long );
+                break;
+
+            case eLoggingLongLong:
+                xValue.llLongLong = va_arg( xArgs, long long );
+                xSize = sizeof( long long );
+                break;
+
+            case eLoggingSize:
+                xValue.xSize = va_arg( xArgs, size_t );
+                xSize = sizeof( size_t );
+                break;
+
+            case eLoggingIntMax:
+                xValue.xIntMax = va_arg( xArgs, intmax_t );
+                xSize = sizeof( intmax_t );
+                break;
+
+            case eLoggingPtrDiff:
+                xValue.xPtrDiff = va_arg( xArgs, ptrdiff_t );
+                xSize = sizeof( ptrdiff_t );
+                break;
+
+            case eLoggingDouble:
+                xValue.dDouble = va_arg( xArgs, double );
+                xSize = sizeof( double );
+                break;
+
+            case eLoggingLongDouble:
+                xValue.ldLongDouble = va_arg( xArgs, long double );
+                xSize = sizeof( long double );
+                break;
+
+            case eLoggingPointer:
+                xValue.pvPointer = va_arg( xArgs, void * );
+                xSize = sizeof( void * );
+                break;
+
+            case eLoggingCount:
+                /* Consumed but not stored, it is never written through. */
+                ( void ) va_arg( xArgs, void * );
+                break;
+
+            case eLoggingString:
+
+                /* The string may not outlive the call, so copy it, up to
+                 * its precision and the room left. */
+                pcString = va_arg( xArgs, const char * );
 
-                    xLength = snprintf( pcPrintString, configLOGGING_MAX_MESSAGE_LENGTH, "%lu %lu [%s] ",
-                                        xMessageNumber++,
-                                        ( unsigned long ) xTaskGetTickCount(),
-                                        pcTaskName );
+                if( pcString == NULL )
+                {
+                    pcString = "(null)";
+                }
+
+                for( xCopied = 0;
+                     ( pcString[ xCopied ] != '\0' ) &&
+                     ( ( lPrecision < 0 ) || ( xCopied < ( size_t ) lPrecision ) ) &&
+                     ( ( xUsed + xCopied + 1 ) < xLength );
+                     xCopied++ )
+                {
+                    pucArguments[ xUsed + xCopied ] = ( uint8_t ) pcString[ xCopied ];
+                }
+
+                if( ( xUsed + xCopied ) < xLength )
+                {
+                    pucArguments[ xUsed + xCopied ] = '\0';
+                    xUsed += xCopied + 1;
                 }
-            #else /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+                else
                 {
-                    xLength = 0;
+                    xFull = pdTRUE;
                 }
-            #endif /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
+
+                break;
+
+            default:
+                /* eLoggingPercent has no argument. */
+                break;
         }
 
-        xLength2 = vsnprintf( pcPrintString + xLength, configLOGGING_MAX_MESSAGE_LENGTH - xLength, pcFormat, args );
+        if( xSize > 0 )
+        {
+            if( ( xLength - xUsed ) >= xSize )
+            {
+                memcpy( &pucArguments[ xUsed ], &xValue, xSize );
+                xUsed += xSize;
+            }
+            else
+            {
+                xFull = pdTRUE;
+            }
+        }
+    }
 
-        if( xLength2 < 0 )
+    return xUsed;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteRecord( const char * pcFormat,
+                            uint8_t ucFlags,
+                            const uint8_t * pucArguments,
+                            size_t xArgumentsLength,
+                            BaseType_t xFromISR )
+{
+    LoggingRecord_t * pxRecord = NULL;
+    size_t xLength = loggingALIGN( sizeof( LoggingRecord_t ) + xArgumentsLength );
+    size_t xOffset, xPadding;
+    UBaseType_t uxSavedInterruptStatus = 0;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    const char * pcTaskName;
+
+    /* The ring is allocated by xLoggingTaskInitialize().  Check
+     * xLoggingTaskInitialize() has been called. */
+    configASSERT( pucRing );
+
+    /* Reserve the record.  The critical section only covers the move of the
+     * head, the record is copied after it. */
+    if( xFromISR == pdTRUE )
+    {
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    }
+    else
+    {
+        taskENTER_CRITICAL();
+    }
+
+    {
+        xOffset = xHead & ( xRingSize - 1 );
+        xPadding = ( ( xOffset + xLength ) > xRingSize ) ? ( xRingSize - xOffset ) : 0;
+
+        if( ( ( xHead - xTail ) + xPadding + xLength ) <= xRingSize )
+        {
+            if( xPadding > 0 )
+            {
+                ( ( LoggingRecord_t * ) &pucRing[ xOffset ] )->ucState = loggingRECORD_PADDING;
+                xOffset = 0;
+            }
+
+            pxRecord = ( LoggingRecord_t * ) &pucRing[ xOffset ];
+            pxRecord->ucState = loggingRECORD_BUSY;
+            pxRecord->ulMessageNumber = ulMessageNumber++;
+            xHead += xPadding + xLength;
+        }
+        else
         {
-            /* vsnprintf() failed. Restore the terminating NULL
-             * character of the first part. Note that the first
-             * part of the buffer may be empty if the value of
-             * configLOGGING_INCLUDE_TIME_AND_TASK_NAME is not
-             * 1 and as a result, the whole buffer may be empty.
-             * That's the reason we have a check for xLength > 0
-             * before sending the buffer to the logging task.
-             */
-            xLength2 = 0;
-            pcPrintString[ xLength ] = '\0';
+            ulDroppedMessages++;
         }
+    }
 
-        xLength += ( size_t ) xLength2;
-        va_end( args );
+    if( xFromISR == pdTRUE )
+    {
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+    }
+    else
+    {
+        taskEXIT_CRITICAL();
+    }
+
+    if( pxRecord != NULL )
+    {
+        pxRecord->ucFlags = ucFlags;
+        pxRecord->usLength = ( uint16_t ) xLength;
+        pxRecord->usArgumentsLength = ( uint16_t ) xArgumentsLength;
+        pxRecord->pcFormat = pcFormat;
+
+        pxRecord->usTaskNumber = 0;
 
-        /* Only send the buffer to the logging task if it is
-         * not empty. */
-        if( xLength > 0 )
+        if( xFromISR == pdTRUE )
+        {
+            pxRecord->xTimeStamp = xTaskGetTickCountFromISR();
+            pcTaskName = "ISR";
+        }
+        else
         {
-            /* Send the string to the logging task for IO. */
-            if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+            pxRecord->xTimeStamp = xTaskGetTickCount();
+
+            if( xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED )
+            {
+                #if ( configLOGGING_OUTPUT_BINARY == 1 )
+                    {
+                        TaskStatus_t xStatus;
+
+                        /* Passing eRunning skips working out the state. */
+                        vTaskGetInfo( NULL, &xStatus, pdFALSE, eRunning );
+                        pxRecord->usTaskNumber = ( uint16_t ) xStatus.xTaskNumber;
+                        pcTaskName = xStatus.pcTaskName;
+                    }
+                #else
+                    {
+                        pcTaskName = pcTaskGetName( NULL );
+                    }
+                #endif
+            }
+            else
             {
-                /* The buffer was not sent so must be freed again. */
-                vPortFree( ( void * ) pcPrintString );
+                pcTaskName = "None";
             }
         }
+
+        strncpy( pxRecord->cTaskName, pcTaskName, sizeof( pxRecord->cTaskName ) - 1 );
+        pxRecord->cTaskName[ sizeof( pxRecord->cTaskName ) - 1 ] = '\0';
+        memcpy( pxRecord + 1, pucArguments, xArgumentsLength );
+
+        /* The critical section also stops the compiler and the core from
+         * publishing the record before its contents. */
+        if( xFromISR == pdTRUE )
+        {
+            uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+            pxRecord->ucState = loggingRECORD_READY;
+            taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+        }
         else
         {
-            /* The buffer was not sent, so it must be
-             * freed. */
-            vPortFree( ( void * ) pcPrintString );
+            taskENTER_CRITICAL();
+            pxRecord->ucState = loggingRECORD_READY;
+            taskEXIT_CRITICAL();
         }
     }
+
+    /* Wake the logging task, also for a dropped message so it reports it. */
+    if( xFromISR == pdTRUE )
+    {
+        vTaskNotifyGiveFromISR( xLoggingTask, &xHigherPriorityTaskWoken );
+        portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+    }
+    else
+    {
+        ( void ) xTaskNotifyGive( xLoggingTask );
+    }
 }
 /*-----------------------------------------------------------*/
 
-void vLoggingPrint( const char * pcMessage )
-{
-    char * pcPrintString = NULL;
-    size_t xLength = 0;
+#if ( configLOGGING_OUTPUT_BINARY == 0 )
 
-    /* The queue is created by xLoggingTaskInitialize().  Check
-     * xLoggingTaskInitialize() has been called. */
-    configASSERT( xQueue );
+static void prvFormatRecord( const LoggingRecord_t * pxRecord )
+{
+    const uint8_t * pucArguments = ( const uint8_t * ) ( pxRecord + 1 );
+    const char * pcFormat = pxRecord->pcFormat;
+    size_t xUsed = 0, xRead = 0, xSize, xCopied;
+    LoggingSpecifier_t xSpecifier;
+    char cSpecifier[ loggingMAX_SPECIFIER_LENGTH ];
+    int iLength = 0;
+    BaseType_t xStop = pdFALSE;
+    union
+    {
+        int iInt;
+        long lLong;
+        long long llLongLong;
+        size_t xSize;
+        intmax_t xIntMax;
+        ptrdiff_t xPtrDiff;
+        double dDouble;
+        long double ldLongDouble;
+        void * pvPointer;
+    } xValue;
 
-    xLength = strlen( pcMessage ) + 1;
-    pcPrintString = pvPortMalloc( xLength );
+    #if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 )
+        {
+            if( ( pxRecord->ucFlags & loggingFLAG_NO_PREFIX ) == 0 )
+            {
+                /* Add a time stamp and the name of the calling task to the
+                 * start of the log. */
+                iLength = snprintf( cOutputBuffer, sizeof( cOutputBuffer ), "%lu %lu [%s] ",
+                                    ( unsigned long ) pxRecord->ulMessageNumber,
+                                    ( unsigned long ) pxRecord->xTimeStamp,
+                                    pxRecord->cTaskName );
+                xUsed = ( iLength > 0 ) ? ( size_t ) iLength : 0;
+            }
+        }
+    #endif /* if ( configLOGGING_INCLUDE_TIME_AND_TASK_NAME == 1 ) */
 
-    if( pcPrintString != NULL )
+    while( ( *pcFormat != '\0' ) && ( xStop == pdFALSE ) && ( ( xUsed + 1 ) < sizeof( cOutputBuffer ) ) )
     {
-        strncpy( pcPrintString, pcMessage, xLength );
+        if( *pcFormat != '%' )
+        {
+            cOutputBuffer[ xUsed++ ] = *pcFormat++;
+            continue;
+        }
 
-        /* Send the string to the logging task for IO. */
-        if( xQueueSend( xQueue, &pcPrintString, loggingDONT_BLOCK ) != pdPASS )
+        prvParseSpecifier( pcFormat, &xSpecifier );
+
+        if( ( xSpecifier.xArgument == eLoggingInvalid ) || ( xSpecifier.xLength >= sizeof( cSpecifier ) ) )
         {
-            /* The buffer was not sent so must be freed again. */
-            vPortFree( ( void * ) pcPrintString );
+            break;
         }
+
+        if( xSpecifier.xArgument == eLoggingPercent )
+        {
+            cOutputBuffer[ xUsed++ ] = '%';
+            pcFormat += xSpecifier.xLength;
+            continue;
+        }
+
+        /* Copy the specifier, replacing each '*' by the value captured for
+         * it, so that only the value itself remains to be passed. */
+        xCopied = 0;
+
+        while( ( xCopied + 1 < sizeof( cSpecifier ) ) && ( xSpecifier.xLength > 0 ) && ( xStop == pdFALSE ) )
+        {
+            if( *pcFormat == '*' )
+            {
+                if( ( pxRecord->usArgumentsLength - xRead ) < sizeof( int ) )
+                {
+                    xStop = pdTRUE;
+                }
+                else
+                {
+                    memcpy( &xValue.iInt, &pucArguments[ xRead ], sizeof( int ) );
+                    xRead += sizeof( int );
+                    iLength = snprintf( &cSpecifier[ xCopied ], sizeof( cSpecifier ) - xCopied, "%d", xValue.iInt );
+
+                    if( ( iLength <= 0 ) || ( ( size_t ) iLength >= ( sizeof( cSpecifier ) - xCopied ) ) )
+                    {
+                        xStop = pdTRUE;
+                    }
+                    else
+                    {
+                        xCopied += ( size_t ) iLength;
+                    }
+                }
+            }
+            else
+            {
+                cSpecifier[ xCopied++ ] = *pcFormat;
+            }
+
+            pcFormat++;
+            xSpecifier.xLength--;
+        }
+
+        if( ( xStop == pdTRUE ) || ( xSpecifier.xLength > 0 ) )
+        {
+            break;
+        }
+
+        cSpecifier[ xCopied ] = '\0';
+
+        switch( xSpecifier.xArgument )
+        {
+            case eLoggingLong:
+                xSize = sizeof( long );
+                break;
+
+            case eLoggingLongLong:
+                xSize = sizeof( long long );
+                break;
+
+            case eLoggingSize:
+                xSize = sizeof( size_t );
+                break;
+
+            case eLoggingIntMax:
+                xSize = sizeof( intmax_t );
+                break;
+
+            case eLoggingPtrDiff:
+                xSize = sizeof( ptrdiff_t );
+                break;
+
+            case eLoggingDouble:
+                xSize = sizeof( double );
+                break;
+
+            case eLoggingLongDouble:
+                xSize = sizeof( long double );
+                break;
+
+            case eLoggingPointer:
+                xSize = sizeof( void * );
+                break;
+
+            case eLoggingString:
+
+                /* The copy ends with its NULL, at the latest where the
+                 * arguments end. */
+                xSize = 0;
+
+                while( ( ( xRead + xSize ) < pxRecord->usArgumentsLength ) && ( pucArguments[ xRead + xSize ] != '\0' ) )
+                {
+                    xSize++;
+                }
+
+                if( ( xRead + xSize ) < pxRecord->usArgumentsLength )
+                {
+                    xSize++;
+                }
+                else
+                {
+                    xStop = pdTRUE;
+                }
+
+                break;
+
+            case eLoggingCount:
+                xSize = 0;
+                break;
+
+            default:
+                xSize = sizeof( int );
+                break;
+        }
+
+        if( ( xStop == pdTRUE ) || ( ( pxRecord->usArgumentsLength - xRead ) < xSize ) )
+        {
+            /* The arguments were cut short when the message was logged. */
+            break;
+        }
+
+        if( xSpecifier.xArgument != eLoggingString )
+        {
+            memcpy( &xValue, &pucArguments[ xRead ], xSize );
+        }
+
+        switch( xSpecifier.xArgument )
+        {
+            case eLoggingLong:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.lLong );
+                break;
+
+            case eLoggingLongLong:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.llLongLong );
+                break;
+
+            case eLoggingSize:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.xSize );
+                break;
+
+            case eLoggingIntMax:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.xIntMax );
+                break;
+
+            case eLoggingPtrDiff:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.xPtrDiff );
+                break;
+
+            case eLoggingDouble:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.dDouble );
+                break;
+
+            case eLoggingLongDouble:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.ldLongDouble );
+                break;
+
+            case eLoggingPointer:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.pvPointer );
+                break;
+
+            case eLoggingString:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, ( const char * ) &pucArguments[ xRead ] );
+                break;
+
+            case eLoggingCount:
+                iLength = 0;
+                break;
+
+            default:
+                iLength = snprintf( &cOutputBuffer[ xUsed ], sizeof( cOutputBuffer ) - xUsed, cSpecifier, xValue.iInt );
+                break;
+        }
+
+        xRead += xSize;
+
+        if( iLength > 0 )
+        {
+            xUsed += ( size_t ) iLength;
+        }
+    }
+
+    /* snprintf() truncates and terminates, but may report the length it
+     * would have needed. */
+    if( xUsed >= sizeof( cOutputBuffer ) )
+    {
+        xUsed = sizeof( cOutputBuffer ) - 1;
+    }
+
+    cOutputBuffer[ xUsed ] = '\0';
+}
+/*-----------------------------------------------------------*/
+
+#endif /* if ( configLOGGING_OUTPUT_BINARY == 0 ) */
+
+/*!
+ * \brief Stores a message and its arguments in the log buffer.
+ *
+ * The message number, time (in ticks), and task that
+ * called vLoggingPrintf are added to the beginning of
+ * each print statement when it is output.
+ *
+ */
+void vLoggingPrintf( const char * pcFormat,
+                     ... )
+{
+    va_list args;
+    uint8_t ucArguments[ configLOGGING_MAX_MESSAGE_LENGTH ];
+    size_t xArgumentsLength;
+
+    /* There are a variable number of parameters. */
+    va_start( args, pcFormat );
+    xArgumentsLength = prvCaptureArguments( pcFormat, args, ucArguments, sizeof( ucArguments ) );
+    va_end( args );
+
+    prvWriteRecord( pcFormat,
+                    ( strcmp( pcFormat, "\n" ) == 0 ) ? loggingFLAG_NO_PREFIX : 0,
+                    ucArguments,
+                    xArgumentsLength,
+                    pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrintfFromISR( const char * pcFormat,
+                            ... )
+{
+    va_list args;
+    uint8_t ucArguments[ configLOGGING_MAX_MESSAGE_LENGTH ];
+    size_t xArgumentsLength;
+
+    va_start( args, pcFormat );
+    xArgumentsLength = prvCaptureArguments( pcFormat, args, ucArguments, sizeof( ucArguments ) );
+    va_end( args );
+
+    prvWriteRecord( pcFormat,
+                    ( strcmp( pcFormat, "\n" ) == 0 ) ? loggingFLAG_NO_PREFIX : 0,
+                    ucArguments,
+                    xArgumentsLength,
+                    pdTRUE );
+}
+/*-----------------------------------------------------------*/
+
+void vLoggingPrint( const char * pcMessage )
+{
+    uint8_t ucArguments[ configLOGGING_MAX_MESSAGE_LENGTH ];
+    size_t xLength;
+
+    /* Stored as the argument of "%s", so it is output without a prefix and
+     * truncated to configLOGGING_MAX_MESSAGE_LENGTH like any other message. */
+    xLength = strlen( pcMessage );
+
+    if( xLength >= sizeof( ucArguments ) )
+    {
+        xLength = sizeof( ucArguments ) - 1;
     }
+
+    memcpy( ucArguments, pcMessage, xLength );
+    ucArguments[ xLength ] = '\0';
+
+    prvWriteRecord( "%s", loggingFLAG_NO_PREFIX, ucArguments, xLength + 1, pdFALSE );
 }
+/*-----------------------------------------------------------*/
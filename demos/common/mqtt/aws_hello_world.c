@@ -76,6 +76,7 @@
 /* Demo includes. */
 #include "aws_demo_config.h"
 #include "aws_hello_world.h"
+#include "aws_telemetry.h"
 
 /**
  * @brief MQTT client ID.
@@ -360,6 +361,8 @@ static BaseType_t prvSubscribe( void )
     /* Subscribe to the topic. */
     xReturned = MQTT_AGENT_Subscribe( xMQTTHandle,
                                       &xSubscribeParams,
+                                      1,
+                                      NULL,
                                       democonfigMQTT_TIMEOUT );
 
     if( xReturned == eMQTTAgentSuccess )
@@ -480,6 +483,10 @@ static void prvMQTTConnectAndPublishTask( void * pvParameters )
 
     if( xReturned == pdPASS )
     {
+        /* Report the CPU and memory use of the device over the same
+         * connection while the demo runs. */
+        ( void ) xTelemetryStart( xMQTTHandle );
+
         /* MQTT client is now connected to a broker.  Publish a message
          * every five seconds until a minute has elapsed. */
         for( xX = 0; xX < xIterationsInAMinute; xX++ )
@@ -491,7 +498,8 @@ static void prvMQTTConnectAndPublishTask( void * pvParameters )
         }
     }
 
-    /* Disconnect the client. */
+    /* Disconnect the client, once the telemetry task no longer uses it. */
+    vTelemetryStop();
     ( void ) MQTT_AGENT_Disconnect( xMQTTHandle, democonfigMQTT_TIMEOUT );
 
     /* End the demo by deleting all created resources. */
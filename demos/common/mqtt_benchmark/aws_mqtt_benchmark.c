@@ -0,0 +1,407 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_benchmark.c
+ * @brief Publish throughput of the MQTT agent.
+ *
+ * The task connects to the broker and then starts
+ * democonfigMQTT_BENCHMARK_PUBLISHERS tasks, which each publish
+ * democonfigMQTT_BENCHMARK_PUBLISHES messages as fast as the MQTT agent takes
+ * them.  It does so once with QoS 0 and once with QoS 1, and prints how many
+ * publishes per second went out in each case.  It then publishes as many QoS 1
+ * messages from its own task with MQTT_AGENT_PublishAsync, keeping up to
+ * mqttconfigMAX_PARALLEL_OPS of them awaiting their PUBACK.
+ *
+ * The publishers run at the priority of the MQTT task, so the commands of
+ * several of them are queued by the time it runs.  That is the case the MQTT
+ * task batches, see mqttconfigMQTT_TASK_MAX_COMMANDS_PER_WAKEUP and
+ * mqttconfigTX_COALESCE_BUFFER_SIZE.  Setting those to 1 and 0 gives the
+ * figures of a task that processes one command per wake up and sends each
+ * packet on its own.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* MQTT includes. */
+#include "aws_mqtt_agent.h"
+#include "aws_mqtt_agent_config.h"
+
+/* Credentials includes. */
+#include "aws_clientcredential.h"
+
+/* Demo includes. */
+#include "aws_demo_config.h"
+#include "aws_mqtt_benchmark.h"
+
+/**
+ * @brief The MQTT client identifier used by the benchmark.
+ */
+#define benchmarkCLIENT_ID         ( ( const uint8_t * ) "MQTTBenchmark" )
+
+/**
+ * @brief The topic the benchmark publishes to.
+ */
+#define benchmarkTOPIC_NAME        ( ( const uint8_t * ) "freertos/benchmark/" clientcredentialIOT_THING_NAME )
+
+/**
+ * @brief Length of the payload of each publish, about that of a small sensor
+ * reading.
+ */
+#define benchmarkPAYLOAD_LENGTH    ( 64 )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Implements the benchmark task.
+ *
+ * @param[in] pvParameters Not used.
+ */
+static void prvMQTTBenchmarkTask( void * pvParameters );
+
+/**
+ * @brief Implements the publisher tasks.
+ *
+ * Each publishes democonfigMQTT_BENCHMARK_PUBLISHES messages with the QoS of
+ * the current run, gives xPublishersDone and deletes itself.
+ *
+ * @param[in] pvParameters Not used.
+ */
+static void prvPublisherTask( void * pvParameters );
+
+/**
+ * @brief Runs the publisher tasks with the given QoS and prints the rate at
+ * which they published.
+ *
+ * @param[in] xQoS The QoS of the publishes.
+ */
+static void prvMeasure( MQTTQoS_t xQoS );
+
+/**
+ * @brief Publishes as many QoS 1 messages as all the publisher tasks do in
+ * prvMeasure, but from the calling task with MQTT_AGENT_PublishAsync, and
+ * prints the rate at which it published.
+ */
+static void prvMeasureAsync( void );
+
+/**
+ * @brief Completion callback of the publishes of prvMeasureAsync.
+ *
+ * Counts a failed publish and gives xPublishWindow back.
+ *
+ * @param[in] pvCallbackContext Not used.
+ * @param[in] xRequestHandle Not used.
+ * @param[in] xResult The result of the publish.
+ */
+static void prvPublishComplete( void * pvCallbackContext,
+                                MQTTAgentRequestHandle_t xRequestHandle,
+                                MQTTAgentReturnCode_t xResult );
+
+/**
+ * @brief Prints the result of a run.
+ *
+ * @param[in] pcRun Describes the run.
+ * @param[in] ulPublishes The number of publishes attempted.
+ * @param[in] uxTasks The number of tasks that published.
+ * @param[in] xStartTicks The tick count when the run started.
+ */
+static void prvPrintResult( const char * pcRun,
+                            uint32_t ulPublishes,
+                            UBaseType_t uxTasks,
+                            TickType_t xStartTicks );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The MQTT client the publishers share.
+ */
+static MQTTAgentHandle_t xMQTTHandle = NULL;
+
+/**
+ * @brief Given by each publisher task once it is done.
+ *
+ * The publisher tasks wait on the MQTT agent, which uses their task
+ * notifications, so they report through a semaphore instead.
+ */
+static SemaphoreHandle_t xPublishersDone = NULL;
+
+/**
+ * @brief Counts the publishes prvMeasureAsync may still start before one of
+ * those in flight completes.
+ */
+static SemaphoreHandle_t xPublishWindow = NULL;
+
+/**
+ * @brief The QoS of the current run.
+ */
+static MQTTQoS_t xRunQoS = eMQTTQoS0;
+
+/**
+ * @brief Number of publishes of the current run that failed.  Updated in a
+ * critical section as every publisher task, or the MQTT task through
+ * prvPublishComplete, adds to it.
+ */
+static uint32_t ulFailedPublishes = 0;
+
+/**
+ * @brief The payload of every publish.
+ */
+static uint8_t ucPayload[ benchmarkPAYLOAD_LENGTH ];
+/*-----------------------------------------------------------*/
+
+static void prvPublisherTask( void * pvParameters )
+{
+    MQTTAgentPublishParams_t xPublishParameters;
+    uint32_t ulPublish, ulFailed = 0;
+
+    ( void ) pvParameters;
+
+    memset( &( xPublishParameters ), 0x00, sizeof( xPublishParameters ) );
+    xPublishParameters.pucTopic = benchmarkTOPIC_NAME;
+    xPublishParameters.usTopicLength = ( uint16_t ) strlen( ( const char * ) benchmarkTOPIC_NAME );
+    xPublishParameters.pvData = ucPayload;
+    xPublishParameters.ulDataLength = ( uint32_t ) sizeof( ucPayload );
+    xPublishParameters.xQoS = xRunQoS;
+
+    for( ulPublish = 0; ulPublish < ( uint32_t ) democonfigMQTT_BENCHMARK_PUBLISHES; ulPublish++ )
+    {
+        if( MQTT_AGENT_Publish( xMQTTHandle, &( xPublishParameters ), democonfigMQTT_TIMEOUT ) != eMQTTAgentSuccess )
+        {
+            ulFailed++;
+        }
+    }
+
+    taskENTER_CRITICAL();
+    {
+        ulFailedPublishes += ulFailed;
+    }
+    taskEXIT_CRITICAL();
+
+    ( void ) xSemaphoreGive( xPublishersDone );
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintResult( const char * pcRun,
+                            uint32_t ulPublishes,
+                            UBaseType_t uxTasks,
+                            TickType_t xStartTicks )
+{
+    TickType_t xElapsedTicks;
+    uint32_t ulElapsedMs, ulPublishesPerSecond;
+
+    xElapsedTicks = xTaskGetTickCount() - xStartTicks;
+
+    /* Only count the publishes that went out. */
+    ulPublishes -= ulFailedPublishes;
+    ulElapsedMs = ( uint32_t ) xElapsedTicks * ( uint32_t ) portTICK_PERIOD_MS;
+    ulPublishesPerSecond = ( ulElapsedMs > 0UL ) ? ( uint32_t ) ( ( ( uint64_t ) ulPublishes * 1000ULL ) / ulElapsedMs ) : 0UL;
+
+    configPRINTF( ( "%s: %u publishes by %u tasks in %u ms, %u per second, %u failed.\r\n",
+                    pcRun,
+                    ( unsigned ) ulPublishes,
+                    ( unsigned ) uxTasks,
+                    ( unsigned ) ulElapsedMs,
+                    ( unsigned ) ulPublishesPerSecond,
+                    ( unsigned ) ulFailedPublishes ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasure( MQTTQoS_t xQoS )
+{
+    UBaseType_t uxPublisher, uxPublishers = 0;
+    TickType_t xStartTicks;
+
+    xRunQoS = xQoS;
+    ulFailedPublishes = 0;
+    xStartTicks = xTaskGetTickCount();
+
+    for( uxPublisher = 0; uxPublisher < ( UBaseType_t ) democonfigMQTT_BENCHMARK_PUBLISHERS; uxPublisher++ )
+    {
+        if( xTaskCreate( prvPublisherTask,
+                         "MQTTPub",
+                         democonfigMQTT_BENCHMARK_TASK_STACK_SIZE,
+                         NULL,
+                         democonfigMQTT_BENCHMARK_PUBLISHER_PRIORITY,
+                         NULL ) == pdPASS )
+        {
+            uxPublishers++;
+        }
+    }
+
+    for( uxPublisher = 0; uxPublisher < uxPublishers; uxPublisher++ )
+    {
+        ( void ) xSemaphoreTake( xPublishersDone, portMAX_DELAY );
+    }
+
+    prvPrintResult( ( xQoS == eMQTTQoS0 ) ? "QoS 0" : "QoS 1",
+                    ( uint32_t ) uxPublishers * ( uint32_t ) democonfigMQTT_BENCHMARK_PUBLISHES,
+                    uxPublishers,
+                    xStartTicks );
+}
+/*-----------------------------------------------------------*/
+
+static void prvPublishComplete( void * pvCallbackContext,
+                                MQTTAgentRequestHandle_t xRequestHandle,
+                                MQTTAgentReturnCode_t xResult )
+{
+    ( void ) pvCallbackContext;
+    ( void ) xRequestHandle;
+
+    if( xResult != eMQTTAgentSuccess )
+    {
+        taskENTER_CRITICAL();
+        {
+            ulFailedPublishes++;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    ( void ) xSemaphoreGive( xPublishWindow );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMeasureAsync( void )
+{
+    MQTTAgentPublishParams_t xPublishParameters;
+    TickType_t xStartTicks;
+    uint32_t ulPublish, ulPublishes;
+    UBaseType_t uxSlot;
+
+    memset( &( xPublishParameters ), 0x00, sizeof( xPublishParameters ) );
+    xPublishParameters.pucTopic = benchmarkTOPIC_NAME;
+    xPublishParameters.usTopicLength = ( uint16_t ) strlen( ( const char * ) benchmarkTOPIC_NAME );
+    xPublishParameters.pvData = ucPayload;
+    xPublishParameters.ulDataLength = ( uint32_t ) sizeof( ucPayload );
+    xPublishParameters.xQoS = eMQTTQoS1;
+
+    ulPublishes = ( uint32_t ) democonfigMQTT_BENCHMARK_PUBLISHERS * ( uint32_t ) democonfigMQTT_BENCHMARK_PUBLISHES;
+    ulFailedPublishes = 0;
+    xStartTicks = xTaskGetTickCount();
+
+    for( ulPublish = 0; ulPublish < ulPublishes; ulPublish++ )
+    {
+        /* Wait for a free slot.  xPublishParameters stays valid until every
+         * publish has completed, as required by MQTT_AGENT_PublishAsync. */
+        ( void ) xSemaphoreTake( xPublishWindow, portMAX_DELAY );
+
+        if( MQTT_AGENT_PublishAsync( xMQTTHandle,
+                                     &( xPublishParameters ),
+                                     democonfigMQTT_TIMEOUT,
+                                     prvPublishComplete,
+                                     NULL,
+                                     NULL ) != eMQTTAgentSuccess )
+        {
+            /* prvPublishComplete will not be called for this one. */
+            prvPublishComplete( NULL, 0, eMQTTAgentFailure );
+        }
+    }
+
+    /* Wait for the publishes still in flight. */
+    for( uxSlot = 0; uxSlot < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; uxSlot++ )
+    {
+        ( void ) xSemaphoreTake( xPublishWindow, portMAX_DELAY );
+    }
+
+    prvPrintResult( "QoS 1 async", ulPublishes, 1, xStartTicks );
+
+    for( uxSlot = 0; uxSlot < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; uxSlot++ )
+    {
+        ( void ) xSemaphoreGive( xPublishWindow );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvMQTTBenchmarkTask( void * pvParameters )
+{
+    static StaticSemaphore_t xPublishersDoneBuffer;
+    static StaticSemaphore_t xPublishWindowBuffer;
+    MQTTAgentConnectParams_t xConnectParameters =
+    {
+        clientcredentialMQTT_BROKER_ENDPOINT, /* The URL of the MQTT broker to connect to. */
+        democonfigMQTT_AGENT_CONNECT_FLAGS,   /* Connection flags. */
+        pdFALSE,                              /* Deprecated. */
+        clientcredentialMQTT_BROKER_PORT,     /* Port number on which the MQTT broker is listening. Can be overridden by ALPN connection flag. */
+        benchmarkCLIENT_ID,                   /* Client Identifier of the MQTT client. It should be unique per broker. */
+        0,                                    /* The length of the client Id, filled in later as not const. */
+        pdFALSE,                              /* Deprecated. */
+        NULL,                                 /* User data supplied to the callback. Can be NULL. */
+        NULL,                                 /* Callback used to report various events. Can be NULL. */
+        NULL,                                 /* Certificate used for secure connection. Can be NULL. */
+        0                                     /* Size of certificate used for secure connection. */
+    };
+
+    ( void ) pvParameters;
+
+    memset( ucPayload, ( int ) 'x', sizeof( ucPayload ) );
+    xPublishersDone = xSemaphoreCreateCountingStatic( ( UBaseType_t ) democonfigMQTT_BENCHMARK_PUBLISHERS, 0, &( xPublishersDoneBuffer ) );
+    xPublishWindow = xSemaphoreCreateCountingStatic( ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS,
+                                                     ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS,
+                                                     &( xPublishWindowBuffer ) );
+
+    if( MQTT_AGENT_Create( &xMQTTHandle ) == eMQTTAgentSuccess )
+    {
+        xConnectParameters.usClientIdLength = ( uint16_t ) strlen( ( const char * ) benchmarkCLIENT_ID );
+
+        if( MQTT_AGENT_Connect( xMQTTHandle,
+                                &( xConnectParameters ),
+                                democonfigMQTT_ECHO_TLS_NEGOTIATION_TIMEOUT ) == eMQTTAgentSuccess )
+        {
+            prvMeasure( eMQTTQoS0 );
+            prvMeasure( eMQTTQoS1 );
+            prvMeasureAsync();
+
+            ( void ) MQTT_AGENT_Disconnect( xMQTTHandle, democonfigMQTT_TIMEOUT );
+        }
+        else
+        {
+            configPRINTF( ( "ERROR:  MQTT benchmark failed to connect.\r\n" ) );
+        }
+
+        ( void ) MQTT_AGENT_Delete( xMQTTHandle );
+        xMQTTHandle = NULL;
+    }
+
+    configPRINTF( ( "MQTT benchmark finished.\r\n" ) );
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vStartMQTTBenchmarkDemo( void )
+{
+    configPRINTF( ( "Creating MQTT Benchmark Task...\r\n" ) );
+
+    ( void ) xTaskCreate( prvMQTTBenchmarkTask,                     /* The function that implements the demo task. */
+                          "MQTTBench",                              /* The name to assign to the task being created. */
+                          democonfigMQTT_BENCHMARK_TASK_STACK_SIZE, /* The size, in WORDS (not bytes), of the stack to allocate for the task being created. */
+                          NULL,                                     /* The task parameter is not being used. */
+                          democonfigMQTT_BENCHMARK_TASK_PRIORITY,   /* The priority at which the task being created will run. */
+                          NULL );                                   /* Not storing the task's handle. */
+}
+/*-----------------------------------------------------------*/
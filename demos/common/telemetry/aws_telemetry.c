@@ -0,0 +1,462 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_telemetry.c
+ * @brief Periodic snapshots of the CPU and memory use of the device.
+ *
+ * The task reads the state of every task with uxTaskGetSystemState(), the
+ * free heap and the occupancy of the buffer pool, encodes them as CBOR and
+ * publishes the result over an MQTT connection owned by the application.
+ * See aws_telemetry.h for the content of a snapshot.
+ *
+ * Everything is encoded into static buffers, so taking a snapshot does not
+ * move the heap figures it reports.  Per task CPU use relies on the run time
+ * statistics clock, see configGENERATE_RUN_TIME_STATS.  Without it the run
+ * time fields are all 0.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "event_groups.h"
+
+/* MQTT includes. */
+#include "aws_mqtt_agent.h"
+
+/* Buffer pool includes. */
+#include "aws_bufferpool.h"
+
+/* Credentials includes. */
+#include "aws_clientcredential.h"
+
+/* Demo includes. */
+#include "aws_demo_config.h"
+#include "aws_telemetry.h"
+
+#if ( configUSE_TRACE_FACILITY != 1 )
+    #error configUSE_TRACE_FACILITY must be set to 1 in FreeRTOSConfig.h to use the telemetry task, as it needs uxTaskGetSystemState().
+#endif
+
+/**
+ * @brief The largest number of tasks reported.
+ *
+ * uxTaskGetSystemState() reports nothing at all when there are more tasks,
+ * so it should allow for every task the application may create.
+ */
+#ifndef democonfigTELEMETRY_MAX_TASKS
+    #define democonfigTELEMETRY_MAX_TASKS         ( 16 )
+#endif
+
+/**
+ * @brief The size of the buffer a snapshot is encoded into.
+ *
+ * Each task takes up to about 45 bytes.  Tasks that do not fit are left out
+ * of the snapshot.
+ */
+#ifndef democonfigTELEMETRY_PAYLOAD_LENGTH
+    #define democonfigTELEMETRY_PAYLOAD_LENGTH    ( 768 )
+#endif
+
+/**
+ * @brief The topic snapshots are published to.
+ */
+#define telemetryTOPIC_NAME          ( ( const uint8_t * ) "freertos/telemetry/" clientcredentialIOT_THING_NAME )
+
+/**
+ * @brief Size classes of the buffer pool reported.
+ */
+#define telemetryMAX_POOL_CLASSES    ( 3 )
+
+/**
+ * @brief Event bits used to stop the task.
+ */
+#define telemetrySTOP_BIT            ( ( EventBits_t ) 0x01 )
+#define telemetrySTOPPED_BIT         ( ( EventBits_t ) 0x02 )
+
+/**
+ * @brief CBOR major types used by the snapshot.
+ */
+#define telemetryCBOR_UNSIGNED       ( ( uint8_t ) 0x00 )
+#define telemetryCBOR_TEXT           ( ( uint8_t ) 0x60 )
+#define telemetryCBOR_ARRAY          ( ( uint8_t ) 0x80 )
+#define telemetryCBOR_MAP            ( ( uint8_t ) 0xA0 )
+
+/**
+ * @brief Start and end of an array whose length is not known up front.
+ */
+#define telemetryCBOR_ARRAY_START    ( ( uint8_t ) 0x9F )
+#define telemetryCBOR_BREAK          ( ( uint8_t ) 0xFF )
+
+/**
+ * @brief Number of entries of the snapshot map.
+ */
+#define telemetrySNAPSHOT_ENTRIES    ( 5 )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A CBOR encoder writing to a fixed buffer.
+ *
+ * Writes that do not fit fail without writing anything.
+ */
+typedef struct CborWriter
+{
+    uint8_t * pucBuffer; /**< The buffer written to. */
+    size_t xLength;      /**< The usable length of pucBuffer. */
+    size_t xUsed;        /**< The number of bytes written so far. */
+} CborWriter_t;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Implements the task that publishes snapshots until it is stopped.
+ *
+ * @param[in] pvParameters Unused.
+ */
+static void prvTelemetryTask( void * pvParameters );
+
+/**
+ * @brief Takes a snapshot and publishes it.
+ */
+static void prvPublishSnapshot( void );
+
+/**
+ * @brief Encodes a snapshot into ucPayload.
+ *
+ * @return The length of the snapshot, or 0 if ucPayload is too small.
+ */
+static size_t prvEncodeSnapshot( void );
+
+/**
+ * @brief Writes the head of a CBOR data item, its type and its value or
+ * length, in the shortest form.
+ *
+ * @return pdPASS if it fitted, pdFAIL otherwise.
+ */
+static BaseType_t prvCborHead( CborWriter_t * pxWriter,
+                               uint8_t ucMajorType,
+                               uint32_t ulValue );
+
+/**
+ * @brief Writes a CBOR text string.
+ *
+ * @return pdPASS if it fitted, pdFAIL otherwise.
+ */
+static BaseType_t prvCborText( CborWriter_t * pxWriter,
+                               const char * pcText );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The MQTT client snapshots are published with.
+ */
+static MQTTAgentHandle_t xTelemetryMQTTHandle = NULL;
+
+/**
+ * @brief The telemetry task, NULL when it is not running.
+ */
+static TaskHandle_t xTelemetryTask = NULL;
+
+/**
+ * @brief Used to tell the task to stop, and to wait for it to have stopped.
+ *
+ * Task notifications cannot be used, as the MQTT agent uses them to wake the
+ * tasks that call it.
+ */
+static EventGroupHandle_t xTelemetryEvents = NULL;
+static StaticEventGroup_t xTelemetryEventsBuffer;
+
+/**
+ * @brief Only used by the telemetry task, to take and encode a snapshot.
+ */
+static TaskStatus_t xTaskStatus[ democonfigTELEMETRY_MAX_TASKS ];
+static uint8_t ucPayload[ democonfigTELEMETRY_PAYLOAD_LENGTH ];
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCborHead( CborWriter_t * pxWriter,
+                               uint8_t ucMajorType,
+                               uint32_t ulValue )
+{
+    BaseType_t xReturn = pdPASS;
+    size_t xValueLength, x;
+    uint8_t ucAdditional;
+
+    if( ulValue < 24UL )
+    {
+        xValueLength = 0;
+        ucAdditional = ( uint8_t ) ulValue;
+    }
+    else if( ulValue <= 0xFFUL )
+    {
+        xValueLength = 1;
+        ucAdditional = 24;
+    }
+    else if( ulValue <= 0xFFFFUL )
+    {
+        xValueLength = 2;
+        ucAdditional = 25;
+    }
+    else
+    {
+        xValueLength = 4;
+        ucAdditional = 26;
+    }
+
+    if( ( pxWriter->xLength - pxWriter->xUsed ) < ( 1 + xValueLength ) )
+    {
+        xReturn = pdFAIL;
+    }
+    else
+    {
+        pxWriter->pucBuffer[ pxWriter->xUsed++ ] = ucMajorType | ucAdditional;
+
+        /* CBOR values are big endian. */
+        for( x = xValueLength; x > 0; x-- )
+        {
+            pxWriter->pucBuffer[ pxWriter->xUsed++ ] = ( uint8_t ) ( ulValue >> ( ( x - 1 ) * 8 ) );
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCborText( CborWriter_t * pxWriter,
+                               const char * pcText )
+{
+    BaseType_t xReturn;
+    size_t xTextLength = strlen( pcText );
+
+    xReturn = prvCborHead( pxWriter, telemetryCBOR_TEXT, ( uint32_t ) xTextLength );
+
+    if( xReturn == pdPASS )
+    {
+        if( ( pxWriter->xLength - pxWriter->xUsed ) < xTextLength )
+        {
+            xReturn = pdFAIL;
+        }
+        else
+        {
+            memcpy( &pxWriter->pucBuffer[ pxWriter->xUsed ], pcText, xTextLength );
+            pxWriter->xUsed += xTextLength;
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvEncodeSnapshot( void )
+{
+    CborWriter_t xWriter;
+    BufferPoolStats_t xPoolStats[ telemetryMAX_POOL_CLASSES ];
+    UBaseType_t uxTasks, x;
+    uint32_t ulTotalRunTime = 0, ulPoolClasses;
+    size_t xTaskStart;
+    BaseType_t xFits;
+
+    /* One byte is kept back to close the task array, which is left open so
+     * that tasks can stop being added when the buffer is full. */
+    xWriter.pucBuffer = ucPayload;
+    xWriter.xLength = sizeof( ucPayload ) - 1;
+    xWriter.xUsed = 0;
+
+    uxTasks = uxTaskGetSystemState( xTaskStatus, democonfigTELEMETRY_MAX_TASKS, &ulTotalRunTime );
+
+    if( uxTasks == 0 )
+    {
+        configPRINTF( ( "Telemetry: more than %d tasks, increase democonfigTELEMETRY_MAX_TASKS.\r\n", democonfigTELEMETRY_MAX_TASKS ) );
+    }
+
+    ulPoolClasses = BUFFERPOOL_GetStats( xPoolStats, telemetryMAX_POOL_CLASSES );
+
+    xFits = prvCborHead( &xWriter, telemetryCBOR_MAP, telemetrySNAPSHOT_ENTRIES );
+    xFits &= prvCborText( &xWriter, "up" );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xTaskGetTickCount() );
+    xFits &= prvCborText( &xWriter, "rt" );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ulTotalRunTime );
+    xFits &= prvCborText( &xWriter, "heap" );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_ARRAY, 2 );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xPortGetFreeHeapSize() );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xPortGetMinimumEverFreeHeapSize() );
+    xFits &= prvCborText( &xWriter, "pool" );
+    xFits &= prvCborHead( &xWriter, telemetryCBOR_ARRAY, ulPoolClasses );
+
+    for( x = 0; x < ulPoolClasses; x++ )
+    {
+        xFits &= prvCborHead( &xWriter, telemetryCBOR_ARRAY, 4 );
+        xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, xPoolStats[ x ].ulBufferSize );
+        xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, xPoolStats[ x ].ulNumBuffers );
+        xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, xPoolStats[ x ].ulInUse );
+        xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, xPoolStats[ x ].ulMaxInUse );
+    }
+
+    xFits &= prvCborText( &xWriter, "tasks" );
+
+    if( ( xFits == pdPASS ) && ( xWriter.xUsed < xWriter.xLength ) )
+    {
+        xWriter.pucBuffer[ xWriter.xUsed++ ] = telemetryCBOR_ARRAY_START;
+
+        for( x = 0; x < uxTasks; x++ )
+        {
+            /* A task that does not fit is removed again. */
+            xTaskStart = xWriter.xUsed;
+
+            xFits = prvCborHead( &xWriter, telemetryCBOR_ARRAY, 6 );
+            xFits &= prvCborText( &xWriter, xTaskStatus[ x ].pcTaskName );
+            xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xTaskStatus[ x ].xTaskNumber );
+            xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xTaskStatus[ x ].uxCurrentPriority );
+            xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xTaskStatus[ x ].eCurrentState );
+            xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, xTaskStatus[ x ].ulRunTimeCounter );
+            xFits &= prvCborHead( &xWriter, telemetryCBOR_UNSIGNED, ( uint32_t ) xTaskStatus[ x ].usStackHighWaterMark * sizeof( StackType_t ) );
+
+            if( xFits != pdPASS )
+            {
+                xWriter.xUsed = xTaskStart;
+                break;
+            }
+        }
+
+        /* The byte kept back. */
+        xWriter.pucBuffer[ xWriter.xUsed++ ] = telemetryCBOR_BREAK;
+    }
+    else
+    {
+        xWriter.xUsed = 0;
+    }
+
+    return xWriter.xUsed;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPublishSnapshot( void )
+{
+    MQTTAgentPublishParams_t xPublishParameters;
+    MQTTAgentReturnCode_t xReturned;
+    size_t xLength;
+
+    xLength = prvEncodeSnapshot();
+
+    if( xLength == 0 )
+    {
+        configPRINTF( ( "ERROR:  Telemetry snapshot does not fit in democonfigTELEMETRY_PAYLOAD_LENGTH.\r\n" ) );
+    }
+    else
+    {
+        /* Snapshots are sent periodically, so a lost one is not sent again. */
+        memset( &( xPublishParameters ), 0x00, sizeof( xPublishParameters ) );
+        xPublishParameters.pucTopic = telemetryTOPIC_NAME;
+        xPublishParameters.usTopicLength = ( uint16_t ) strlen( ( const char * ) telemetryTOPIC_NAME );
+        xPublishParameters.pvData = ucPayload;
+        xPublishParameters.ulDataLength = ( uint32_t ) xLength;
+        xPublishParameters.xQoS = eMQTTQoS0;
+
+        xReturned = MQTT_AGENT_Publish( xTelemetryMQTTHandle,
+                                        &( xPublishParameters ),
+                                        democonfigMQTT_TIMEOUT );
+
+        if( xReturned != eMQTTAgentSuccess )
+        {
+            configPRINTF( ( "ERROR:  Telemetry failed to publish a snapshot with error %d.\r\n", xReturned ) );
+        }
+
+        /* Remove compiler warnings in case configPRINTF() is not defined. */
+        ( void ) xReturned;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTelemetryTask( void * pvParameters )
+{
+    EventBits_t xBits = 0;
+
+    /* Avoid compiler warnings about unused parameters. */
+    ( void ) pvParameters;
+
+    while( ( xBits & telemetrySTOP_BIT ) == 0 )
+    {
+        prvPublishSnapshot();
+
+        xBits = xEventGroupWaitBits( xTelemetryEvents,
+                                     telemetrySTOP_BIT,
+                                     pdTRUE,  /* Clear the bit. */
+                                     pdFALSE, /* Any of the bits. */
+                                     democonfigTELEMETRY_PERIOD );
+    }
+
+    xTelemetryTask = NULL;
+    ( void ) xEventGroupSetBits( xTelemetryEvents, telemetrySTOPPED_BIT );
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTelemetryStart( MQTTAgentHandle_t xMQTTHandle )
+{
+    BaseType_t xReturn = pdFAIL;
+
+    configASSERT( xMQTTHandle != NULL );
+
+    if( xTelemetryEvents == NULL )
+    {
+        xTelemetryEvents = xEventGroupCreateStatic( &xTelemetryEventsBuffer );
+    }
+
+    if( xTelemetryTask == NULL )
+    {
+        xTelemetryMQTTHandle = xMQTTHandle;
+        ( void ) xEventGroupClearBits( xTelemetryEvents, telemetrySTOP_BIT | telemetrySTOPPED_BIT );
+
+        xReturn = xTaskCreate( prvTelemetryTask,                    /* The function that implements the task. */
+                               "Telemetry",                         /* Human readable name for the task. */
+                               democonfigTELEMETRY_TASK_STACK_SIZE, /* Size of the stack to allocate for the task, in words not bytes! */
+                               NULL,                                /* The task parameter is not used. */
+                               democonfigTELEMETRY_TASK_PRIORITY,   /* The priority at which the task runs. */
+                               &( xTelemetryTask ) );               /* Kept so the task is only created once. */
+
+        if( xReturn != pdPASS )
+        {
+            xTelemetryTask = NULL;
+            configPRINTF( ( "Telemetry task could not be created - out of heap space?\r\n" ) );
+        }
+    }
+
+    return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTelemetryStop( void )
+{
+    if( xTelemetryTask != NULL )
+    {
+        ( void ) xEventGroupSetBits( xTelemetryEvents, telemetrySTOP_BIT );
+        ( void ) xEventGroupWaitBits( xTelemetryEvents,
+                                      telemetrySTOPPED_BIT,
+                                      pdTRUE,  /* Clear the bit. */
+                                      pdFALSE, /* Any of the bits. */
+                                      portMAX_DELAY );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,337 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/*
+ * Linux simulator entry point.
+ *
+ * Every FreeRTOS task runs on its own pthread, see
+ * lib/FreeRTOS/portable/GCC/POSIX/port.c.  The network stack of the host
+ * is used directly, so there is no network interface to bring up before
+ * the demos start.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+/* Demo includes */
+#include "aws_hello_world.h"
+#include "aws_system_init.h"
+#include "aws_logging_task.h"
+#include "aws_dev_mode_key_provisioning.h"
+
+/* Application version info. */
+#include "aws_application_version.h"
+
+/* Declare the firmware version structure for all to see. */
+const AppVersion32_t xAppFirmwareVersion =
+{
+    .u.x.ucMajor = APP_VERSION_MAJOR,
+    .u.x.ucMinor = APP_VERSION_MINOR,
+    .u.x.usBuild = APP_VERSION_BUILD,
+};
+
+#define mainLOGGING_TASK_PRIORITY           ( configMAX_PRIORITIES - 1 )
+#define mainLOGGING_TASK_STACK_SIZE         ( configMINIMAL_STACK_SIZE * 5 )
+#define mainLOGGING_MESSAGE_QUEUE_LENGTH    ( 15 )
+
+/**
+ * @brief Time the idle task sleeps for on each iteration.
+ *
+ * Without it the idle task would keep one host core fully busy.  It is
+ * shorter than a tick so the tick is still serviced on time.
+ */
+#define mainIDLE_SLEEP_US                   ( 500 )
+
+/**
+ * @brief How often the counters of the tickless idle are logged.
+ */
+#define mainTICKLESS_STATS_PERIOD           pdMS_TO_TICKS( 60000 )
+/*-----------------------------------------------------------*/
+
+void vApplicationDaemonTaskStartupHook( void );
+
+/* Used by mbedTLS as its entropy source, see MBEDTLS_ENTROPY_HARDWARE_ALT. */
+int mbedtls_hardware_poll( void * data,
+                           unsigned char * output,
+                           size_t len,
+                           size_t * olen );
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+/**
+ * @brief Logs the counters of the tickless idle kept by the POSIX port.
+ *
+ * @param[in] xTimer The timer that expired.
+ */
+    static void prvLogTicklessIdleStats( TimerHandle_t xTimer );
+#endif
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Application runtime entry point.
+ */
+int main( void )
+{
+    #if ( configUSE_TICKLESS_IDLE == 1 )
+        static StaticTimer_t xTicklessStatsTimerBuffer;
+        TimerHandle_t xTicklessStatsTimer;
+    #endif
+
+    /* Create tasks that are not dependent on the network being initialized. */
+    xLoggingTaskInitialize( mainLOGGING_TASK_STACK_SIZE,
+                            mainLOGGING_TASK_PRIORITY,
+                            mainLOGGING_MESSAGE_QUEUE_LENGTH );
+
+    #if ( configUSE_TICKLESS_IDLE == 1 )
+        xTicklessStatsTimer = xTimerCreateStatic( "Tickless",
+                                                  mainTICKLESS_STATS_PERIOD,
+                                                  pdTRUE,
+                                                  NULL,
+                                                  prvLogTicklessIdleStats,
+                                                  &xTicklessStatsTimerBuffer );
+        ( void ) xTimerStart( xTicklessStatsTimer, 0 );
+    #endif
+
+    /* Start the scheduler.  Initialization that requires the OS to be running
+     * is performed in the RTOS daemon task startup hook. */
+    vTaskStartScheduler();
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationDaemonTaskStartupHook( void )
+{
+    /* A simple example to demonstrate key and certificate provisioning
+     * using PKCS#11 interface. This should be replaced by production ready
+     * key provisioning mechanism. */
+    vDevModeKeyProvisioning();
+
+    if( SYSTEM_Init() == pdPASS )
+    {
+        /* The board demo in App_RUNNER_Run() reads the ST sensors, so run
+         * the MQTT echo demo instead. */
+        vStartMQTTEchoDemo();
+    }
+    else
+    {
+        configPRINTF( ( "Failed to initialize the libraries.\r\n" ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_TICKLESS_IDLE == 1 )
+
+    static void prvLogTicklessIdleStats( TimerHandle_t xTimer )
+    {
+        PortTicklessIdleStats_t xStats;
+
+        ( void ) xTimer;
+
+        vPortGetTicklessIdleStats( &xStats );
+
+        configPRINTF( ( "Tickless idle: %u ticks suppressed in %u sleeps, longest %u, %u aborted.\r\n",
+                        ( unsigned ) xStats.ulSuppressedTicks,
+                        ( unsigned ) xStats.ulSleeps,
+                        ( unsigned ) xStats.ulLongestSleepTicks,
+                        ( unsigned ) xStats.ulAbortedSleeps ) );
+    }
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+/* configUSE_STATIC_ALLOCATION is set to 1, so the application must provide an
+ * implementation of vApplicationGetIdleTaskMemory() to provide the memory that is
+ * used by the Idle task. */
+void vApplicationGetIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
+                                    StackType_t ** ppxIdleTaskStackBuffer,
+                                    uint32_t * pulIdleTaskStackSize )
+{
+/* If the buffers to be provided to the Idle task are declared inside this
+ * function then they must be declared static - otherwise they will be allocated on
+ * the stack and so not exists after this function exits. */
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+    /* Pass out a pointer to the StaticTask_t structure in which the Idle
+     * task's state will be stored. */
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+
+    /* Pass out the array that will be used as the Idle task's stack. */
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+
+    /* Pass out the size of the array pointed to by *ppxIdleTaskStackBuffer.
+     * Note that, as the array is necessarily of type StackType_t,
+     * configMINIMAL_STACK_SIZE is specified in words, not bytes. */
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+/*-----------------------------------------------------------*/
+
+/* configUSE_STATIC_ALLOCATION is set to 1, so the application must provide an
+ * implementation of vApplicationGetTimerTaskMemory() to provide the memory that is
+ * used by the RTOS daemon/time task. */
+void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
+                                     StackType_t ** ppxTimerTaskStackBuffer,
+                                     uint32_t * pulTimerTaskStackSize )
+{
+/* If the buffers to be provided to the Timer task are declared inside this
+ * function then they must be declared static - otherwise they will be allocated on
+ * the stack and so not exists after this function exits. */
+    static StaticTask_t xTimerTaskTCB;
+    static StackType_t uxTimerTaskStack[ configTIMER_TASK_STACK_DEPTH ];
+
+    /* Pass out a pointer to the StaticTask_t structure in which the Timer
+     * task's state will be stored. */
+    *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
+
+    /* Pass out the array that will be used as the Timer task's stack. */
+    *ppxTimerTaskStackBuffer = uxTimerTaskStack;
+
+    /* Pass out the size of the array pointed to by *ppxTimerTaskStackBuffer.
+     * Note that, as the array is necessarily of type StackType_t,
+     * configMINIMAL_STACK_SIZE is specified in words, not bytes. */
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Stop the simulator if pvPortMalloc fails.
+ *
+ * Called if a call to pvPortMalloc() fails because there is insufficient
+ * free memory available in the FreeRTOS heap.  The size of the FreeRTOS heap
+ * is set by the configTOTAL_HEAP_SIZE configuration constant in
+ * FreeRTOSConfig.h.
+ */
+void vApplicationMallocFailedHook()
+{
+    vAssertCalled( __FILE__, __LINE__ );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Stop the simulator if stack overflow is detected.
+ *
+ * If configCHECK_FOR_STACK_OVERFLOW is set to 1 or 2,
+ * this hook provides a location for applications to
+ * define a response to a stack overflow.
+ */
+void vApplicationStackOverflowHook( TaskHandle_t xTask,
+                                    char * pcTaskName )
+{
+    ( void ) xTask;
+
+    fprintf( stderr, "Stack overflow in task %s\n", pcTaskName );
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook( void )
+{
+    /* Give the host core back rather than spinning. */
+    usleep( mainIDLE_SLEEP_US );
+}
+/*-----------------------------------------------------------*/
+
+void vAssertCalled( const char * pcFile,
+                    uint32_t ulLine )
+{
+    fprintf( stderr, "ASSERT! Line %u of file %s\n", ( unsigned ) ulLine, pcFile );
+    fflush( stderr );
+
+    /* Stop here so a debugger attached to the process lands on the assert. */
+    abort();
+}
+/*-----------------------------------------------------------*/
+
+void vMainUARTPrintString( char * pcString )
+{
+    ( void ) fputs( pcString, stdout );
+    ( void ) fflush( stdout );
+}
+/*-----------------------------------------------------------*/
+
+void vMainUARTPrintBinary( const uint8_t * pucData,
+                           size_t xLength )
+{
+    ( void ) fwrite( pucData, 1, xLength, stdout );
+    ( void ) fflush( stdout );
+}
+/*-----------------------------------------------------------*/
+
+/* Psuedo random number generator.  Just used by demos so does not need to be
+ * secure.  Do not use the standard C library rand() function as it can cause
+ * unexpected behaviour, such as calls to malloc(). */
+int iMainRand32( void )
+{
+    static UBaseType_t uxlNextRand; /*_RB_ Not seeded. */
+    const uint32_t ulMultiplier = 0x015a4e35UL, ulIncrement = 1UL;
+
+    /* Utility function to generate a pseudo random number. */
+
+    uxlNextRand = ( ulMultiplier * uxlNextRand ) + ulIncrement;
+
+    return( ( int ) ( uxlNextRand >> 16UL ) & 0x7fffUL );
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_hardware_poll( void * data,
+                           unsigned char * output,
+                           size_t len,
+                           size_t * olen )
+{
+    int iFile;
+    ssize_t xRead;
+
+    ( void ) data;
+    *olen = 0;
+
+    /* The host kernel entropy pool stands in for the hardware RNG. */
+    iFile = open( "/dev/urandom", O_RDONLY | O_CLOEXEC );
+
+    if( iFile >= 0 )
+    {
+        xRead = read( iFile, output, len );
+
+        if( xRead > 0 )
+        {
+            *olen = ( size_t ) xRead;
+        }
+
+        ( void ) close( iFile );
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,143 @@
+/*
+ * FreeRTOS Kernel V10.2.0
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+* Application specific definitions.
+*
+* These definitions should be adjusted for your particular hardware and
+* application requirements.
+*
+* THESE PARAMETERS ARE DESCRIBED WITHIN THE 'CONFIGURATION' SECTION OF THE
+* FreeRTOS API DOCUMENTATION AVAILABLE ON THE FreeRTOS.org WEB SITE.
+*
+* See http://www.freertos.org/a00110.html.
+*----------------------------------------------------------*/
+
+#include <stdint.h>
+
+#define configSUPPORT_STATIC_ALLOCATION              1
+#define configSUPPORT_DYNAMIC_ALLOCATION             1
+
+#define configUSE_PREEMPTION                         1
+#define configUSE_IDLE_HOOK                          1
+#define configUSE_TICK_HOOK                          0
+#define configUSE_TICKLESS_IDLE                      1
+#define configUSE_DAEMON_TASK_STARTUP_HOOK           1
+#define configTICK_RATE_HZ                           ( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES                         ( 7 )
+
+/* Each task runs on a pthread which uses the task stack, so the minimal stack
+ * must be at least the host's PTHREAD_STACK_MIN (16KB on x86-64).  Smaller
+ * stacks fall back to a stack allocated by the host C library. */
+#define configMINIMAL_STACK_SIZE                     ( ( uint16_t ) 2048 )
+#define configTOTAL_HEAP_SIZE                        ( ( size_t ) ( 16 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN                      ( 16 )
+#define configUSE_TRACE_FACILITY                     1
+#define configUSE_16_BIT_TICKS                       0
+#define configIDLE_SHOULD_YIELD                      1
+#define configUSE_MUTEXES                            1
+#define configQUEUE_REGISTRY_SIZE                    8
+#define configCHECK_FOR_STACK_OVERFLOW               2
+#define configUSE_RECURSIVE_MUTEXES                  1
+#define configUSE_MALLOC_FAILED_HOOK                 1
+#define configUSE_APPLICATION_TASK_TAG               0
+#define configUSE_COUNTING_SEMAPHORES                1
+#define configGENERATE_RUN_TIME_STATS                1
+#define configUSE_STATS_FORMATTING_FUNCTIONS         1
+#define configRECORD_STACK_HIGH_ADDRESS              1
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES                        0
+#define configMAX_CO_ROUTINE_PRIORITIES              ( 2 )
+
+/* Software timer definitions. */
+#define configUSE_TIMERS                             1
+#define configTIMER_TASK_PRIORITY                    ( configMAX_PRIORITIES - 2 )
+#define configTIMER_QUEUE_LENGTH                     10
+#define configTIMER_TASK_STACK_DEPTH                 ( configMINIMAL_STACK_SIZE * 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+ * to exclude the API function. */
+#define INCLUDE_vTaskPrioritySet                     1
+#define INCLUDE_uxTaskPriorityGet                    1
+#define INCLUDE_vTaskDelete                          1
+#define INCLUDE_vTaskCleanUpResources                0
+#define INCLUDE_vTaskSuspend                         1
+#define INCLUDE_vTaskDelayUntil                      1
+#define INCLUDE_vTaskDelay                           1
+#define INCLUDE_xTaskGetSchedulerState               1
+#define INCLUDE_uxTaskGetStackHighWaterMark          1
+
+/* Assert with the file and line so failures can be located from the host
+ * console or a debugger. */
+void vAssertCalled( const char * pcFile,
+                    uint32_t ulLine );
+#define configASSERT( x )    if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ )
+
+/* Logging task definitions. */
+extern void vMainUARTPrintString( char * pcString );
+extern void vMainUARTPrintBinary( const uint8_t * pucData,
+                                 size_t xLength );
+void vLoggingPrintf( const char * pcFormat,
+                     ... );
+
+/* Map the FreeRTOS printf() to the logging task printf. */
+#define configPRINTF( x )          vLoggingPrintf x
+
+/* Map the logging task's printf to the host console. */
+#define configPRINT_STRING( x )    vMainUARTPrintString( x );
+
+/* Map the logging task's binary output to the host console, see
+ * configLOGGING_OUTPUT_BINARY. */
+#define configPRINT_BINARY( pucData, xLength )    vMainUARTPrintBinary( pucData, xLength );
+
+/* Sets the length of the buffers into which logging messages are written - so
+ * also defines the maximum length of each log message. */
+#define configLOGGING_MAX_MESSAGE_LENGTH            160
+
+/* Set to 1 to prepend each log message with a message number, the task name,
+ * and a time stamp. */
+#define configLOGGING_INCLUDE_TIME_AND_TASK_NAME    1
+
+/* Set to 1 to output log messages as binary frames instead of text.  The
+ * frames carry the address of the format string and the raw arguments, and
+ * are turned back into text on the host by
+ * tools/binary_log_decoder/decode_binary_log.py. */
+#define configLOGGING_OUTPUT_BINARY                 0
+
+/* Pseudo random number generator, just used by demos so does not have to be
+ * secure.  Do not use the standard C library rand() function as it can cause
+ * unexpected behaviour, such as calls to malloc(). */
+extern int iMainRand32( void );
+#define configRAND32()    iMainRand32()
+
+/* The platform FreeRTOS is running on. */
+#define configPLATFORM_NAME    "Linux"
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,66 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_bufferpool_config.h
+ * @brief Buffer Pool config options.
+ */
+
+#ifndef _AWS_BUFFER_POOL_CONFIG_H_
+#define _AWS_BUFFER_POOL_CONFIG_H_
+
+/**
+ * @brief The number of buffers in the largest size class of the static
+ * buffer pool.
+ */
+#define bufferpoolconfigNUM_BUFFERS           ( 6 )
+
+/**
+ * @brief The size of each buffer in the largest size class.
+ */
+#define bufferpoolconfigBUFFER_SIZE           ( 1024 + 128 )
+
+/**
+ * @brief The number and size of the buffers for received acknowledgements
+ * (CONNACK, PUBACK, SUBACK and UNSUBACK) and for the headers of publishes
+ * whose payload is not copied (see mqttconfigPUBLISH_COPY_THRESHOLD).
+ *
+ * The MQTT library requests the packet length plus the size of
+ * MQTTBufferMetadata_t, which is 56 bytes on a 64-bit host (80 bytes with
+ * mqttconfigPUBLISH_RETRANSMIT_TICKS enabled). That leaves room for a
+ * publish header with a topic of up to about 60 bytes. The PUBACK and
+ * PINGREQ packets sent by the client do not use the pool.
+ */
+#define bufferpoolconfigNUM_SMALL_BUFFERS     ( 8 )
+#define bufferpoolconfigSMALL_BUFFER_SIZE     ( 128 )
+
+/**
+ * @brief The number and size of the buffers for CONNECT, SUBSCRIBE,
+ * UNSUBSCRIBE and short PUBLISH packets, including the metadata.
+ */
+#define bufferpoolconfigNUM_MEDIUM_BUFFERS    ( 4 )
+#define bufferpoolconfigMEDIUM_BUFFER_SIZE    ( 256 )
+
+#endif /* _AWS_BUFFER_POOL_CONFIG_H_ */
@@ -0,0 +1,117 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_agent_config.h
+ * @brief MQTT agent config options.
+ */
+
+#ifndef _AWS_MQTT_AGENT_CONFIG_H_
+#define _AWS_MQTT_AGENT_CONFIG_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Controls whether or not to report usage metrics to the
+ * AWS IoT broker.
+ *
+ * If mqttconfigENABLE_METRICS is set to 1, a string containing
+ * metric information will be included in the "username" field of
+ * the MQTT connect messages.
+ */
+#define mqttconfigENABLE_METRICS    ( 1 )
+
+/**
+ * @brief The maximum time interval in seconds allowed to elapse between 2 consecutive
+ * control packets.
+ */
+#define mqttconfigKEEP_ALIVE_INTERVAL_SECONDS         ( 1200 )
+
+/**
+ * @brief Defines the frequency at which the client should send Keep Alive messages.
+ *
+ * Even though the maximum time allowed between 2 consecutive control packets
+ * is defined by the mqttconfigKEEP_ALIVE_INTERVAL_SECONDS macro, the user
+ * can and should send Keep Alive messages at a slightly faster rate to ensure
+ * that the connection is not closed by the server because of network delays.
+ * This macro defines the interval of inactivity after which a keep alive messages
+ * is sent.
+ */
+#define mqttconfigKEEP_ALIVE_ACTUAL_INTERVAL_TICKS    ( pdMS_TO_TICKS( 300000 ) )
+
+/**
+ * @brief The maximum interval in ticks to wait for PINGRESP.
+ *
+ * If PINGRESP is not received within this much time after sending PINGREQ,
+ * the client assumes that the PINGREQ timed out.
+ */
+#define mqttconfigKEEP_ALIVE_TIMEOUT_TICKS            ( 1000 )
+
+/**
+ * @brief The maximum time in ticks for which the MQTT task is permitted to block.
+ *
+ * The Linux secure sockets port does not wake up the MQTT task when data is
+ * received on a connected socket, so this bounds the receive latency measured
+ * by host benchmarks and is kept short.
+ */
+#define mqttconfigMQTT_TASK_MAX_BLOCK_TICKS           ( 10 )
+
+/**
+ * @defgroup MQTTTask MQTT task configuration parameters.
+ */
+/** @{ */
+#define mqttconfigMQTT_TASK_STACK_DEPTH    ( configMINIMAL_STACK_SIZE * 4 )
+#define mqttconfigMQTT_TASK_PRIORITY       ( tskIDLE_PRIORITY + 2 )
+/** @} */
+
+/**
+ * @brief Maximum number of MQTT clients that can exist simultaneously.
+ */
+#define mqttconfigMAX_BROKERS            ( 2 )
+
+/**
+ * @brief Maximum number of parallel operations per client.
+ */
+#define mqttconfigMAX_PARALLEL_OPS       ( 5 )
+
+/**
+ * @brief Time in milliseconds after which the TCP send operation should timeout.
+ */
+#define mqttconfigTCP_SEND_TIMEOUT_MS    ( 20 )
+
+/**
+ * @brief Size in bytes of the queue in which each client keeps the QoS1
+ * publishes made while it is not connected.
+ */
+#define mqttconfigOFFLINE_QUEUE_SIZE     ( 2048 )
+
+/**
+ * @brief Size in bytes of the persistent store which takes the offline queue
+ * when it is full.  The store is kept in a file in the working directory.
+ */
+#define mqttconfigOFFLINE_STORE_SIZE     ( 8192 )
+
+#endif /* _AWS_MQTT_AGENT_CONFIG_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Amazon FreeRTOS V1.4.8
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_config.h
+ * @brief MQTT config options.
+ */
+
+#ifndef _AWS_MQTT_CONFIG_H_
+#define _AWS_MQTT_CONFIG_H_
+
+/**
+ * @brief Enable subscription management.
+ *
+ * This gives the user flexibility of registering a callback per topic.
+ */
+#define mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT            ( 1 )
+
+/**
+ * @brief Maximum length of the topic which can be stored in subscription
+ * manager.
+ */
+#define mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_LENGTH     ( 128 )
+
+/**
+ * @brief Maximum number of subscriptions which can be stored in subscription
+ * manager.
+ */
+#define mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS    ( 8 )
+
+/**
+ * @brief Maximum number of QoS1 publishes which can be waiting for PUBACK.
+ *
+ * One less than mqttconfigMAX_PARALLEL_OPS so that publishes cannot hold up
+ * subscribes and unsubscribes.
+ */
+#define mqttconfigPUBLISH_WINDOW_SIZE                       ( 4 )
+
+/**
+ * @brief Ticks after which an unacknowledged QoS1 publish is transmitted
+ * again with the DUP flag set.
+ *
+ * Disabled. TCP already retransmits lost segments within a session, so a
+ * DUP resend on the same connection only duplicates the delivery whenever
+ * the PUBACK is merely slow. Publishes which are still unacknowledged when
+ * the connection drops are resent after the reconnect instead, see
+ * mqttconfigOFFLINE_QUEUE_SIZE. If enabled, this must be well above
+ * the worst case round trip time to the broker.
+ */
+#define mqttconfigPUBLISH_RETRANSMIT_TICKS                  ( 0 )
+
+/*
+ * Uncomment the following two lines to enable asserts.
+ */
+/* extern void vAssertCalled( const char *pcFile, uint32_t ulLine ); */
+/* #define mqttconfigASSERT( x )                       if( ( x ) == 0 ) vAssertCalled( __FILE__, __LINE__ ) */
+
+/**
+ * @brief Set this macro to 1 for enabling debug logs.
+ */
+#define mqttconfigENABLE_DEBUG_LOGS    0
+
+#endif /* _AWS_MQTT_CONFIG_H_ */
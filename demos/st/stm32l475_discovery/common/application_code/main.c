@@ -95,6 +95,7 @@ RNG_HandleTypeDef xHrng;
 
 /* Private variables ---------------------------------------------------------*/
 static UART_HandleTypeDef xConsoleUart;
+static TIM_HandleTypeDef xRunTimeTimer;
 
 /* Private function prototypes -----------------------------------------------*/
 static void SystemClock_Config( void );
@@ -575,6 +576,56 @@ void vMainUARTPrintString( char * pcString )
 }
 /*-----------------------------------------------------------*/
 
+void vMainUARTPrintBinary( const uint8_t * pucData,
+                           size_t xLength )
+{
+    const uint32_t ulTimeout = 3000UL;
+
+    HAL_UART_Transmit( &xConsoleUart,
+                       ( uint8_t * ) pucData,
+                       ( uint16_t ) xLength,
+                       ulTimeout );
+}
+/*-----------------------------------------------------------*/
+
+void vMainConfigureRunTimeCounter( void )
+{
+    /* TIM2 is free running over its full 32 bits, at 1MHz.  APB1 is not
+     * divided, so the timer is clocked at PCLK1. */
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    xRunTimeTimer.Instance = TIM2;
+    xRunTimeTimer.Init.Prescaler = ( HAL_RCC_GetPCLK1Freq() / 1000000UL ) - 1UL;
+    xRunTimeTimer.Init.Period = 0xFFFFFFFFUL;
+    xRunTimeTimer.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    xRunTimeTimer.Init.CounterMode = TIM_COUNTERMODE_UP;
+
+    if( ( HAL_TIM_Base_Init( &xRunTimeTimer ) != HAL_OK ) ||
+        ( HAL_TIM_Base_Start( &xRunTimeTimer ) != HAL_OK ) )
+    {
+        Error_Handler();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vMainPreSleepProcessing( uint32_t ulExpectedIdleTime )
+{
+    ( void ) ulExpectedIdleTime;
+
+    /* Stop the HAL time base so that only SysTick, reprogrammed by the
+     * kernel for the whole idle period, or a peripheral wakes the MCU. */
+    HAL_SuspendTick();
+}
+/*-----------------------------------------------------------*/
+
+void vMainPostSleepProcessing( uint32_t ulExpectedIdleTime )
+{
+    ( void ) ulExpectedIdleTime;
+
+    HAL_ResumeTick();
+}
+/*-----------------------------------------------------------*/
+
 void prvGetRegistersFromStack( uint32_t * pulFaultStackAddress )
 {
 /* These are volatile to try and prevent the compiler/linker optimising them
@@ -52,6 +52,16 @@
 #include "es_wifi_conf.h"
 #include <core_cm4.h>
 
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "aws_wifi_config.h"
+
+#ifndef wificonfigUSE_DATA_READY_NOTIFICATION
+  #define wificonfigUSE_DATA_READY_NOTIFICATION  ( 0 )
+#endif
+
 /* Private define ------------------------------------------------------------*/
 #define MIN(a, b)  ((a) < (b) ? (a) : (b))
 /* Private typedef -----------------------------------------------------------*/
@@ -80,6 +90,13 @@ osSemaphoreDef(cmddata_rdy_rising_sem);
 
 #endif
 
+#if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+/* Given from SPI_WIFI_ISR on the Cmd/Data ready rising edge, so the task
+   waiting for the module blocks instead of spinning on the flag. */
+static  SemaphoreHandle_t cmddata_rdy_rising_notify = NULL;
+static  StaticSemaphore_t cmddata_rdy_rising_notify_buffer;
+#endif
+
 
 /* Private function prototypes -----------------------------------------------*/
 static  int wait_cmddata_rdy_high(int timeout);
@@ -208,6 +225,12 @@ int8_t SPI_WIFI_Init(uint16_t mode)
     spi_rx_sem = osSemaphoreCreate(osSemaphore(spi_rx_sem) , 1 );
     spi_tx_sem = osSemaphoreCreate(osSemaphore(spi_tx_sem) , 1 );
     cmddata_rdy_rising_sem = osSemaphoreCreate(osSemaphore(cmddata_rdy_rising_sem) , 1 );
+#endif
+#if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+    if (cmddata_rdy_rising_notify == NULL)
+    {
+      cmddata_rdy_rising_notify = xSemaphoreCreateBinaryStatic(&cmddata_rdy_rising_notify_buffer);
+    }
 #endif
     // first call used for calibration
     SPI_WIFI_DelayUs(10);
@@ -299,6 +322,28 @@ int wait_cmddata_rdy_rising_event(int timeout)
    return SEM_WAIT(cmddata_rdy_rising_sem, timeout);
 #else
   int tickstart = HAL_GetTick();
+#if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+  /* Sleep until the interrupt fires. Before the scheduler starts there
+     is nothing else to run, so fall through to the busy wait. */
+  if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)
+  {
+    /* Time the wait with the kernel tick. The HAL tick is suspended while
+       the idle task sleeps, so it barely moves during this wait. */
+    TickType_t xTickStart = xTaskGetTickCount();
+
+    while (cmddata_rdy_rising_event==1)
+    {
+      if((xTaskGetTickCount() - xTickStart) > pdMS_TO_TICKS(timeout))
+      {
+        return -1;
+      }
+      /* The slice only bounds how late the timeout is noticed, the
+         interrupt wakes the task as soon as the edge arrives. */
+      (void) xSemaphoreTake(cmddata_rdy_rising_notify, pdMS_TO_TICKS(10));
+    }
+    return 0;
+  }
+#endif
   while (cmddata_rdy_rising_event==1)
   {
     if((HAL_GetTick() - tickstart ) > timeout)
@@ -414,6 +459,13 @@ int16_t SPI_WIFI_SendData( uint8_t *pdata,  uint16_t len, uint32_t timeout)
     return ES_WIFI_ERROR_SPI_FAILED;
   }
 
+#if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+  // drop a stale edge so the next wait is for this command's answer
+  if (cmddata_rdy_rising_notify != NULL)
+  {
+    (void) xSemaphoreTake(cmddata_rdy_rising_notify, 0);
+  }
+#endif
   // arm to detect rising event
   cmddata_rdy_rising_event=1;
   LOCK_SPI();
@@ -532,6 +584,15 @@ void    SPI_WIFI_ISR(void)
    {
      SEM_SIGNAL(cmddata_rdy_rising_sem);
      cmddata_rdy_rising_event=0;
+#if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+     if (cmddata_rdy_rising_notify != NULL)
+     {
+       BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+       (void) xSemaphoreGiveFromISR(cmddata_rdy_rising_notify, &xHigherPriorityTaskWoken);
+       portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+     }
+#endif
    }
 }
 /**
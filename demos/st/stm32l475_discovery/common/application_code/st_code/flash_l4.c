@@ -247,7 +247,7 @@ int FLASH_update(uint32_t dst_addr, const void *data, uint32_t size)
 		do {
 			uint32_t fl_addr = ROUND_DOWN(dst_addr, FLASH_PAGE_SIZE);
 			int fl_offset = dst_addr - fl_addr;
-			int len = MIN(FLASH_PAGE_SIZE - fl_offset, size);
+			int len = MIN(FLASH_PAGE_SIZE - fl_offset, remaining);
 
 			/* Load from the flash into the cache */
 			memcpy(page_cache, (void *) fl_addr, FLASH_PAGE_SIZE);
@@ -50,7 +50,7 @@
 #define configUSE_PREEMPTION                         1
 #define configUSE_IDLE_HOOK                          1
 #define configUSE_TICK_HOOK                          0
-#define configUSE_TICKLESS_IDLE                      0
+#define configUSE_TICKLESS_IDLE                      1
 #define configUSE_DAEMON_TASK_STARTUP_HOOK           1
 #define configCPU_CLOCK_HZ                           ( SystemCoreClock )
 #define configTICK_RATE_HZ                           ( ( TickType_t ) 1000 )
@@ -68,10 +68,17 @@
 #define configUSE_MALLOC_FAILED_HOOK                 1
 #define configUSE_APPLICATION_TASK_TAG               0
 #define configUSE_COUNTING_SEMAPHORES                1
-#define configGENERATE_RUN_TIME_STATS                0
+#define configGENERATE_RUN_TIME_STATS                1
 #define configOVERRIDE_DEFAULT_TICK_CONFIGURATION    1
 #define configRECORD_STACK_HIGH_ADDRESS              1
 
+/* Run time statistics are counted by TIM2, a 32-bit timer that main.c clocks
+ * at 1MHz, so the counters wrap after about 71 minutes.  The counter register
+ * is read directly so that each context switch only costs one load. */
+extern void vMainConfigureRunTimeCounter( void );
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()    vMainConfigureRunTimeCounter()
+#define portGET_RUN_TIME_COUNTER_VALUE()            ( *( volatile uint32_t * ) 0x40000024UL ) /* TIM2->CNT */
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES                        0
 #define configMAX_CO_ROUTINE_PRIORITIES              ( 2 )
@@ -129,6 +136,8 @@
 
 /* Logging task definitions. */
 extern void vMainUARTPrintString( char * pcString );
+extern void vMainUARTPrintBinary( const uint8_t * pucData,
+                                 size_t xLength );
 void vLoggingPrintf( const char * pcFormat,
                      ... );
 
@@ -138,6 +147,10 @@ void vLoggingPrintf( const char * pcFormat,
 /* Map the logging task's printf to the board specific output function. */
 #define configPRINT_STRING( x )    vMainUARTPrintString( x );
 
+/* Map the logging task's binary output to the board specific output function, see
+ * configLOGGING_OUTPUT_BINARY. */
+#define configPRINT_BINARY( pucData, xLength )    vMainUARTPrintBinary( pucData, xLength );
+
 /* Sets the length of the buffers into which logging messages are written - so
  * also defines the maximum length of each log message. */
 #define configLOGGING_MAX_MESSAGE_LENGTH            160
@@ -146,6 +159,12 @@ void vLoggingPrintf( const char * pcFormat,
  * and a time stamp. */
 #define configLOGGING_INCLUDE_TIME_AND_TASK_NAME    1
 
+/* Set to 1 to output log messages as binary frames instead of text.  The
+ * frames carry the address of the format string and the raw arguments, and
+ * are turned back into text on the host by
+ * tools/binary_log_decoder/decode_binary_log.py. */
+#define configLOGGING_OUTPUT_BINARY                 0
+
 /* Pseudo random number generator, just used by demos so does not have to be
  * secure.  Do not use the standard C library rand() function as it can cause
  * unexpected behaviour, such as calls to malloc(). */
@@ -167,6 +186,17 @@ extern int iMainRand32( void );
 #define configPRE_STOP_PROCESSING     vMainPreStopProcessing
 #define configPOST_STOP_PROCESSING    vMainPostStopProcessing
 
+/* The tickless idle stops SysTick and sleeps with WFI, but the HAL time base
+ * (TIM6) would still wake the MCU every millisecond.  These stop and restart
+ * it around the SLEEP mode.  The HAL tick does not advance while asleep, so
+ * HAL_GetTick() cannot time a wait during which the task blocks.  Such waits
+ * must use xTaskGetTickCount() instead, as es_wifi_io.c does while it waits
+ * for the Wi-Fi module to raise CMDDATA_RDY. */
+extern void vMainPreSleepProcessing( uint32_t ulExpectedIdleTime );
+extern void vMainPostSleepProcessing( uint32_t ulExpectedIdleTime );
+#define configPRE_SLEEP_PROCESSING( x )     vMainPreSleepProcessing( x )
+#define configPOST_SLEEP_PROCESSING( x )    vMainPostSleepProcessing( x )
+
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
  * standard names. */
 #define vPortSVCHandler               SVC_Handler
@@ -32,13 +32,35 @@
 #define _AWS_BUFFER_POOL_CONFIG_H_
 
 /**
- * @brief The number of buffers in the static buffer pool.
+ * @brief The number of buffers in the largest size class of the static
+ * buffer pool.
  */
-#define bufferpoolconfigNUM_BUFFERS    ( 8 )
+#define bufferpoolconfigNUM_BUFFERS           ( 6 )
 
 /**
- * @brief The size of each buffer in the static buffer pool.
+ * @brief The size of each buffer in the largest size class.
  */
-#define bufferpoolconfigBUFFER_SIZE    ( 1024 + 128 )
+#define bufferpoolconfigBUFFER_SIZE           ( 1024 + 128 )
+
+/**
+ * @brief The number and size of the buffers for received acknowledgements
+ * (CONNACK, PUBACK, SUBACK and UNSUBACK) and for the headers of publishes
+ * whose payload is not copied (see mqttconfigPUBLISH_COPY_THRESHOLD).
+ *
+ * The MQTT library requests the packet length plus the size of
+ * MQTTBufferMetadata_t, which is 40 bytes on Cortex-M4 (56 bytes with
+ * mqttconfigPUBLISH_RETRANSMIT_TICKS enabled). That leaves room for a
+ * publish header with a topic of up to about 60 bytes. The PUBACK and
+ * PINGREQ packets sent by the client do not use the pool.
+ */
+#define bufferpoolconfigNUM_SMALL_BUFFERS     ( 8 )
+#define bufferpoolconfigSMALL_BUFFER_SIZE     ( 128 )
+
+/**
+ * @brief The number and size of the buffers for CONNECT, SUBSCRIBE,
+ * UNSUBSCRIBE and short PUBLISH packets, including the metadata.
+ */
+#define bufferpoolconfigNUM_MEDIUM_BUFFERS    ( 4 )
+#define bufferpoolconfigMEDIUM_BUFFER_SIZE    ( 256 )
 
 #endif /* _AWS_BUFFER_POOL_CONFIG_H_ */
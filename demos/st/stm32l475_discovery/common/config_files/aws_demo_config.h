@@ -67,11 +67,32 @@
 #define democonfigTCP_ECHO_TASKS_SEPARATE_TASK_STACK_SIZE    ( configMINIMAL_STACK_SIZE * 3 )
 #define democonfigTCP_ECHO_TASKS_SEPARATE_TASK_PRIORITY      ( tskIDLE_PRIORITY )
 
+/* Crypto benchmark task parameters. */
+#define democonfigCRYPTO_BENCHMARK_TASK_STACK_SIZE           ( configMINIMAL_STACK_SIZE * 8 )
+#define democonfigCRYPTO_BENCHMARK_TASK_PRIORITY             ( tskIDLE_PRIORITY )
+
+/* MQTT benchmark task parameters, see aws_mqtt_benchmark.h.  The publisher
+ * tasks run at the priority of the MQTT task so their commands queue up while
+ * it is busy. */
+#define democonfigMQTT_BENCHMARK_TASK_STACK_SIZE             ( configMINIMAL_STACK_SIZE * 3 )
+#define democonfigMQTT_BENCHMARK_TASK_PRIORITY               ( tskIDLE_PRIORITY )
+#define democonfigMQTT_BENCHMARK_PUBLISHER_PRIORITY          ( tskIDLE_PRIORITY + 2 )
+#define democonfigMQTT_BENCHMARK_PUBLISHERS                  ( 4 )
+#define democonfigMQTT_BENCHMARK_PUBLISHES                   ( 50 )
+
+/* Telemetry task parameters, see aws_telemetry.h. */
+#define democonfigTELEMETRY_TASK_STACK_SIZE                  ( configMINIMAL_STACK_SIZE * 3 )
+#define democonfigTELEMETRY_TASK_PRIORITY                    ( tskIDLE_PRIORITY )
+
+/* Time between two telemetry snapshots. */
+#define democonfigTELEMETRY_PERIOD                           pdMS_TO_TICKS( 10000 )
+
 /* Timeout used when performing MQTT operations that do not need extra time
  * to perform a TLS negotiation. */
 #define democonfigMQTT_TIMEOUT                               pdMS_TO_TICKS( 2500 )
 
-/* Send AWS IoT MQTT traffic encrypted. */
-#define democonfigMQTT_AGENT_CONNECT_FLAGS          	     ( mqttagentREQUIRE_TLS )
+/* Send AWS IoT MQTT traffic encrypted.  The demo callbacks never take the
+ * ownership of received messages, so they can be delivered without a copy. */
+#define democonfigMQTT_AGENT_CONNECT_FLAGS          	     ( mqttagentREQUIRE_TLS | mqttagentDELIVER_PUBLISHES_IN_PLACE )
 
 #endif /* _AWS_DEMO_CONFIG_H_ */
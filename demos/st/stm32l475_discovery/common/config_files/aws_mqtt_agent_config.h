@@ -103,4 +103,18 @@
  */
 #define mqttconfigTCP_SEND_TIMEOUT_MS    ( 20 )
 
+/**
+ * @brief Size in bytes of the queue in which each client keeps the QoS1
+ * publishes made while it is not connected.
+ */
+#define mqttconfigOFFLINE_QUEUE_SIZE     ( 1024 )
+
+/**
+ * @brief Size in bytes of the persistent store which takes the offline queue
+ * when it is full.  The store is kept in the fixed location flash area, which
+ * must be large enough to hold mqttconfigMAX_BROKERS stores along with the
+ * PKCS#11 objects.
+ */
+#define mqttconfigOFFLINE_STORE_SIZE     ( 4096 )
+
 #endif /* _AWS_MQTT_AGENT_CONFIG_H_ */
@@ -50,6 +50,27 @@
  */
 #define mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS    ( 8 )
 
+/**
+ * @brief Maximum number of QoS1 publishes which can be waiting for PUBACK.
+ *
+ * One less than mqttconfigMAX_PARALLEL_OPS so that publishes cannot hold up
+ * subscribes and unsubscribes.
+ */
+#define mqttconfigPUBLISH_WINDOW_SIZE                       ( 4 )
+
+/**
+ * @brief Ticks after which an unacknowledged QoS1 publish is transmitted
+ * again with the DUP flag set.
+ *
+ * Disabled. TCP already retransmits lost segments within a session, so a
+ * DUP resend on the same connection only duplicates the delivery whenever
+ * the PUBACK is merely slow. Publishes which are still unacknowledged when
+ * the connection drops are resent after the reconnect instead, see
+ * mqttconfigOFFLINE_QUEUE_SIZE. If enabled, this must be well above
+ * the worst case round trip time to the broker.
+ */
+#define mqttconfigPUBLISH_RETRANSMIT_TICKS                  ( 0 )
+
 /*
  * Uncomment the following two lines to enable asserts.
  */
@@ -81,6 +81,12 @@
  */
 #define wificonfigMAX_SEMAPHORE_WAIT_TIME_MS  ( 60000 )
 
+/**
+ * @brief Wake a task blocked in socket receive from the Cmd/Data ready
+ * interrupt of the module instead of polling the module every 5 ms.
+ */
+#define wificonfigUSE_DATA_READY_NOTIFICATION ( 1 )
+
 /**
  * @brief Soft Access point security
  * WPA2 Security, see WIFISecurity_t
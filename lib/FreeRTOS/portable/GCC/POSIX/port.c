@@ -0,0 +1,675 @@
+/*
+ * FreeRTOS Kernel V10.2.0
+ * Copyright (C) 2019 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the POSIX port.
+ *
+ * Each task is run in its own pthread.  Only the thread belonging to the
+ * task selected by the scheduler is allowed to run, all other task threads
+ * are blocked waiting on a per thread event.  The tick interrupt is emulated
+ * with SIGALRM, so masking that signal is equivalent to disabling interrupts.
+ * When configUSE_TICKLESS_IDLE is 1 the interval timer that raises SIGALRM is
+ * stopped while the idle task sleeps, as the tick timer of a target would be.
+ *
+ * This port is intended for building and profiling the libraries on a host
+ * workstation.  It does not give real time guarantees.
+ *----------------------------------------------------------*/
+
+/* Standard includes. */
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* The signal used to generate the tick interrupt. */
+#define portTICK_SIGNAL				SIGALRM
+
+/* Number of microseconds in one tick. */
+#define portTICK_PERIOD_US			( ( long ) 1000000L / ( long ) configTICK_RATE_HZ )
+
+/*-----------------------------------------------------------*/
+
+/* Used to block the thread of a task until the scheduler selects it. */
+typedef struct PORT_EVENT
+{
+	pthread_mutex_t xMutex;
+	pthread_cond_t xCond;
+	BaseType_t xSignalled;
+} PortEvent_t;
+
+/* The state stored for each task.  It lives at the top of the task's stack so
+it can be found from the task handle. */
+typedef struct THREAD
+{
+	pthread_t xPthread;
+	TaskFunction_t pxCode;
+	void *pvParams;
+	volatile BaseType_t xDying;
+	PortEvent_t xEvent;
+} Thread_t;
+
+/*
+ * The critical nesting depth of the running task.  As only one task thread
+ * runs at a time a single variable is enough, the value is saved and restored
+ * on the stack of the thread across a switch.
+ */
+static volatile UBaseType_t uxCriticalNesting = 0;
+
+/* Set of signals used to mask the tick. */
+static sigset_t xTickSignal;
+
+/* Ensures the signal set and handler are only set up once. */
+static pthread_once_t xSignalSetupOnce = PTHREAD_ONCE_INIT;
+
+/* The main thread waits on this event while the scheduler is running. */
+static PortEvent_t xSchedulerEndEvent;
+
+/* Time at which the scheduler was started, used for run time stats. */
+static struct timespec xStartTime;
+
+/* Counters of the tickless idle.  Only updated by the idle task with the tick
+masked. */
+static PortTicklessIdleStats_t xTicklessIdleStats = { 0 };
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Event primitives used to start and stop task threads.
+ */
+static void prvEventInit( PortEvent_t *pxEvent );
+static void prvEventDelete( PortEvent_t *pxEvent );
+static void prvEventSignal( PortEvent_t *pxEvent );
+static void prvEventWait( PortEvent_t *pxEvent );
+static void prvEventUnlock( void *pvMutex );
+
+/*
+ * Setup the signal set and the handler used to emulate the tick interrupt.
+ */
+static void prvSetupSignals( void );
+
+/*
+ * Start the interval timer that raises the tick signal.
+ */
+static void prvSetupTimerInterrupt( void );
+
+/*
+ * The tick interrupt handler.
+ */
+static void prvSystemTickHandler( int iSignal );
+
+/*
+ * Entry point of all task threads.  Blocks until the scheduler first selects
+ * the task, then runs the task function.
+ */
+static void *prvWaitForStart( void *pvParams );
+
+/*
+ * Hand the processor from one task thread to another.
+ */
+static void prvSwitchThread( Thread_t *pxThreadToResume, Thread_t *pxThreadToSuspend );
+
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+	/*
+	 * Restart the tick timer so the next tick occurs after llTimeToNextTickUs.
+	 */
+	static void prvRestartTickTimer( long long llTimeToNextTickUs );
+
+#endif /* configUSE_TICKLESS_IDLE */
+
+/*
+ * Report an unexpected failure from the host and abort.
+ */
+static void prvFatalError( const char *pcCall, int iErrno );
+
+/*-----------------------------------------------------------*/
+
+static Thread_t *prvGetThreadFromTask( TaskHandle_t xTask )
+{
+StackType_t *pxTopOfStack = *( StackType_t ** ) xTask;
+
+	/* The first member of the TCB is the top of stack returned by
+	pxPortInitialiseStack(), which is just below the thread data. */
+	return ( Thread_t * ) ( pxTopOfStack + 1 );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * See header file for description.
+ */
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, StackType_t *pxEndOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+Thread_t *pxThread;
+pthread_attr_t xThreadAttributes;
+size_t xStackSize;
+int iRet;
+
+	( void ) pthread_once( &xSignalSetupOnce, prvSetupSignals );
+
+	/* Store the thread data at the top of the stack, the rest of the stack is
+	handed to the pthread so stack high water marks remain meaningful. */
+	pxThread = ( Thread_t * ) ( pxTopOfStack + 1 ) - 1;
+	pxTopOfStack = ( StackType_t * ) pxThread - 1;
+	xStackSize = ( size_t ) ( ( uint8_t * ) pxThread - ( uint8_t * ) pxEndOfStack );
+
+	pxThread->pxCode = pxCode;
+	pxThread->pvParams = pvParameters;
+	pxThread->xDying = pdFALSE;
+	prvEventInit( &( pxThread->xEvent ) );
+
+	( void ) pthread_attr_init( &xThreadAttributes );
+
+	/* Stacks too small for the host C library fall back to a stack allocated
+	by pthreads, in which case the high water mark is not tracked. */
+	if( xStackSize >= ( size_t ) PTHREAD_STACK_MIN )
+	{
+		( void ) pthread_attr_setstack( &xThreadAttributes, pxEndOfStack, xStackSize );
+	}
+
+	/* The new thread inherits the signal mask of the creator, so create it
+	with the tick masked. */
+	vPortEnterCritical();
+
+	iRet = pthread_create( &( pxThread->xPthread ), &xThreadAttributes, prvWaitForStart, pxThread );
+
+	if( iRet != 0 )
+	{
+		prvFatalError( "pthread_create", iRet );
+	}
+
+	vPortExitCritical();
+
+	( void ) pthread_attr_destroy( &xThreadAttributes );
+
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+Thread_t *pxFirstThread;
+
+	( void ) pthread_once( &xSignalSetupOnce, prvSetupSignals );
+
+	/* The main thread never runs task code, so it must never take the tick.
+	Interrupts have already been disabled by vTaskStartScheduler(). */
+	( void ) pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+
+	prvEventInit( &xSchedulerEndEvent );
+	( void ) clock_gettime( CLOCK_MONOTONIC, &xStartTime );
+
+	/* Start the timer that generates the tick. */
+	prvSetupTimerInterrupt();
+
+	/* Start the first task. */
+	pxFirstThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+	prvEventSignal( &( pxFirstThread->xEvent ) );
+
+	/* Wait until vPortEndScheduler() is called. */
+	prvEventWait( &xSchedulerEndEvent );
+	prvEventDelete( &xSchedulerEndEvent );
+
+	/* Restore the signal mask of the main thread. */
+	( void ) pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+struct itimerval xTimer;
+struct sigaction xAction;
+Thread_t *pxCurrentThread;
+
+	/* Stop the timer and ignore any pending tick. */
+	memset( &xTimer, 0x00, sizeof( xTimer ) );
+	( void ) setitimer( ITIMER_REAL, &xTimer, NULL );
+
+	memset( &xAction, 0x00, sizeof( xAction ) );
+	xAction.sa_handler = SIG_IGN;
+	( void ) sigaction( portTICK_SIGNAL, &xAction, NULL );
+
+	/* Release the main thread from xPortStartScheduler(). */
+	prvEventSignal( &xSchedulerEndEvent );
+
+	/* The calling task never runs again. */
+	pxCurrentThread = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+	prvEventWait( &( pxCurrentThread->xEvent ) );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+Thread_t *pxThreadToSuspend;
+Thread_t *pxThreadToResume;
+
+	vPortEnterCritical();
+	{
+		pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+		vTaskSwitchContext();
+		pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+		prvSwitchThread( pxThreadToResume, pxThreadToSuspend );
+	}
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+	( void ) pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+	( void ) pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+}
+/*-----------------------------------------------------------*/
+
+portBASE_TYPE xPortSetInterruptMask( void )
+{
+sigset_t xPreviousMask;
+
+	( void ) pthread_sigmask( SIG_BLOCK, &xTickSignal, &xPreviousMask );
+
+	/* Return whether the tick was already masked so the previous state can be
+	restored by vPortClearInterruptMask(). */
+	return ( portBASE_TYPE ) sigismember( &xPreviousMask, portTICK_SIGNAL );
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( portBASE_TYPE xMask )
+{
+	if( xMask == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+	configASSERT( uxCriticalNesting );
+	uxCriticalNesting--;
+
+	if( uxCriticalNesting == 0 )
+	{
+		vPortEnableInterrupts();
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortThreadDying( void *pxTaskToDelete, volatile BaseType_t *pxPendYield )
+{
+Thread_t *pxThread = prvGetThreadFromTask( ( TaskHandle_t ) pxTaskToDelete );
+
+	( void ) pxPendYield;
+
+	/* The thread exits the next time it is switched out. */
+	pxThread->xDying = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCancelThread( void *pxTaskToDelete )
+{
+Thread_t *pxThread = prvGetThreadFromTask( ( TaskHandle_t ) pxTaskToDelete );
+
+	/* The thread is either blocked in prvEventWait(), which is a cancellation
+	point, or has already exited.  Either way it must be joined before its
+	stack is freed. */
+	( void ) pthread_cancel( pxThread->xPthread );
+	( void ) pthread_join( pxThread->xPthread, NULL );
+	prvEventDelete( &( pxThread->xEvent ) );
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulPortGetRunTime( void )
+{
+struct timespec xNow;
+
+	( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+	return ( unsigned long ) ( ( xNow.tv_sec - xStartTime.tv_sec ) * 1000000L +
+							   ( xNow.tv_nsec - xStartTime.tv_nsec ) / 1000L );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetTicklessIdleStats( PortTicklessIdleStats_t *pxStats )
+{
+	vPortEnterCritical();
+	{
+		*pxStats = xTicklessIdleStats;
+	}
+	vPortExitCritical();
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+	void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+	{
+	struct itimerval xTimer, xPreviousTimer;
+	struct timespec xSleepStart, xSleepEnd, xWakeTime;
+	sigset_t xPendingSignals;
+	long long llTimeToNextTickUs, llSleptUs;
+	TickType_t xModifiableIdleTime, xCompleteTickPeriods;
+	int iRet;
+
+		/* Mask the tick, then stop the timer that raises it, noting how long
+		was left until the next tick. */
+		vPortDisableInterrupts();
+
+		memset( &xTimer, 0x00, sizeof( xTimer ) );
+		( void ) setitimer( ITIMER_REAL, &xTimer, &xPreviousTimer );
+		( void ) clock_gettime( CLOCK_MONOTONIC, &xSleepStart );
+
+		llTimeToNextTickUs = ( long long ) xPreviousTimer.it_value.tv_sec * 1000000LL + ( long long ) xPreviousTimer.it_value.tv_usec;
+
+		/* Don't sleep if a tick is already pending, or if a task left the
+		Blocked state while the scheduler was suspended. */
+		( void ) sigpending( &xPendingSignals );
+
+		if( ( sigismember( &xPendingSignals, portTICK_SIGNAL ) == 1 ) || ( eTaskConfirmSleepModeStatus() == eAbortSleep ) )
+		{
+			prvRestartTickTimer( llTimeToNextTickUs );
+			xTicklessIdleStats.ulAbortedSleeps++;
+			vPortEnableInterrupts();
+		}
+		else
+		{
+			/* Sleep until the tick that unblocks the next task would have
+			occurred.  configPRE_SLEEP_PROCESSING() can set xModifiableIdleTime
+			to 0 to skip the sleep, as on the targets. */
+			xModifiableIdleTime = xExpectedIdleTime;
+			configPRE_SLEEP_PROCESSING( xModifiableIdleTime );
+
+			if( xModifiableIdleTime > 0 )
+			{
+				llSleptUs = llTimeToNextTickUs + ( long long ) ( xExpectedIdleTime - 1UL ) * portTICK_PERIOD_US;
+				xWakeTime.tv_sec = xSleepStart.tv_sec + ( time_t ) ( llSleptUs / 1000000LL );
+				xWakeTime.tv_nsec = xSleepStart.tv_nsec + ( long ) ( llSleptUs % 1000000LL ) * 1000L;
+
+				if( xWakeTime.tv_nsec >= 1000000000L )
+				{
+					xWakeTime.tv_sec++;
+					xWakeTime.tv_nsec -= 1000000000L;
+				}
+
+				do
+				{
+					iRet = clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &xWakeTime, NULL );
+				} while( iRet == EINTR );
+			}
+
+			configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+			/* Work out how many tick periods passed while asleep, and how long
+			remains until the next tick. */
+			( void ) clock_gettime( CLOCK_MONOTONIC, &xSleepEnd );
+			llSleptUs = ( long long ) ( xSleepEnd.tv_sec - xSleepStart.tv_sec ) * 1000000LL +
+						( long long ) ( xSleepEnd.tv_nsec - xSleepStart.tv_nsec ) / 1000LL;
+
+			if( llSleptUs < llTimeToNextTickUs )
+			{
+				xCompleteTickPeriods = 0;
+				llTimeToNextTickUs -= llSleptUs;
+			}
+			else
+			{
+				llSleptUs -= llTimeToNextTickUs;
+				xCompleteTickPeriods = ( TickType_t ) ( 1LL + ( llSleptUs / portTICK_PERIOD_US ) );
+				llTimeToNextTickUs = portTICK_PERIOD_US - ( llSleptUs % portTICK_PERIOD_US );
+			}
+
+			/* The tick count must not be stepped past the time the next task
+			unblocks.  If that tick is due, or the host overslept, leave it to
+			the tick handler, which runs as soon as the tick is unmasked. */
+			if( xCompleteTickPeriods >= xExpectedIdleTime )
+			{
+				xCompleteTickPeriods = xExpectedIdleTime - 1UL;
+				llTimeToNextTickUs = 1;
+			}
+
+			vTaskStepTick( xCompleteTickPeriods );
+			prvRestartTickTimer( llTimeToNextTickUs );
+
+			xTicklessIdleStats.ulSleeps++;
+			xTicklessIdleStats.ulSuppressedTicks += ( uint32_t ) xCompleteTickPeriods;
+
+			if( ( uint32_t ) xCompleteTickPeriods > xTicklessIdleStats.ulLongestSleepTicks )
+			{
+				xTicklessIdleStats.ulLongestSleepTicks = ( uint32_t ) xCompleteTickPeriods;
+			}
+
+			vPortEnableInterrupts();
+		}
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+static void prvSetupSignals( void )
+{
+struct sigaction xAction;
+
+	( void ) sigemptyset( &xTickSignal );
+	( void ) sigaddset( &xTickSignal, portTICK_SIGNAL );
+
+	memset( &xAction, 0x00, sizeof( xAction ) );
+	xAction.sa_handler = prvSystemTickHandler;
+	xAction.sa_flags = SA_RESTART;
+	( void ) sigfillset( &xAction.sa_mask );
+
+	if( sigaction( portTICK_SIGNAL, &xAction, NULL ) != 0 )
+	{
+		prvFatalError( "sigaction", errno );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvSetupTimerInterrupt( void )
+{
+struct itimerval xTimer;
+
+	xTimer.it_interval.tv_sec = 0;
+	xTimer.it_interval.tv_usec = portTICK_PERIOD_US;
+	xTimer.it_value = xTimer.it_interval;
+
+	if( setitimer( ITIMER_REAL, &xTimer, NULL ) != 0 )
+	{
+		prvFatalError( "setitimer", errno );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_TICKLESS_IDLE == 1 )
+
+	static void prvRestartTickTimer( long long llTimeToNextTickUs )
+	{
+	struct itimerval xTimer;
+
+		/* A zero value would disarm the timer rather than fire it. */
+		if( llTimeToNextTickUs <= 0 )
+		{
+			llTimeToNextTickUs = 1;
+		}
+
+		xTimer.it_interval.tv_sec = 0;
+		xTimer.it_interval.tv_usec = portTICK_PERIOD_US;
+		xTimer.it_value.tv_sec = ( time_t ) ( llTimeToNextTickUs / 1000000LL );
+		xTimer.it_value.tv_usec = ( suseconds_t ) ( llTimeToNextTickUs % 1000000LL );
+
+		if( setitimer( ITIMER_REAL, &xTimer, NULL ) != 0 )
+		{
+			prvFatalError( "setitimer", errno );
+		}
+	}
+
+#endif /* configUSE_TICKLESS_IDLE */
+/*-----------------------------------------------------------*/
+
+static void prvSystemTickHandler( int iSignal )
+{
+Thread_t *pxThreadToSuspend;
+Thread_t *pxThreadToResume;
+
+	( void ) iSignal;
+
+	/* The tick signal is masked while its handler runs. */
+	uxCriticalNesting++;
+
+	pxThreadToSuspend = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		vTaskSwitchContext();
+		pxThreadToResume = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+		prvSwitchThread( pxThreadToResume, pxThreadToSuspend );
+	}
+
+	uxCriticalNesting--;
+}
+/*-----------------------------------------------------------*/
+
+static void *prvWaitForStart( void *pvParams )
+{
+Thread_t *pxThread = ( Thread_t * ) pvParams;
+
+	prvEventWait( &( pxThread->xEvent ) );
+
+	/* The task starts with no critical nesting and the tick enabled. */
+	uxCriticalNesting = 0;
+	vPortEnableInterrupts();
+
+	pxThread->pxCode( pxThread->pvParams );
+
+	/* A function that implements a task must not exit or attempt to return to
+	its caller as there is nothing to return to.  Delete the task instead. */
+	vTaskDelete( NULL );
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwitchThread( Thread_t *pxThreadToResume, Thread_t *pxThreadToSuspend )
+{
+UBaseType_t uxSavedCriticalNesting;
+
+	if( pxThreadToSuspend != pxThreadToResume )
+	{
+		/* The critical nesting count belongs to the task, so keep it on the
+		stack of this thread while another task runs. */
+		uxSavedCriticalNesting = uxCriticalNesting;
+
+		prvEventSignal( &( pxThreadToResume->xEvent ) );
+
+		if( pxThreadToSuspend->xDying != pdFALSE )
+		{
+			/* The task deleted itself.  The thread is joined by the idle task
+			from vPortCancelThread(). */
+			pthread_exit( NULL );
+		}
+
+		prvEventWait( &( pxThreadToSuspend->xEvent ) );
+
+		uxCriticalNesting = uxSavedCriticalNesting;
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventInit( PortEvent_t *pxEvent )
+{
+	( void ) pthread_mutex_init( &( pxEvent->xMutex ), NULL );
+	( void ) pthread_cond_init( &( pxEvent->xCond ), NULL );
+	pxEvent->xSignalled = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventDelete( PortEvent_t *pxEvent )
+{
+	( void ) pthread_cond_destroy( &( pxEvent->xCond ) );
+	( void ) pthread_mutex_destroy( &( pxEvent->xMutex ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventSignal( PortEvent_t *pxEvent )
+{
+	( void ) pthread_mutex_lock( &( pxEvent->xMutex ) );
+	pxEvent->xSignalled = pdTRUE;
+	( void ) pthread_cond_signal( &( pxEvent->xCond ) );
+	( void ) pthread_mutex_unlock( &( pxEvent->xMutex ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventWait( PortEvent_t *pxEvent )
+{
+	( void ) pthread_mutex_lock( &( pxEvent->xMutex ) );
+
+	/* Release the mutex if the thread is cancelled while waiting. */
+	pthread_cleanup_push( prvEventUnlock, &( pxEvent->xMutex ) );
+
+	while( pxEvent->xSignalled == pdFALSE )
+	{
+		( void ) pthread_cond_wait( &( pxEvent->xCond ), &( pxEvent->xMutex ) );
+	}
+
+	pxEvent->xSignalled = pdFALSE;
+
+	pthread_cleanup_pop( 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventUnlock( void *pvMutex )
+{
+	( void ) pthread_mutex_unlock( ( pthread_mutex_t * ) pvMutex );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFatalError( const char *pcCall, int iErrno )
+{
+	fprintf( stderr, "%s: %s\n", pcCall, strerror( iErrno ) );
+	abort();
+}
+/*-----------------------------------------------------------*/
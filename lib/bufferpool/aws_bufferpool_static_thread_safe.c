@@ -23,15 +23,23 @@
  * http://www.FreeRTOS.org
  */
 
-
 /**
  * @file aws_bufferpool_static_thread_safe.c
  * @brief A thread safe implementation of the BufferPool interface.
  *
- * A pool of statically allocated buffers is maintained. The number
- * of buffers in the pool and the size of each buffer is controlled
- * via macros bufferpoolconfigNUM_BUFFERS and bufferpoolconfigBUFFER_SIZE
- * which must be defined in BufferPoolConfig.h.
+ * Pools of statically allocated buffers are maintained, one per size class.
+ * A request is served from the smallest class that fits it and still has a
+ * free buffer, so short packets such as received acknowledgements do not
+ * tie up a buffer sized for a full PUBLISH.
+ *
+ * The largest class is controlled via macros bufferpoolconfigNUM_BUFFERS and
+ * bufferpoolconfigBUFFER_SIZE which must be defined in BufferPoolConfig.h.
+ * The small and medium classes are optional and are controlled via
+ * bufferpoolconfigNUM_SMALL_BUFFERS, bufferpoolconfigSMALL_BUFFER_SIZE,
+ * bufferpoolconfigNUM_MEDIUM_BUFFERS and bufferpoolconfigMEDIUM_BUFFER_SIZE.
+ *
+ * Getting and returning a buffer is O(1) and never blocks, so both can be
+ * done from interrupts as well as from tasks.
  */
 
 /* FreeRTOS includes. */
@@ -51,80 +59,385 @@
     #error bufferpoolconfigBUFFER_SIZE must be defined in BufferPoolConfig.h
 #endif
 
+/* The small and medium size classes are disabled unless configured. */
+#ifndef bufferpoolconfigNUM_SMALL_BUFFERS
+    #define bufferpoolconfigNUM_SMALL_BUFFERS    ( 0 )
+#endif
+
+#ifndef bufferpoolconfigSMALL_BUFFER_SIZE
+    #define bufferpoolconfigSMALL_BUFFER_SIZE    ( 128 )
+#endif
+
+#ifndef bufferpoolconfigNUM_MEDIUM_BUFFERS
+    #define bufferpoolconfigNUM_MEDIUM_BUFFERS    ( 0 )
+#endif
+
+#ifndef bufferpoolconfigMEDIUM_BUFFER_SIZE
+    #define bufferpoolconfigMEDIUM_BUFFER_SIZE    ( 256 )
+#endif
+
+#if ( ( bufferpoolconfigSMALL_BUFFER_SIZE > bufferpoolconfigMEDIUM_BUFFER_SIZE ) || ( bufferpoolconfigMEDIUM_BUFFER_SIZE > bufferpoolconfigBUFFER_SIZE ) )
+    #error The buffer size classes must be configured in increasing order of size
+#endif
+
+/**
+ * @brief The number of size classes.
+ */
+#define bufferpoolstaticNUM_CLASSES    ( 3 )
+
+/**
+ * @brief Rounds the given buffer size up so that every buffer in a class
+ * starts at an address aligned as specified by portBYTE_ALIGNMENT.
+ *
+ * Free buffers store the free list link in their first bytes, so a buffer is
+ * never smaller than a pointer.
+ *
+ * @param[in] ulSize The configured buffer size.
+ */
+#define bufferpoolstaticSLOT_SIZE( ulSize )                                                  \
+    ( ( ( ( ulSize ) < sizeof( FreeBuffer_t ) ? sizeof( FreeBuffer_t ) : ( ulSize ) ) + \
+        ( portBYTE_ALIGNMENT - 1 ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) )
+
+/**
+ * @brief Size of the storage of a class, including the space needed to
+ * align its first buffer.
+ *
+ * @param[in] ulNumBuffers The number of buffers in the class.
+ * @param[in] ulSize The configured buffer size.
+ */
+#define bufferpoolstaticCLASS_STORAGE_SIZE( ulNumBuffers, ulSize )    ( ( ( ulNumBuffers ) * bufferpoolstaticSLOT_SIZE( ulSize ) ) + ( portBYTE_ALIGNMENT - 1 ) )
+
 /**
  * @brief Moves the given pointer ahead by the number of bytes required to
  * properly align it as specified by portBYTE_ALIGNMENT.
  *
  * @param[in] pucPtr The given pointer to be aligned.
  */
-#define bufferpoolstaticALIGN_POINTER( pucPtr )                                ( ( uint8_t * ) ( ( ( size_t ) ( pucPtr + ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) )
+#define bufferpoolstaticALIGN_POINTER( pucPtr )                       ( ( uint8_t * ) ( ( ( size_t ) ( pucPtr + ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) )
 
 /**
- * @brief Moves the given pointer ahead by the number of bytes required to
- * store the metadata.
+ * @brief Whether the free lists and counters are updated with the LDREX/STREX
+ * exclusive access instructions instead of with interrupts masked.
  *
- * @param[in] pucPtr The given pointer to move.
+ * A sequence that is interrupted has its STREX fail and is retried, so no
+ * interrupt is ever masked.  The exclusive monitor is cleared on exception
+ * entry and return, which also makes the free list pop immune to ABA.
+ * Defaults to 1 when building with GCC for ARMv7-M (Cortex-M3/M4/M7).
  */
-#define bufferpoolstaticRESERVE_METADATA_SPACE( pucPtr )                       ( ( uint8_t * ) ( pucPtr + sizeof( BufferMetadata_t ) ) )
+#ifndef bufferpoolconfigUSE_EXCLUSIVE_ACCESS
+    #if defined( __GNUC__ ) && ( defined( __ARM_ARCH_7M__ ) || defined( __ARM_ARCH_7EM__ ) )
+        #define bufferpoolconfigUSE_EXCLUSIVE_ACCESS    ( 1 )
+    #else
+        #define bufferpoolconfigUSE_EXCLUSIVE_ACCESS    ( 0 )
+    #endif
+#endif
+/*-----------------------------------------------------------*/
 
 /**
- * @brief Extracts the location of the user data in the given buffer. The data
- * location is ensured to be properly aligned as specified by portBYTE_ALIGNMENT.
- *
- * @param[in] pucBuffer The buffer for which to find the user data location.
+ * @brief Overlays the start of a buffer while it is on a free list.
+ */
+typedef struct FreeBuffer
+{
+    struct FreeBuffer * pxNext; /**< The next free buffer of the same class. */
+} FreeBuffer_t;
+
+/**
+ * @brief A size class of buffers.
  */
-#define bufferpoolstaticDATA_LOCATION_IN_BUFFER( pucBuffer )                   ( ( uint8_t * ) ( bufferpoolstaticALIGN_POINTER( bufferpoolstaticRESERVE_METADATA_SPACE( pucBuffer ) ) ) )
+typedef struct BufferClass
+{
+    uint8_t * pucStart;                 /**< The first buffer of the class. */
+    uint8_t * pucEnd;                   /**< One past the last buffer of the class. */
+    uint32_t ulBufferSize;              /**< Size reported to the user for each buffer. */
+    uint32_t ulSlotSize;                /**< Distance between two buffers of the class. */
+    FreeBuffer_t * volatile pxFreeList; /**< The free buffers of the class. */
+    volatile uint32_t ulInUse;          /**< Number of buffers handed out. */
+    volatile uint32_t ulMaxInUse;       /**< High-water mark of ulInUse. */
+} BufferClass_t;
+/*-----------------------------------------------------------*/
 
 /**
- * @brief Given the data location in a buffer, extracts the buffer "in-use"
- * information from the metadata portion of the buffer.
+ * @brief The statically allocated storage of each size class.
+ *
+ * The number and size of the buffers of each class are controlled via the
+ * bufferpoolconfig macros which must be defined in BufferPoolConfig.h.
  *
- * @param[in] pucDataLocation The given data location in the buffer.
+ * @note Each class allocates additional space to ensure alignment.
  */
-#define bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( pucDataLocation )    ( ( ( BufferMetadata_t * ) ( ( pucDataLocation ) - sizeof( BufferMetadata_t ) ) )->ucBufferInUse )
+#if ( bufferpoolconfigNUM_SMALL_BUFFERS > 0 )
+    static uint8_t ucSmallBufferPool[ bufferpoolstaticCLASS_STORAGE_SIZE( bufferpoolconfigNUM_SMALL_BUFFERS, bufferpoolconfigSMALL_BUFFER_SIZE ) ];
+#endif
+
+#if ( bufferpoolconfigNUM_MEDIUM_BUFFERS > 0 )
+    static uint8_t ucMediumBufferPool[ bufferpoolstaticCLASS_STORAGE_SIZE( bufferpoolconfigNUM_MEDIUM_BUFFERS, bufferpoolconfigMEDIUM_BUFFER_SIZE ) ];
+#endif
+
+static uint8_t ucBufferPool[ bufferpoolstaticCLASS_STORAGE_SIZE( bufferpoolconfigNUM_BUFFERS, bufferpoolconfigBUFFER_SIZE ) ];
 
 /**
- * @brief Extracts the buffer "in-use" information from the metadata portion
- * of the given buffer.
+ * @brief The size classes, in increasing order of buffer size.
  *
- * @param[in] pucBuffer The given buffer.
+ * A class without buffers has an empty address range and free list.
  */
-#define bufferpoolstaticBUFFER_IN_USE( pucBuffer )                             bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( bufferpoolstaticDATA_LOCATION_IN_BUFFER( pucBuffer ) )
+static BufferClass_t xBufferClasses[ bufferpoolstaticNUM_CLASSES ];
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Metadata added in the beginning of each buffer.
+ * @brief Lays out the buffers of a class and puts all of them on its free
+ * list.
+ *
+ * @param[out] pxClass The class to initialize.
+ * @param[in] pucStorage The storage of the class, or NULL if it has no buffers.
+ * @param[in] ulNumBuffers The number of buffers in the class.
+ * @param[in] ulBufferSize The configured buffer size of the class.
  */
-typedef struct BufferMetadata
-{
-    uint8_t ucBufferInUse; /**< Whether or not the buffer is in use. */
-} BufferMetadata_t;
-/*-----------------------------------------------------------*/
+static void prvInitClass( BufferClass_t * pxClass,
+                          uint8_t * pucStorage,
+                          uint32_t ulNumBuffers,
+                          uint32_t ulBufferSize );
 
 /**
- * @brief The pool of statically allocated buffers.
+ * @brief Takes the first buffer off the free list of a class and accounts
+ * for it in the usage counters.
+ *
+ * Safe to call from tasks and interrupts.
  *
- * The number of buffers in the pool and the size of each buffer is controlled
- * via macros bufferpoolconfigNUM_BUFFERS and bufferpoolconfigBUFFER_SIZE which
- * must be defined in BufferPoolConfig.h.
+ * @param[in] pxClass The class to take a buffer from.
  *
- * @note Each buffer in the buffer pool allocates additional the space required
- * to store the metadata and to ensure alignment.
+ * @return The buffer, or NULL if the class has no free buffer.
  */
-static uint8_t ucBufferPool[ bufferpoolconfigNUM_BUFFERS ][ sizeof( BufferMetadata_t ) + bufferpoolconfigBUFFER_SIZE + ( portBYTE_ALIGNMENT - 1 ) ];
+static FreeBuffer_t * prvTakeBuffer( BufferClass_t * pxClass );
+
+/**
+ * @brief Puts a buffer back on the free list of its class and accounts for
+ * it in the usage counters.
+ *
+ * Safe to call from tasks and interrupts.
+ *
+ * @param[in] pxClass The class the buffer belongs to.
+ * @param[in] pxBuffer The buffer to put back.
+ */
+static void prvGiveBuffer( BufferClass_t * pxClass,
+                           FreeBuffer_t * pxBuffer );
 /*-----------------------------------------------------------*/
 
-BaseType_t BUFFERPOOL_Init( void )
+#if ( bufferpoolconfigUSE_EXCLUSIVE_ACCESS == 1 )
+
+/**
+ * @brief LDREX: loads a word and marks its address for exclusive access.
+ */
+    static portFORCE_INLINE uint32_t prvLoadExclusive( volatile uint32_t * pulAddress )
+    {
+        uint32_t ulValue;
+
+        __asm volatile ( "ldrex %0, [%1]" : "=r" ( ulValue ) : "r" ( pulAddress ) : "memory" );
+
+        return ulValue;
+    }
+
+/**
+ * @brief STREX: stores a word if the address is still marked for exclusive
+ * access.
+ *
+ * @return 0 if the store was done, 1 if it must be retried.
+ */
+    static portFORCE_INLINE uint32_t prvStoreExclusive( volatile uint32_t * pulAddress,
+                                                        uint32_t ulValue )
+    {
+        uint32_t ulFailed;
+
+        __asm volatile ( "strex %0, %2, [%1]" : "=&r" ( ulFailed ) : "r" ( pulAddress ), "r" ( ulValue ) : "memory" );
+
+        return ulFailed;
+    }
+
+/**
+ * @brief CLREX: drops the exclusive access mark when no store follows.
+ */
+    static portFORCE_INLINE void prvClearExclusive( void )
+    {
+        __asm volatile ( "clrex" : : : "memory" );
+    }
+
+/**
+ * @brief Adds to a usage counter and raises the high-water mark if needed.
+ */
+    static void prvUpdateCounters( BufferClass_t * pxClass,
+                                   int32_t lDelta )
+    {
+        uint32_t ulInUse;
+        uint32_t ulMax;
+        BaseType_t xDone = pdFALSE;
+
+        do
+        {
+            ulInUse = prvLoadExclusive( &pxClass->ulInUse ) + ( uint32_t ) lDelta;
+        } while( prvStoreExclusive( &pxClass->ulInUse, ulInUse ) != 0 );
+
+        while( xDone == pdFALSE )
+        {
+            ulMax = prvLoadExclusive( &pxClass->ulMaxInUse );
+
+            if( ulInUse <= ulMax )
+            {
+                prvClearExclusive();
+                xDone = pdTRUE;
+            }
+            else if( prvStoreExclusive( &pxClass->ulMaxInUse, ulInUse ) == 0 )
+            {
+                xDone = pdTRUE;
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static FreeBuffer_t * prvTakeBuffer( BufferClass_t * pxClass )
+    {
+        FreeBuffer_t * pxBuffer;
+        uint32_t ulFailed;
+
+        do
+        {
+            pxBuffer = ( FreeBuffer_t * ) prvLoadExclusive( ( volatile uint32_t * ) &pxClass->pxFreeList ); /*lint !e923 !e9078 The list head is a word. */
+
+            if( pxBuffer == NULL )
+            {
+                prvClearExclusive();
+                ulFailed = 0;
+            }
+            else
+            {
+                /* If another context took this buffer and wrote to it after
+                 * the LDREX, it also ran an exception entry or return which
+                 * cleared the monitor, so the STREX fails and the stale link
+                 * is never stored. */
+                ulFailed = prvStoreExclusive( ( volatile uint32_t * ) &pxClass->pxFreeList, ( uint32_t ) pxBuffer->pxNext ); /*lint !e923 !e9078 The list head is a word. */
+            }
+        } while( ulFailed != 0 );
+
+        if( pxBuffer != NULL )
+        {
+            prvUpdateCounters( pxClass, 1 );
+        }
+
+        return pxBuffer;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvGiveBuffer( BufferClass_t * pxClass,
+                               FreeBuffer_t * pxBuffer )
+    {
+        do
+        {
+            pxBuffer->pxNext = ( FreeBuffer_t * ) prvLoadExclusive( ( volatile uint32_t * ) &pxClass->pxFreeList ); /*lint !e923 !e9078 The list head is a word. */
+        } while( prvStoreExclusive( ( volatile uint32_t * ) &pxClass->pxFreeList, ( uint32_t ) pxBuffer ) != 0 ); /*lint !e923 !e9078 The list head is a word. */
+
+        prvUpdateCounters( pxClass, -1 );
+    }
+/*-----------------------------------------------------------*/
+
+#else /* if ( bufferpoolconfigUSE_EXCLUSIVE_ACCESS == 1 ) */
+
+/* Without exclusive access instructions the lists are updated with
+ * interrupts masked.  The _FROM_ISR variant of the critical section is used
+ * because it can be called from both tasks and interrupts. */
+
+    static FreeBuffer_t * prvTakeBuffer( BufferClass_t * pxClass )
+    {
+        FreeBuffer_t * pxBuffer;
+        UBaseType_t uxSavedInterruptStatus;
+
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        {
+            pxBuffer = pxClass->pxFreeList;
+
+            if( pxBuffer != NULL )
+            {
+                pxClass->pxFreeList = pxBuffer->pxNext;
+                pxClass->ulInUse++;
+
+                if( pxClass->ulInUse > pxClass->ulMaxInUse )
+                {
+                    pxClass->ulMaxInUse = pxClass->ulInUse;
+                }
+            }
+        }
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+        return pxBuffer;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvGiveBuffer( BufferClass_t * pxClass,
+                               FreeBuffer_t * pxBuffer )
+    {
+        UBaseType_t uxSavedInterruptStatus;
+
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        {
+            pxBuffer->pxNext = pxClass->pxFreeList;
+            pxClass->pxFreeList = pxBuffer;
+            pxClass->ulInUse--;
+        }
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* if ( bufferpoolconfigUSE_EXCLUSIVE_ACCESS == 1 ) */
+
+static void prvInitClass( BufferClass_t * pxClass,
+                          uint8_t * pucStorage,
+                          uint32_t ulNumBuffers,
+                          uint32_t ulBufferSize )
 {
-    BaseType_t x = 0;
+    uint32_t x = 0;
+    FreeBuffer_t * pxBuffer;
 
-    /* This function is supposed to be called exactly once
-     * and hence no thread safety is ensured. */
-    for( x = 0; x < bufferpoolconfigNUM_BUFFERS; x++ )
+    pxClass->ulBufferSize = ulBufferSize;
+    pxClass->ulSlotSize = ( uint32_t ) bufferpoolstaticSLOT_SIZE( ulBufferSize );
+    pxClass->pxFreeList = NULL;
+    pxClass->ulInUse = 0;
+    pxClass->ulMaxInUse = 0;
+
+    if( pucStorage == NULL )
     {
-        /* Mark all the buffers as free. */
-        bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) = 0;
+        pxClass->pucStart = NULL;
+        pxClass->pucEnd = NULL;
     }
+    else
+    {
+        pxClass->pucStart = bufferpoolstaticALIGN_POINTER( pucStorage );
+        pxClass->pucEnd = pxClass->pucStart + ( ulNumBuffers * pxClass->ulSlotSize );
+
+        /* Push the buffers in reverse so that they are handed out in
+         * address order. */
+        for( x = ulNumBuffers; x > 0; x-- )
+        {
+            pxBuffer = ( FreeBuffer_t * ) ( pxClass->pucStart + ( ( x - 1 ) * pxClass->ulSlotSize ) ); /*lint !e9087 !e826 The slot is aligned and large enough for the link. */
+            pxBuffer->pxNext = pxClass->pxFreeList;
+            pxClass->pxFreeList = pxBuffer;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t BUFFERPOOL_Init( void )
+{
+    /* This function is supposed to be called exactly once
+     * and hence no thread safety is ensured. */
+    #if ( bufferpoolconfigNUM_SMALL_BUFFERS > 0 )
+        prvInitClass( &xBufferClasses[ 0 ], ucSmallBufferPool, bufferpoolconfigNUM_SMALL_BUFFERS, bufferpoolconfigSMALL_BUFFER_SIZE );
+    #else
+        prvInitClass( &xBufferClasses[ 0 ], NULL, 0, bufferpoolconfigSMALL_BUFFER_SIZE );
+    #endif
+
+    #if ( bufferpoolconfigNUM_MEDIUM_BUFFERS > 0 )
+        prvInitClass( &xBufferClasses[ 1 ], ucMediumBufferPool, bufferpoolconfigNUM_MEDIUM_BUFFERS, bufferpoolconfigMEDIUM_BUFFER_SIZE );
+    #else
+        prvInitClass( &xBufferClasses[ 1 ], NULL, 0, bufferpoolconfigMEDIUM_BUFFER_SIZE );
+    #endif
+
+    prvInitClass( &xBufferClasses[ 2 ], ucBufferPool, bufferpoolconfigNUM_BUFFERS, bufferpoolconfigBUFFER_SIZE );
 
     return pdPASS;
 }
@@ -133,62 +446,103 @@ BaseType_t BUFFERPOOL_Init( void )
 uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength )
 {
     BaseType_t x = 0;
-    uint8_t * pucFreeBuffer = NULL;
+    BufferClass_t * pxClass;
+    FreeBuffer_t * pxFreeBuffer = NULL;
 
-    /* All the buffers in the pool are of size bufferpoolconfigBUFFER_SIZE,
-     * so we cannot provide any buffer larger than that. */
-    if( *pulBufferLength <= bufferpoolconfigBUFFER_SIZE )
+    /* Try the classes from the smallest up, so that a request only falls
+     * back to larger buffers once every class that fits it is exhausted. */
+    for( x = 0; x < bufferpoolstaticNUM_CLASSES; x++ )
     {
-        /* Iterate over all the buffers to find a free buffer. */
-        for( x = 0; x < bufferpoolconfigNUM_BUFFERS; x++ )
+        pxClass = &xBufferClasses[ x ];
+
+        if( *pulBufferLength <= pxClass->ulBufferSize )
         {
-            /* Start critical section. */
-            taskENTER_CRITICAL();
+            /* Take the first free buffer of the class, if any. */
+            pxFreeBuffer = prvTakeBuffer( pxClass );
 
-            /* Check if the buffer is free. */
-            if( bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) == 0 )
+            if( pxFreeBuffer != NULL )
             {
-                /* Mark the buffer as "in-use". */
-                bufferpoolstaticBUFFER_IN_USE( ucBufferPool[ x ] ) = 1;
-
-                /* End critical section. The further operations in this
-                 * if branch do not modify the buffer and hence the critical
-                 * section is not needed hereafter. */
-                taskEXIT_CRITICAL();
-
-                /* Return the actual buffer size (as configured by the
-                 * bufferpoolconfigBUFFER_SIZE macro) to the user. */
-                *pulBufferLength = bufferpoolconfigBUFFER_SIZE;
-
-                /* Return the data location to the user. */
-                pucFreeBuffer = bufferpoolstaticDATA_LOCATION_IN_BUFFER( ucBufferPool[ x ] );
+                /* Return the actual buffer size (as configured for the
+                 * class) to the user. */
+                *pulBufferLength = pxClass->ulBufferSize;
 
                 /* Stop as we have found a buffer. */
                 break;
             }
-            else
-            {
-                /* End critical section. */
-                taskEXIT_CRITICAL();
-            }
         }
     }
 
-    return pucFreeBuffer;
+    return ( uint8_t * ) pxFreeBuffer;
 }
 /*-----------------------------------------------------------*/
 
 void BUFFERPOOL_ReturnBuffer( uint8_t * const pucBuffer )
 {
-    /* Start critical section. */
-    taskENTER_CRITICAL();
+    BaseType_t x = 0;
+    BufferClass_t * pxClass = NULL;
+    FreeBuffer_t * pxBuffer = ( FreeBuffer_t * ) pucBuffer; /*lint !e9087 !e826 Buffers handed out are aligned slots. */
+
+    /* Find the class the buffer belongs to from its address. */
+    for( x = 0; x < bufferpoolstaticNUM_CLASSES; x++ )
+    {
+        if( ( pucBuffer >= xBufferClasses[ x ].pucStart ) &&
+            ( pucBuffer < xBufferClasses[ x ].pucEnd ) )
+        {
+            pxClass = &xBufferClasses[ x ];
+            break;
+        }
+    }
+
+    /* The buffer must be one that BUFFERPOOL_GetFreeBuffer handed out. */
+    configASSERT( pxClass != NULL );
+    configASSERT( ( ( uint32_t ) ( pucBuffer - pxClass->pucStart ) % pxClass->ulSlotSize ) == 0 );
+
+    if( pxClass != NULL )
+    {
+        /* Put the buffer back on the free list of its class. */
+        prvGiveBuffer( pxClass, pxBuffer );
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t BUFFERPOOL_GetHighWaterMark( uint32_t ulBufferLength )
+{
+    BaseType_t x = 0;
+    uint32_t ulMaxInUse = 0;
 
-    /* Mark the buffer as free. The returned buffer is the data
-     * location in the actual buffer (because we gave the data location
-     * to the user). */
-    bufferpoolstaticBUFFER_IN_USE_FROM_DATA_LOCATION( pucBuffer ) = 0;
+    /* Report the class that requests of this length are served from first. */
+    for( x = 0; x < bufferpoolstaticNUM_CLASSES; x++ )
+    {
+        if( ( xBufferClasses[ x ].pucStart != NULL ) &&
+            ( ulBufferLength <= xBufferClasses[ x ].ulBufferSize ) )
+        {
+            ulMaxInUse = xBufferClasses[ x ].ulMaxInUse;
+            break;
+        }
+    }
+
+    return ulMaxInUse;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t BUFFERPOOL_GetStats( BufferPoolStats_t * pxStats,
+                              uint32_t ulMaxClasses )
+{
+    BaseType_t x = 0;
+    uint32_t ulClasses = 0;
+
+    for( x = 0; ( x < bufferpoolstaticNUM_CLASSES ) && ( ulClasses < ulMaxClasses ); x++ )
+    {
+        if( xBufferClasses[ x ].pucStart != NULL )
+        {
+            pxStats[ ulClasses ].ulBufferSize = xBufferClasses[ x ].ulBufferSize;
+            pxStats[ ulClasses ].ulNumBuffers = ( uint32_t ) ( xBufferClasses[ x ].pucEnd - xBufferClasses[ x ].pucStart ) / xBufferClasses[ x ].ulSlotSize;
+            pxStats[ ulClasses ].ulInUse = xBufferClasses[ x ].ulInUse;
+            pxStats[ ulClasses ].ulMaxInUse = xBufferClasses[ x ].ulMaxInUse;
+            ulClasses++;
+        }
+    }
 
-    /* End critical section. */
-    taskEXIT_CRITICAL();
+    return ulClasses;
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,867 @@
+/*
+ * Amazon FreeRTOS Crypto V1.0.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_aes_alt.c
+ * @brief AES for mbedTLS, built with MBEDTLS_AES_ALT.
+ *
+ * Blocks go to the registered crypto accelerator if it implements AES, see
+ * aws_crypto_accelerator.h, and to a word-oriented T-table kernel otherwise.
+ * The kernel keeps a single forward and a single reverse table and derives
+ * the other three columns by rotation, which costs nothing on Cortex-M where
+ * the barrel shifter can rotate an operand of EOR.  That saves 6 KB of flash
+ * over the four tables of the stock aes.c.  All rounds are unrolled.
+ */
+
+/* mbedTLS includes. */
+#include "mbedtls/config.h"
+
+#if defined( MBEDTLS_AES_C ) && defined( MBEDTLS_AES_ALT )
+
+#include "mbedtls/aes.h"
+#include "mbedtls/platform_util.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "aws_crypto_accelerator.h"
+
+/* C runtime includes. */
+#include <string.h>
+
+/**
+ * @brief Reads a little endian 32-bit word from a byte array.
+ */
+#define aesGET_UINT32_LE( pucBytes )                 \
+    ( ( ( uint32_t ) ( pucBytes )[ 0 ] ) |           \
+      ( ( uint32_t ) ( pucBytes )[ 1 ] << 8 ) |      \
+      ( ( uint32_t ) ( pucBytes )[ 2 ] << 16 ) |     \
+      ( ( uint32_t ) ( pucBytes )[ 3 ] << 24 ) )
+
+/**
+ * @brief Writes a 32-bit word to a byte array, little endian.
+ */
+#define aesPUT_UINT32_LE( ulWord, pucBytes )                     \
+    {                                                            \
+        ( pucBytes )[ 0 ] = ( unsigned char ) ( ulWord );        \
+        ( pucBytes )[ 1 ] = ( unsigned char ) ( ( ulWord ) >> 8 );  \
+        ( pucBytes )[ 2 ] = ( unsigned char ) ( ( ulWord ) >> 16 ); \
+        ( pucBytes )[ 3 ] = ( unsigned char ) ( ( ulWord ) >> 24 ); \
+    }
+
+/**
+ * @brief Rotates a 32-bit word left.
+ */
+#define aesROTL( ulWord, ulBits )    ( ( ( ulWord ) << ( ulBits ) ) | ( ( ulWord ) >> ( 32 - ( ulBits ) ) ) )
+/*-----------------------------------------------------------*/
+
+/*
+ * Forward table: byte 0 = 2.S[x], byte 1 = S[x], byte 2 = S[x], byte 3 = 3.S[x].
+ */
+static const uint32_t ulForwardTable[ 256 ] =
+{
+    0xA56363C6UL, 0x847C7CF8UL, 0x997777EEUL, 0x8D7B7BF6UL,
+    0x0DF2F2FFUL, 0xBD6B6BD6UL, 0xB16F6FDEUL, 0x54C5C591UL,
+    0x50303060UL, 0x03010102UL, 0xA96767CEUL, 0x7D2B2B56UL,
+    0x19FEFEE7UL, 0x62D7D7B5UL, 0xE6ABAB4DUL, 0x9A7676ECUL,
+    0x45CACA8FUL, 0x9D82821FUL, 0x40C9C989UL, 0x877D7DFAUL,
+    0x15FAFAEFUL, 0xEB5959B2UL, 0xC947478EUL, 0x0BF0F0FBUL,
+    0xECADAD41UL, 0x67D4D4B3UL, 0xFDA2A25FUL, 0xEAAFAF45UL,
+    0xBF9C9C23UL, 0xF7A4A453UL, 0x967272E4UL, 0x5BC0C09BUL,
+    0xC2B7B775UL, 0x1CFDFDE1UL, 0xAE93933DUL, 0x6A26264CUL,
+    0x5A36366CUL, 0x413F3F7EUL, 0x02F7F7F5UL, 0x4FCCCC83UL,
+    0x5C343468UL, 0xF4A5A551UL, 0x34E5E5D1UL, 0x08F1F1F9UL,
+    0x937171E2UL, 0x73D8D8ABUL, 0x53313162UL, 0x3F15152AUL,
+    0x0C040408UL, 0x52C7C795UL, 0x65232346UL, 0x5EC3C39DUL,
+    0x28181830UL, 0xA1969637UL, 0x0F05050AUL, 0xB59A9A2FUL,
+    0x0907070EUL, 0x36121224UL, 0x9B80801BUL, 0x3DE2E2DFUL,
+    0x26EBEBCDUL, 0x6927274EUL, 0xCDB2B27FUL, 0x9F7575EAUL,
+    0x1B090912UL, 0x9E83831DUL, 0x742C2C58UL, 0x2E1A1A34UL,
+    0x2D1B1B36UL, 0xB26E6EDCUL, 0xEE5A5AB4UL, 0xFBA0A05BUL,
+    0xF65252A4UL, 0x4D3B3B76UL, 0x61D6D6B7UL, 0xCEB3B37DUL,
+    0x7B292952UL, 0x3EE3E3DDUL, 0x712F2F5EUL, 0x97848413UL,
+    0xF55353A6UL, 0x68D1D1B9UL, 0x00000000UL, 0x2CEDEDC1UL,
+    0x60202040UL, 0x1FFCFCE3UL, 0xC8B1B179UL, 0xED5B5BB6UL,
+    0xBE6A6AD4UL, 0x46CBCB8DUL, 0xD9BEBE67UL, 0x4B393972UL,
+    0xDE4A4A94UL, 0xD44C4C98UL, 0xE85858B0UL, 0x4ACFCF85UL,
+    0x6BD0D0BBUL, 0x2AEFEFC5UL, 0xE5AAAA4FUL, 0x16FBFBEDUL,
+    0xC5434386UL, 0xD74D4D9AUL, 0x55333366UL, 0x94858511UL,
+    0xCF45458AUL, 0x10F9F9E9UL, 0x06020204UL, 0x817F7FFEUL,
+    0xF05050A0UL, 0x443C3C78UL, 0xBA9F9F25UL, 0xE3A8A84BUL,
+    0xF35151A2UL, 0xFEA3A35DUL, 0xC0404080UL, 0x8A8F8F05UL,
+    0xAD92923FUL, 0xBC9D9D21UL, 0x48383870UL, 0x04F5F5F1UL,
+    0xDFBCBC63UL, 0xC1B6B677UL, 0x75DADAAFUL, 0x63212142UL,
+    0x30101020UL, 0x1AFFFFE5UL, 0x0EF3F3FDUL, 0x6DD2D2BFUL,
+    0x4CCDCD81UL, 0x140C0C18UL, 0x35131326UL, 0x2FECECC3UL,
+    0xE15F5FBEUL, 0xA2979735UL, 0xCC444488UL, 0x3917172EUL,
+    0x57C4C493UL, 0xF2A7A755UL, 0x827E7EFCUL, 0x473D3D7AUL,
+    0xAC6464C8UL, 0xE75D5DBAUL, 0x2B191932UL, 0x957373E6UL,
+    0xA06060C0UL, 0x98818119UL, 0xD14F4F9EUL, 0x7FDCDCA3UL,
+    0x66222244UL, 0x7E2A2A54UL, 0xAB90903BUL, 0x8388880BUL,
+    0xCA46468CUL, 0x29EEEEC7UL, 0xD3B8B86BUL, 0x3C141428UL,
+    0x79DEDEA7UL, 0xE25E5EBCUL, 0x1D0B0B16UL, 0x76DBDBADUL,
+    0x3BE0E0DBUL, 0x56323264UL, 0x4E3A3A74UL, 0x1E0A0A14UL,
+    0xDB494992UL, 0x0A06060CUL, 0x6C242448UL, 0xE45C5CB8UL,
+    0x5DC2C29FUL, 0x6ED3D3BDUL, 0xEFACAC43UL, 0xA66262C4UL,
+    0xA8919139UL, 0xA4959531UL, 0x37E4E4D3UL, 0x8B7979F2UL,
+    0x32E7E7D5UL, 0x43C8C88BUL, 0x5937376EUL, 0xB76D6DDAUL,
+    0x8C8D8D01UL, 0x64D5D5B1UL, 0xD24E4E9CUL, 0xE0A9A949UL,
+    0xB46C6CD8UL, 0xFA5656ACUL, 0x07F4F4F3UL, 0x25EAEACFUL,
+    0xAF6565CAUL, 0x8E7A7AF4UL, 0xE9AEAE47UL, 0x18080810UL,
+    0xD5BABA6FUL, 0x887878F0UL, 0x6F25254AUL, 0x722E2E5CUL,
+    0x241C1C38UL, 0xF1A6A657UL, 0xC7B4B473UL, 0x51C6C697UL,
+    0x23E8E8CBUL, 0x7CDDDDA1UL, 0x9C7474E8UL, 0x211F1F3EUL,
+    0xDD4B4B96UL, 0xDCBDBD61UL, 0x868B8B0DUL, 0x858A8A0FUL,
+    0x907070E0UL, 0x423E3E7CUL, 0xC4B5B571UL, 0xAA6666CCUL,
+    0xD8484890UL, 0x05030306UL, 0x01F6F6F7UL, 0x120E0E1CUL,
+    0xA36161C2UL, 0x5F35356AUL, 0xF95757AEUL, 0xD0B9B969UL,
+    0x91868617UL, 0x58C1C199UL, 0x271D1D3AUL, 0xB99E9E27UL,
+    0x38E1E1D9UL, 0x13F8F8EBUL, 0xB398982BUL, 0x33111122UL,
+    0xBB6969D2UL, 0x70D9D9A9UL, 0x898E8E07UL, 0xA7949433UL,
+    0xB69B9B2DUL, 0x221E1E3CUL, 0x92878715UL, 0x20E9E9C9UL,
+    0x49CECE87UL, 0xFF5555AAUL, 0x78282850UL, 0x7ADFDFA5UL,
+    0x8F8C8C03UL, 0xF8A1A159UL, 0x80898909UL, 0x170D0D1AUL,
+    0xDABFBF65UL, 0x31E6E6D7UL, 0xC6424284UL, 0xB86868D0UL,
+    0xC3414182UL, 0xB0999929UL, 0x772D2D5AUL, 0x110F0F1EUL,
+    0xCBB0B07BUL, 0xFC5454A8UL, 0xD6BBBB6DUL, 0x3A16162CUL
+};
+
+/* Forward S-box. */
+static const uint8_t ucForwardSBox[ 256 ] =
+{
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5,
+    0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0,
+    0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC,
+    0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A,
+    0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0,
+    0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B,
+    0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85,
+    0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5,
+    0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17,
+    0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88,
+    0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C,
+    0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9,
+    0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6,
+    0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E,
+    0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94,
+    0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68,
+    0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+/*
+ * Reverse table: byte 0 = E.Si[x], byte 1 = 9.Si[x], byte 2 = D.Si[x],
+ * byte 3 = B.Si[x].
+ */
+static const uint32_t ulReverseTable[ 256 ] =
+{
+    0x50A7F451UL, 0x5365417EUL, 0xC3A4171AUL, 0x965E273AUL,
+    0xCB6BAB3BUL, 0xF1459D1FUL, 0xAB58FAACUL, 0x9303E34BUL,
+    0x55FA3020UL, 0xF66D76ADUL, 0x9176CC88UL, 0x254C02F5UL,
+    0xFCD7E54FUL, 0xD7CB2AC5UL, 0x80443526UL, 0x8FA362B5UL,
+    0x495AB1DEUL, 0x671BBA25UL, 0x980EEA45UL, 0xE1C0FE5DUL,
+    0x02752FC3UL, 0x12F04C81UL, 0xA397468DUL, 0xC6F9D36BUL,
+    0xE75F8F03UL, 0x959C9215UL, 0xEB7A6DBFUL, 0xDA595295UL,
+    0x2D83BED4UL, 0xD3217458UL, 0x2969E049UL, 0x44C8C98EUL,
+    0x6A89C275UL, 0x78798EF4UL, 0x6B3E5899UL, 0xDD71B927UL,
+    0xB64FE1BEUL, 0x17AD88F0UL, 0x66AC20C9UL, 0xB43ACE7DUL,
+    0x184ADF63UL, 0x82311AE5UL, 0x60335197UL, 0x457F5362UL,
+    0xE07764B1UL, 0x84AE6BBBUL, 0x1CA081FEUL, 0x942B08F9UL,
+    0x58684870UL, 0x19FD458FUL, 0x876CDE94UL, 0xB7F87B52UL,
+    0x23D373ABUL, 0xE2024B72UL, 0x578F1FE3UL, 0x2AAB5566UL,
+    0x0728EBB2UL, 0x03C2B52FUL, 0x9A7BC586UL, 0xA50837D3UL,
+    0xF2872830UL, 0xB2A5BF23UL, 0xBA6A0302UL, 0x5C8216EDUL,
+    0x2B1CCF8AUL, 0x92B479A7UL, 0xF0F207F3UL, 0xA1E2694EUL,
+    0xCDF4DA65UL, 0xD5BE0506UL, 0x1F6234D1UL, 0x8AFEA6C4UL,
+    0x9D532E34UL, 0xA055F3A2UL, 0x32E18A05UL, 0x75EBF6A4UL,
+    0x39EC830BUL, 0xAAEF6040UL, 0x069F715EUL, 0x51106EBDUL,
+    0xF98A213EUL, 0x3D06DD96UL, 0xAE053EDDUL, 0x46BDE64DUL,
+    0xB58D5491UL, 0x055DC471UL, 0x6FD40604UL, 0xFF155060UL,
+    0x24FB9819UL, 0x97E9BDD6UL, 0xCC434089UL, 0x779ED967UL,
+    0xBD42E8B0UL, 0x888B8907UL, 0x385B19E7UL, 0xDBEEC879UL,
+    0x470A7CA1UL, 0xE90F427CUL, 0xC91E84F8UL, 0x00000000UL,
+    0x83868009UL, 0x48ED2B32UL, 0xAC70111EUL, 0x4E725A6CUL,
+    0xFBFF0EFDUL, 0x5638850FUL, 0x1ED5AE3DUL, 0x27392D36UL,
+    0x64D90F0AUL, 0x21A65C68UL, 0xD1545B9BUL, 0x3A2E3624UL,
+    0xB1670A0CUL, 0x0FE75793UL, 0xD296EEB4UL, 0x9E919B1BUL,
+    0x4FC5C080UL, 0xA220DC61UL, 0x694B775AUL, 0x161A121CUL,
+    0x0ABA93E2UL, 0xE52AA0C0UL, 0x43E0223CUL, 0x1D171B12UL,
+    0x0B0D090EUL, 0xADC78BF2UL, 0xB9A8B62DUL, 0xC8A91E14UL,
+    0x8519F157UL, 0x4C0775AFUL, 0xBBDD99EEUL, 0xFD607FA3UL,
+    0x9F2601F7UL, 0xBCF5725CUL, 0xC53B6644UL, 0x347EFB5BUL,
+    0x7629438BUL, 0xDCC623CBUL, 0x68FCEDB6UL, 0x63F1E4B8UL,
+    0xCADC31D7UL, 0x10856342UL, 0x40229713UL, 0x2011C684UL,
+    0x7D244A85UL, 0xF83DBBD2UL, 0x1132F9AEUL, 0x6DA129C7UL,
+    0x4B2F9E1DUL, 0xF330B2DCUL, 0xEC52860DUL, 0xD0E3C177UL,
+    0x6C16B32BUL, 0x99B970A9UL, 0xFA489411UL, 0x2264E947UL,
+    0xC48CFCA8UL, 0x1A3FF0A0UL, 0xD82C7D56UL, 0xEF903322UL,
+    0xC74E4987UL, 0xC1D138D9UL, 0xFEA2CA8CUL, 0x360BD498UL,
+    0xCF81F5A6UL, 0x28DE7AA5UL, 0x268EB7DAUL, 0xA4BFAD3FUL,
+    0xE49D3A2CUL, 0x0D927850UL, 0x9BCC5F6AUL, 0x62467E54UL,
+    0xC2138DF6UL, 0xE8B8D890UL, 0x5EF7392EUL, 0xF5AFC382UL,
+    0xBE805D9FUL, 0x7C93D069UL, 0xA92DD56FUL, 0xB31225CFUL,
+    0x3B99ACC8UL, 0xA77D1810UL, 0x6E639CE8UL, 0x7BBB3BDBUL,
+    0x097826CDUL, 0xF418596EUL, 0x01B79AECUL, 0xA89A4F83UL,
+    0x656E95E6UL, 0x7EE6FFAAUL, 0x08CFBC21UL, 0xE6E815EFUL,
+    0xD99BE7BAUL, 0xCE366F4AUL, 0xD4099FEAUL, 0xD67CB029UL,
+    0xAFB2A431UL, 0x31233F2AUL, 0x3094A5C6UL, 0xC066A235UL,
+    0x37BC4E74UL, 0xA6CA82FCUL, 0xB0D090E0UL, 0x15D8A733UL,
+    0x4A9804F1UL, 0xF7DAEC41UL, 0x0E50CD7FUL, 0x2FF69117UL,
+    0x8DD64D76UL, 0x4DB0EF43UL, 0x544DAACCUL, 0xDF0496E4UL,
+    0xE3B5D19EUL, 0x1B886A4CUL, 0xB81F2CC1UL, 0x7F516546UL,
+    0x04EA5E9DUL, 0x5D358C01UL, 0x737487FAUL, 0x2E410BFBUL,
+    0x5A1D67B3UL, 0x52D2DB92UL, 0x335610E9UL, 0x1347D66DUL,
+    0x8C61D79AUL, 0x7A0CA137UL, 0x8E14F859UL, 0x893C13EBUL,
+    0xEE27A9CEUL, 0x35C961B7UL, 0xEDE51CE1UL, 0x3CB1477AUL,
+    0x59DFD29CUL, 0x3F73F255UL, 0x79CE1418UL, 0xBF37C773UL,
+    0xEACDF753UL, 0x5BAAFD5FUL, 0x146F3DDFUL, 0x86DB4478UL,
+    0x81F3AFCAUL, 0x3EC468B9UL, 0x2C342438UL, 0x5F40A3C2UL,
+    0x72C31D16UL, 0x0C25E2BCUL, 0x8B493C28UL, 0x41950DFFUL,
+    0x7101A839UL, 0xDEB30C08UL, 0x9CE4B4D8UL, 0x90C15664UL,
+    0x6184CB7BUL, 0x70B632D5UL, 0x745C6C48UL, 0x4257B8D0UL
+};
+
+/* Reverse S-box. */
+static const uint8_t ucReverseSBox[ 256 ] =
+{
+    0x52, 0x09, 0x6A, 0xD5, 0x30, 0x36, 0xA5, 0x38,
+    0xBF, 0x40, 0xA3, 0x9E, 0x81, 0xF3, 0xD7, 0xFB,
+    0x7C, 0xE3, 0x39, 0x82, 0x9B, 0x2F, 0xFF, 0x87,
+    0x34, 0x8E, 0x43, 0x44, 0xC4, 0xDE, 0xE9, 0xCB,
+    0x54, 0x7B, 0x94, 0x32, 0xA6, 0xC2, 0x23, 0x3D,
+    0xEE, 0x4C, 0x95, 0x0B, 0x42, 0xFA, 0xC3, 0x4E,
+    0x08, 0x2E, 0xA1, 0x66, 0x28, 0xD9, 0x24, 0xB2,
+    0x76, 0x5B, 0xA2, 0x49, 0x6D, 0x8B, 0xD1, 0x25,
+    0x72, 0xF8, 0xF6, 0x64, 0x86, 0x68, 0x98, 0x16,
+    0xD4, 0xA4, 0x5C, 0xCC, 0x5D, 0x65, 0xB6, 0x92,
+    0x6C, 0x70, 0x48, 0x50, 0xFD, 0xED, 0xB9, 0xDA,
+    0x5E, 0x15, 0x46, 0x57, 0xA7, 0x8D, 0x9D, 0x84,
+    0x90, 0xD8, 0xAB, 0x00, 0x8C, 0xBC, 0xD3, 0x0A,
+    0xF7, 0xE4, 0x58, 0x05, 0xB8, 0xB3, 0x45, 0x06,
+    0xD0, 0x2C, 0x1E, 0x8F, 0xCA, 0x3F, 0x0F, 0x02,
+    0xC1, 0xAF, 0xBD, 0x03, 0x01, 0x13, 0x8A, 0x6B,
+    0x3A, 0x91, 0x11, 0x41, 0x4F, 0x67, 0xDC, 0xEA,
+    0x97, 0xF2, 0xCF, 0xCE, 0xF0, 0xB4, 0xE6, 0x73,
+    0x96, 0xAC, 0x74, 0x22, 0xE7, 0xAD, 0x35, 0x85,
+    0xE2, 0xF9, 0x37, 0xE8, 0x1C, 0x75, 0xDF, 0x6E,
+    0x47, 0xF1, 0x1A, 0x71, 0x1D, 0x29, 0xC5, 0x89,
+    0x6F, 0xB7, 0x62, 0x0E, 0xAA, 0x18, 0xBE, 0x1B,
+    0xFC, 0x56, 0x3E, 0x4B, 0xC6, 0xD2, 0x79, 0x20,
+    0x9A, 0xDB, 0xC0, 0xFE, 0x78, 0xCD, 0x5A, 0xF4,
+    0x1F, 0xDD, 0xA8, 0x33, 0x88, 0x07, 0xC7, 0x31,
+    0xB1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xEC, 0x5F,
+    0x60, 0x51, 0x7F, 0xA9, 0x19, 0xB5, 0x4A, 0x0D,
+    0x2D, 0xE5, 0x7A, 0x9F, 0x93, 0xC9, 0x9C, 0xEF,
+    0xA0, 0xE0, 0x3B, 0x4D, 0xAE, 0x2A, 0xF5, 0xB0,
+    0xC8, 0xEB, 0xBB, 0x3C, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2B, 0x04, 0x7E, 0xBA, 0x77, 0xD6, 0x26,
+    0xE1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0C, 0x7D
+};
+
+/* Round constants of the key expansion. */
+static const uint8_t ucRoundConstants[ 10 ] =
+{
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief One column of a full encryption round, without the round key.
+ */
+#define aesFORWARD_COLUMN( ulA, ulB, ulC, ulD )                          \
+    ( ulForwardTable[ ( ulA ) & 0xFFUL ] ^                               \
+      aesROTL( ulForwardTable[ ( ( ulB ) >> 8 ) & 0xFFUL ], 8 ) ^        \
+      aesROTL( ulForwardTable[ ( ( ulC ) >> 16 ) & 0xFFUL ], 16 ) ^      \
+      aesROTL( ulForwardTable[ ( ulD ) >> 24 ], 24 ) )
+
+/**
+ * @brief One column of a full decryption round, without the round key.
+ */
+#define aesREVERSE_COLUMN( ulA, ulB, ulC, ulD )                          \
+    ( ulReverseTable[ ( ulA ) & 0xFFUL ] ^                               \
+      aesROTL( ulReverseTable[ ( ( ulB ) >> 8 ) & 0xFFUL ], 8 ) ^        \
+      aesROTL( ulReverseTable[ ( ( ulC ) >> 16 ) & 0xFFUL ], 16 ) ^      \
+      aesROTL( ulReverseTable[ ( ulD ) >> 24 ], 24 ) )
+
+/**
+ * @brief One column of the last encryption or decryption round.
+ */
+#define aesLAST_COLUMN( pucSBox, ulA, ulB, ulC, ulD )                   \
+    ( ( uint32_t ) ( pucSBox )[ ( ulA ) & 0xFFUL ] ^                     \
+      ( ( uint32_t ) ( pucSBox )[ ( ( ulB ) >> 8 ) & 0xFFUL ] << 8 ) ^   \
+      ( ( uint32_t ) ( pucSBox )[ ( ( ulC ) >> 16 ) & 0xFFUL ] << 16 ) ^ \
+      ( ( uint32_t ) ( pucSBox )[ ( ulD ) >> 24 ] << 24 ) )
+
+/**
+ * @brief A full encryption round from the state in Y to the state in X.
+ */
+#define aesFORWARD_ROUND( X0, X1, X2, X3, Y0, Y1, Y2, Y3 )         \
+    {                                                              \
+        X0 = pulRK[ 0 ] ^ aesFORWARD_COLUMN( Y0, Y1, Y2, Y3 );     \
+        X1 = pulRK[ 1 ] ^ aesFORWARD_COLUMN( Y1, Y2, Y3, Y0 );     \
+        X2 = pulRK[ 2 ] ^ aesFORWARD_COLUMN( Y2, Y3, Y0, Y1 );     \
+        X3 = pulRK[ 3 ] ^ aesFORWARD_COLUMN( Y3, Y0, Y1, Y2 );     \
+        pulRK += 4;                                                \
+    }
+
+/**
+ * @brief A full decryption round from the state in Y to the state in X.
+ */
+#define aesREVERSE_ROUND( X0, X1, X2, X3, Y0, Y1, Y2, Y3 )         \
+    {                                                              \
+        X0 = pulRK[ 0 ] ^ aesREVERSE_COLUMN( Y0, Y3, Y2, Y1 );     \
+        X1 = pulRK[ 1 ] ^ aesREVERSE_COLUMN( Y1, Y0, Y3, Y2 );     \
+        X2 = pulRK[ 2 ] ^ aesREVERSE_COLUMN( Y2, Y1, Y0, Y3 );     \
+        X3 = pulRK[ 3 ] ^ aesREVERSE_COLUMN( Y3, Y2, Y1, Y0 );     \
+        pulRK += 4;                                                \
+    }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Applies the S-box to each byte of a word.
+ */
+static uint32_t prvSubWord( uint32_t ulWord );
+
+/**
+ * @brief Encrypts one block with the software kernel.
+ */
+static void prvEncryptBlock( const mbedtls_aes_context * ctx,
+                             const unsigned char * pucInput,
+                             unsigned char * pucOutput );
+
+/**
+ * @brief Decrypts one block with the software kernel.
+ */
+static void prvDecryptBlock( const mbedtls_aes_context * ctx,
+                             const unsigned char * pucInput,
+                             unsigned char * pucOutput );
+
+/**
+ * @brief Encrypts or decrypts one block with the accelerator, if it
+ * implements AES, or with the software kernel.
+ */
+static int prvCryptBlock( const mbedtls_aes_context * ctx,
+                          int iMode,
+                          const unsigned char * pucInput,
+                          unsigned char * pucOutput );
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSubWord( uint32_t ulWord )
+{
+    return aesLAST_COLUMN( ucForwardSBox, ulWord, ulWord, ulWord, ulWord );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEncryptBlock( const mbedtls_aes_context * ctx,
+                             const unsigned char * pucInput,
+                             unsigned char * pucOutput )
+{
+    const uint32_t * pulRK = ctx->rk;
+    uint32_t ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3;
+
+    ulX0 = aesGET_UINT32_LE( pucInput ) ^ pulRK[ 0 ];
+    ulX1 = aesGET_UINT32_LE( pucInput + 4 ) ^ pulRK[ 1 ];
+    ulX2 = aesGET_UINT32_LE( pucInput + 8 ) ^ pulRK[ 2 ];
+    ulX3 = aesGET_UINT32_LE( pucInput + 12 ) ^ pulRK[ 3 ];
+    pulRK += 4;
+
+    /* Longer keys only add rounds in front of the ten of AES-128. */
+    switch( ctx->nr )
+    {
+        case 14:
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+        /* Falls through. */
+
+        case 12:
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+        /* Falls through. */
+
+        default:
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesFORWARD_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesFORWARD_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            break;
+    }
+
+    ulX0 = pulRK[ 0 ] ^ aesLAST_COLUMN( ucForwardSBox, ulY0, ulY1, ulY2, ulY3 );
+    ulX1 = pulRK[ 1 ] ^ aesLAST_COLUMN( ucForwardSBox, ulY1, ulY2, ulY3, ulY0 );
+    ulX2 = pulRK[ 2 ] ^ aesLAST_COLUMN( ucForwardSBox, ulY2, ulY3, ulY0, ulY1 );
+    ulX3 = pulRK[ 3 ] ^ aesLAST_COLUMN( ucForwardSBox, ulY3, ulY0, ulY1, ulY2 );
+
+    aesPUT_UINT32_LE( ulX0, pucOutput );
+    aesPUT_UINT32_LE( ulX1, pucOutput + 4 );
+    aesPUT_UINT32_LE( ulX2, pucOutput + 8 );
+    aesPUT_UINT32_LE( ulX3, pucOutput + 12 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvDecryptBlock( const mbedtls_aes_context * ctx,
+                             const unsigned char * pucInput,
+                             unsigned char * pucOutput )
+{
+    const uint32_t * pulRK = ctx->rk;
+    uint32_t ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3;
+
+    ulX0 = aesGET_UINT32_LE( pucInput ) ^ pulRK[ 0 ];
+    ulX1 = aesGET_UINT32_LE( pucInput + 4 ) ^ pulRK[ 1 ];
+    ulX2 = aesGET_UINT32_LE( pucInput + 8 ) ^ pulRK[ 2 ];
+    ulX3 = aesGET_UINT32_LE( pucInput + 12 ) ^ pulRK[ 3 ];
+    pulRK += 4;
+
+    switch( ctx->nr )
+    {
+        case 14:
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+        /* Falls through. */
+
+        case 12:
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+        /* Falls through. */
+
+        default:
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            aesREVERSE_ROUND( ulX0, ulX1, ulX2, ulX3, ulY0, ulY1, ulY2, ulY3 );
+            aesREVERSE_ROUND( ulY0, ulY1, ulY2, ulY3, ulX0, ulX1, ulX2, ulX3 );
+            break;
+    }
+
+    ulX0 = pulRK[ 0 ] ^ aesLAST_COLUMN( ucReverseSBox, ulY0, ulY3, ulY2, ulY1 );
+    ulX1 = pulRK[ 1 ] ^ aesLAST_COLUMN( ucReverseSBox, ulY1, ulY0, ulY3, ulY2 );
+    ulX2 = pulRK[ 2 ] ^ aesLAST_COLUMN( ucReverseSBox, ulY2, ulY1, ulY0, ulY3 );
+    ulX3 = pulRK[ 3 ] ^ aesLAST_COLUMN( ucReverseSBox, ulY3, ulY2, ulY1, ulY0 );
+
+    aesPUT_UINT32_LE( ulX0, pucOutput );
+    aesPUT_UINT32_LE( ulX1, pucOutput + 4 );
+    aesPUT_UINT32_LE( ulX2, pucOutput + 8 );
+    aesPUT_UINT32_LE( ulX3, pucOutput + 12 );
+}
+/*-----------------------------------------------------------*/
+
+static int prvCryptBlock( const mbedtls_aes_context * ctx,
+                          int iMode,
+                          const unsigned char * pucInput,
+                          unsigned char * pucOutput )
+{
+    int iResult = 0;
+    const CryptoAccelerator_t * pxAccelerator = CRYPTO_GetAccelerator();
+
+    if( ( pxAccelerator != NULL ) && ( pxAccelerator->xAesCryptBlock != NULL ) )
+    {
+        iResult = pxAccelerator->xAesCryptBlock( iMode,
+                                                 ctx->key,
+                                                 ctx->keybits,
+                                                 pucInput,
+                                                 pucOutput );
+    }
+    else if( iMode == MBEDTLS_AES_ENCRYPT )
+    {
+        prvEncryptBlock( ctx, pucInput, pucOutput );
+    }
+    else
+    {
+        prvDecryptBlock( ctx, pucInput, pucOutput );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_aes_init( mbedtls_aes_context * ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_aes_context ) );
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_aes_free( mbedtls_aes_context * ctx )
+{
+    if( ctx != NULL )
+    {
+        mbedtls_platform_zeroize( ctx, sizeof( mbedtls_aes_context ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_aes_setkey_enc( mbedtls_aes_context * ctx,
+                            const unsigned char * key,
+                            unsigned int keybits )
+{
+    int iResult = 0;
+    uint32_t ulKeyWords = keybits / 32U;
+    uint32_t i, ulWord;
+
+    switch( keybits )
+    {
+        case 128:
+            ctx->nr = 10;
+            break;
+
+        case 192:
+            ctx->nr = 12;
+            break;
+
+        case 256:
+            ctx->nr = 14;
+            break;
+
+        default:
+            iResult = MBEDTLS_ERR_AES_INVALID_KEY_LENGTH;
+            break;
+    }
+
+    if( iResult == 0 )
+    {
+        ctx->keybits = keybits;
+        memcpy( ctx->key, key, keybits / 8U );
+
+        for( i = 0; i < ulKeyWords; i++ )
+        {
+            ctx->rk[ i ] = aesGET_UINT32_LE( key + ( 4U * i ) );
+        }
+
+        /* FIPS-197 section 5.2, with the bytes of a word stored little
+         * endian, so RotWord() is a rotation to the right. */
+        for( i = ulKeyWords; i < ( 4U * ( ( uint32_t ) ctx->nr + 1U ) ); i++ )
+        {
+            ulWord = ctx->rk[ i - 1U ];
+
+            if( ( i % ulKeyWords ) == 0U )
+            {
+                ulWord = prvSubWord( aesROTL( ulWord, 24 ) ) ^
+                         ( uint32_t ) ucRoundConstants[ ( i / ulKeyWords ) - 1U ];
+            }
+            else if( ( ulKeyWords == 8U ) && ( ( i % ulKeyWords ) == 4U ) )
+            {
+                ulWord = prvSubWord( ulWord );
+            }
+
+            ctx->rk[ i ] = ctx->rk[ i - ulKeyWords ] ^ ulWord;
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_aes_setkey_dec( mbedtls_aes_context * ctx,
+                            const unsigned char * key,
+                            unsigned int keybits )
+{
+    int iResult;
+    uint32_t i, j, ulWord;
+    uint32_t * pulFront;
+    uint32_t * pulBack;
+
+    iResult = mbedtls_aes_setkey_enc( ctx, key, keybits );
+
+    if( iResult == 0 )
+    {
+        /* The equivalent inverse cipher of FIPS-197 section 5.3.5 uses the
+         * round keys in reverse order... */
+        pulFront = ctx->rk;
+        pulBack = ctx->rk + ( 4 * ctx->nr );
+
+        while( pulFront < pulBack )
+        {
+            for( j = 0; j < 4U; j++ )
+            {
+                ulWord = pulFront[ j ];
+                pulFront[ j ] = pulBack[ j ];
+                pulBack[ j ] = ulWord;
+            }
+
+            pulFront += 4;
+            pulBack -= 4;
+        }
+
+        /* ...with InvMixColumns() applied to all but the first and last.
+         * The reverse table includes the inverse S-box, which the forward
+         * S-box cancels out. */
+        for( i = 4; i < ( 4U * ( uint32_t ) ctx->nr ); i++ )
+        {
+            ulWord = prvSubWord( ctx->rk[ i ] );
+            ctx->rk[ i ] = aesREVERSE_COLUMN( ulWord, ulWord, ulWord, ulWord );
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_internal_aes_encrypt( mbedtls_aes_context * ctx,
+                                  const unsigned char input[ 16 ],
+                                  unsigned char output[ 16 ] )
+{
+    return prvCryptBlock( ctx, MBEDTLS_AES_ENCRYPT, input, output );
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_internal_aes_decrypt( mbedtls_aes_context * ctx,
+                                  const unsigned char input[ 16 ],
+                                  unsigned char output[ 16 ] )
+{
+    return prvCryptBlock( ctx, MBEDTLS_AES_DECRYPT, input, output );
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_aes_crypt_ecb( mbedtls_aes_context * ctx,
+                           int mode,
+                           const unsigned char input[ 16 ],
+                           unsigned char output[ 16 ] )
+{
+    return prvCryptBlock( ctx, mode, input, output );
+}
+/*-----------------------------------------------------------*/
+
+#if defined( MBEDTLS_CIPHER_MODE_CBC )
+    int mbedtls_aes_crypt_cbc( mbedtls_aes_context * ctx,
+                               int mode,
+                               size_t length,
+                               unsigned char iv[ 16 ],
+                               const unsigned char * input,
+                               unsigned char * output )
+    {
+        int iResult = 0;
+        size_t i;
+        unsigned char ucBlock[ 16 ];
+
+        if( ( length % 16U ) != 0U )
+        {
+            iResult = MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH;
+        }
+
+        while( ( iResult == 0 ) && ( length > 0U ) )
+        {
+            if( mode == MBEDTLS_AES_DECRYPT )
+            {
+                /* Keep the ciphertext, the output may overwrite it. */
+                memcpy( ucBlock, input, 16 );
+                iResult = prvCryptBlock( ctx, mode, input, output );
+
+                for( i = 0; i < 16U; i++ )
+                {
+                    output[ i ] ^= iv[ i ];
+                }
+
+                memcpy( iv, ucBlock, 16 );
+            }
+            else
+            {
+                for( i = 0; i < 16U; i++ )
+                {
+                    output[ i ] = input[ i ] ^ iv[ i ];
+                }
+
+                iResult = prvCryptBlock( ctx, mode, output, output );
+                memcpy( iv, output, 16 );
+            }
+
+            input += 16;
+            output += 16;
+            length -= 16U;
+        }
+
+        return iResult;
+    }
+#endif /* MBEDTLS_CIPHER_MODE_CBC */
+/*-----------------------------------------------------------*/
+
+#if defined( MBEDTLS_CIPHER_MODE_CFB )
+    int mbedtls_aes_crypt_cfb128( mbedtls_aes_context * ctx,
+                                  int mode,
+                                  size_t length,
+                                  size_t * iv_off,
+                                  unsigned char iv[ 16 ],
+                                  const unsigned char * input,
+                                  unsigned char * output )
+    {
+        int iResult = 0;
+        size_t n = *iv_off;
+        unsigned char c;
+
+        while( ( iResult == 0 ) && ( length > 0U ) )
+        {
+            if( n == 0U )
+            {
+                iResult = prvCryptBlock( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+            }
+
+            c = *input++;
+            *output++ = c ^ iv[ n ];
+            iv[ n ] = ( mode == MBEDTLS_AES_DECRYPT ) ? c : output[ -1 ];
+
+            n = ( n + 1U ) & 0x0FU;
+            length--;
+        }
+
+        *iv_off = n;
+
+        return iResult;
+    }
+/*-----------------------------------------------------------*/
+
+    int mbedtls_aes_crypt_cfb8( mbedtls_aes_context * ctx,
+                                int mode,
+                                size_t length,
+                                unsigned char iv[ 16 ],
+                                const unsigned char * input,
+                                unsigned char * output )
+    {
+        int iResult = 0;
+        unsigned char c;
+        unsigned char ucShift[ 17 ];
+
+        while( ( iResult == 0 ) && ( length > 0U ) )
+        {
+            memcpy( ucShift, iv, 16 );
+            iResult = prvCryptBlock( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+
+            if( mode == MBEDTLS_AES_DECRYPT )
+            {
+                ucShift[ 16 ] = *input;
+            }
+
+            c = *output++ = iv[ 0 ] ^ *input++;
+
+            if( mode == MBEDTLS_AES_ENCRYPT )
+            {
+                ucShift[ 16 ] = c;
+            }
+
+            memcpy( iv, ucShift + 1, 16 );
+            length--;
+        }
+
+        return iResult;
+    }
+#endif /* MBEDTLS_CIPHER_MODE_CFB */
+/*-----------------------------------------------------------*/
+
+#if defined( MBEDTLS_CIPHER_MODE_OFB )
+    int mbedtls_aes_crypt_ofb( mbedtls_aes_context * ctx,
+                               size_t length,
+                               size_t * iv_off,
+                               unsigned char iv[ 16 ],
+                               const unsigned char * input,
+                               unsigned char * output )
+    {
+        int iResult = 0;
+        size_t n = *iv_off;
+
+        while( ( iResult == 0 ) && ( length > 0U ) )
+        {
+            if( n == 0U )
+            {
+                iResult = prvCryptBlock( ctx, MBEDTLS_AES_ENCRYPT, iv, iv );
+            }
+
+            *output++ = *input++ ^ iv[ n ];
+
+            n = ( n + 1U ) & 0x0FU;
+            length--;
+        }
+
+        *iv_off = n;
+
+        return iResult;
+    }
+#endif /* MBEDTLS_CIPHER_MODE_OFB */
+/*-----------------------------------------------------------*/
+
+#if defined( MBEDTLS_CIPHER_MODE_CTR )
+    int mbedtls_aes_crypt_ctr( mbedtls_aes_context * ctx,
+                               size_t length,
+                               size_t * nc_off,
+                               unsigned char nonce_counter[ 16 ],
+                               unsigned char stream_block[ 16 ],
+                               const unsigned char * input,
+                               unsigned char * output )
+    {
+        int iResult = 0;
+        size_t i;
+        size_t n = *nc_off;
+
+        if( n > 0x0FU )
+        {
+            iResult = MBEDTLS_ERR_AES_BAD_INPUT_DATA;
+        }
+
+        while( ( iResult == 0 ) && ( length > 0U ) )
+        {
+            if( n == 0U )
+            {
+                iResult = prvCryptBlock( ctx, MBEDTLS_AES_ENCRYPT, nonce_counter, stream_block );
+
+                for( i = 16; i > 0U; i-- )
+                {
+                    if( ++nonce_counter[ i - 1U ] != 0U )
+                    {
+                        break;
+                    }
+                }
+            }
+
+            *output++ = *input++ ^ stream_block[ n ];
+
+            n = ( n + 1U ) & 0x0FU;
+            length--;
+        }
+
+        *nc_off = n;
+
+        return iResult;
+    }
+#endif /* MBEDTLS_CIPHER_MODE_CTR */
+/*-----------------------------------------------------------*/
+
+#endif /* if defined( MBEDTLS_AES_C ) && defined( MBEDTLS_AES_ALT ) */
@@ -0,0 +1,48 @@
+/*
+ * Amazon FreeRTOS Crypto V1.0.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "aws_crypto_accelerator.h"
+
+/**
+ * @brief The accelerator used by the AES, GCM and SHA-256 modules.
+ *
+ * NULL selects the software kernels.
+ */
+static const CryptoAccelerator_t * pxCryptoAccelerator = NULL;
+/*-----------------------------------------------------------*/
+
+void CRYPTO_SetAccelerator( const CryptoAccelerator_t * pxAccelerator )
+{
+    pxCryptoAccelerator = pxAccelerator;
+}
+/*-----------------------------------------------------------*/
+
+const CryptoAccelerator_t * CRYPTO_GetAccelerator( void )
+{
+    return pxCryptoAccelerator;
+}
+/*-----------------------------------------------------------*/
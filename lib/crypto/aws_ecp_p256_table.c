@@ -0,0 +1,1185 @@
+/*
+ * Amazon FreeRTOS Crypto V1.0.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_ecp_p256_table.c
+ * @brief Comb table for the P-256 generator, built with
+ * MBEDTLS_ECP_FIXED_BASE_TABLE.
+ *
+ * mbedTLS multiplies the generator with the comb method.  By default the
+ * first multiplication on each mbedtls_ecp_group computes a table of
+ * 2^(w-1) points into the heap and keeps it with the group.  TLS loads a new
+ * group for the ECDHE key of every handshake, so that table was built again
+ * on each connection, at about the cost of a whole multiplication.  The
+ * table below was computed offline, lives in flash, and is wider than the
+ * one mbedTLS computes, because a wider table only costs flash here.
+ *
+ * ecp_select_comb() still reads every entry of the table on each step, so
+ * the multiplication stays constant time whatever the scalar.
+ */
+
+/* mbedTLS includes. */
+#include "mbedtls/config.h"
+
+#if defined( MBEDTLS_ECP_FIXED_BASE_TABLE ) && defined( MBEDTLS_ECP_DP_SECP256R1_ENABLED )
+
+#include "mbedtls/ecp.h"
+#include "mbedtls/ecp_internal.h"
+
+/* C runtime includes. */
+#include <stddef.h>
+
+/**
+ * @brief Width of the comb, in bits.
+ *
+ * The table has 2^(w-1) entries of 64 bytes, and a multiplication costs
+ * d = ceil( 256 / w ) doublings and d additions, each of which reads the
+ * whole table.  7 bits is the widest comb ecp_comb_fixed() can encode, and
+ * was the fastest in vStartCryptoBenchmarkDemo() on the Linux simulator:
+ * it needs 37 doublings and additions instead of 43 with 6 bits, which
+ * more than pays for reading twice the table.  It takes 4 KB of flash for
+ * the coordinates.
+ */
+#define eccCOMB_WIDTH     ( 7 )
+
+/**
+ * @brief Number of entries in the table, 2^(eccCOMB_WIDTH-1).
+ */
+#define eccCOMB_POINTS    ( 1 << ( eccCOMB_WIDTH - 1 ) )
+
+/**
+ * @brief Number of mbedtls_mpi_uint limbs in a P-256 coordinate.
+ */
+#define eccLIMBS          ( 32 / sizeof( mbedtls_mpi_uint ) )
+
+/*
+ * Builds limbs from bytes in little endian order, as ecp_curves.c does.
+ */
+#if defined( MBEDTLS_HAVE_INT32 )
+
+#define BYTES_TO_T_UINT_4( a, b, c, d )      \
+    ( ( mbedtls_mpi_uint ) a << 0 ) |        \
+    ( ( mbedtls_mpi_uint ) b << 8 ) |        \
+    ( ( mbedtls_mpi_uint ) c << 16 ) |       \
+    ( ( mbedtls_mpi_uint ) d << 24 )
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \
+    BYTES_TO_T_UINT_4( a, b, c, d ),                \
+    BYTES_TO_T_UINT_4( e, f, g, h )
+
+#else /* 64-bits */
+
+#define BYTES_TO_T_UINT_8( a, b, c, d, e, f, g, h ) \
+    ( ( mbedtls_mpi_uint ) a << 0 ) |               \
+    ( ( mbedtls_mpi_uint ) b << 8 ) |               \
+    ( ( mbedtls_mpi_uint ) c << 16 ) |              \
+    ( ( mbedtls_mpi_uint ) d << 24 ) |              \
+    ( ( mbedtls_mpi_uint ) e << 32 ) |              \
+    ( ( mbedtls_mpi_uint ) f << 40 ) |              \
+    ( ( mbedtls_mpi_uint ) g << 48 ) |              \
+    ( ( mbedtls_mpi_uint ) h << 56 )
+
+#endif /* bits in mbedtls_mpi_uint */
+
+/**
+ * @brief Wraps the coordinates of one entry as an mbedtls_ecp_point.
+ *
+ * The MPIs point straight at the flash copy, as the curve parameters loaded
+ * by ecp_curves.c do.  Z is left empty: ecp_mul_comb_core() only reads X and
+ * Y, and treats every entry as affine.
+ */
+#define eccCOMB_POINT( x )                                                        \
+    {                                                                             \
+        { 1, eccLIMBS, ( mbedtls_mpi_uint * ) xP256CombCoordinates[ ( x ) ][ 0 ] }, \
+        { 1, eccLIMBS, ( mbedtls_mpi_uint * ) xP256CombCoordinates[ ( x ) ][ 1 ] }, \
+        { 0, 0, NULL }                                                            \
+    }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Affine X and Y of the entries, little endian.
+ *
+ * With d = ceil( 256 / eccCOMB_WIDTH ), entry i is
+ * ( 1 + i_1 2^d + i_2 2^(2d) + ... ) G, where i_j is bit j-1 of i.  This is
+ * what ecp_precompute_comb() computes, so it can be checked against the run
+ * time table by multiplying the same scalars through both, which
+ * vStartCryptoBenchmarkDemo() does.
+ */
+static const mbedtls_mpi_uint xP256CombCoordinates[ eccCOMB_POINTS ][ 2 ][ eccLIMBS ] =
+{
+    /* T[ 0 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x96, 0xC2, 0x98, 0xD8, 0x45, 0x39, 0xA1, 0xF4 ),
+            BYTES_TO_T_UINT_8( 0xA0, 0x33, 0xEB, 0x2D, 0x81, 0x7D, 0x03, 0x77 ),
+            BYTES_TO_T_UINT_8( 0xF2, 0x40, 0xA4, 0x63, 0xE5, 0xE6, 0xBC, 0xF8 ),
+            BYTES_TO_T_UINT_8( 0x47, 0x42, 0x2C, 0xE1, 0xF2, 0xD1, 0x17, 0x6B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xF5, 0x51, 0xBF, 0x37, 0x68, 0x40, 0xB6, 0xCB ),
+            BYTES_TO_T_UINT_8( 0xCE, 0x5E, 0x31, 0x6B, 0x57, 0x33, 0xCE, 0x2B ),
+            BYTES_TO_T_UINT_8( 0x16, 0x9E, 0x0F, 0x7C, 0x4A, 0xEB, 0xE7, 0x8E ),
+            BYTES_TO_T_UINT_8( 0x9B, 0x7F, 0x1A, 0xFE, 0xE2, 0x42, 0xE3, 0x4F )
+        }
+    },
+    /* T[ 1 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xBC, 0xE2, 0xD4, 0x66, 0x8E, 0xFA, 0xBD, 0x58 ),
+            BYTES_TO_T_UINT_8( 0x8B, 0x85, 0x1F, 0x9B, 0x69, 0xA5, 0x77, 0x8F ),
+            BYTES_TO_T_UINT_8( 0x70, 0x10, 0xFB, 0xB6, 0x05, 0x58, 0xEC, 0xFE ),
+            BYTES_TO_T_UINT_8( 0x1F, 0x35, 0x64, 0x9D, 0x1E, 0x70, 0xDF, 0x1C )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x45, 0xBA, 0x83, 0x27, 0x42, 0x70, 0x42, 0xBA ),
+            BYTES_TO_T_UINT_8( 0x19, 0x5B, 0x66, 0xF7, 0xE3, 0x9C, 0xB0, 0x54 ),
+            BYTES_TO_T_UINT_8( 0x62, 0x68, 0x65, 0x8C, 0xAA, 0x94, 0xCA, 0x0B ),
+            BYTES_TO_T_UINT_8( 0x76, 0x6B, 0x3C, 0xC4, 0x62, 0x7F, 0x7D, 0xC3 )
+        }
+    },
+    /* T[ 2 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x11, 0x06, 0x7A, 0x71, 0x19, 0x89, 0xF6, 0x49 ),
+            BYTES_TO_T_UINT_8( 0x01, 0x77, 0xF1, 0x28, 0x96, 0xA2, 0x76, 0x39 ),
+            BYTES_TO_T_UINT_8( 0x83, 0xCB, 0xF3, 0x5D, 0x9D, 0xEB, 0xCD, 0x09 ),
+            BYTES_TO_T_UINT_8( 0x8F, 0x44, 0xB6, 0xCF, 0xCC, 0x55, 0x3C, 0x18 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xE8, 0xBC, 0xEF, 0x70, 0x3F, 0x1B, 0x6D, 0x1B ),
+            BYTES_TO_T_UINT_8( 0x28, 0x62, 0x7E, 0x16, 0x84, 0x44, 0xFF, 0x79 ),
+            BYTES_TO_T_UINT_8( 0x34, 0x0B, 0x29, 0xF6, 0x6F, 0xC3, 0x41, 0xFA ),
+            BYTES_TO_T_UINT_8( 0x65, 0x6B, 0xB7, 0xE5, 0x49, 0x12, 0xEF, 0xEA )
+        }
+    },
+    /* T[ 3 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xEC, 0xB1, 0x7A, 0xA9, 0x2D, 0x1D, 0x1B, 0xB4 ),
+            BYTES_TO_T_UINT_8( 0x2B, 0xBA, 0xCE, 0x83, 0x84, 0x77, 0x91, 0xB7 ),
+            BYTES_TO_T_UINT_8( 0xDE, 0x50, 0x28, 0x8D, 0x0D, 0xEC, 0xFB, 0x45 ),
+            BYTES_TO_T_UINT_8( 0xB1, 0x76, 0x63, 0x3A, 0xFD, 0xB5, 0x20, 0x7A )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x97, 0x8D, 0x5F, 0x68, 0x22, 0x17, 0xD2, 0xB2 ),
+            BYTES_TO_T_UINT_8( 0x84, 0x21, 0xEE, 0x22, 0xD6, 0xF8, 0x73, 0xA0 ),
+            BYTES_TO_T_UINT_8( 0x74, 0xA3, 0x46, 0x3F, 0x51, 0x89, 0xCC, 0x97 ),
+            BYTES_TO_T_UINT_8( 0xAD, 0xAD, 0x5F, 0x17, 0x41, 0x1D, 0x7F, 0x47 )
+        }
+    },
+    /* T[ 4 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x27, 0x28, 0x60, 0xFC, 0x32, 0x58, 0x30, 0x16 ),
+            BYTES_TO_T_UINT_8( 0x72, 0xB3, 0xC1, 0x55, 0x79, 0xB3, 0xE0, 0x08 ),
+            BYTES_TO_T_UINT_8( 0x7B, 0xA6, 0xA3, 0x2A, 0xF7, 0x57, 0xCB, 0x7D ),
+            BYTES_TO_T_UINT_8( 0x9A, 0xF0, 0xB0, 0x4F, 0x3D, 0xB6, 0xF1, 0x5F )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x7F, 0x4F, 0x85, 0x1C, 0x36, 0x46, 0x0A, 0x37 ),
+            BYTES_TO_T_UINT_8( 0x55, 0xF4, 0x30, 0x28, 0xA7, 0xF9, 0x37, 0xD8 ),
+            BYTES_TO_T_UINT_8( 0xCE, 0x8A, 0xD5, 0xA2, 0xF2, 0x33, 0x0D, 0xAA ),
+            BYTES_TO_T_UINT_8( 0xF0, 0xB3, 0x90, 0xC4, 0x57, 0x47, 0x2E, 0x56 )
+        }
+    },
+    /* T[ 5 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x63, 0x3D, 0x02, 0x79, 0x7F, 0xFD, 0x57, 0x81 ),
+            BYTES_TO_T_UINT_8( 0x8B, 0xE7, 0x6D, 0x05, 0xBF, 0x03, 0x96, 0x7F ),
+            BYTES_TO_T_UINT_8( 0x21, 0xF9, 0x4D, 0x21, 0x89, 0xA8, 0x90, 0x37 ),
+            BYTES_TO_T_UINT_8( 0x1A, 0x5A, 0x3A, 0x9A, 0x8E, 0xCB, 0x0C, 0xA2 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xB1, 0x87, 0x57, 0xF7, 0x4B, 0x59, 0xEB, 0x9B ),
+            BYTES_TO_T_UINT_8( 0x08, 0x9C, 0x11, 0x86, 0x4F, 0x6F, 0x80, 0xDD ),
+            BYTES_TO_T_UINT_8( 0x64, 0x13, 0x07, 0xD8, 0xE8, 0x51, 0x3A, 0x6D ),
+            BYTES_TO_T_UINT_8( 0xAA, 0x43, 0x7A, 0x15, 0x16, 0x56, 0xAA, 0xFC )
+        }
+    },
+    /* T[ 6 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xEB, 0x4A, 0x5C, 0x37, 0x57, 0xAC, 0x7C, 0x51 ),
+            BYTES_TO_T_UINT_8( 0xD2, 0x6B, 0xF1, 0x4F, 0xBC, 0x99, 0x24, 0x35 ),
+            BYTES_TO_T_UINT_8( 0xE8, 0x65, 0xD2, 0xB0, 0x32, 0x10, 0x1B, 0x2C ),
+            BYTES_TO_T_UINT_8( 0xA4, 0x4E, 0x17, 0xF4, 0x6B, 0xB3, 0xB3, 0x2D )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xA4, 0xC1, 0x15, 0x33, 0x0D, 0x82, 0x6C, 0x62 ),
+            BYTES_TO_T_UINT_8( 0xC4, 0xDC, 0x51, 0xF8, 0x26, 0xCE, 0xE3, 0xC0 ),
+            BYTES_TO_T_UINT_8( 0xE8, 0xE4, 0x9E, 0x8E, 0xFC, 0x1D, 0x4F, 0x27 ),
+            BYTES_TO_T_UINT_8( 0x6E, 0x9E, 0x03, 0xE6, 0x4E, 0xE7, 0x30, 0x30 )
+        }
+    },
+    /* T[ 7 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x5F, 0x88, 0x88, 0x34, 0x96, 0x0D, 0xBB, 0xD7 ),
+            BYTES_TO_T_UINT_8( 0xF6, 0xF8, 0x05, 0xD5, 0xEF, 0x4B, 0x03, 0xBE ),
+            BYTES_TO_T_UINT_8( 0xCC, 0xF6, 0xAC, 0x32, 0x6E, 0x8F, 0xCD, 0x64 ),
+            BYTES_TO_T_UINT_8( 0x0F, 0xB5, 0x84, 0xAB, 0x4C, 0x8E, 0x5F, 0x91 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xD4, 0x1B, 0xC9, 0x2D, 0x38, 0xAE, 0x42, 0x06 ),
+            BYTES_TO_T_UINT_8( 0x9E, 0xAC, 0x59, 0xAA, 0x9E, 0x98, 0x6C, 0x96 ),
+            BYTES_TO_T_UINT_8( 0x71, 0xC5, 0x41, 0xFC, 0xC1, 0xAD, 0x5E, 0x2D ),
+            BYTES_TO_T_UINT_8( 0xCB, 0x42, 0x9D, 0xEF, 0x79, 0xDA, 0xF8, 0x43 )
+        }
+    },
+    /* T[ 8 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xAD, 0x59, 0x5E, 0xCA, 0x6D, 0xB2, 0x6C, 0x27 ),
+            BYTES_TO_T_UINT_8( 0xE1, 0x1D, 0x04, 0x13, 0xFB, 0xAA, 0x88, 0xB6 ),
+            BYTES_TO_T_UINT_8( 0x73, 0xCF, 0x3B, 0x14, 0x35, 0x22, 0x7D, 0x2F ),
+            BYTES_TO_T_UINT_8( 0x74, 0xE7, 0x77, 0x59, 0x97, 0x74, 0x1C, 0xA9 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xC9, 0x1A, 0x9D, 0x2F, 0x81, 0xEF, 0x0D, 0xF6 ),
+            BYTES_TO_T_UINT_8( 0xE7, 0x6E, 0xE1, 0x86, 0xEA, 0xD5, 0x67, 0x0C ),
+            BYTES_TO_T_UINT_8( 0xD1, 0xF8, 0x30, 0x47, 0xD9, 0x2D, 0xDD, 0x85 ),
+            BYTES_TO_T_UINT_8( 0x8A, 0xEF, 0x61, 0x3B, 0xD7, 0x5D, 0x9A, 0xF5 )
+        }
+    },
+    /* T[ 9 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xCF, 0xEF, 0x95, 0x75, 0x03, 0x89, 0xC4, 0xAC ),
+            BYTES_TO_T_UINT_8( 0xD4, 0xCF, 0x99, 0x6A, 0x71, 0x71, 0x5B, 0x4A ),
+            BYTES_TO_T_UINT_8( 0x78, 0x05, 0xDC, 0xFE, 0xED, 0xF7, 0xBB, 0x85 ),
+            BYTES_TO_T_UINT_8( 0x6B, 0x25, 0xEC, 0xF5, 0x27, 0xD2, 0xB5, 0x1D )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x30, 0x4B, 0xE4, 0xFF, 0x54, 0xBE, 0xD1, 0x6E ),
+            BYTES_TO_T_UINT_8( 0x75, 0x5A, 0x5E, 0x7C, 0x20, 0x68, 0x4D, 0xB0 ),
+            BYTES_TO_T_UINT_8( 0xDA, 0x51, 0xEF, 0x2A, 0xCA, 0x90, 0xFA, 0xA8 ),
+            BYTES_TO_T_UINT_8( 0x66, 0x9A, 0x23, 0x30, 0x1D, 0xC3, 0x26, 0x9F )
+        }
+    },
+    /* T[ 10 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xB9, 0xC3, 0xA1, 0x80, 0x18, 0x36, 0xE8, 0xFB ),
+            BYTES_TO_T_UINT_8( 0x6D, 0xC4, 0x01, 0x14, 0xAE, 0xB0, 0x95, 0x9F ),
+            BYTES_TO_T_UINT_8( 0xF7, 0xB0, 0x76, 0x4A, 0xD0, 0x8C, 0x6A, 0x6C ),
+            BYTES_TO_T_UINT_8( 0xDB, 0x9B, 0x15, 0x99, 0x29, 0x6B, 0x24, 0x5B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x3D, 0x0D, 0xFF, 0x3A, 0x1A, 0x97, 0x68, 0x6E ),
+            BYTES_TO_T_UINT_8( 0xF9, 0xD2, 0xB6, 0xFB, 0x07, 0x64, 0x04, 0x2B ),
+            BYTES_TO_T_UINT_8( 0x26, 0x7A, 0xAB, 0x73, 0xF4, 0x3F, 0x8E, 0xED ),
+            BYTES_TO_T_UINT_8( 0x2E, 0xA1, 0x05, 0x9F, 0x23, 0x06, 0xCD, 0xB1 )
+        }
+    },
+    /* T[ 11 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xB4, 0xB2, 0x40, 0x44, 0xC3, 0x0A, 0x0D, 0x0F ),
+            BYTES_TO_T_UINT_8( 0xEB, 0x66, 0x24, 0xBC, 0xC4, 0xAB, 0x5B, 0x6E ),
+            BYTES_TO_T_UINT_8( 0x5D, 0xAE, 0x87, 0x6E, 0xE5, 0x97, 0xD9, 0x75 ),
+            BYTES_TO_T_UINT_8( 0x97, 0x3D, 0x35, 0xCA, 0x07, 0x37, 0x2A, 0x7B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x0D, 0x2F, 0xEF, 0xD2, 0xE7, 0x39, 0x80, 0x42 ),
+            BYTES_TO_T_UINT_8( 0x14, 0xE5, 0x91, 0xCC, 0xF6, 0x0C, 0xDB, 0x48 ),
+            BYTES_TO_T_UINT_8( 0xF5, 0xB5, 0x85, 0xA6, 0xE7, 0xAA, 0x5F, 0xE1 ),
+            BYTES_TO_T_UINT_8( 0xCC, 0x52, 0x27, 0xA4, 0x9E, 0x3B, 0x50, 0x71 )
+        }
+    },
+    /* T[ 12 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xA1, 0x1A, 0x26, 0xFB, 0xA5, 0xAF, 0x69, 0x2C ),
+            BYTES_TO_T_UINT_8( 0x2C, 0xA5, 0xC7, 0xD0, 0xFE, 0xEB, 0xD7, 0xEA ),
+            BYTES_TO_T_UINT_8( 0x17, 0xAA, 0x46, 0xB6, 0x8C, 0x5F, 0xAA, 0x3D ),
+            BYTES_TO_T_UINT_8( 0xFE, 0x29, 0xA7, 0x57, 0x51, 0x6B, 0xF2, 0xD1 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x5F, 0x59, 0x4A, 0x4F, 0x34, 0x2A, 0x8C, 0x2A ),
+            BYTES_TO_T_UINT_8( 0xB9, 0xF6, 0x69, 0x93, 0xCE, 0xE8, 0xC3, 0x85 ),
+            BYTES_TO_T_UINT_8( 0x3D, 0xB3, 0xC3, 0xD4, 0x03, 0x09, 0x71, 0x1F ),
+            BYTES_TO_T_UINT_8( 0x23, 0x14, 0xFC, 0x48, 0x72, 0x09, 0xF6, 0x48 )
+        }
+    },
+    /* T[ 13 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x57, 0x83, 0x8F, 0xA2, 0x4D, 0x75, 0xA6, 0x84 ),
+            BYTES_TO_T_UINT_8( 0x1C, 0xC1, 0xE5, 0xB1, 0xCD, 0xDB, 0x88, 0xA8 ),
+            BYTES_TO_T_UINT_8( 0x17, 0x33, 0xBC, 0x14, 0xB1, 0xD9, 0xF6, 0x04 ),
+            BYTES_TO_T_UINT_8( 0x2E, 0x88, 0xF0, 0xDD, 0x6F, 0xE3, 0xF6, 0x33 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x5C, 0x39, 0x7F, 0xAE, 0xB5, 0xAF, 0xF4, 0x51 ),
+            BYTES_TO_T_UINT_8( 0x58, 0x0C, 0x72, 0x52, 0x52, 0xCF, 0x0E, 0xC2 ),
+            BYTES_TO_T_UINT_8( 0x52, 0x99, 0x7E, 0xDF, 0x4F, 0x1E, 0x31, 0xD7 ),
+            BYTES_TO_T_UINT_8( 0x77, 0x89, 0x4F, 0xDF, 0xA7, 0x3A, 0x19, 0x9E )
+        }
+    },
+    /* T[ 14 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x45, 0xD0, 0xBC, 0x7D, 0x5C, 0x71, 0x5C, 0xCC ),
+            BYTES_TO_T_UINT_8( 0x08, 0xBE, 0xC5, 0x6A, 0x2F, 0x44, 0x2A, 0xCB ),
+            BYTES_TO_T_UINT_8( 0xD3, 0x4F, 0x30, 0x1A, 0xA4, 0x37, 0xC3, 0x6F ),
+            BYTES_TO_T_UINT_8( 0x01, 0x14, 0x39, 0xDE, 0xDE, 0x31, 0x2B, 0xBE )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xA8, 0x27, 0x3D, 0x4D, 0x0D, 0x39, 0x04, 0x52 ),
+            BYTES_TO_T_UINT_8( 0x27, 0xB5, 0x70, 0x8E, 0xAB, 0x9A, 0xFC, 0xFE ),
+            BYTES_TO_T_UINT_8( 0xDF, 0x79, 0xDF, 0xC7, 0x92, 0x73, 0x9B, 0x3F ),
+            BYTES_TO_T_UINT_8( 0x70, 0x79, 0x66, 0x2C, 0xBE, 0xA9, 0xEB, 0x90 )
+        }
+    },
+    /* T[ 15 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xCC, 0x12, 0x6A, 0xE7, 0xC4, 0x77, 0xA2, 0x28 ),
+            BYTES_TO_T_UINT_8( 0x95, 0x4C, 0xC4, 0x3E, 0x84, 0xED, 0xBF, 0x53 ),
+            BYTES_TO_T_UINT_8( 0x86, 0x92, 0x35, 0x20, 0x11, 0x68, 0xED, 0x2A ),
+            BYTES_TO_T_UINT_8( 0x2E, 0x01, 0x2E, 0x75, 0xA5, 0x2C, 0x1D, 0x04 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xE9, 0x76, 0x74, 0x71, 0xB2, 0x23, 0x17, 0x88 ),
+            BYTES_TO_T_UINT_8( 0xE6, 0x3F, 0x4A, 0xA6, 0x6E, 0xEF, 0xC9, 0x60 ),
+            BYTES_TO_T_UINT_8( 0xE9, 0x41, 0xDD, 0x62, 0x6E, 0xA2, 0xF0, 0x69 ),
+            BYTES_TO_T_UINT_8( 0x79, 0xBF, 0x4F, 0xB7, 0x8C, 0x2E, 0xD4, 0x19 )
+        }
+    },
+    /* T[ 16 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xBD, 0x50, 0xD8, 0xA0, 0x2A, 0x98, 0x1D, 0x02 ),
+            BYTES_TO_T_UINT_8( 0xEB, 0x68, 0x4F, 0x68, 0x31, 0x79, 0x60, 0xAD ),
+            BYTES_TO_T_UINT_8( 0xCD, 0xFD, 0xF6, 0xDD, 0x69, 0x4C, 0xC8, 0x17 ),
+            BYTES_TO_T_UINT_8( 0x58, 0x47, 0x3F, 0xEB, 0xF9, 0xAE, 0x3D, 0x65 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x37, 0x2B, 0x15, 0xEF, 0xAB, 0xA6, 0xEA, 0x3D ),
+            BYTES_TO_T_UINT_8( 0xAB, 0x2D, 0x9B, 0xF6, 0xBE, 0xDA, 0x7F, 0xDE ),
+            BYTES_TO_T_UINT_8( 0xA5, 0x4F, 0x75, 0x41, 0xB0, 0x06, 0x72, 0xDD ),
+            BYTES_TO_T_UINT_8( 0x0C, 0x18, 0xE0, 0xF9, 0xF8, 0x79, 0xC9, 0x2D )
+        }
+    },
+    /* T[ 17 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x22, 0x8D, 0x8F, 0xB9, 0x0D, 0x30, 0xA9, 0xCA ),
+            BYTES_TO_T_UINT_8( 0xEC, 0x88, 0x4F, 0xB2, 0x7B, 0xD4, 0x1D, 0x2E ),
+            BYTES_TO_T_UINT_8( 0x93, 0x2A, 0x2A, 0xB7, 0x50, 0xFF, 0xDB, 0x9F ),
+            BYTES_TO_T_UINT_8( 0x71, 0x52, 0x9D, 0x5D, 0xD5, 0xF0, 0x70, 0x89 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x45, 0xA3, 0x42, 0x7C, 0xCC, 0x3B, 0x8F, 0x26 ),
+            BYTES_TO_T_UINT_8( 0x24, 0x72, 0x9F, 0xDF, 0x79, 0x11, 0xCC, 0xE4 ),
+            BYTES_TO_T_UINT_8( 0x51, 0xD0, 0xAB, 0x56, 0xCA, 0xA8, 0x9C, 0x09 ),
+            BYTES_TO_T_UINT_8( 0x53, 0x53, 0xB9, 0x85, 0x99, 0xE5, 0xB9, 0x2F )
+        }
+    },
+    /* T[ 18 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x9A, 0x6B, 0x38, 0x31, 0x68, 0xA5, 0x32, 0x74 ),
+            BYTES_TO_T_UINT_8( 0x4B, 0xF4, 0x22, 0x6B, 0x28, 0x5D, 0xAA, 0x5E ),
+            BYTES_TO_T_UINT_8( 0xBF, 0x4D, 0xEC, 0xBC, 0x49, 0xAA, 0x2F, 0xF1 ),
+            BYTES_TO_T_UINT_8( 0x32, 0x2C, 0xB6, 0x93, 0x30, 0x13, 0x79, 0x3D )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x85, 0x63, 0xAA, 0x7C, 0x54, 0xC0, 0x1C, 0x21 ),
+            BYTES_TO_T_UINT_8( 0x94, 0x42, 0x14, 0xC3, 0xB4, 0xD9, 0x56, 0x7E ),
+            BYTES_TO_T_UINT_8( 0xB8, 0xEB, 0xD5, 0x6E, 0x13, 0x2E, 0x79, 0x06 ),
+            BYTES_TO_T_UINT_8( 0xB5, 0x04, 0x84, 0xCA, 0x6E, 0xDF, 0x2F, 0x69 )
+        }
+    },
+    /* T[ 19 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x08, 0xEC, 0x47, 0xC0, 0xB8, 0xA7, 0xFA, 0x93 ),
+            BYTES_TO_T_UINT_8( 0x48, 0x4E, 0x56, 0x2A, 0x3C, 0x3A, 0xD9, 0x75 ),
+            BYTES_TO_T_UINT_8( 0x3E, 0x78, 0x40, 0x8E, 0x50, 0x58, 0x5A, 0x77 ),
+            BYTES_TO_T_UINT_8( 0x39, 0x3C, 0x72, 0xA5, 0x40, 0xD5, 0xE8, 0x0E )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x72, 0xF6, 0x05, 0xAD, 0x0E, 0xC6, 0x5A, 0xD6 ),
+            BYTES_TO_T_UINT_8( 0x52, 0xDA, 0x2A, 0x2F, 0x01, 0x84, 0x14, 0x17 ),
+            BYTES_TO_T_UINT_8( 0xE7, 0x5D, 0x93, 0xA1, 0x4F, 0x75, 0x4C, 0xFD ),
+            BYTES_TO_T_UINT_8( 0x82, 0x7C, 0x1A, 0x06, 0xD5, 0x4B, 0xAC, 0xFF )
+        }
+    },
+    /* T[ 20 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xBE, 0xB1, 0x6F, 0x1A, 0xC0, 0x81, 0x9D, 0x3E ),
+            BYTES_TO_T_UINT_8( 0xE3, 0xC8, 0x53, 0x86, 0xED, 0x03, 0xA8, 0xD9 ),
+            BYTES_TO_T_UINT_8( 0xB2, 0xEF, 0x49, 0x8E, 0x5A, 0x7E, 0xC6, 0x18 ),
+            BYTES_TO_T_UINT_8( 0x55, 0xAC, 0xF2, 0xB9, 0xF7, 0x25, 0x3D, 0x9B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x50, 0x0E, 0xA9, 0xA2, 0x3D, 0xA2, 0x3B, 0x31 ),
+            BYTES_TO_T_UINT_8( 0xBC, 0x90, 0x06, 0x81, 0x7E, 0xA3, 0x09, 0x1C ),
+            BYTES_TO_T_UINT_8( 0xDA, 0x3E, 0xB6, 0x18, 0x45, 0x03, 0xBE, 0x0F ),
+            BYTES_TO_T_UINT_8( 0x6C, 0xF2, 0x96, 0x64, 0x08, 0xE3, 0xD4, 0x36 )
+        }
+    },
+    /* T[ 21 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xED, 0xC3, 0xEB, 0x49, 0x90, 0xD8, 0x45, 0x12 ),
+            BYTES_TO_T_UINT_8( 0x7E, 0x1A, 0xD9, 0xBF, 0x94, 0xC9, 0x98, 0x3B ),
+            BYTES_TO_T_UINT_8( 0x35, 0x8B, 0xFF, 0x64, 0x5E, 0x88, 0x5B, 0xF3 ),
+            BYTES_TO_T_UINT_8( 0xEC, 0xFF, 0x55, 0xF3, 0x48, 0x0A, 0x66, 0x96 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x99, 0xF8, 0xBB, 0x51, 0xAE, 0x9D, 0x7A, 0x24 ),
+            BYTES_TO_T_UINT_8( 0x1B, 0x40, 0x36, 0x4F, 0x8B, 0x66, 0xB0, 0x16 ),
+            BYTES_TO_T_UINT_8( 0x7C, 0x18, 0x6D, 0xFC, 0x8B, 0xC8, 0x13, 0xB2 ),
+            BYTES_TO_T_UINT_8( 0x07, 0x55, 0x32, 0x7D, 0xE4, 0xF3, 0x01, 0x55 )
+        }
+    },
+    /* T[ 22 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xD2, 0x8D, 0x7D, 0x7B, 0x0F, 0xEB, 0xD4, 0xDD ),
+            BYTES_TO_T_UINT_8( 0xD0, 0xDF, 0x47, 0x55, 0xBE, 0xF6, 0x78, 0x3F ),
+            BYTES_TO_T_UINT_8( 0x2E, 0x7C, 0x4C, 0x60, 0x41, 0xB5, 0x6D, 0x3A ),
+            BYTES_TO_T_UINT_8( 0x36, 0x1D, 0x2F, 0x6F, 0x6F, 0x9A, 0xCA, 0x10 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x48, 0xC8, 0xAF, 0x27, 0x35, 0xE2, 0x4D, 0x17 ),
+            BYTES_TO_T_UINT_8( 0xD7, 0x9C, 0xE8, 0x85, 0x4F, 0x04, 0x7A, 0x7D ),
+            BYTES_TO_T_UINT_8( 0x18, 0x21, 0x53, 0xED, 0xB8, 0x42, 0x80, 0x37 ),
+            BYTES_TO_T_UINT_8( 0x9F, 0xFA, 0x51, 0x1F, 0x38, 0x9A, 0x11, 0x1D )
+        }
+    },
+    /* T[ 23 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xF6, 0xC3, 0x45, 0x25, 0x79, 0x7C, 0x95, 0x01 ),
+            BYTES_TO_T_UINT_8( 0xD6, 0x90, 0xCC, 0x59, 0xBE, 0x1B, 0xD1, 0x4D ),
+            BYTES_TO_T_UINT_8( 0x2B, 0x36, 0xAC, 0x61, 0x77, 0x60, 0x52, 0xAE ),
+            BYTES_TO_T_UINT_8( 0x2D, 0xA7, 0xC0, 0xCD, 0xC5, 0xD0, 0x0C, 0x0D )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xD7, 0x47, 0x49, 0x9E, 0xC9, 0x41, 0xC8, 0x71 ),
+            BYTES_TO_T_UINT_8( 0x86, 0x76, 0x5A, 0xE0, 0x1A, 0xEA, 0xB7, 0x5D ),
+            BYTES_TO_T_UINT_8( 0x1E, 0xDA, 0xBB, 0x88, 0x53, 0x17, 0xD5, 0xF2 ),
+            BYTES_TO_T_UINT_8( 0x73, 0x6D, 0x0C, 0x11, 0xAA, 0xA9, 0x0D, 0xDD )
+        }
+    },
+    /* T[ 24 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x2E, 0x4F, 0x5D, 0x1F, 0xE1, 0x92, 0xBD, 0x24 ),
+            BYTES_TO_T_UINT_8( 0xE3, 0x7F, 0x3A, 0xED, 0x3D, 0xD2, 0xEE, 0x33 ),
+            BYTES_TO_T_UINT_8( 0xAA, 0xBC, 0x21, 0x99, 0x76, 0x32, 0xEF, 0x30 ),
+            BYTES_TO_T_UINT_8( 0x83, 0x07, 0x19, 0x6A, 0x20, 0x17, 0x1E, 0xFE )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xC1, 0x8F, 0xB3, 0xD0, 0xCA, 0xBF, 0x4B, 0xA7 ),
+            BYTES_TO_T_UINT_8( 0x37, 0x85, 0x23, 0x26, 0xBD, 0x6F, 0xD5, 0x6A ),
+            BYTES_TO_T_UINT_8( 0x0D, 0xCE, 0x4D, 0xA2, 0x3F, 0xC5, 0x53, 0x14 ),
+            BYTES_TO_T_UINT_8( 0xF3, 0x13, 0x2E, 0x57, 0x8D, 0x6F, 0xD6, 0xB8 )
+        }
+    },
+    /* T[ 25 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x5B, 0xA3, 0xDB, 0x6D, 0xA9, 0x5F, 0x13, 0x55 ),
+            BYTES_TO_T_UINT_8( 0xBA, 0xFE, 0x99, 0x0C, 0xC2, 0x93, 0x47, 0x3C ),
+            BYTES_TO_T_UINT_8( 0x61, 0x53, 0xCD, 0x65, 0xED, 0x4D, 0x98, 0xA6 ),
+            BYTES_TO_T_UINT_8( 0xFE, 0x04, 0xF8, 0x23, 0x72, 0xDF, 0xE9, 0xC1 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x6F, 0x2A, 0x78, 0x34, 0x4D, 0xA4, 0x61, 0x51 ),
+            BYTES_TO_T_UINT_8( 0x37, 0x0E, 0x58, 0x8F, 0x96, 0x42, 0xB4, 0xC2 ),
+            BYTES_TO_T_UINT_8( 0x5D, 0x24, 0x7F, 0x67, 0xCA, 0x56, 0x24, 0xBB ),
+            BYTES_TO_T_UINT_8( 0x73, 0x8A, 0xCD, 0x6B, 0x3F, 0x09, 0xD4, 0xF8 )
+        }
+    },
+    /* T[ 26 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xC5, 0x58, 0xC6, 0x80, 0x62, 0xF2, 0xD5, 0xA9 ),
+            BYTES_TO_T_UINT_8( 0x5C, 0x04, 0xA7, 0xED, 0x50, 0x57, 0xC1, 0x71 ),
+            BYTES_TO_T_UINT_8( 0xF3, 0x5F, 0x2A, 0xC9, 0x9B, 0x29, 0xF4, 0x54 ),
+            BYTES_TO_T_UINT_8( 0xE8, 0x3B, 0xFE, 0xE7, 0x03, 0x7C, 0x7D, 0x60 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x62, 0x40, 0x35, 0xE3, 0xFE, 0x84, 0xA1, 0x1E ),
+            BYTES_TO_T_UINT_8( 0xB1, 0x39, 0x5A, 0x66, 0x38, 0x62, 0x67, 0x7D ),
+            BYTES_TO_T_UINT_8( 0xB1, 0x92, 0x62, 0x70, 0x43, 0x08, 0x28, 0x45 ),
+            BYTES_TO_T_UINT_8( 0x7F, 0xD7, 0xDA, 0x12, 0x00, 0x02, 0xFB, 0xF5 )
+        }
+    },
+    /* T[ 27 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x57, 0x67, 0xA8, 0x75, 0xF7, 0x1B, 0x10, 0xE1 ),
+            BYTES_TO_T_UINT_8( 0xF2, 0x80, 0x87, 0xC5, 0x1C, 0xB0, 0x34, 0x3F ),
+            BYTES_TO_T_UINT_8( 0x2E, 0x31, 0x62, 0x8A, 0xF8, 0x80, 0xD0, 0x0F ),
+            BYTES_TO_T_UINT_8( 0x40, 0xCB, 0x3B, 0x69, 0x7E, 0xCC, 0xD3, 0xB0 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xBB, 0x47, 0x02, 0x99, 0xC1, 0xA9, 0x3B, 0xE6 ),
+            BYTES_TO_T_UINT_8( 0x21, 0x05, 0x1A, 0x6F, 0x03, 0xD0, 0x7D, 0x09 ),
+            BYTES_TO_T_UINT_8( 0xF9, 0xCD, 0xA1, 0x4B, 0x48, 0x4A, 0x8E, 0xBA ),
+            BYTES_TO_T_UINT_8( 0x47, 0xF2, 0x38, 0x7E, 0x26, 0xEB, 0xE2, 0xB8 )
+        }
+    },
+    /* T[ 28 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xA8, 0x9C, 0x92, 0x3E, 0x87, 0xAE, 0xFC, 0x9C ),
+            BYTES_TO_T_UINT_8( 0x23, 0x2F, 0xBD, 0xE8, 0x1F, 0x27, 0xDA, 0xF2 ),
+            BYTES_TO_T_UINT_8( 0x30, 0x7E, 0x1D, 0x96, 0xE3, 0x9F, 0x53, 0x04 ),
+            BYTES_TO_T_UINT_8( 0x2F, 0x49, 0xD3, 0x67, 0xBF, 0xE7, 0x20, 0x0A )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xC2, 0x57, 0x66, 0xAE, 0x24, 0xEA, 0x14, 0xB6 ),
+            BYTES_TO_T_UINT_8( 0x37, 0x8F, 0x21, 0x9A, 0xCF, 0x0E, 0xCE, 0x9C ),
+            BYTES_TO_T_UINT_8( 0x17, 0xC3, 0x5F, 0x74, 0x8D, 0x58, 0x49, 0xA5 ),
+            BYTES_TO_T_UINT_8( 0x73, 0xFC, 0x34, 0x8F, 0x64, 0x43, 0x34, 0xB3 )
+        }
+    },
+    /* T[ 29 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xEC, 0x8B, 0x11, 0xAE, 0x84, 0xB3, 0x0B, 0xCA ),
+            BYTES_TO_T_UINT_8( 0x71, 0xC3, 0x6E, 0x2D, 0x7A, 0xFC, 0x5E, 0x7E ),
+            BYTES_TO_T_UINT_8( 0x75, 0x7A, 0x1F, 0x93, 0x70, 0x3D, 0xCA, 0x35 ),
+            BYTES_TO_T_UINT_8( 0x93, 0x29, 0x15, 0x11, 0xEC, 0x1C, 0x2B, 0x97 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x50, 0x6B, 0x63, 0xFE, 0x14, 0xE0, 0x03, 0x48 ),
+            BYTES_TO_T_UINT_8( 0x7D, 0xF7, 0x38, 0xBC, 0xCB, 0x9B, 0x51, 0xA1 ),
+            BYTES_TO_T_UINT_8( 0xED, 0x81, 0xEA, 0x7B, 0x29, 0xA8, 0x75, 0xDB ),
+            BYTES_TO_T_UINT_8( 0x60, 0x0F, 0x4B, 0xDA, 0xE5, 0x43, 0x20, 0x3F )
+        }
+    },
+    /* T[ 30 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x17, 0x67, 0x20, 0x2C, 0xAD, 0xF2, 0xB3, 0xC6 ),
+            BYTES_TO_T_UINT_8( 0x71, 0xD0, 0xAB, 0x75, 0x26, 0x2C, 0x69, 0xF1 ),
+            BYTES_TO_T_UINT_8( 0x9C, 0xC1, 0x94, 0x73, 0xDE, 0x53, 0xD1, 0xBD ),
+            BYTES_TO_T_UINT_8( 0x04, 0x57, 0x28, 0x89, 0x3B, 0xCD, 0x7B, 0x44 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x7F, 0x1E, 0x64, 0x34, 0x1D, 0x03, 0xDA, 0x78 ),
+            BYTES_TO_T_UINT_8( 0xD0, 0xC2, 0x0B, 0xA8, 0x3B, 0xE1, 0x6A, 0x8E ),
+            BYTES_TO_T_UINT_8( 0xBB, 0x42, 0x19, 0x34, 0x72, 0x84, 0x64, 0x72 ),
+            BYTES_TO_T_UINT_8( 0x89, 0x4F, 0x8B, 0xD7, 0x3E, 0xCE, 0xC7, 0x57 )
+        }
+    },
+    /* T[ 31 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x22, 0x1B, 0xFC, 0xD9, 0xA4, 0x31, 0xBA, 0xC0 ),
+            BYTES_TO_T_UINT_8( 0xB4, 0x72, 0xB3, 0x13, 0x4C, 0xAE, 0xA1, 0x60 ),
+            BYTES_TO_T_UINT_8( 0x45, 0x88, 0x79, 0xCC, 0x76, 0xDD, 0x34, 0x74 ),
+            BYTES_TO_T_UINT_8( 0x5D, 0x73, 0x8A, 0x03, 0xBF, 0x88, 0xE3, 0xA7 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x7D, 0xBC, 0x05, 0x34, 0x4E, 0xE4, 0x24, 0x11 ),
+            BYTES_TO_T_UINT_8( 0x5D, 0x41, 0x79, 0x3B, 0x5F, 0xFE, 0x86, 0x43 ),
+            BYTES_TO_T_UINT_8( 0xE3, 0x44, 0x45, 0xF5, 0xFF, 0xC6, 0x3D, 0xC4 ),
+            BYTES_TO_T_UINT_8( 0x80, 0x53, 0x0F, 0x31, 0x06, 0x7B, 0xCA, 0x73 )
+        }
+    },
+    /* T[ 32 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x65, 0x54, 0x0E, 0xF4, 0x01, 0x48, 0xA2, 0x90 ),
+            BYTES_TO_T_UINT_8( 0x9E, 0xB9, 0x1D, 0x5D, 0x36, 0x55, 0x5A, 0x2F ),
+            BYTES_TO_T_UINT_8( 0x4B, 0x4E, 0xD5, 0x3B, 0x71, 0xA4, 0x76, 0x25 ),
+            BYTES_TO_T_UINT_8( 0x00, 0x8E, 0xF7, 0xD2, 0x14, 0xCF, 0x7D, 0xE8 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x79, 0xFB, 0xDA, 0x66, 0x3D, 0x8D, 0x27, 0x31 ),
+            BYTES_TO_T_UINT_8( 0xAC, 0xC8, 0x91, 0x90, 0x12, 0xCF, 0x42, 0xA9 ),
+            BYTES_TO_T_UINT_8( 0x7B, 0xB2, 0xB5, 0x84, 0xB3, 0xD2, 0xC2, 0x55 ),
+            BYTES_TO_T_UINT_8( 0xE1, 0x9F, 0x57, 0xAB, 0xE6, 0xCE, 0xD5, 0x52 )
+        }
+    },
+    /* T[ 33 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xD1, 0x85, 0x65, 0x6D, 0xD4, 0xFF, 0xA8, 0xA1 ),
+            BYTES_TO_T_UINT_8( 0x72, 0xA1, 0xAF, 0xAB, 0x28, 0xE1, 0x49, 0xA1 ),
+            BYTES_TO_T_UINT_8( 0x2A, 0x71, 0xD9, 0x78, 0xDE, 0x3A, 0x5B, 0x8F ),
+            BYTES_TO_T_UINT_8( 0xCB, 0x62, 0x28, 0x0C, 0x7C, 0x16, 0x70, 0x9C )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xEC, 0x4A, 0x58, 0xE2, 0x42, 0x69, 0x63, 0x6D ),
+            BYTES_TO_T_UINT_8( 0x2C, 0x4E, 0xDD, 0xC5, 0x93, 0x1F, 0xAA, 0xC7 ),
+            BYTES_TO_T_UINT_8( 0x65, 0x4B, 0x17, 0x2D, 0x23, 0x87, 0xFA, 0x5B ),
+            BYTES_TO_T_UINT_8( 0xE4, 0x96, 0x2A, 0x52, 0x36, 0x6D, 0xCE, 0x64 )
+        }
+    },
+    /* T[ 34 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x29, 0xA7, 0x85, 0xD3, 0x3C, 0x55, 0x71, 0x61 ),
+            BYTES_TO_T_UINT_8( 0xCA, 0xC6, 0x64, 0x51, 0xA5, 0x2D, 0xF9, 0x7A ),
+            BYTES_TO_T_UINT_8( 0x5A, 0x5C, 0x4A, 0x14, 0x39, 0xE4, 0xD0, 0xFB ),
+            BYTES_TO_T_UINT_8( 0xC1, 0x76, 0x15, 0x29, 0x7A, 0xF2, 0x44, 0x97 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xD1, 0x5E, 0x95, 0x5D, 0x18, 0x63, 0x7C, 0x60 ),
+            BYTES_TO_T_UINT_8( 0xE6, 0x6B, 0x23, 0xCE, 0x3A, 0x11, 0x77, 0x53 ),
+            BYTES_TO_T_UINT_8( 0xD9, 0x09, 0xF9, 0x2C, 0x8D, 0x34, 0x19, 0x9B ),
+            BYTES_TO_T_UINT_8( 0x8E, 0xC1, 0x5E, 0x4F, 0xDD, 0x0C, 0x52, 0x71 )
+        }
+    },
+    /* T[ 35 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x5D, 0xBB, 0xB3, 0xD1, 0x75, 0x1E, 0x26, 0x45 ),
+            BYTES_TO_T_UINT_8( 0x10, 0xDF, 0xDB, 0x8D, 0xFE, 0x27, 0x06, 0x1A ),
+            BYTES_TO_T_UINT_8( 0x32, 0x7E, 0xA5, 0x18, 0xC3, 0x7A, 0x19, 0xC7 ),
+            BYTES_TO_T_UINT_8( 0xCA, 0x6C, 0x32, 0x2D, 0xD8, 0x36, 0xE6, 0xFC )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x61, 0x00, 0xA4, 0x2E, 0x2A, 0xC1, 0x4A, 0xC5 ),
+            BYTES_TO_T_UINT_8( 0xC7, 0x18, 0xF3, 0x12, 0x85, 0xD8, 0xFA, 0xB1 ),
+            BYTES_TO_T_UINT_8( 0xF9, 0x05, 0x7D, 0x4F, 0xEE, 0xAF, 0x8B, 0xEA ),
+            BYTES_TO_T_UINT_8( 0xA6, 0x5B, 0xCD, 0x76, 0x14, 0xB7, 0x33, 0xF4 )
+        }
+    },
+    /* T[ 36 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x80, 0x2E, 0x70, 0x7D, 0xC7, 0x5C, 0x5E, 0xEC ),
+            BYTES_TO_T_UINT_8( 0xD3, 0x02, 0xEF, 0xA8, 0xC5, 0xEF, 0x0E, 0x31 ),
+            BYTES_TO_T_UINT_8( 0x5B, 0x7B, 0xF0, 0x64, 0xAC, 0x55, 0x84, 0xFC ),
+            BYTES_TO_T_UINT_8( 0x54, 0xA2, 0x40, 0x8C, 0x26, 0xD8, 0xE1, 0x49 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x1E, 0x9D, 0x87, 0xA0, 0xE2, 0x6A, 0x57, 0x5C ),
+            BYTES_TO_T_UINT_8( 0x98, 0xC0, 0x5E, 0xA2, 0xDA, 0x52, 0x4E, 0xEC ),
+            BYTES_TO_T_UINT_8( 0x80, 0x6E, 0xDB, 0x9A, 0xDD, 0xD3, 0xCE, 0xBB ),
+            BYTES_TO_T_UINT_8( 0xD3, 0x08, 0xC4, 0x23, 0xA2, 0xDF, 0x41, 0xBD )
+        }
+    },
+    /* T[ 37 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x1B, 0x68, 0xF0, 0x30, 0x6B, 0x87, 0x8B, 0x4C ),
+            BYTES_TO_T_UINT_8( 0x43, 0x35, 0x76, 0x1B, 0xE9, 0x5A, 0x63, 0x1B ),
+            BYTES_TO_T_UINT_8( 0x2C, 0xC1, 0x25, 0xC1, 0x05, 0x86, 0x6C, 0xB3 ),
+            BYTES_TO_T_UINT_8( 0x11, 0xEA, 0xA1, 0xBC, 0x70, 0x10, 0xCD, 0x90 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x70, 0x74, 0x41, 0x32, 0xB8, 0xCD, 0xAD, 0xBB ),
+            BYTES_TO_T_UINT_8( 0xDB, 0x27, 0xF5, 0x67, 0x5A, 0x18, 0xDD, 0x0C ),
+            BYTES_TO_T_UINT_8( 0x54, 0x00, 0xB5, 0xA5, 0xBF, 0x72, 0xF9, 0x01 ),
+            BYTES_TO_T_UINT_8( 0x82, 0x19, 0xEE, 0x5B, 0x87, 0xE9, 0x06, 0x60 )
+        }
+    },
+    /* T[ 38 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x29, 0xFF, 0xB1, 0x58, 0x6E, 0xC4, 0xC6, 0x92 ),
+            BYTES_TO_T_UINT_8( 0x0B, 0x50, 0xB0, 0x05, 0x89, 0xD9, 0x30, 0x5C ),
+            BYTES_TO_T_UINT_8( 0x69, 0x02, 0x9A, 0x3A, 0x2B, 0xB8, 0x8C, 0x26 ),
+            BYTES_TO_T_UINT_8( 0x0A, 0xDD, 0x43, 0x07, 0xD4, 0xF1, 0x20, 0xCB )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x55, 0x9A, 0x8F, 0xF1, 0x4A, 0x22, 0x44, 0xC2 ),
+            BYTES_TO_T_UINT_8( 0x8A, 0x29, 0x2B, 0xC7, 0xBF, 0x32, 0x6E, 0x03 ),
+            BYTES_TO_T_UINT_8( 0x8E, 0x8E, 0x89, 0x56, 0xE2, 0x32, 0xB0, 0x35 ),
+            BYTES_TO_T_UINT_8( 0xB2, 0xE0, 0xAE, 0xBB, 0xDF, 0x17, 0x3C, 0x6C )
+        }
+    },
+    /* T[ 39 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x2C, 0x9D, 0xA9, 0x12, 0xAE, 0xFC, 0x38, 0x57 ),
+            BYTES_TO_T_UINT_8( 0xA2, 0xEF, 0xA6, 0xF9, 0x45, 0xF6, 0xCB, 0x4D ),
+            BYTES_TO_T_UINT_8( 0x26, 0xF1, 0x52, 0xE4, 0xEB, 0xD4, 0x3D, 0xC6 ),
+            BYTES_TO_T_UINT_8( 0x10, 0xF1, 0xD2, 0x1B, 0xCF, 0xB8, 0x2C, 0x46 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xF6, 0xCB, 0x85, 0xDF, 0x15, 0xB2, 0xFD, 0xCE ),
+            BYTES_TO_T_UINT_8( 0x59, 0xD9, 0x4C, 0xF2, 0xC5, 0x7F, 0x23, 0x06 ),
+            BYTES_TO_T_UINT_8( 0xF7, 0xA5, 0x20, 0x57, 0x41, 0x8F, 0x15, 0xFE ),
+            BYTES_TO_T_UINT_8( 0xA0, 0x70, 0xA2, 0x7B, 0xFA, 0x68, 0xC7, 0xC5 )
+        }
+    },
+    /* T[ 40 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x16, 0x6A, 0x8C, 0x7F, 0xC7, 0x93, 0x3B, 0xBE ),
+            BYTES_TO_T_UINT_8( 0x97, 0xEB, 0x7E, 0x1E, 0x1C, 0x69, 0x11, 0xA1 ),
+            BYTES_TO_T_UINT_8( 0x43, 0xC1, 0x31, 0xF8, 0xA7, 0x62, 0x06, 0xC2 ),
+            BYTES_TO_T_UINT_8( 0xEB, 0x54, 0xAD, 0x4B, 0x28, 0xB1, 0xD5, 0xA8 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xB3, 0x00, 0xE9, 0x26, 0xC2, 0xD4, 0xE1, 0xF9 ),
+            BYTES_TO_T_UINT_8( 0xB4, 0xB6, 0x31, 0x02, 0x2E, 0x48, 0x58, 0x8F ),
+            BYTES_TO_T_UINT_8( 0xA3, 0x2F, 0x3C, 0x0B, 0x7B, 0x73, 0x6F, 0xFF ),
+            BYTES_TO_T_UINT_8( 0x7E, 0x20, 0xF5, 0x1A, 0xBA, 0xDE, 0x92, 0x35 )
+        }
+    },
+    /* T[ 41 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x96, 0x00, 0xC6, 0x48, 0x15, 0x3B, 0x9A, 0x92 ),
+            BYTES_TO_T_UINT_8( 0x04, 0xF6, 0xD1, 0x1E, 0x45, 0x28, 0x5E, 0x3A ),
+            BYTES_TO_T_UINT_8( 0xA7, 0x9E, 0x88, 0xF6, 0x3E, 0x71, 0x6A, 0x7C ),
+            BYTES_TO_T_UINT_8( 0xFC, 0x79, 0xB5, 0xE7, 0x57, 0x40, 0x54, 0x44 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x24, 0xA5, 0xDC, 0x4C, 0x8C, 0x0F, 0x13, 0x87 ),
+            BYTES_TO_T_UINT_8( 0x4F, 0xC0, 0xE8, 0xAA, 0x6C, 0xC9, 0xD1, 0x41 ),
+            BYTES_TO_T_UINT_8( 0x7E, 0x3D, 0x03, 0xA6, 0x5D, 0x41, 0x1F, 0x3C ),
+            BYTES_TO_T_UINT_8( 0xD3, 0xDB, 0xE7, 0x5A, 0x0B, 0x94, 0xD2, 0xFC )
+        }
+    },
+    /* T[ 42 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x6A, 0x65, 0xB3, 0x35, 0x76, 0x02, 0x3F, 0xD9 ),
+            BYTES_TO_T_UINT_8( 0x10, 0x9A, 0xBC, 0xE6, 0xC7, 0x0C, 0x63, 0x74 ),
+            BYTES_TO_T_UINT_8( 0xAB, 0xAD, 0x32, 0xB9, 0xC5, 0x25, 0x23, 0xE8 ),
+            BYTES_TO_T_UINT_8( 0xAF, 0x70, 0x07, 0x42, 0xD9, 0x31, 0x2F, 0xD8 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x8C, 0xE0, 0xEC, 0xA5, 0x4B, 0xDF, 0xB4, 0x30 ),
+            BYTES_TO_T_UINT_8( 0x4A, 0xAA, 0xF2, 0x32, 0x1E, 0xB5, 0xB3, 0xA0 ),
+            BYTES_TO_T_UINT_8( 0x2A, 0x9A, 0x24, 0x17, 0x08, 0x34, 0x3A, 0x2B ),
+            BYTES_TO_T_UINT_8( 0x40, 0xFD, 0xE6, 0xA1, 0x3A, 0x16, 0x8F, 0x03 )
+        }
+    },
+    /* T[ 43 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xB7, 0x49, 0x19, 0x5A, 0x68, 0x83, 0x21, 0x42 ),
+            BYTES_TO_T_UINT_8( 0x56, 0x2C, 0xA8, 0xFF, 0x8E, 0xF7, 0x74, 0xBF ),
+            BYTES_TO_T_UINT_8( 0xF6, 0xDB, 0x45, 0x45, 0xAE, 0x3F, 0xD6, 0x57 ),
+            BYTES_TO_T_UINT_8( 0xB6, 0xF9, 0x0C, 0x6B, 0x92, 0x58, 0xCF, 0xF1 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x01, 0x7C, 0x08, 0x26, 0x34, 0xAD, 0xA0, 0xC2 ),
+            BYTES_TO_T_UINT_8( 0x68, 0x0F, 0x93, 0x0C, 0xFE, 0xD1, 0xE4, 0xF4 ),
+            BYTES_TO_T_UINT_8( 0x2C, 0x28, 0x63, 0xF7, 0x72, 0x05, 0xE6, 0x75 ),
+            BYTES_TO_T_UINT_8( 0x6F, 0x7F, 0x66, 0xA3, 0xBA, 0x06, 0x9E, 0x93 )
+        }
+    },
+    /* T[ 44 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xCB, 0x0E, 0xD8, 0x78, 0xA0, 0x1C, 0xCF, 0x95 ),
+            BYTES_TO_T_UINT_8( 0xEB, 0x27, 0x11, 0xD1, 0x59, 0x1D, 0xEA, 0x27 ),
+            BYTES_TO_T_UINT_8( 0xC2, 0x0F, 0x30, 0x99, 0x5A, 0x9C, 0xC8, 0x96 ),
+            BYTES_TO_T_UINT_8( 0x5A, 0xD5, 0xB3, 0x02, 0xE0, 0x00, 0x9E, 0xA9 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x72, 0xC0, 0xE7, 0x84, 0xFE, 0x66, 0xE7, 0x59 ),
+            BYTES_TO_T_UINT_8( 0xA1, 0xAB, 0x72, 0xBF, 0x67, 0x4F, 0x5F, 0xDB ),
+            BYTES_TO_T_UINT_8( 0x7D, 0x09, 0x33, 0xFB, 0x7D, 0x05, 0x29, 0xD6 ),
+            BYTES_TO_T_UINT_8( 0x85, 0x83, 0x58, 0x24, 0xE7, 0x79, 0xF3, 0xDF )
+        }
+    },
+    /* T[ 45 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xEF, 0x70, 0xA3, 0xA8, 0x40, 0x60, 0x22, 0x45 ),
+            BYTES_TO_T_UINT_8( 0x5A, 0x95, 0x8B, 0x7A, 0xEC, 0x4C, 0x10, 0xF7 ),
+            BYTES_TO_T_UINT_8( 0x79, 0x44, 0x12, 0x97, 0x5F, 0xCF, 0xB4, 0x5A ),
+            BYTES_TO_T_UINT_8( 0x99, 0xD4, 0xCF, 0x73, 0x9C, 0x46, 0x0B, 0xCE )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x7B, 0xE0, 0x33, 0xE4, 0xC8, 0x56, 0x10, 0xB5 ),
+            BYTES_TO_T_UINT_8( 0x72, 0xE6, 0xD6, 0xA1, 0x9C, 0x37, 0xA6, 0xC4 ),
+            BYTES_TO_T_UINT_8( 0xF9, 0x1D, 0x81, 0x45, 0xEA, 0xFC, 0x21, 0x99 ),
+            BYTES_TO_T_UINT_8( 0xE5, 0x10, 0xDB, 0xE2, 0x13, 0x7E, 0x99, 0x23 )
+        }
+    },
+    /* T[ 46 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x33, 0x71, 0xB7, 0x57, 0xD4, 0x87, 0x68, 0x3C ),
+            BYTES_TO_T_UINT_8( 0x43, 0xF7, 0x24, 0x13, 0xC3, 0x26, 0xC7, 0x5F ),
+            BYTES_TO_T_UINT_8( 0x49, 0x6B, 0x41, 0xB4, 0x60, 0x2B, 0xE0, 0x61 ),
+            BYTES_TO_T_UINT_8( 0x4F, 0xD4, 0x51, 0xF4, 0xE8, 0xCC, 0x9E, 0xAD )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x68, 0xF7, 0x9A, 0x4D, 0xAF, 0x52, 0x8D, 0x7D ),
+            BYTES_TO_T_UINT_8( 0x82, 0x64, 0x62, 0x33, 0x4C, 0x62, 0x1B, 0x12 ),
+            BYTES_TO_T_UINT_8( 0xA5, 0xA7, 0x05, 0x1F, 0x13, 0xCE, 0xBA, 0xBF ),
+            BYTES_TO_T_UINT_8( 0xF6, 0x13, 0x15, 0x08, 0x1E, 0xDB, 0x8C, 0x4C )
+        }
+    },
+    /* T[ 47 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x18, 0x70, 0x5E, 0x4B, 0x89, 0x5C, 0x18, 0x2C ),
+            BYTES_TO_T_UINT_8( 0xDB, 0x4C, 0x6C, 0x03, 0xF8, 0x6E, 0xD5, 0x41 ),
+            BYTES_TO_T_UINT_8( 0xF7, 0xA6, 0xF6, 0xB9, 0xBD, 0xF0, 0x78, 0xB2 ),
+            BYTES_TO_T_UINT_8( 0x35, 0x1D, 0x1E, 0xBF, 0xE4, 0x4F, 0x39, 0x81 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x27, 0xA8, 0x3C, 0x31, 0x88, 0x64, 0xEB, 0x39 ),
+            BYTES_TO_T_UINT_8( 0xF4, 0x97, 0xB3, 0x89, 0x6D, 0x54, 0x42, 0x85 ),
+            BYTES_TO_T_UINT_8( 0xCB, 0x2C, 0x92, 0x0C, 0xAB, 0x02, 0x0B, 0xA5 ),
+            BYTES_TO_T_UINT_8( 0xC0, 0x67, 0x10, 0x60, 0xCA, 0xE7, 0xC0, 0x46 )
+        }
+    },
+    /* T[ 48 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x65, 0x06, 0xA6, 0xD5, 0x8A, 0xC3, 0x17, 0xB0 ),
+            BYTES_TO_T_UINT_8( 0xA6, 0x8E, 0xE8, 0x75, 0x05, 0x7B, 0x46, 0xC9 ),
+            BYTES_TO_T_UINT_8( 0xF8, 0x75, 0x78, 0x6F, 0x0F, 0x0D, 0xF3, 0xA1 ),
+            BYTES_TO_T_UINT_8( 0x01, 0x26, 0xD5, 0xD4, 0x86, 0x92, 0x50, 0x6C )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xF0, 0x45, 0x2E, 0x1F, 0x7C, 0xFB, 0xA5, 0xD1 ),
+            BYTES_TO_T_UINT_8( 0x39, 0x17, 0x40, 0x13, 0x6B, 0x9A, 0xF4, 0x5F ),
+            BYTES_TO_T_UINT_8( 0xE2, 0x69, 0xFA, 0x87, 0xBB, 0x26, 0x4C, 0x4A ),
+            BYTES_TO_T_UINT_8( 0x99, 0xCC, 0x6A, 0x6B, 0xCB, 0xAC, 0x4E, 0x21 )
+        }
+    },
+    /* T[ 49 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xCF, 0x1B, 0x5F, 0x92, 0x86, 0x27, 0xC0, 0x99 ),
+            BYTES_TO_T_UINT_8( 0x7F, 0x19, 0xE1, 0x5B, 0xF3, 0x91, 0x4F, 0x4C ),
+            BYTES_TO_T_UINT_8( 0x40, 0x74, 0x64, 0x65, 0x77, 0x53, 0x0A, 0x4D ),
+            BYTES_TO_T_UINT_8( 0x2C, 0x8B, 0x5A, 0x22, 0xEE, 0x7B, 0x91, 0xF4 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xC2, 0x67, 0x97, 0x75, 0x6B, 0x5A, 0x75, 0xFA ),
+            BYTES_TO_T_UINT_8( 0x04, 0x48, 0x6F, 0xD4, 0x12, 0x78, 0xFF, 0x74 ),
+            BYTES_TO_T_UINT_8( 0xD4, 0xDF, 0xEE, 0xCD, 0xC7, 0x40, 0x11, 0x95 ),
+            BYTES_TO_T_UINT_8( 0xC5, 0xF1, 0x80, 0x93, 0x98, 0xE5, 0x00, 0x6D )
+        }
+    },
+    /* T[ 50 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x79, 0x67, 0xB7, 0x0B, 0x70, 0xA3, 0x20, 0x1A ),
+            BYTES_TO_T_UINT_8( 0xED, 0x78, 0x69, 0x30, 0xE1, 0xE0, 0x1C, 0x11 ),
+            BYTES_TO_T_UINT_8( 0xC4, 0x22, 0xC0, 0x4A, 0x97, 0x80, 0x94, 0x75 ),
+            BYTES_TO_T_UINT_8( 0xB0, 0x5C, 0x65, 0x43, 0x1B, 0xF9, 0x45, 0xB6 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xB0, 0x92, 0xCD, 0x12, 0x9F, 0x53, 0xCF, 0x5B ),
+            BYTES_TO_T_UINT_8( 0x38, 0x73, 0x75, 0x3A, 0x37, 0xA9, 0x37, 0x21 ),
+            BYTES_TO_T_UINT_8( 0xA7, 0xE9, 0x6A, 0xE3, 0xA2, 0x61, 0xD4, 0xEA ),
+            BYTES_TO_T_UINT_8( 0x0E, 0x53, 0xCF, 0x12, 0xDA, 0x01, 0xA1, 0xE1 )
+        }
+    },
+    /* T[ 51 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x04, 0x8B, 0x52, 0xCD, 0x9A, 0xBC, 0xDE, 0xD5 ),
+            BYTES_TO_T_UINT_8( 0x69, 0x65, 0x78, 0x1B, 0xB8, 0x31, 0x5F, 0x62 ),
+            BYTES_TO_T_UINT_8( 0x4D, 0x2B, 0xA4, 0x9F, 0x67, 0x79, 0x31, 0x2D ),
+            BYTES_TO_T_UINT_8( 0x0D, 0x9B, 0xBC, 0xAE, 0xAB, 0xC4, 0xDD, 0xC7 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x38, 0xBC, 0x3C, 0xB5, 0xE7, 0x18, 0x59, 0x31 ),
+            BYTES_TO_T_UINT_8( 0x0E, 0x55, 0xD2, 0xCC, 0xDD, 0x18, 0xC5, 0xD5 ),
+            BYTES_TO_T_UINT_8( 0x3C, 0x73, 0xAA, 0xE5, 0xCB, 0x7C, 0xF4, 0x2E ),
+            BYTES_TO_T_UINT_8( 0x1E, 0x17, 0x8E, 0xC2, 0xDE, 0xD8, 0x00, 0xF3 )
+        }
+    },
+    /* T[ 52 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x8D, 0x5C, 0xC9, 0xD5, 0x64, 0x07, 0x5C, 0xD6 ),
+            BYTES_TO_T_UINT_8( 0x03, 0xDA, 0x21, 0x17, 0x21, 0x88, 0x1F, 0xE1 ),
+            BYTES_TO_T_UINT_8( 0x99, 0x07, 0x76, 0xB9, 0x19, 0xCD, 0x9E, 0x4E ),
+            BYTES_TO_T_UINT_8( 0x31, 0x54, 0x5E, 0x46, 0xD8, 0x4A, 0xB9, 0x06 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xE0, 0x72, 0xEA, 0x1B, 0xDF, 0x4D, 0x76, 0xEE ),
+            BYTES_TO_T_UINT_8( 0xE1, 0xAE, 0x11, 0xB2, 0xD1, 0x2B, 0x46, 0x36 ),
+            BYTES_TO_T_UINT_8( 0x4E, 0xFB, 0x36, 0x2F, 0x52, 0x7A, 0x6D, 0x43 ),
+            BYTES_TO_T_UINT_8( 0x00, 0x7F, 0x2E, 0x65, 0x60, 0xF6, 0x55, 0xF7 )
+        }
+    },
+    /* T[ 53 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x94, 0x90, 0x76, 0x2E, 0x57, 0x6C, 0xAD, 0x51 ),
+            BYTES_TO_T_UINT_8( 0xBC, 0x0F, 0xB2, 0x28, 0x8F, 0x63, 0x90, 0x4C ),
+            BYTES_TO_T_UINT_8( 0x8D, 0xB6, 0xB9, 0x89, 0xF5, 0xBA, 0x5F, 0xE5 ),
+            BYTES_TO_T_UINT_8( 0x39, 0xF7, 0x05, 0x74, 0xC1, 0x4F, 0xBB, 0x31 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x7E, 0x05, 0x6F, 0x68, 0x61, 0x74, 0x15, 0xAA ),
+            BYTES_TO_T_UINT_8( 0xDF, 0x6A, 0xE1, 0x4A, 0xB5, 0xA8, 0x10, 0x3B ),
+            BYTES_TO_T_UINT_8( 0x1B, 0x5F, 0x60, 0x07, 0xB1, 0x83, 0xE9, 0xC3 ),
+            BYTES_TO_T_UINT_8( 0x30, 0x39, 0x41, 0x8D, 0x08, 0x3E, 0xB1, 0xE3 )
+        }
+    },
+    /* T[ 54 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xA8, 0x42, 0xD9, 0xA2, 0x48, 0x76, 0x83, 0x85 ),
+            BYTES_TO_T_UINT_8( 0x50, 0xBE, 0x2A, 0xA2, 0x3F, 0xFA, 0xE0, 0x84 ),
+            BYTES_TO_T_UINT_8( 0x30, 0x71, 0x89, 0x3F, 0x7B, 0xA9, 0xB2, 0x5B ),
+            BYTES_TO_T_UINT_8( 0x2C, 0x18, 0x63, 0xC7, 0xC6, 0x07, 0xFB, 0x6B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x8F, 0x6C, 0x68, 0xB1, 0xC6, 0x95, 0x58, 0x60 ),
+            BYTES_TO_T_UINT_8( 0xB4, 0xF0, 0x79, 0x52, 0x6C, 0x32, 0x14, 0x60 ),
+            BYTES_TO_T_UINT_8( 0xA1, 0xC4, 0x51, 0x70, 0x41, 0x51, 0xE7, 0x76 ),
+            BYTES_TO_T_UINT_8( 0x22, 0x50, 0xF2, 0x13, 0x36, 0x8A, 0x9C, 0xE6 )
+        }
+    },
+    /* T[ 55 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x78, 0x36, 0x05, 0x18, 0xB0, 0xE4, 0xBB, 0x98 ),
+            BYTES_TO_T_UINT_8( 0x86, 0xF7, 0x26, 0xF4, 0x10, 0x7C, 0x29, 0xCB ),
+            BYTES_TO_T_UINT_8( 0xF3, 0x1E, 0xEA, 0x38, 0xA2, 0x1F, 0x84, 0xB5 ),
+            BYTES_TO_T_UINT_8( 0x22, 0x40, 0xB3, 0x4B, 0xB4, 0x6C, 0x1B, 0xAC )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x23, 0xE1, 0x18, 0x46, 0x9F, 0xF0, 0x59, 0x60 ),
+            BYTES_TO_T_UINT_8( 0x93, 0xF1, 0x6B, 0xA6, 0x92, 0x51, 0x57, 0x62 ),
+            BYTES_TO_T_UINT_8( 0x5D, 0xD7, 0xF6, 0x9A, 0x79, 0xCF, 0x29, 0xC5 ),
+            BYTES_TO_T_UINT_8( 0xFB, 0x66, 0x4B, 0x1A, 0xED, 0x19, 0xB8, 0xCA )
+        }
+    },
+    /* T[ 56 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xD6, 0xB1, 0xA1, 0x1D, 0x2E, 0x8B, 0xD8, 0xCB ),
+            BYTES_TO_T_UINT_8( 0x7C, 0x1E, 0x7B, 0xC2, 0x4B, 0xD2, 0x87, 0x7B ),
+            BYTES_TO_T_UINT_8( 0x1D, 0x0B, 0x3B, 0x0C, 0x98, 0x43, 0x77, 0x3D ),
+            BYTES_TO_T_UINT_8( 0x31, 0x77, 0x6A, 0xF8, 0x0A, 0xD0, 0x10, 0x69 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xAC, 0x50, 0x8A, 0xDD, 0xBC, 0xC0, 0x22, 0xAB ),
+            BYTES_TO_T_UINT_8( 0xB2, 0xB8, 0xD5, 0x86, 0x11, 0x16, 0x11, 0xA7 ),
+            BYTES_TO_T_UINT_8( 0x2D, 0x44, 0xFB, 0xCC, 0xB2, 0x16, 0x8E, 0x99 ),
+            BYTES_TO_T_UINT_8( 0x72, 0xA7, 0x29, 0x1F, 0x3C, 0x6A, 0xE4, 0x45 )
+        }
+    },
+    /* T[ 57 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xB7, 0xBC, 0x16, 0x2D, 0x0D, 0x24, 0x58, 0x7A ),
+            BYTES_TO_T_UINT_8( 0xF1, 0x06, 0x54, 0x73, 0xC3, 0x9F, 0x91, 0x1E ),
+            BYTES_TO_T_UINT_8( 0xA8, 0x2D, 0xF4, 0x66, 0xFE, 0xF8, 0xF9, 0xA7 ),
+            BYTES_TO_T_UINT_8( 0xD9, 0xBD, 0x32, 0x9A, 0x26, 0xDF, 0xB9, 0x8B )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x1E, 0x70, 0xE5, 0x2E, 0x2E, 0xB3, 0xCE, 0x66 ),
+            BYTES_TO_T_UINT_8( 0x65, 0x2A, 0x6D, 0x3E, 0xFC, 0x63, 0x1C, 0x0B ),
+            BYTES_TO_T_UINT_8( 0x4A, 0x11, 0x41, 0xA8, 0x7B, 0xBF, 0x9A, 0x91 ),
+            BYTES_TO_T_UINT_8( 0x63, 0x0C, 0xB2, 0x45, 0x20, 0x63, 0xC1, 0x1F )
+        }
+    },
+    /* T[ 58 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x1C, 0xC8, 0xAD, 0x70, 0x80, 0x09, 0xD2, 0xD1 ),
+            BYTES_TO_T_UINT_8( 0x85, 0x65, 0x0A, 0x96, 0xA7, 0xDD, 0xB2, 0xC8 ),
+            BYTES_TO_T_UINT_8( 0xC2, 0x4D, 0x7B, 0x2E, 0x83, 0x3C, 0x18, 0xDD ),
+            BYTES_TO_T_UINT_8( 0x88, 0x4C, 0x66, 0xA4, 0x4F, 0x14, 0x56, 0xF6 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x2B, 0x24, 0x99, 0x4E, 0x86, 0x8D, 0xDD, 0x66 ),
+            BYTES_TO_T_UINT_8( 0x46, 0xDD, 0xE0, 0x78, 0x9D, 0xEE, 0x9D, 0x9C ),
+            BYTES_TO_T_UINT_8( 0x73, 0x00, 0x76, 0x66, 0x36, 0x94, 0xA7, 0x2C ),
+            BYTES_TO_T_UINT_8( 0xCE, 0x38, 0xD6, 0x20, 0xB8, 0x38, 0x7E, 0xE9 )
+        }
+    },
+    /* T[ 59 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x1A, 0x15, 0xFB, 0xC6, 0x0E, 0x0C, 0xD3, 0x77 ),
+            BYTES_TO_T_UINT_8( 0xB7, 0xB9, 0x1A, 0x97, 0x48, 0x5E, 0x9F, 0x44 ),
+            BYTES_TO_T_UINT_8( 0xE3, 0x22, 0x3D, 0xE8, 0x05, 0x84, 0x74, 0xCC ),
+            BYTES_TO_T_UINT_8( 0x75, 0xA2, 0x4C, 0xB2, 0x79, 0xB3, 0x62, 0x91 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x36, 0xFD, 0x19, 0x4B, 0x39, 0x31, 0x27, 0xD2 ),
+            BYTES_TO_T_UINT_8( 0x01, 0x2A, 0xA8, 0xBD, 0xB6, 0xC4, 0x0C, 0x07 ),
+            BYTES_TO_T_UINT_8( 0x7E, 0x7B, 0x74, 0xC9, 0x9A, 0xEB, 0x9F, 0x66 ),
+            BYTES_TO_T_UINT_8( 0xC0, 0x91, 0x9F, 0xAB, 0x67, 0x69, 0x3A, 0x72 )
+        }
+    },
+    /* T[ 60 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x53, 0xF5, 0x3C, 0xB3, 0x7D, 0xF8, 0x2C, 0xAE ),
+            BYTES_TO_T_UINT_8( 0x7C, 0xC2, 0xB4, 0xA6, 0xDA, 0xAD, 0x0C, 0xC5 ),
+            BYTES_TO_T_UINT_8( 0xEC, 0x0D, 0x5E, 0xE9, 0x87, 0xB8, 0x34, 0xC5 ),
+            BYTES_TO_T_UINT_8( 0xC7, 0xCE, 0x82, 0xBD, 0x57, 0x41, 0x07, 0xA2 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xFA, 0xB7, 0x47, 0xE2, 0x24, 0x6D, 0xC9, 0xF3 ),
+            BYTES_TO_T_UINT_8( 0x2E, 0xCB, 0x7D, 0xFD, 0x64, 0xFB, 0xF4, 0x87 ),
+            BYTES_TO_T_UINT_8( 0xC2, 0x6E, 0x28, 0x7D, 0x3E, 0x3A, 0xBA, 0x3F ),
+            BYTES_TO_T_UINT_8( 0x5B, 0x19, 0xA9, 0x91, 0xF2, 0x8D, 0x27, 0x2A )
+        }
+    },
+    /* T[ 61 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x03, 0xD4, 0x25, 0x9B, 0xA8, 0x40, 0xC3, 0x6A ),
+            BYTES_TO_T_UINT_8( 0x6E, 0xF3, 0x72, 0x04, 0xF6, 0xCE, 0x2F, 0xE4 ),
+            BYTES_TO_T_UINT_8( 0x04, 0xEA, 0xFA, 0xDC, 0xCD, 0x37, 0x06, 0xA7 ),
+            BYTES_TO_T_UINT_8( 0x1A, 0x17, 0x12, 0x79, 0x97, 0xFE, 0x07, 0xA3 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x6F, 0x39, 0xCD, 0x2F, 0x73, 0x5A, 0x97, 0xB9 ),
+            BYTES_TO_T_UINT_8( 0x79, 0x99, 0x01, 0xA9, 0x67, 0x16, 0x5E, 0x87 ),
+            BYTES_TO_T_UINT_8( 0x92, 0x6A, 0x73, 0x0E, 0x94, 0x49, 0xE8, 0x7B ),
+            BYTES_TO_T_UINT_8( 0xFA, 0x89, 0xC9, 0x86, 0x13, 0x81, 0xAC, 0xD5 )
+        }
+    },
+    /* T[ 62 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0x6F, 0x6E, 0xDE, 0xA9, 0xCC, 0xE5, 0x4A, 0xE9 ),
+            BYTES_TO_T_UINT_8( 0x2B, 0x00, 0x2C, 0xE0, 0x30, 0xC5, 0x09, 0xA8 ),
+            BYTES_TO_T_UINT_8( 0xF6, 0x0C, 0xBF, 0xD0, 0x85, 0x3A, 0x61, 0xF8 ),
+            BYTES_TO_T_UINT_8( 0x6A, 0x05, 0xB5, 0x49, 0xA0, 0xB3, 0xBB, 0x07 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0x89, 0xC2, 0xC0, 0x1C, 0xDC, 0x4B, 0x38, 0x2F ),
+            BYTES_TO_T_UINT_8( 0x94, 0x64, 0x77, 0x51, 0xAD, 0x08, 0x7E, 0xF0 ),
+            BYTES_TO_T_UINT_8( 0x51, 0x0F, 0x9C, 0x97, 0x98, 0xB5, 0x44, 0x85 ),
+            BYTES_TO_T_UINT_8( 0x76, 0x90, 0x2D, 0x12, 0x24, 0x40, 0x40, 0x20 )
+        }
+    },
+    /* T[ 63 ] */
+    {
+        {
+            BYTES_TO_T_UINT_8( 0xA3, 0xC9, 0x03, 0xF3, 0x7D, 0xF2, 0x2E, 0xD3 ),
+            BYTES_TO_T_UINT_8( 0x61, 0x4E, 0x52, 0xD7, 0x3D, 0xC2, 0x11, 0x7A ),
+            BYTES_TO_T_UINT_8( 0x48, 0x98, 0x1E, 0x6C, 0xC2, 0xCE, 0x02, 0x5E ),
+            BYTES_TO_T_UINT_8( 0xB4, 0x3F, 0x45, 0x60, 0x1F, 0x29, 0x32, 0xD0 )
+        },
+        {
+            BYTES_TO_T_UINT_8( 0xD9, 0x66, 0x62, 0x8B, 0x55, 0xDE, 0xE2, 0x1B ),
+            BYTES_TO_T_UINT_8( 0x0E, 0xCF, 0x2B, 0x5D, 0x23, 0xE4, 0xFB, 0x36 ),
+            BYTES_TO_T_UINT_8( 0xD4, 0x76, 0x99, 0xA7, 0x29, 0x0F, 0x82, 0xF6 ),
+            BYTES_TO_T_UINT_8( 0x08, 0x08, 0xE3, 0xF6, 0x9E, 0x11, 0xDA, 0x9E )
+        }
+    }
+};
+
+/**
+ * @brief The table handed to ecp_mul_comb().
+ */
+static const mbedtls_ecp_point xP256CombTable[ eccCOMB_POINTS ] =
+{
+    eccCOMB_POINT( 0 ),
+    eccCOMB_POINT( 1 ),
+    eccCOMB_POINT( 2 ),
+    eccCOMB_POINT( 3 ),
+    eccCOMB_POINT( 4 ),
+    eccCOMB_POINT( 5 ),
+    eccCOMB_POINT( 6 ),
+    eccCOMB_POINT( 7 ),
+    eccCOMB_POINT( 8 ),
+    eccCOMB_POINT( 9 ),
+    eccCOMB_POINT( 10 ),
+    eccCOMB_POINT( 11 ),
+    eccCOMB_POINT( 12 ),
+    eccCOMB_POINT( 13 ),
+    eccCOMB_POINT( 14 ),
+    eccCOMB_POINT( 15 ),
+    eccCOMB_POINT( 16 ),
+    eccCOMB_POINT( 17 ),
+    eccCOMB_POINT( 18 ),
+    eccCOMB_POINT( 19 ),
+    eccCOMB_POINT( 20 ),
+    eccCOMB_POINT( 21 ),
+    eccCOMB_POINT( 22 ),
+    eccCOMB_POINT( 23 ),
+    eccCOMB_POINT( 24 ),
+    eccCOMB_POINT( 25 ),
+    eccCOMB_POINT( 26 ),
+    eccCOMB_POINT( 27 ),
+    eccCOMB_POINT( 28 ),
+    eccCOMB_POINT( 29 ),
+    eccCOMB_POINT( 30 ),
+    eccCOMB_POINT( 31 ),
+    eccCOMB_POINT( 32 ),
+    eccCOMB_POINT( 33 ),
+    eccCOMB_POINT( 34 ),
+    eccCOMB_POINT( 35 ),
+    eccCOMB_POINT( 36 ),
+    eccCOMB_POINT( 37 ),
+    eccCOMB_POINT( 38 ),
+    eccCOMB_POINT( 39 ),
+    eccCOMB_POINT( 40 ),
+    eccCOMB_POINT( 41 ),
+    eccCOMB_POINT( 42 ),
+    eccCOMB_POINT( 43 ),
+    eccCOMB_POINT( 44 ),
+    eccCOMB_POINT( 45 ),
+    eccCOMB_POINT( 46 ),
+    eccCOMB_POINT( 47 ),
+    eccCOMB_POINT( 48 ),
+    eccCOMB_POINT( 49 ),
+    eccCOMB_POINT( 50 ),
+    eccCOMB_POINT( 51 ),
+    eccCOMB_POINT( 52 ),
+    eccCOMB_POINT( 53 ),
+    eccCOMB_POINT( 54 ),
+    eccCOMB_POINT( 55 ),
+    eccCOMB_POINT( 56 ),
+    eccCOMB_POINT( 57 ),
+    eccCOMB_POINT( 58 ),
+    eccCOMB_POINT( 59 ),
+    eccCOMB_POINT( 60 ),
+    eccCOMB_POINT( 61 ),
+    eccCOMB_POINT( 62 ),
+    eccCOMB_POINT( 63 )
+};
+/*-----------------------------------------------------------*/
+
+int mbedtls_ecp_fixed_base_table( const mbedtls_ecp_group * grp,
+                                  const mbedtls_ecp_point ** T,
+                                  unsigned char * w )
+{
+    int ret = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+
+    /* The table only fits the generator of P-256.  The group id is enough
+     * to tell, because groups are only ever loaded from their id. */
+    if( grp->id == MBEDTLS_ECP_DP_SECP256R1 )
+    {
+        *T = xP256CombTable;
+        *w = eccCOMB_WIDTH;
+        ret = 0;
+    }
+
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* if defined( MBEDTLS_ECP_FIXED_BASE_TABLE ) && defined( MBEDTLS_ECP_DP_SECP256R1_ENABLED ) */
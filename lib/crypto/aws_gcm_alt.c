@@ -0,0 +1,582 @@
+/*
+ * Amazon FreeRTOS Crypto V1.0.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_gcm_alt.c
+ * @brief GCM for mbedTLS, built with MBEDTLS_GCM_ALT.
+ *
+ * The counter blocks are encrypted through the cipher layer, so they reach
+ * the crypto accelerator through aws_aes_alt.c.  GHASH goes to the
+ * accelerator if it implements it, see aws_crypto_accelerator.h, and to the
+ * software kernel below otherwise.
+ *
+ * The kernel is Shoup's method with 4-bit tables, as in the stock gcm.c,
+ * but with the field elements held in four 32-bit words instead of two
+ * 64-bit ones, which a Cortex-M has to emulate with pairs of registers.
+ * Each call to mbedtls_gcm_update() hashes all its data in one pass.
+ */
+
+/* mbedTLS includes. */
+#include "mbedtls/config.h"
+
+#if defined( MBEDTLS_GCM_C ) && defined( MBEDTLS_GCM_ALT )
+
+#include "mbedtls/gcm.h"
+#include "mbedtls/platform_util.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "aws_crypto_accelerator.h"
+
+/* C runtime includes. */
+#include <string.h>
+
+/**
+ * @brief Reads a big endian 32-bit word from a byte array.
+ */
+#define gcmGET_UINT32_BE( pucBytes )                 \
+    ( ( ( uint32_t ) ( pucBytes )[ 0 ] << 24 ) |     \
+      ( ( uint32_t ) ( pucBytes )[ 1 ] << 16 ) |     \
+      ( ( uint32_t ) ( pucBytes )[ 2 ] << 8 ) |      \
+      ( ( uint32_t ) ( pucBytes )[ 3 ] ) )
+
+/**
+ * @brief Writes a 32-bit word to a byte array, big endian.
+ */
+#define gcmPUT_UINT32_BE( ulWord, pucBytes )                        \
+    {                                                               \
+        ( pucBytes )[ 0 ] = ( unsigned char ) ( ( ulWord ) >> 24 ); \
+        ( pucBytes )[ 1 ] = ( unsigned char ) ( ( ulWord ) >> 16 ); \
+        ( pucBytes )[ 2 ] = ( unsigned char ) ( ( ulWord ) >> 8 );  \
+        ( pucBytes )[ 3 ] = ( unsigned char ) ( ulWord );           \
+    }
+
+/**
+ * @brief Shifts Z right by four bits and reduces it modulo the GCM
+ * polynomial.
+ */
+#define gcmSHIFT_RIGHT_4( ulZ0, ulZ1, ulZ2, ulZ3 )                      \
+    {                                                                   \
+        ulRem = ( ulZ3 ) & 0x0FUL;                                      \
+        ( ulZ3 ) = ( ( ulZ3 ) >> 4 ) | ( ( ulZ2 ) << 28 );              \
+        ( ulZ2 ) = ( ( ulZ2 ) >> 4 ) | ( ( ulZ1 ) << 28 );              \
+        ( ulZ1 ) = ( ( ulZ1 ) >> 4 ) | ( ( ulZ0 ) << 28 );              \
+        ( ulZ0 ) = ( ( ulZ0 ) >> 4 ) ^ ( ( uint32_t ) usLast4[ ulRem ] << 16 ); \
+    }
+
+/**
+ * @brief Adds the multiple of H selected by a nibble to Z.
+ */
+#define gcmADD_MULTIPLE( ulZ0, ulZ1, ulZ2, ulZ3, ulNibble )    \
+    {                                                          \
+        pulMultiple = ctx->HT[ ulNibble ];                     \
+        ( ulZ0 ) ^= pulMultiple[ 0 ];                          \
+        ( ulZ1 ) ^= pulMultiple[ 1 ];                          \
+        ( ulZ2 ) ^= pulMultiple[ 2 ];                          \
+        ( ulZ3 ) ^= pulMultiple[ 3 ];                          \
+    }
+/*-----------------------------------------------------------*/
+
+/*
+ * Shoup's method uses this table with last4[ x ] = x times P^128, where x
+ * and last4[ x ] are seen as elements of GF(2^128).
+ */
+static const uint16_t usLast4[ 16 ] =
+{
+    0x0000, 0x1c20, 0x3840, 0x2460,
+    0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560,
+    0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Computes H and the table of its multiples for the software kernel.
+ */
+static int prvGenerateTable( mbedtls_gcm_context * ctx );
+
+/**
+ * @brief Multiplies X, held as four big endian words, by H.
+ */
+static void prvMultiply( const mbedtls_gcm_context * ctx,
+                         uint32_t * pulX );
+
+/**
+ * @brief Folds data into a GHASH state.
+ *
+ * A partial last block is padded with zeroes.
+ *
+ * @param[in] ctx The GCM context.
+ * @param[in,out] pucState The 16 byte GHASH state.
+ * @param[in] pucData The data.
+ * @param[in] xLength The length of pucData.
+ *
+ * @return 0, or the error of the accelerator.
+ */
+static int prvGhash( const mbedtls_gcm_context * ctx,
+                     unsigned char * pucState,
+                     const unsigned char * pucData,
+                     size_t xLength );
+/*-----------------------------------------------------------*/
+
+static int prvGenerateTable( mbedtls_gcm_context * ctx )
+{
+    int iResult;
+    size_t xLength = 0;
+    uint32_t ulV0, ulV1, ulV2, ulV3, ulReduce;
+    uint32_t i, j;
+
+    /* H = E( K, 0^128 ). */
+    memset( ctx->H, 0, sizeof( ctx->H ) );
+    iResult = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->H, 16, ctx->H, &xLength );
+
+    if( iResult == 0 )
+    {
+        ulV0 = gcmGET_UINT32_BE( ctx->H );
+        ulV1 = gcmGET_UINT32_BE( ctx->H + 4 );
+        ulV2 = gcmGET_UINT32_BE( ctx->H + 8 );
+        ulV3 = gcmGET_UINT32_BE( ctx->H + 12 );
+
+        /* The bits of GCM are reflected, so 8 stands for H itself and 4, 2
+         * and 1 for H times x, x^2 and x^3. */
+        memset( ctx->HT[ 0 ], 0, sizeof( ctx->HT[ 0 ] ) );
+        ctx->HT[ 8 ][ 0 ] = ulV0;
+        ctx->HT[ 8 ][ 1 ] = ulV1;
+        ctx->HT[ 8 ][ 2 ] = ulV2;
+        ctx->HT[ 8 ][ 3 ] = ulV3;
+
+        for( i = 4; i > 0U; i >>= 1 )
+        {
+            ulReduce = ( ulV3 & 1UL ) * 0xE1000000UL;
+            ulV3 = ( ulV3 >> 1 ) | ( ulV2 << 31 );
+            ulV2 = ( ulV2 >> 1 ) | ( ulV1 << 31 );
+            ulV1 = ( ulV1 >> 1 ) | ( ulV0 << 31 );
+            ulV0 = ( ulV0 >> 1 ) ^ ulReduce;
+
+            ctx->HT[ i ][ 0 ] = ulV0;
+            ctx->HT[ i ][ 1 ] = ulV1;
+            ctx->HT[ i ][ 2 ] = ulV2;
+            ctx->HT[ i ][ 3 ] = ulV3;
+        }
+
+        /* The other multiples are sums of those. */
+        for( i = 2; i <= 8U; i *= 2U )
+        {
+            for( j = 1; j < i; j++ )
+            {
+                ctx->HT[ i + j ][ 0 ] = ctx->HT[ i ][ 0 ] ^ ctx->HT[ j ][ 0 ];
+                ctx->HT[ i + j ][ 1 ] = ctx->HT[ i ][ 1 ] ^ ctx->HT[ j ][ 1 ];
+                ctx->HT[ i + j ][ 2 ] = ctx->HT[ i ][ 2 ] ^ ctx->HT[ j ][ 2 ];
+                ctx->HT[ i + j ][ 3 ] = ctx->HT[ i ][ 3 ] ^ ctx->HT[ j ][ 3 ];
+            }
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+static void prvMultiply( const mbedtls_gcm_context * ctx,
+                         uint32_t * pulX )
+{
+    const uint32_t * pulMultiple;
+    uint32_t ulZ0 = 0, ulZ1 = 0, ulZ2 = 0, ulZ3 = 0;
+    uint32_t ulRem, ulWord, ulNibble;
+    int32_t i, j;
+
+    /* Walk the nibbles of X from the last one, multiplying Z by x^4 between
+     * them, as in the stock gcm.c.  Shifting the initial zero is harmless,
+     * so the first nibble needs no special case. */
+    for( i = 3; i >= 0; i-- )
+    {
+        ulWord = pulX[ i ];
+
+        for( j = 0; j < 8; j++ )
+        {
+            ulNibble = ulWord & 0x0FUL;
+            ulWord >>= 4;
+
+            gcmSHIFT_RIGHT_4( ulZ0, ulZ1, ulZ2, ulZ3 );
+            gcmADD_MULTIPLE( ulZ0, ulZ1, ulZ2, ulZ3, ulNibble );
+        }
+    }
+
+    pulX[ 0 ] = ulZ0;
+    pulX[ 1 ] = ulZ1;
+    pulX[ 2 ] = ulZ2;
+    pulX[ 3 ] = ulZ3;
+}
+/*-----------------------------------------------------------*/
+
+static int prvGhash( const mbedtls_gcm_context * ctx,
+                     unsigned char * pucState,
+                     const unsigned char * pucData,
+                     size_t xLength )
+{
+    int iResult = 0;
+    const CryptoAccelerator_t * pxAccelerator = CRYPTO_GetAccelerator();
+    size_t xWhole = xLength & ~( ( size_t ) 15U );
+    unsigned char ucLast[ 16 ];
+    uint32_t ulX[ 4 ];
+    size_t i;
+
+    if( ( pxAccelerator != NULL ) && ( pxAccelerator->xGhashUpdate != NULL ) )
+    {
+        if( xWhole > 0U )
+        {
+            iResult = pxAccelerator->xGhashUpdate( ctx->H, pucState, pucData, xWhole );
+        }
+
+        if( ( iResult == 0 ) && ( xLength > xWhole ) )
+        {
+            memset( ucLast, 0, sizeof( ucLast ) );
+            memcpy( ucLast, pucData + xWhole, xLength - xWhole );
+            iResult = pxAccelerator->xGhashUpdate( ctx->H, pucState, ucLast, 16 );
+        }
+    }
+    else
+    {
+        ulX[ 0 ] = gcmGET_UINT32_BE( pucState );
+        ulX[ 1 ] = gcmGET_UINT32_BE( pucState + 4 );
+        ulX[ 2 ] = gcmGET_UINT32_BE( pucState + 8 );
+        ulX[ 3 ] = gcmGET_UINT32_BE( pucState + 12 );
+
+        for( i = 0; i < xWhole; i += 16U )
+        {
+            ulX[ 0 ] ^= gcmGET_UINT32_BE( pucData + i );
+            ulX[ 1 ] ^= gcmGET_UINT32_BE( pucData + i + 4 );
+            ulX[ 2 ] ^= gcmGET_UINT32_BE( pucData + i + 8 );
+            ulX[ 3 ] ^= gcmGET_UINT32_BE( pucData + i + 12 );
+            prvMultiply( ctx, ulX );
+        }
+
+        if( xLength > xWhole )
+        {
+            memset( ucLast, 0, sizeof( ucLast ) );
+            memcpy( ucLast, pucData + xWhole, xLength - xWhole );
+
+            ulX[ 0 ] ^= gcmGET_UINT32_BE( ucLast );
+            ulX[ 1 ] ^= gcmGET_UINT32_BE( ucLast + 4 );
+            ulX[ 2 ] ^= gcmGET_UINT32_BE( ucLast + 8 );
+            ulX[ 3 ] ^= gcmGET_UINT32_BE( ucLast + 12 );
+            prvMultiply( ctx, ulX );
+        }
+
+        gcmPUT_UINT32_BE( ulX[ 0 ], pucState );
+        gcmPUT_UINT32_BE( ulX[ 1 ], pucState + 4 );
+        gcmPUT_UINT32_BE( ulX[ 2 ], pucState + 8 );
+        gcmPUT_UINT32_BE( ulX[ 3 ], pucState + 12 );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_gcm_init( mbedtls_gcm_context * ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_gcm_context ) );
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_setkey( mbedtls_gcm_context * ctx,
+                        mbedtls_cipher_id_t cipher,
+                        const unsigned char * key,
+                        unsigned int keybits )
+{
+    int iResult = 0;
+    const mbedtls_cipher_info_t * pxCipherInfo;
+
+    pxCipherInfo = mbedtls_cipher_info_from_values( cipher, ( int ) keybits, MBEDTLS_MODE_ECB );
+
+    if( ( pxCipherInfo == NULL ) || ( pxCipherInfo->block_size != 16U ) )
+    {
+        iResult = MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    if( iResult == 0 )
+    {
+        mbedtls_cipher_free( &ctx->cipher_ctx );
+        iResult = mbedtls_cipher_setup( &ctx->cipher_ctx, pxCipherInfo );
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_cipher_setkey( &ctx->cipher_ctx, key, ( int ) keybits, MBEDTLS_ENCRYPT );
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = prvGenerateTable( ctx );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_starts( mbedtls_gcm_context * ctx,
+                        int mode,
+                        const unsigned char * iv,
+                        size_t iv_len,
+                        const unsigned char * add,
+                        size_t add_len )
+{
+    int iResult = 0;
+    unsigned char ucLengths[ 16 ];
+    size_t xLength = 0;
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes, and the IV may not
+     * be empty. */
+    if( ( iv_len == 0U ) ||
+        ( ( ( uint64_t ) iv_len >> 61 ) != 0U ) ||
+        ( ( ( uint64_t ) add_len >> 61 ) != 0U ) )
+    {
+        iResult = MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    if( iResult == 0 )
+    {
+        memset( ctx->y, 0, sizeof( ctx->y ) );
+        memset( ctx->buf, 0, sizeof( ctx->buf ) );
+
+        ctx->mode = mode;
+        ctx->len = 0;
+        ctx->add_len = add_len;
+
+        if( iv_len == 12U )
+        {
+            memcpy( ctx->y, iv, iv_len );
+            ctx->y[ 15 ] = 1;
+        }
+        else
+        {
+            /* Y0 = GHASH( IV || 0-padding || [len(IV)]64 ). */
+            memset( ucLengths, 0, sizeof( ucLengths ) );
+            gcmPUT_UINT32_BE( ( uint32_t ) ( iv_len * 8U ), ucLengths + 12 );
+
+            iResult = prvGhash( ctx, ctx->y, iv, iv_len );
+
+            if( iResult == 0 )
+            {
+                iResult = prvGhash( ctx, ctx->y, ucLengths, sizeof( ucLengths ) );
+            }
+        }
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ctx->base_ectr, &xLength );
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = prvGhash( ctx, ctx->buf, add, add_len );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_update( mbedtls_gcm_context * ctx,
+                        size_t length,
+                        const unsigned char * input,
+                        unsigned char * output )
+{
+    int iResult = 0;
+    unsigned char ucKeyStream[ 16 ];
+    size_t xLength = 0;
+    size_t xOffset, xUse, i;
+
+    if( ( output > input ) && ( ( size_t ) ( output - input ) < length ) )
+    {
+        iResult = MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes.
+     * Also check for possible overflow. */
+    else if( ( ( ctx->len + length ) < ctx->len ) ||
+             ( ( ( uint64_t ) ctx->len + length ) > 0xFFFFFFFE0ULL ) )
+    {
+        iResult = MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+    else
+    {
+        ctx->len += length;
+    }
+
+    /* The ciphertext is hashed, which is the input when decrypting.  Hash it
+     * before the output can overwrite it. */
+    if( ( iResult == 0 ) && ( ctx->mode == MBEDTLS_GCM_DECRYPT ) )
+    {
+        iResult = prvGhash( ctx, ctx->buf, input, length );
+    }
+
+    for( xOffset = 0; ( iResult == 0 ) && ( xOffset < length ); xOffset += xUse )
+    {
+        xUse = ( ( length - xOffset ) < 16U ) ? ( length - xOffset ) : 16U;
+
+        /* Only the low 32 bits of the counter block are incremented. */
+        for( i = 16; i > 12U; i-- )
+        {
+            if( ++ctx->y[ i - 1U ] != 0U )
+            {
+                break;
+            }
+        }
+
+        iResult = mbedtls_cipher_update( &ctx->cipher_ctx, ctx->y, 16, ucKeyStream, &xLength );
+
+        for( i = 0; ( iResult == 0 ) && ( i < xUse ); i++ )
+        {
+            output[ xOffset + i ] = input[ xOffset + i ] ^ ucKeyStream[ i ];
+        }
+    }
+
+    if( ( iResult == 0 ) && ( ctx->mode == MBEDTLS_GCM_ENCRYPT ) )
+    {
+        iResult = prvGhash( ctx, ctx->buf, output, length );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_finish( mbedtls_gcm_context * ctx,
+                        unsigned char * tag,
+                        size_t tag_len )
+{
+    int iResult = 0;
+    unsigned char ucLengths[ 16 ];
+    uint64_t ullBits = ctx->len * 8U;
+    uint64_t ullAddBits = ctx->add_len * 8U;
+    size_t i;
+
+    if( ( tag_len > 16U ) || ( tag_len < 4U ) )
+    {
+        iResult = MBEDTLS_ERR_GCM_BAD_INPUT;
+    }
+    else
+    {
+        memcpy( tag, ctx->base_ectr, tag_len );
+
+        if( ( ullBits != 0U ) || ( ullAddBits != 0U ) )
+        {
+            gcmPUT_UINT32_BE( ( uint32_t ) ( ullAddBits >> 32 ), ucLengths );
+            gcmPUT_UINT32_BE( ( uint32_t ) ullAddBits, ucLengths + 4 );
+            gcmPUT_UINT32_BE( ( uint32_t ) ( ullBits >> 32 ), ucLengths + 8 );
+            gcmPUT_UINT32_BE( ( uint32_t ) ullBits, ucLengths + 12 );
+
+            iResult = prvGhash( ctx, ctx->buf, ucLengths, sizeof( ucLengths ) );
+
+            for( i = 0; ( iResult == 0 ) && ( i < tag_len ); i++ )
+            {
+                tag[ i ] ^= ctx->buf[ i ];
+            }
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_crypt_and_tag( mbedtls_gcm_context * ctx,
+                               int mode,
+                               size_t length,
+                               const unsigned char * iv,
+                               size_t iv_len,
+                               const unsigned char * add,
+                               size_t add_len,
+                               const unsigned char * input,
+                               unsigned char * output,
+                               size_t tag_len,
+                               unsigned char * tag )
+{
+    int iResult;
+
+    iResult = mbedtls_gcm_starts( ctx, mode, iv, iv_len, add, add_len );
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_gcm_update( ctx, length, input, output );
+    }
+
+    if( iResult == 0 )
+    {
+        iResult = mbedtls_gcm_finish( ctx, tag, tag_len );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_gcm_auth_decrypt( mbedtls_gcm_context * ctx,
+                              size_t length,
+                              const unsigned char * iv,
+                              size_t iv_len,
+                              const unsigned char * add,
+                              size_t add_len,
+                              const unsigned char * tag,
+                              size_t tag_len,
+                              const unsigned char * input,
+                              unsigned char * output )
+{
+    int iResult;
+    unsigned char ucCheckTag[ 16 ];
+    unsigned char ucDiff = 0;
+    size_t i;
+
+    iResult = mbedtls_gcm_crypt_and_tag( ctx, MBEDTLS_GCM_DECRYPT, length,
+                                         iv, iv_len, add, add_len,
+                                         input, output, tag_len, ucCheckTag );
+
+    if( iResult == 0 )
+    {
+        /* Compare the tags in constant time. */
+        for( i = 0; i < tag_len; i++ )
+        {
+            ucDiff |= tag[ i ] ^ ucCheckTag[ i ];
+        }
+
+        if( ucDiff != 0U )
+        {
+            mbedtls_platform_zeroize( output, length );
+            iResult = MBEDTLS_ERR_GCM_AUTH_FAILED;
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_gcm_free( mbedtls_gcm_context * ctx )
+{
+    if( ctx != NULL )
+    {
+        mbedtls_cipher_free( &ctx->cipher_ctx );
+        mbedtls_platform_zeroize( ctx, sizeof( mbedtls_gcm_context ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+#endif /* if defined( MBEDTLS_GCM_C ) && defined( MBEDTLS_GCM_ALT ) */
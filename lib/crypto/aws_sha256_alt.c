@@ -0,0 +1,418 @@
+/*
+ * Amazon FreeRTOS Crypto V1.0.4
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_sha256_alt.c
+ * @brief SHA-256 for mbedTLS, built with MBEDTLS_SHA256_ALT.
+ *
+ * Whole blocks go to the registered crypto accelerator if it implements
+ * SHA-256, see aws_crypto_accelerator.h, and to the software kernel below
+ * otherwise.  The kernel unrolls all 64 rounds, so the round constants are
+ * immediates, and keeps the message schedule in a 16 word ring rather than
+ * the 64 words of the stock sha256.c.  Runs of whole blocks are hashed in
+ * one call, keeping the state in registers between blocks.
+ */
+
+/* mbedTLS includes. */
+#include "mbedtls/config.h"
+
+#if defined( MBEDTLS_SHA256_C ) && defined( MBEDTLS_SHA256_ALT )
+
+#include "mbedtls/sha256.h"
+#include "mbedtls/platform_util.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "aws_crypto_accelerator.h"
+
+/* C runtime includes. */
+#include <string.h>
+
+/**
+ * @brief Reads a big endian 32-bit word from a byte array.
+ */
+#define shaGET_UINT32_BE( pucBytes )                 \
+    ( ( ( uint32_t ) ( pucBytes )[ 0 ] << 24 ) |     \
+      ( ( uint32_t ) ( pucBytes )[ 1 ] << 16 ) |     \
+      ( ( uint32_t ) ( pucBytes )[ 2 ] << 8 ) |      \
+      ( ( uint32_t ) ( pucBytes )[ 3 ] ) )
+
+/**
+ * @brief Writes a 32-bit word to a byte array, big endian.
+ */
+#define shaPUT_UINT32_BE( ulWord, pucBytes )                        \
+    {                                                               \
+        ( pucBytes )[ 0 ] = ( unsigned char ) ( ( ulWord ) >> 24 ); \
+        ( pucBytes )[ 1 ] = ( unsigned char ) ( ( ulWord ) >> 16 ); \
+        ( pucBytes )[ 2 ] = ( unsigned char ) ( ( ulWord ) >> 8 );  \
+        ( pucBytes )[ 3 ] = ( unsigned char ) ( ulWord );           \
+    }
+
+/*
+ * The functions of FIPS 180-4 section 4.1.2.
+ */
+#define shaROTR( ulWord, ulBits )    ( ( ( ulWord ) >> ( ulBits ) ) | ( ( ulWord ) << ( 32 - ( ulBits ) ) ) )
+#define shaCH( ulX, ulY, ulZ )       ( ( ulZ ) ^ ( ( ulX ) & ( ( ulY ) ^ ( ulZ ) ) ) )
+#define shaMAJ( ulX, ulY, ulZ )      ( ( ( ulX ) & ( ulY ) ) | ( ( ulZ ) & ( ( ulX ) | ( ulY ) ) ) )
+#define shaSIGMA0( ulX )             ( shaROTR( ulX, 2 ) ^ shaROTR( ulX, 13 ) ^ shaROTR( ulX, 22 ) )
+#define shaSIGMA1( ulX )             ( shaROTR( ulX, 6 ) ^ shaROTR( ulX, 11 ) ^ shaROTR( ulX, 25 ) )
+#define shaSMALL_SIGMA0( ulX )       ( shaROTR( ulX, 7 ) ^ shaROTR( ulX, 18 ) ^ ( ( ulX ) >> 3 ) )
+#define shaSMALL_SIGMA1( ulX )       ( shaROTR( ulX, 17 ) ^ shaROTR( ulX, 19 ) ^ ( ( ulX ) >> 10 ) )
+
+/**
+ * @brief Round i, for i below 16, with the roles of the eight working
+ * variables rotated by i.
+ */
+#define shaROUND( A, B, C, D, E, F, G, H, i, ulK )                                 \
+    {                                                                              \
+        ulT1 = H + shaSIGMA1( E ) + shaCH( E, F, G ) + ( ulK ) + ulW[ ( i ) & 15 ]; \
+        D += ulT1;                                                                 \
+        H = ulT1 + shaSIGMA0( A ) + shaMAJ( A, B, C );                             \
+    }
+
+/**
+ * @brief Round i, for i from 16, which first extends the message schedule.
+ *
+ * ulW[ i & 15 ] still holds W[ i - 16 ] when it is overwritten with W[ i ].
+ */
+#define shaROUND_EXPAND( A, B, C, D, E, F, G, H, i, ulK )             \
+    {                                                                 \
+        ulW[ ( i ) & 15 ] += shaSMALL_SIGMA1( ulW[ ( ( i ) - 2 ) & 15 ] ) + \
+                             ulW[ ( ( i ) - 7 ) & 15 ] +                \
+                             shaSMALL_SIGMA0( ulW[ ( ( i ) - 15 ) & 15 ] ); \
+        shaROUND( A, B, C, D, E, F, G, H, i, ulK );                   \
+    }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Hashes whole blocks with the software kernel.
+ */
+static void prvProcessBlocks( uint32_t * pulState,
+                              const unsigned char * pucData,
+                              size_t xBlocks );
+
+/**
+ * @brief Hashes whole blocks with the accelerator, if it implements SHA-256,
+ * or with the software kernel.
+ */
+static int prvProcess( mbedtls_sha256_context * ctx,
+                       const unsigned char * pucData,
+                       size_t xBlocks );
+/*-----------------------------------------------------------*/
+
+static void prvProcessBlocks( uint32_t * pulState,
+                              const unsigned char * pucData,
+                              size_t xBlocks )
+{
+    uint32_t ulW[ 16 ];
+    uint32_t ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulT1;
+    uint32_t i;
+
+    ulA = pulState[ 0 ];
+    ulB = pulState[ 1 ];
+    ulC = pulState[ 2 ];
+    ulD = pulState[ 3 ];
+    ulE = pulState[ 4 ];
+    ulF = pulState[ 5 ];
+    ulG = pulState[ 6 ];
+    ulH = pulState[ 7 ];
+
+    while( xBlocks > 0U )
+    {
+        for( i = 0; i < 16U; i++ )
+        {
+            ulW[ i ] = shaGET_UINT32_BE( pucData + ( 4U * i ) );
+        }
+
+        shaROUND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH,  0, 0x428A2F98UL );
+        shaROUND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG,  1, 0x71374491UL );
+        shaROUND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF,  2, 0xB5C0FBCFUL );
+        shaROUND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE,  3, 0xE9B5DBA5UL );
+        shaROUND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD,  4, 0x3956C25BUL );
+        shaROUND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC,  5, 0x59F111F1UL );
+        shaROUND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB,  6, 0x923F82A4UL );
+        shaROUND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA,  7, 0xAB1C5ED5UL );
+
+        shaROUND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH,  8, 0xD807AA98UL );
+        shaROUND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG,  9, 0x12835B01UL );
+        shaROUND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 10, 0x243185BEUL );
+        shaROUND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 11, 0x550C7DC3UL );
+        shaROUND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 12, 0x72BE5D74UL );
+        shaROUND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 13, 0x80DEB1FEUL );
+        shaROUND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 14, 0x9BDC06A7UL );
+        shaROUND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 15, 0xC19BF174UL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 16, 0xE49B69C1UL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 17, 0xEFBE4786UL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 18, 0x0FC19DC6UL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 19, 0x240CA1CCUL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 20, 0x2DE92C6FUL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 21, 0x4A7484AAUL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 22, 0x5CB0A9DCUL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 23, 0x76F988DAUL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 24, 0x983E5152UL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 25, 0xA831C66DUL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 26, 0xB00327C8UL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 27, 0xBF597FC7UL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 28, 0xC6E00BF3UL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 29, 0xD5A79147UL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 30, 0x06CA6351UL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 31, 0x14292967UL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 32, 0x27B70A85UL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 33, 0x2E1B2138UL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 34, 0x4D2C6DFCUL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 35, 0x53380D13UL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 36, 0x650A7354UL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 37, 0x766A0ABBUL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 38, 0x81C2C92EUL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 39, 0x92722C85UL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 40, 0xA2BFE8A1UL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 41, 0xA81A664BUL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 42, 0xC24B8B70UL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 43, 0xC76C51A3UL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 44, 0xD192E819UL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 45, 0xD6990624UL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 46, 0xF40E3585UL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 47, 0x106AA070UL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 48, 0x19A4C116UL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 49, 0x1E376C08UL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 50, 0x2748774CUL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 51, 0x34B0BCB5UL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 52, 0x391C0CB3UL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 53, 0x4ED8AA4AUL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 54, 0x5B9CCA4FUL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 55, 0x682E6FF3UL );
+
+        shaROUND_EXPAND( ulA, ulB, ulC, ulD, ulE, ulF, ulG, ulH, 56, 0x748F82EEUL );
+        shaROUND_EXPAND( ulH, ulA, ulB, ulC, ulD, ulE, ulF, ulG, 57, 0x78A5636FUL );
+        shaROUND_EXPAND( ulG, ulH, ulA, ulB, ulC, ulD, ulE, ulF, 58, 0x84C87814UL );
+        shaROUND_EXPAND( ulF, ulG, ulH, ulA, ulB, ulC, ulD, ulE, 59, 0x8CC70208UL );
+        shaROUND_EXPAND( ulE, ulF, ulG, ulH, ulA, ulB, ulC, ulD, 60, 0x90BEFFFAUL );
+        shaROUND_EXPAND( ulD, ulE, ulF, ulG, ulH, ulA, ulB, ulC, 61, 0xA4506CEBUL );
+        shaROUND_EXPAND( ulC, ulD, ulE, ulF, ulG, ulH, ulA, ulB, 62, 0xBEF9A3F7UL );
+        shaROUND_EXPAND( ulB, ulC, ulD, ulE, ulF, ulG, ulH, ulA, 63, 0xC67178F2UL );
+
+        ulA += pulState[ 0 ];
+        ulB += pulState[ 1 ];
+        ulC += pulState[ 2 ];
+        ulD += pulState[ 3 ];
+        ulE += pulState[ 4 ];
+        ulF += pulState[ 5 ];
+        ulG += pulState[ 6 ];
+        ulH += pulState[ 7 ];
+
+        pulState[ 0 ] = ulA;
+        pulState[ 1 ] = ulB;
+        pulState[ 2 ] = ulC;
+        pulState[ 3 ] = ulD;
+        pulState[ 4 ] = ulE;
+        pulState[ 5 ] = ulF;
+        pulState[ 6 ] = ulG;
+        pulState[ 7 ] = ulH;
+
+        pucData += 64;
+        xBlocks--;
+    }
+
+    mbedtls_platform_zeroize( ulW, sizeof( ulW ) );
+}
+/*-----------------------------------------------------------*/
+
+static int prvProcess( mbedtls_sha256_context * ctx,
+                       const unsigned char * pucData,
+                       size_t xBlocks )
+{
+    int iResult = 0;
+    const CryptoAccelerator_t * pxAccelerator = CRYPTO_GetAccelerator();
+
+    if( ( pxAccelerator != NULL ) && ( pxAccelerator->xSha256Process != NULL ) )
+    {
+        iResult = pxAccelerator->xSha256Process( ctx->state, pucData, xBlocks );
+    }
+    else
+    {
+        prvProcessBlocks( ctx->state, pucData, xBlocks );
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_sha256_init( mbedtls_sha256_context * ctx )
+{
+    memset( ctx, 0, sizeof( mbedtls_sha256_context ) );
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_sha256_free( mbedtls_sha256_context * ctx )
+{
+    if( ctx != NULL )
+    {
+        mbedtls_platform_zeroize( ctx, sizeof( mbedtls_sha256_context ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void mbedtls_sha256_clone( mbedtls_sha256_context * dst,
+                           const mbedtls_sha256_context * src )
+{
+    *dst = *src;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_sha256_starts_ret( mbedtls_sha256_context * ctx,
+                               int is224 )
+{
+    static const uint32_t ulInitialSha256[ 8 ] =
+    {
+        0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+        0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+    };
+    static const uint32_t ulInitialSha224[ 8 ] =
+    {
+        0xC1059ED8UL, 0x367CD507UL, 0x3070DD17UL, 0xF70E5939UL,
+        0xFFC00B31UL, 0x68581511UL, 0x64F98FA7UL, 0xBEFA4FA4UL
+    };
+
+    ctx->total[ 0 ] = 0;
+    ctx->total[ 1 ] = 0;
+    ctx->is224 = is224;
+    memcpy( ctx->state,
+            ( is224 == 0 ) ? ulInitialSha256 : ulInitialSha224,
+            sizeof( ctx->state ) );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_internal_sha256_process( mbedtls_sha256_context * ctx,
+                                     const unsigned char data[ 64 ] )
+{
+    return prvProcess( ctx, data, 1 );
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_sha256_update_ret( mbedtls_sha256_context * ctx,
+                               const unsigned char * input,
+                               size_t ilen )
+{
+    int iResult = 0;
+    size_t xFill;
+    size_t xBlocks;
+    uint32_t ulLeft;
+
+    if( ilen > 0U )
+    {
+        ulLeft = ctx->total[ 0 ] & 0x3FUL;
+        xFill = 64U - ulLeft;
+
+        ctx->total[ 0 ] += ( uint32_t ) ilen;
+
+        if( ctx->total[ 0 ] < ( uint32_t ) ilen )
+        {
+            ctx->total[ 1 ]++;
+        }
+
+        /* Complete a block left over from the previous call first. */
+        if( ( ulLeft != 0U ) && ( ilen >= xFill ) )
+        {
+            memcpy( ctx->buffer + ulLeft, input, xFill );
+            iResult = prvProcess( ctx, ctx->buffer, 1 );
+
+            input += xFill;
+            ilen -= xFill;
+            ulLeft = 0;
+        }
+
+        /* Then hash the whole blocks straight from the input. */
+        xBlocks = ilen / 64U;
+
+        if( ( iResult == 0 ) && ( xBlocks > 0U ) )
+        {
+            iResult = prvProcess( ctx, input, xBlocks );
+
+            input += xBlocks * 64U;
+            ilen -= xBlocks * 64U;
+        }
+
+        if( ( iResult == 0 ) && ( ilen > 0U ) )
+        {
+            memcpy( ctx->buffer + ulLeft, input, ilen );
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+int mbedtls_sha256_finish_ret( mbedtls_sha256_context * ctx,
+                               unsigned char output[ 32 ] )
+{
+    int iResult = 0;
+    uint32_t ulUsed = ctx->total[ 0 ] & 0x3FUL;
+    uint32_t ulHigh, ulLow, i;
+
+    /* Pad with 0x80 and zeroes up to the eight bytes of the length. */
+    ctx->buffer[ ulUsed++ ] = 0x80;
+
+    if( ulUsed <= 56U )
+    {
+        memset( ctx->buffer + ulUsed, 0, 56U - ulUsed );
+    }
+    else
+    {
+        memset( ctx->buffer + ulUsed, 0, 64U - ulUsed );
+        iResult = prvProcess( ctx, ctx->buffer, 1 );
+        memset( ctx->buffer, 0, 56 );
+    }
+
+    if( iResult == 0 )
+    {
+        ulHigh = ( ctx->total[ 0 ] >> 29 ) | ( ctx->total[ 1 ] << 3 );
+        ulLow = ctx->total[ 0 ] << 3;
+
+        shaPUT_UINT32_BE( ulHigh, ctx->buffer + 56 );
+        shaPUT_UINT32_BE( ulLow, ctx->buffer + 60 );
+
+        iResult = prvProcess( ctx, ctx->buffer, 1 );
+    }
+
+    if( iResult == 0 )
+    {
+        for( i = 0; i < ( ( ctx->is224 == 0 ) ? 8U : 7U ); i++ )
+        {
+            shaPUT_UINT32_BE( ctx->state[ i ], output + ( 4U * i ) );
+        }
+    }
+
+    return iResult;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* if defined( MBEDTLS_SHA256_C ) && defined( MBEDTLS_SHA256_ALT ) */
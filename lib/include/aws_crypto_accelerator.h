@@ -0,0 +1,126 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+#ifndef __AWS_CRYPTO_ACCELERATOR__H__
+#define __AWS_CRYPTO_ACCELERATOR__H__
+
+#include "FreeRTOS.h"
+
+/* C runtime includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Direction passed to CryptoAccelerator_t::xAesCryptBlock.
+ *
+ * The values match MBEDTLS_AES_ENCRYPT and MBEDTLS_AES_DECRYPT.
+ */
+#define cryptoAES_DECRYPT    0
+#define cryptoAES_ENCRYPT    1
+
+/**
+ * @brief Primitives a crypto accelerator can take over from mbedTLS.
+ *
+ * mbedTLS is built with MBEDTLS_AES_ALT, MBEDTLS_GCM_ALT and
+ * MBEDTLS_SHA256_ALT.  The replacement modules in lib/crypto call the
+ * primitives below when an accelerator has been registered with
+ * CRYPTO_SetAccelerator(), and their own word-oriented software kernels
+ * otherwise.  Any member may be NULL, in which case the software kernel is
+ * used for that primitive only.
+ *
+ * Every member returns 0 on success or a negative mbedTLS error code, such
+ * as MBEDTLS_ERR_AES_HW_ACCEL_FAILED, which is passed back to the caller of
+ * the mbedTLS API.
+ */
+typedef struct CryptoAccelerator
+{
+    /**
+     * @brief Encrypts or decrypts one 16 byte block with AES-ECB.
+     *
+     * The raw key is passed on every call, so a driver that keeps the key
+     * loaded in the peripheral should compare it with the last key used.
+     *
+     * @param[in] iMode cryptoAES_ENCRYPT or cryptoAES_DECRYPT.
+     * @param[in] pucKey The key, ulKeyBits / 8 bytes long.
+     * @param[in] ulKeyBits 128, 192 or 256.
+     * @param[in] pucInput The input block.
+     * @param[out] pucOutput The output block.  It may equal pucInput.
+     */
+    int ( * xAesCryptBlock )( int iMode,
+                              const uint8_t * pucKey,
+                              uint32_t ulKeyBits,
+                              const uint8_t * pucInput,
+                              uint8_t * pucOutput );
+
+    /**
+     * @brief Folds whole blocks into a GHASH state.
+     *
+     * For each 16 byte block B of pucData, computes
+     * state = ( state ^ B ) * H in GF(2^128), as defined for GCM.
+     *
+     * @param[in] pucHashKey The 16 byte hash key H.
+     * @param[in,out] pucState The 16 byte GHASH state.
+     * @param[in] pucData The data, a multiple of 16 bytes long.
+     * @param[in] xLength The length of pucData.
+     */
+    int ( * xGhashUpdate )( const uint8_t * pucHashKey,
+                            uint8_t * pucState,
+                            const uint8_t * pucData,
+                            size_t xLength );
+
+    /**
+     * @brief Runs the SHA-256 compression function over whole blocks.
+     *
+     * @param[in,out] pulState The eight word intermediate hash value.
+     * @param[in] pucData The data, xBlocks * 64 bytes long.
+     * @param[in] xBlocks The number of 64 byte blocks.
+     */
+    int ( * xSha256Process )( uint32_t * pulState,
+                              const uint8_t * pucData,
+                              size_t xBlocks );
+} CryptoAccelerator_t;
+
+/**
+ * @brief Registers the crypto accelerator used by mbedTLS.
+ *
+ * Call this once during start up, before any TLS connection is opened or
+ * any PKCS#11 session digests data.  Contexts that already hold a key keep
+ * working, because both the raw key and the software key schedule are
+ * always kept.
+ *
+ * @param[in] pxAccelerator The accelerator, which must stay valid for as
+ * long as it is registered, or NULL to use the software kernels only.
+ */
+void CRYPTO_SetAccelerator( const CryptoAccelerator_t * pxAccelerator );
+
+/**
+ * @brief Returns the registered crypto accelerator.
+ *
+ * @return The accelerator passed to CRYPTO_SetAccelerator(), or NULL if the
+ * software kernels are in use.
+ */
+const CryptoAccelerator_t * CRYPTO_GetAccelerator( void );
+
+#endif /* ifndef __AWS_CRYPTO_ACCELERATOR__H__ */
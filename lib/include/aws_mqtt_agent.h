@@ -115,19 +115,52 @@ typedef struct MQTTAgentCallbackParams
  * The user should take the ownership of the buffer containing the received message from the
  * broker by returning pdTRUE from the callback if the user wants to use the buffer after
  * the callback is over. The user should return the buffer whenever done by calling the
- * MQTT_AGENT_ReturnBuffer API.
+ * MQTT_AGENT_ReturnBuffer API.<br>
+ * Taking the ownership is not possible if the mqttagentDELIVER_PUBLISHES_IN_PLACE flag was
+ * set on connect. With it, messages are passed to the callback straight from the receive
+ * buffer of the MQTT task whenever possible, in which case xBuffer is NULL and the callback
+ * must return pdFALSE.
  *
  * @see MQTTAgentCallbackParams_t.
  */
 typedef BaseType_t ( * MQTTAgentCallback_t )( void * pvUserData,
                                               const MQTTAgentCallbackParams_t * const pxCallbackParams );
 
+/**
+ * @brief Identifies an operation started with MQTT_AGENT_PublishAsync or
+ * MQTT_AGENT_SubscribeAsync.
+ *
+ * It is returned when the operation is started and passed again to the
+ * completion callback, so that one callback can serve many operations.
+ */
+typedef uint32_t MQTTAgentRequestHandle_t;
+
+/**
+ * @brief Signature of the callback invoked when an asynchronous operation completes.
+ *
+ * xResult is eMQTTAgentSuccess once a QoS0 publish has been sent, a QoS1 publish has
+ * been acknowledged or a subscription has been accepted, eMQTTAgentTimeout if the
+ * operation did not complete within its timeout and eMQTTAgentFailure otherwise.
+ *
+ * The callback is invoked from the MQTT task and must return quickly.  It must not
+ * call the blocking MQTT agent APIs, but it may start further asynchronous operations
+ * or post the result to a queue for an application task to handle.
+ *
+ * @param[in] pvCallbackContext The context passed when the operation was started.
+ * @param[in] xRequestHandle The handle returned when the operation was started.
+ * @param[in] xResult The result of the operation.
+ */
+typedef void ( * MQTTAgentCompletionCallback_t )( void * pvCallbackContext,
+                                                  MQTTAgentRequestHandle_t xRequestHandle,
+                                                  MQTTAgentReturnCode_t xResult );
+
 /**
  * @brief Flags for the MQTT agent connect params.
  */
-#define mqttagentURL_IS_IP_ADDRESS       0x00000001    /**< Set this bit in xFlags if the provided URL is an IP address. */
-#define mqttagentREQUIRE_TLS             0x00000002    /**< Set this bit in xFlags to use TLS. */
-#define mqttagentUSE_AWS_IOT_ALPN_443    0x00000004    /**< Set this bit in xFlags to use AWS IoT support for MQTT over TLS port 443. */
+#define mqttagentURL_IS_IP_ADDRESS             0x00000001    /**< Set this bit in xFlags if the provided URL is an IP address. */
+#define mqttagentREQUIRE_TLS                   0x00000002    /**< Set this bit in xFlags to use TLS. */
+#define mqttagentUSE_AWS_IOT_ALPN_443          0x00000004    /**< Set this bit in xFlags to use AWS IoT support for MQTT over TLS port 443. */
+#define mqttagentDELIVER_PUBLISHES_IN_PLACE    0x00000008    /**< Set this bit in xFlags if none of the callbacks takes the ownership of received publish messages, so that they can be delivered without a copy. */
 
 /**
  * @brief Parameters passed to the MQTT_AGENT_Connect API.
@@ -149,7 +182,7 @@ typedef struct MQTTAgentConnectParams
 } MQTTAgentConnectParams_t;
 
 /**
- * @brief Parameters passed to the MQTT_AGENT_Subscribe API.
+ * @brief A topic filter passed to the MQTT_AGENT_Subscribe and MQTT_AGENT_SubscribeAsync APIs.
  */
 typedef struct MQTTAgentSubscribeParams
 {
@@ -166,7 +199,7 @@ typedef struct MQTTAgentSubscribeParams
 } MQTTAgentSubscribeParams_t;
 
 /**
- * @brief Parameters passed to the MQTT_AGENT_Unsubscribe API.
+ * @brief A topic filter passed to the MQTT_AGENT_Unsubscribe API.
  */
 typedef struct MQTTAgentUnsubscribeParams
 {
@@ -182,7 +215,7 @@ typedef struct MQTTAgentPublishParams
     const uint8_t * pucTopic; /**< The topic string on which the message should be published. */
     uint16_t usTopicLength;   /**< The length of the topic. */
     MQTTQoS_t xQoS;           /**< Quality of Service (QoS). */
-    const void * pvData;      /**< The data to publish. This data is copied into the MQTT buffers and therefore the user can free the buffer after the MQTT_AGENT_Publish call returns. */
+    const void * pvData;      /**< The data to publish. This data is transmitted (small payloads are first copied into the MQTT buffers) before MQTT_AGENT_Publish returns and therefore the user can free the buffer after the MQTT_AGENT_Publish call returns. */
     uint32_t ulDataLength;    /**< Length of the data. */
 } MQTTAgentPublishParams_t;
 
@@ -264,7 +297,12 @@ MQTTAgentReturnCode_t MQTT_AGENT_Disconnect( MQTTAgentHandle_t xMQTTHandle,
                                              TickType_t xTimeoutTicks );
 
 /**
- * @brief Subscribes to a given topic.
+ * @brief Subscribes to the given topics.
+ *
+ * All the topic filters are sent in a single SUBSCRIBE message and are acknowledged by
+ * a single SUBACK which carries a return code for each of them.  If the broker rejects
+ * any of the topic filters the operation fails, but the topic filters it accepted stay
+ * subscribed.  pxSubACKReturnCodes tells which those are.
  *
  * @note This function alters the calling task's notification state and value. If xTimeoutTicks
  * is short the calling task's notification state and value may be updated after MQTT_AGENT_Subscribe()
@@ -290,7 +328,11 @@ MQTTAgentReturnCode_t MQTT_AGENT_Disconnect( MQTTAgentHandle_t xMQTTHandle,
  *   any of the callback by returning eMQTTTrue, no further callbacks are invoked.
  *
  * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
- * @param[in] pxSubscribeParams Subscribe parameters.
+ * @param[in] pxSubscribeParams Array of ulTopicCount topic filters to subscribe to.
+ * @param[in] ulTopicCount Number of topic filters. Must be between 1 and mqttconfigSUBSCRIBE_MAX_TOPICS.
+ * @param[out] pxSubACKReturnCodes Array of ulTopicCount entries which receives the return code
+ * of each topic filter from the SUBACK.  Written only if a SUBACK is received, before this
+ * function returns.  Can be NULL.
  * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail. Use pdMS_TO_TICKS
  * macro to convert milliseconds to ticks.
  *
@@ -299,17 +341,22 @@ MQTTAgentReturnCode_t MQTT_AGENT_Disconnect( MQTTAgentHandle_t xMQTTHandle,
  */
 MQTTAgentReturnCode_t MQTT_AGENT_Subscribe( MQTTAgentHandle_t xMQTTHandle,
                                             const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                            uint32_t ulTopicCount,
+                                            MQTTSubACKReturnCode_t * const pxSubACKReturnCodes,
                                             TickType_t xTimeoutTicks );
 
 /**
- * @brief Unsubscribes from a given topic.
+ * @brief Unsubscribes from the given topics.
+ *
+ * All the topic filters are sent in a single UNSUBSCRIBE message.
  *
  * @note This function alters the calling task's notification state and value. If xTimeoutTicks
  * is short the calling task's notification state and value may be updated after MQTT_AGENT_Unsubscribe()
  * has returned.
  *
  * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
- * @param[in] pxUnsubscribeParams Unsubscribe parameters.
+ * @param[in] pxUnsubscribeParams Array of ulTopicCount topic filters to unsubscribe from.
+ * @param[in] ulTopicCount Number of topic filters. Must be between 1 and mqttconfigSUBSCRIBE_MAX_TOPICS.
  * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail. Use pdMS_TO_TICKS
  * macro to convert milliseconds to ticks.
  *
@@ -318,11 +365,30 @@ MQTTAgentReturnCode_t MQTT_AGENT_Subscribe( MQTTAgentHandle_t xMQTTHandle,
  */
 MQTTAgentReturnCode_t MQTT_AGENT_Unsubscribe( MQTTAgentHandle_t xMQTTHandle,
                                               const MQTTAgentUnsubscribeParams_t * const pxUnsubscribeParams,
+                                              uint32_t ulTopicCount,
                                               TickType_t xTimeoutTicks );
 
 /**
  * @brief Publishes a message to a given topic.
  *
+ * At most mqttconfigPUBLISH_WINDOW_SIZE QoS1 publishes, and at most mqttconfigMAX_PARALLEL_OPS
+ * QoS1 publishes, subscribes and unsubscribes together, await an ACK on a connection at any
+ * time.  A QoS1 publish which finds no room is held by the MQTT task until a PUBACK or a
+ * timeout makes room for it.  The MQTT task takes no further commands for any connection
+ * meanwhile, so the tasks which publish faster than the broker acknowledges end up waiting
+ * for space in the command queue.
+ *
+ * If mqttconfigOFFLINE_QUEUE_SIZE is not 0, a QoS1 publish made while the client is not
+ * connected is copied to the offline queue of the client and succeeds once stored.  It is
+ * sent when the client is connected again, as are QoS1 publishes which were still waiting
+ * for PUBACK when the connection dropped, from a copy taken when they were sent.  Until the queue has been emptied, further QoS1
+ * publishes are appended to it as well, so that they keep their order.  The queue stays
+ * with the handle through MQTT_AGENT_Delete and MQTT_AGENT_Create, and if
+ * mqttconfigOFFLINE_STORE_SIZE is not 0 publishes which do not fit in RAM are kept in
+ * persistent storage.  Publishes whose topic or data exceed
+ * mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH or mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH, or
+ * which find the queue full, fail.
+ *
  * @note This function alters the calling task's notification state and value. If xTimeoutTicks
  * is short the calling task's notification state and value may be updated after MQTT_AGENT_Publish()
  * has returned.
@@ -339,6 +405,77 @@ MQTTAgentReturnCode_t MQTT_AGENT_Publish( MQTTAgentHandle_t xMQTTHandle,
                                           const MQTTAgentPublishParams_t * const pxPublishParams,
                                           TickType_t xTimeoutTicks );
 
+/**
+ * @brief Subscribes to the given topics without waiting for the SUBACK.
+ *
+ * The topic filters are sent as described for MQTT_AGENT_Subscribe.  The request is queued to the MQTT task and the function returns straight away.  The
+ * result is reported by calling pxCompletionCallback from the MQTT task.  Unlike
+ * MQTT_AGENT_Subscribe, this function does not alter the calling task's notification
+ * state and value, and it may be called from a callback of the MQTT agent.
+ *
+ * @note pxSubscribeParams and the topics it points to are read, and pxSubACKReturnCodes
+ * is written, by the MQTT task, so they must remain valid until pxCompletionCallback is invoked.
+ *
+ * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
+ * @param[in] pxSubscribeParams Array of ulTopicCount topic filters to subscribe to.
+ * @param[in] ulTopicCount Number of topic filters. Must be between 1 and mqttconfigSUBSCRIBE_MAX_TOPICS.
+ * @param[out] pxSubACKReturnCodes Array of ulTopicCount entries which receives the return code
+ * of each topic filter from the SUBACK.  Written only if a SUBACK is received, before
+ * pxCompletionCallback is invoked.  Can be NULL.
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.  It
+ * also bounds how long the function waits for space in the command queue, except when called
+ * from a callback of the MQTT agent, in which case it does not wait.
+ * @param[in] pxCompletionCallback The callback invoked when the operation completes.
+ * @param[in] pvCallbackContext Passed unchanged to pxCompletionCallback.
+ * @param[out] pxRequestHandle Receives the handle of the operation.  May be NULL.
+ *
+ * @return eMQTTAgentSuccess if the operation was started, in which case pxCompletionCallback
+ * will be invoked exactly once, otherwise an error code explaining the reason of the failure
+ * is returned and pxCompletionCallback is not invoked.
+ */
+MQTTAgentReturnCode_t MQTT_AGENT_SubscribeAsync( MQTTAgentHandle_t xMQTTHandle,
+                                                 const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                                 uint32_t ulTopicCount,
+                                                 MQTTSubACKReturnCode_t * const pxSubACKReturnCodes,
+                                                 TickType_t xTimeoutTicks,
+                                                 MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                                 void * pvCallbackContext,
+                                                 MQTTAgentRequestHandle_t * const pxRequestHandle );
+
+/**
+ * @brief Publishes a message to a given topic without waiting for it to be sent or
+ * acknowledged.
+ *
+ * The request is queued to the MQTT task and the function returns straight away, so a
+ * single task can keep several QoS1 publishes awaiting their PUBACK.  How many can await
+ * it is limited as described for MQTT_AGENT_Publish, and once the command queue is full
+ * this function waits for space in it for up to xTimeoutTicks.  The result is reported
+ * by calling pxCompletionCallback from the MQTT task.  Unlike MQTT_AGENT_Publish, this function does not alter the calling task's
+ * notification state and value, and it may be called from a callback of the MQTT agent.
+ *
+ * @note pxPublishParams and the topic and data it points to are read by the MQTT task, so
+ * they must remain valid until pxCompletionCallback is invoked.
+ *
+ * @param[in] xMQTTHandle The opaque handle as returned from MQTT_AGENT_Create.
+ * @param[in] pxPublishParams Publish parameters.
+ * @param[in] xTimeoutTicks Maximum time in ticks after which the operation should fail.  It
+ * also bounds how long the function waits for space in the command queue, except when called
+ * from a callback of the MQTT agent, in which case it does not wait.
+ * @param[in] pxCompletionCallback The callback invoked when the operation completes.
+ * @param[in] pvCallbackContext Passed unchanged to pxCompletionCallback.
+ * @param[out] pxRequestHandle Receives the handle of the operation.  May be NULL.
+ *
+ * @return eMQTTAgentSuccess if the operation was started, in which case pxCompletionCallback
+ * will be invoked exactly once, otherwise an error code explaining the reason of the failure
+ * is returned and pxCompletionCallback is not invoked.
+ */
+MQTTAgentReturnCode_t MQTT_AGENT_PublishAsync( MQTTAgentHandle_t xMQTTHandle,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams,
+                                               TickType_t xTimeoutTicks,
+                                               MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                               void * pvCallbackContext,
+                                               MQTTAgentRequestHandle_t * const pxRequestHandle );
+
 /**
  * @brief Returns the buffer provided in the publish callback.
  *
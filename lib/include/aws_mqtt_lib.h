@@ -81,7 +81,8 @@ typedef enum
     eMQTTNoFreeBuffer,               /**< No free buffer is available for the operation. */
     eMQTTSendFailed,                 /**< The registered send callback failed to transmit data. */
     eMQTTMalformedPacketReceived,    /**< A malformed packet was received. Client has been disconnected. The user must re-connect before carrying out any other operation. */
-    eMQTTSubscriptionManagerFull     /**< No space left in subscription manager to store any more subscriptions. */
+    eMQTTSubscriptionManagerFull,    /**< No space left in subscription manager to store any more subscriptions. */
+    eMQTTPublishWindowFull           /**< mqttconfigPUBLISH_WINDOW_SIZE QoS1 publishes are already waiting for PUBACK. */
 } MQTTReturnCode_t;
 
 /**
@@ -223,8 +224,10 @@ typedef struct MQTTConnACKData
  */
 typedef struct MQTTSubACKData
 {
-    MQTTSubACKReturnCode_t xSubACKReturnCode; /**< SUBACK return code. @see MQTTSubACKReturnCode_t. */
+    MQTTSubACKReturnCode_t xSubACKReturnCode; /**< eMQTTSubACKFailure if the broker rejected any of the topic filters, otherwise the return code of the first one. @see MQTTSubACKReturnCode_t. */
     uint16_t usPacketIdentifier;              /**< Packet identifier which the user can use to match the SUBACK with the Subscribe request. */
+    const uint8_t * pucReturnCodes;           /**< The MQTTSubACKReturnCode_t value of each topic filter, in the order of the Subscribe request. Valid only during the callback. */
+    uint32_t ulReturnCodeCount;               /**< The number of return codes, which is the number of topic filters in the Subscribe request. */
 } MQTTSubACKData_t;
 
 /**
@@ -256,7 +259,7 @@ typedef struct MQTTPublishData
     uint16_t usTopicLength;     /**< Length of the topic. */
     const void * pvData;        /**< The received message. */
     uint32_t ulDataLength;      /**< Length of the message. */
-    MQTTBufferHandle_t xBuffer; /**< The buffer containing the whole MQTT message. Both pcTopic and pvData are pointers to the locations in this buffer. */
+    MQTTBufferHandle_t xBuffer; /**< The buffer containing the whole MQTT message. Both pcTopic and pvData are pointers to the locations in this buffer. NULL if the message is delivered in place, see xDeliverPublishesInPlace in MQTTConnectParams_t. */
 } MQTTPublishData_t;
 
 /**
@@ -427,6 +430,29 @@ typedef void ( * MQTTReturnBuffer_t )( uint8_t * pucBuffer );
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
+/**
+ * @brief Represents one topic level in the topic trie of the subscription
+ * manager.
+ *
+ * Nodes are linked by index. The text of the level is not copied in the node,
+ * it is read from the topic filter of one of the subscriptions that go
+ * through the node.
+ */
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+
+    typedef struct MQTTTopicNode
+    {
+        uint16_t usFirstChild;   /**< The first node of the next topic level. */
+        uint16_t usNextSibling;  /**< The next node of the same topic level. */
+        uint16_t usRefCount;     /**< Number of subscriptions going through this node. Zero if the node is free. */
+        uint16_t usSubscription; /**< The subscription whose topic filter ends at this node, if any. */
+        uint16_t usTextOwner;    /**< The subscription whose topic filter contains the text of this level. */
+        uint16_t usLevelOffset;  /**< Offset of the text of this level in that topic filter. */
+        uint16_t usLevelLength;  /**< Length of the text of this level. */
+    } MQTTTopicNode_t;
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
+
 /**
  * @brief The subscription manager used to keep track of user subscriptions
  * and topic specific callbacks.
@@ -437,6 +463,11 @@ typedef void ( * MQTTReturnBuffer_t )( uint8_t * pucBuffer );
     {
         MQTTSubscription_t xSubscriptions[ mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ]; /**< User subscriptions. */
         uint32_t ulInUseSubscriptions;                                                         /**< Number of subscription entries currently in use. */
+        #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+            MQTTTopicNode_t xTopicNodes[ mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES ];     /**< Storage for the nodes of the topic trie. */
+            uint32_t ulFreeTopicNodes;                                                         /**< Number of nodes currently free. */
+            uint16_t usFirstTopicNode;                                                         /**< The first node of the first topic level. */
+        #endif /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
     } MQTTSubscriptionManager_t;
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -472,25 +503,28 @@ typedef struct MQTTRxMessageState
  */
 typedef struct MQTTContext
 {
-    Link_t xTxBufferListHead;                                   /**< The list of Tx buffers i.e. buffers containing transmitted messages waiting for ACK. */
-    MQTTBufferHandle_t xRxBuffer;                               /**< The Rx buffer i.e. the buffer used to store the incoming message. */
-    MQTTRxMessageState_t xRxMessageState;                       /**< The state of the message being received currently. */
-    uint8_t ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_MAX_SIZE ]; /**< The buffer used to store the fixed header of the incoming message. */
-    uint32_t ulRxMessageReceivedLength;                         /**< The length of the message received so far. */
-    void * pvCallbackContext;                                   /**< As supplied by the user in Init parameters. */
-    MQTTEventCallback_t pxCallback;                             /**< Callback supplied  by the user to get notified of various events. */
-    void * pvSendContext;                                       /**< As supplied by the user in Init parameters. */
-    MQTTSend_t pxMQTTSendFxn;                                   /**< Callback supplied by the user to transmit data. */
-    MQTTGetTicks_t pxGetTicksFxn;                               /**< Callback supplied by the user to get current tick count. */
-    MQTTBufferPoolInterface_t xBufferPoolInterface;             /**< The buffer pool interface supplied by the user. @see MQTTBufferPoolInterface_t. */
-    MQTTConnectionState_t xConnectionState;                     /**< The current connection state. */
-    uint64_t xLastSentMessageTimestamp;                         /**< The timestamp when the last message (or acknowledgment) was sent. */
-    uint32_t ulNextPeriodicInvokeTicks;                         /**< The time interval in ticks after which MQTT_Periodic function must be called. */
-    uint32_t ulKeepAliveActualIntervalTicks;                    /**< The time interval in ticks after which a keep alive message should be sent. */
-    uint32_t ulPingRequestTimeoutTicks;                         /**< The time interval in ticks to wait for PINGRESP after sending PINGREQ. */
-    MQTTBool_t xWaitingForPingResp;                             /**< Whether a keep alive message has been sent and we are waiting for response from the broker. */
+    Link_t xTxBufferListHead;                                                    /**< The list of Tx buffers i.e. buffers containing transmitted messages waiting for ACK, ordered by deadline. */
+    Link_t xTxBufferIdentifierBuckets[ mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS ]; /**< The Tx buffers again, indexed by packet identifier. */
+    MQTTBufferHandle_t xRxBuffer;                                                /**< The Rx buffer i.e. the buffer used to store the incoming message. */
+    MQTTRxMessageState_t xRxMessageState;                                        /**< The state of the message being received currently. */
+    uint8_t ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_MAX_SIZE ];                  /**< The buffer used to store the fixed header of the incoming message. */
+    uint32_t ulRxMessageReceivedLength;                                          /**< The length of the message received so far. */
+    void * pvCallbackContext;                                                    /**< As supplied by the user in Init parameters. */
+    MQTTEventCallback_t pxCallback;                                              /**< Callback supplied  by the user to get notified of various events. */
+    void * pvSendContext;                                                        /**< As supplied by the user in Init parameters. */
+    MQTTSend_t pxMQTTSendFxn;                                                    /**< Callback supplied by the user to transmit data. */
+    MQTTGetTicks_t pxGetTicksFxn;                                                /**< Callback supplied by the user to get current tick count. */
+    MQTTBufferPoolInterface_t xBufferPoolInterface;                              /**< The buffer pool interface supplied by the user. @see MQTTBufferPoolInterface_t. */
+    MQTTConnectionState_t xConnectionState;                                      /**< The current connection state. */
+    uint64_t xLastSentMessageTimestamp;                                          /**< The timestamp when the last message (or acknowledgment) was sent. */
+    uint32_t ulNextPeriodicInvokeTicks;                                          /**< The time interval in ticks after which MQTT_Periodic function must be called. */
+    uint32_t ulKeepAliveActualIntervalTicks;                                     /**< The time interval in ticks after which a keep alive message should be sent. */
+    uint32_t ulPingRequestTimeoutTicks;                                          /**< The time interval in ticks to wait for PINGRESP after sending PINGREQ. */
+    MQTTBool_t xDeliverPublishesInPlace;                                         /**< As supplied by the user in Connect parameters. */
+    MQTTBool_t xWaitingForPingResp;                                              /**< Whether a keep alive message has been sent and we are waiting for response from the broker. */
+    uint32_t ulPublishesInFlight;                                                /**< The number of QoS1 publishes waiting for PUBACK. */
     #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
-        MQTTSubscriptionManager_t xSubscriptionManager;         /**< The subscription manager used to keep track of user subscriptions and topic specific callbacks.*/
+        MQTTSubscriptionManager_t xSubscriptionManager;                          /**< The subscription manager used to keep track of user subscriptions and topic specific callbacks.*/
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 } MQTTContext_t;
 
@@ -525,20 +559,21 @@ typedef struct MQTTConnectParams
     uint16_t usUserNameLength;               /**< The length of the user name. */
     uint16_t usPacketIdentifier;             /**< The same identifier is returned in the callback when corresponding CONNACK is received or the operation times out. */
     uint32_t ulTimeoutTicks;                 /**< The time interval in ticks after which the operation should fail. */
+    MQTTBool_t xDeliverPublishesInPlace;     /**< Set to eMQTTTrue if none of the callbacks takes the ownership of received publish messages. A publish message which is then
+                                              *   entirely contained in the data passed to MQTT_ParseReceivedData is delivered from there without being copied into a buffer.
+                                              *   Such a message is only valid during the callback, xBuffer in MQTTPublishData_t is NULL and the callback must return eMQTTFalse. */
 } MQTTConnectParams_t;
 
 /**
- * @brief MQTT Subscribe Parameters.
+ * @brief A topic filter to subscribe to.
  *
- * Parameters passed to the MQTT_Subscribe API.
+ * Topic filters passed to the MQTT_Subscribe API.
  */
-typedef struct MQTTSubscribeParams
+typedef struct MQTTSubscribeTopic
 {
     const uint8_t * pucTopic;                    /**< The topic to subscribe to. This can be a topic filter containing wild cards as permitted by the MQTT protocol. */
     uint16_t usTopicLength;                      /**< The length of the topic. */
     MQTTQoS_t xQos;                              /**< Requested Quality of Service (QoS). */
-    uint16_t usPacketIdentifier;                 /**< The same identifier is returned in the callback when corresponding SUBACK is received or the operation times out. */
-    uint32_t ulTimeoutTicks;                     /**< The time interval in ticks after which the operation should fail. */
     #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
         void * pvPublishCallbackContext;         /**< Passed as it is in the publish callback. */
         MQTTPublishCallback_t pxPublishCallback; /**< Callback function to be called whenever a publish message is received on this topic or on a topic which matches this
@@ -546,8 +581,32 @@ typedef struct MQTTSubscribeParams
                                                   *   the callbacks are invoked is undefined. This can be NULL if the user does not want to register a topic specific callback,
                                                   *   in which case the generic callback ( if registered during initialization ) is invoked. */
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+} MQTTSubscribeTopic_t;
+
+/**
+ * @brief MQTT Subscribe Parameters.
+ *
+ * Parameters passed to the MQTT_Subscribe API.
+ */
+typedef struct MQTTSubscribeParams
+{
+    const MQTTSubscribeTopic_t * pxTopics; /**< The topic filters to subscribe to, all of which are sent in one Subscribe message. */
+    uint32_t ulTopicCount;                 /**< The number of topic filters in pxTopics. Must be at least 1. */
+    uint16_t usPacketIdentifier;           /**< The same identifier is returned in the callback when corresponding SUBACK is received or the operation times out. */
+    uint32_t ulTimeoutTicks;               /**< The time interval in ticks after which the operation should fail. */
 } MQTTSubscribeParams_t;
 
+/**
+ * @brief A topic filter to unsubscribe from.
+ *
+ * Topic filters passed to the MQTT_Unsubscribe API.
+ */
+typedef struct MQTTUnsubscribeTopic
+{
+    const uint8_t * pucTopic; /**< The topic to unsubscribe from. */
+    uint16_t usTopicLength;   /**< The length of the topic. */
+} MQTTUnsubscribeTopic_t;
+
 /**
  * @brief MQTT Unsubscribe Parameters.
  *
@@ -555,10 +614,10 @@ typedef struct MQTTSubscribeParams
  */
 typedef struct MQTTUnsubscribeParams
 {
-    const uint8_t * pucTopic;    /**< The topic to unsubscribe from. */
-    uint16_t usTopicLength;      /**< The length of the topic. */
-    uint16_t usPacketIdentifier; /**< The same identifier is returned in the callback when corresponding UNSUBACK is received or the operation times out. */
-    uint32_t ulTimeoutTicks;     /**< The time interval in ticks after which the operation should fail. */
+    const MQTTUnsubscribeTopic_t * pxTopics; /**< The topic filters to unsubscribe from, all of which are sent in one Unsubscribe message. */
+    uint32_t ulTopicCount;                   /**< The number of topic filters in pxTopics. Must be at least 1. */
+    uint16_t usPacketIdentifier;             /**< The same identifier is returned in the callback when corresponding UNSUBACK is received or the operation times out. */
+    uint32_t ulTimeoutTicks;                 /**< The time interval in ticks after which the operation should fail. */
 } MQTTUnsubscribeParams_t;
 
 /**
@@ -627,6 +686,11 @@ MQTTReturnCode_t MQTT_Disconnect( MQTTContext_t * pxMQTTContext );
  * waiting ACK list which is removed when the corresponding SUBACK is received
  * or the operation times out.
  *
+ * All the topic filters are sent in the one message and acknowledged by the
+ * one SUBACK, which carries a return code for each of them.  If the broker
+ * rejects some of the topic filters, only those are removed from the
+ * subscription manager.
+ *
  * Whenever a publish message is received on a topic, the registered callbacks are invoked
  * in the following order:
  * * If we have an exact matching entry in the subscription manager, the corresponding
@@ -660,7 +724,7 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
  *
  * Prepares and transmits an MQTT unsubscribe message and puts the packet on the
  * waiting ACK list which is removed when the corresponding UNSUBACK is received
- * or the operation times out.
+ * or the operation times out.  All the topic filters are sent in the one message.
  *
  * @param[in] pxMQTTContext The initialized MQTT context.
  * @param[in] pxUnsubscribeParams Unsubscribe parameters.
@@ -677,6 +741,15 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
  * packet on the waiting ACK list which is removed when the corresponding PUBACK
  * is received or the operation times out.
  *
+ * Payloads larger than mqttconfigPUBLISH_COPY_THRESHOLD are not copied. They
+ * are passed to the send callback as a separate segment after the header, so
+ * the payload only needs to remain valid until this function returns, unless
+ * QoS1 publishes are retransmitted (see mqttconfigPUBLISH_RETRANSMIT_TICKS).
+ *
+ * A QoS1 publish fails with eMQTTPublishWindowFull while
+ * mqttconfigPUBLISH_WINDOW_SIZE publishes are waiting for PUBACK. It can be
+ * tried again once one of them has been acknowledged or has timed out.
+ *
  * @param[in] pxMQTTContext The initialized MQTT context.
  * @param[in] pxPublishParams Publish parameters.
  *
@@ -83,6 +83,9 @@ typedef BaseType_t ( * NetworkSend_t )( void * pvCallerContext,
  * @param[in] pxNetworkSend Caller-defined network send function pointer.
  * @param[in] pvCallerContext Caller-defined context handle to be used with callback
  * functions.
+ * @param[in] ulMaxFragmentLength Largest record the server should send, one of
+ * 512, 1024, 2048 or 4096, negotiated with the max_fragment_length extension.
+ * Zero to use tlsconfigMAX_FRAGMENT_LENGTH.
  */
 typedef struct xTLS_PARAMS
 {
@@ -96,6 +99,7 @@ typedef struct xTLS_PARAMS
     NetworkRecv_t pxNetworkRecv;
     NetworkSend_t pxNetworkSend;
     void * pvCallerContext;
+    uint32_t ulMaxFragmentLength;
 } TLSParams_t;
 
 /**
@@ -145,6 +149,15 @@ BaseType_t TLS_Send( void * pvContext,
                      const unsigned char * pucMsg,
                      size_t xMsgLength );
 
+/**
+ * @brief Makes the next TLS_Connect() read the device credentials again.
+ *
+ * The client certificate and the private key handle are read from PKCS#11
+ * once and shared by all later connections.  Call this after provisioning
+ * new credentials.  Handshakes in progress keep using the old ones.
+ */
+void TLS_ClearClientCredential( void );
+
 /**
  * @brief Frees resources consumed by the TLS context.
  *
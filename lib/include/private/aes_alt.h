@@ -0,0 +1,54 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aes_alt.h
+ * @brief AES context used when mbedTLS is built with MBEDTLS_AES_ALT.
+ *
+ * The functions are implemented in lib/crypto/aws_aes_alt.c.
+ */
+
+#ifndef __AES_ALT_H__
+#define __AES_ALT_H__
+
+#include <stdint.h>
+
+#if defined( MBEDTLS_CIPHER_MODE_XTS )
+    #error "MBEDTLS_CIPHER_MODE_XTS is not supported by lib/crypto/aws_aes_alt.c."
+#endif
+
+/**
+ * @brief The AES context-type definition.
+ */
+typedef struct mbedtls_aes_context
+{
+    int nr;                    /*!< The number of rounds. */
+    uint32_t rk[ 60 ];         /*!< Round keys for the software kernel. */
+    unsigned int keybits;      /*!< The key length, in bits. */
+    unsigned char key[ 32 ];   /*!< The raw key, for the accelerator. */
+}
+mbedtls_aes_context;
+
+#endif /* ifndef __AES_ALT_H__ */
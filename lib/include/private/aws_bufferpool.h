@@ -59,6 +59,9 @@ lib_initDECLARE_LIB_INIT( BUFFERPOOL_Init );
  * than the requested length and pulBufferLength is updated to the
  * actual length of the buffer.
  *
+ * @note This function does not block and can also be called from an
+ * interrupt service routine.
+ *
  * @return The pointer to the buffer if one is available, NULL otherwise.
  */
 uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength );
@@ -66,8 +69,50 @@ uint8_t * BUFFERPOOL_GetFreeBuffer( uint32_t * pulBufferLength );
 /**
  * @brief Returns the buffer back to the central buffer pool.
  *
+ * @note This function does not block and can also be called from an
+ * interrupt service routine.
+ *
  * @param[in] pucBuffer The buffer to return to the buffer pool.
  */
 void BUFFERPOOL_ReturnBuffer( uint8_t * const pucBuffer );
 
+/**
+ * @brief Gets the largest number of buffers that were in use at the same
+ * time, for sizing the buffer pool.
+ *
+ * The pool may be made of several size classes. The count is for the class
+ * that a request of the given length is served from first.
+ *
+ * @param[in] ulBufferLength Selects the class as for BUFFERPOOL_GetFreeBuffer.
+ *
+ * @return The high-water mark of the class, or 0 if no class can serve the
+ * length.
+ */
+uint32_t BUFFERPOOL_GetHighWaterMark( uint32_t ulBufferLength );
+
+/**
+ * @brief Occupancy of one size class of the buffer pool.
+ */
+typedef struct BufferPoolStats
+{
+    uint32_t ulBufferSize; /**< Size of each buffer of the class. */
+    uint32_t ulNumBuffers; /**< Number of buffers in the class. */
+    uint32_t ulInUse;      /**< Number of buffers handed out now. */
+    uint32_t ulMaxInUse;   /**< High-water mark of ulInUse. */
+} BufferPoolStats_t;
+
+/**
+ * @brief Gets the occupancy of each size class of the buffer pool.
+ *
+ * Classes are reported smallest first.  Classes configured with no buffers
+ * are left out.
+ *
+ * @param[out] pxStats Array the occupancy of each class is written to.
+ * @param[in] ulMaxClasses Number of entries of pxStats.
+ *
+ * @return The number of entries written.
+ */
+uint32_t BUFFERPOOL_GetStats( BufferPoolStats_t * pxStats,
+                              uint32_t ulMaxClasses );
+
 #endif /* _AWS_BUFFER_POOL_H_ */
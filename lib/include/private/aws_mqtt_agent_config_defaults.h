@@ -102,6 +102,12 @@
  * i.e. the MQTT task cannot wake up whenever data is received on a connected socket,
  * this value should be set to a small number:
  * #define mqttconfigMQTT_TASK_MAX_BLOCK_TICKS             ( 100 )
+ *
+ * The limit only applies while data can arrive on a socket which does not wake
+ * the MQTT task, i.e. while a packet is waiting for its ACK, a PINGREQ is waiting
+ * for its PINGRESP or the client has subscribed to a topic. At other times the
+ * MQTT task blocks until the next keep alive or timeout deadline, so that a
+ * tickless idle can keep the core asleep for as long as possible.
  */
 #ifndef mqttconfigMQTT_TASK_MAX_BLOCK_TICKS
     #error "mqttconfigMQTT_TASK_MAX_BLOCK_TICKS must be defined in aws_mqtt_agent_config.h."
@@ -134,6 +140,18 @@
     #define mqttconfigMAX_PARALLEL_OPS    ( 5 )
 #endif
 
+/**
+ * @brief Maximum number of topic filters in a single call to
+ * MQTT_AGENT_Subscribe(), MQTT_AGENT_SubscribeAsync() or MQTT_AGENT_Unsubscribe().
+ *
+ * The MQTT task builds the list of topic filters passed to the core library
+ * on its stack, so each additional topic filter costs a few words of
+ * mqttconfigMQTT_TASK_STACK_DEPTH.
+ */
+#ifndef mqttconfigSUBSCRIBE_MAX_TOPICS
+    #define mqttconfigSUBSCRIBE_MAX_TOPICS    ( 8 )
+#endif
+
 /**
  * @brief Time in milliseconds after which the TCP send operation should timeout.
  */
@@ -148,6 +166,105 @@
     #define mqttconfigRX_BUFFER_SIZE    ( 1024 )
 #endif
 
+/**
+ * @brief Length of the buffer in which each connection collects the packets it
+ * sends during one pass of the MQTT task.
+ *
+ * The packets of the commands processed in one pass, along with any ACK or
+ * PINGREQ sent while servicing the connection, go out in a single SOCKETS_Send,
+ * and so in a single TLS record.  Only segments up to
+ * mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE are collected.  Set it to 0 to send each
+ * packet as soon as it is built.
+ *
+ * A QoS 0 publish is reported as sent once the buffer holding it has been sent.
+ * If the buffer cannot be sent, the publish fails and the client is disconnected.
+ */
+#ifndef mqttconfigTX_COALESCE_BUFFER_SIZE
+    #define mqttconfigTX_COALESCE_BUFFER_SIZE    ( 512 )
+#endif
+
+/**
+ * @brief Largest segment the MQTT library sends which is collected in the Tx
+ * buffer, see mqttconfigTX_COALESCE_BUFFER_SIZE.
+ *
+ * This covers the ACKs, the PINGREQ and the headers of publishes with short
+ * topics.  Larger segments, such as publish payloads which are not copied (see
+ * mqttconfigPUBLISH_COPY_THRESHOLD), are sent straight from the memory they are
+ * in, after the packets collected before them.
+ */
+#ifndef mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE
+    #define mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE    ( 64 )
+#endif
+
+/**
+ * @brief Maximum number of commands the MQTT task processes each time it wakes up,
+ * before it receives data and runs the keep alive and timeout processing.
+ *
+ * A larger value lets a burst of commands from several tasks share one pass over
+ * the connections, and one send.  Setting it to 1 processes the connections after
+ * every command.
+ */
+#ifndef mqttconfigMQTT_TASK_MAX_COMMANDS_PER_WAKEUP
+    #define mqttconfigMQTT_TASK_MAX_COMMANDS_PER_WAKEUP    ( mqttconfigMAX_PARALLEL_OPS )
+#endif
+
+/**
+ * @brief Size in bytes of the RAM queue in which each connection stores the
+ * QoS 1 publishes made while it is not connected.
+ *
+ * The publishes are sent, oldest first, once the connection is established
+ * again, and are only removed from the queue when their PUBACK arrives.  Until
+ * the queue is empty, further QoS 1 publishes are appended to it so that they
+ * keep their order.  A publish which goes to the queue is reported as
+ * successful as soon as it is stored.  QoS 1 publishes still waiting for
+ * PUBACK when the connection drops are stored too.
+ *
+ * Each publish takes 4 bytes plus the length of its topic and data.  Set it
+ * to 0 to fail publishes made while not connected instead.
+ */
+#ifndef mqttconfigOFFLINE_QUEUE_SIZE
+    #define mqttconfigOFFLINE_QUEUE_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Size in bytes of the persistent store to which each connection moves
+ * the contents of its offline queue when the queue is full.
+ *
+ * The store is read and written through MQTT_OFFLINE_STORE_PAL_Read and
+ * MQTT_OFFLINE_STORE_PAL_Write, and survives a reset of the device.  It is only
+ * written when the RAM queue overflows and once it has been drained, so its
+ * contents may be sent again after a reset.  Set it to 0 to keep the offline
+ * queue in RAM only.
+ */
+#ifndef mqttconfigOFFLINE_STORE_SIZE
+    #define mqttconfigOFFLINE_STORE_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Maximum topic length of a publish stored in the offline queue.
+ */
+#ifndef mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH
+    #define mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH    ( 128 )
+#endif
+
+/**
+ * @brief Maximum data length of a publish stored in the offline queue.
+ *
+ * Must not be more than mqttconfigPUBLISH_COPY_THRESHOLD, so that the MQTT
+ * library copies the data of the queued publishes it sends.
+ */
+#ifndef mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH
+    #define mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH    ( mqttconfigPUBLISH_COPY_THRESHOLD )
+#endif
+
+/**
+ * @brief Time in ticks to wait for the PUBACK of a publish sent from the
+ * offline queue, after which it is sent again.
+ */
+#ifndef mqttconfigOFFLINE_QUEUE_ACK_TIMEOUT_TICKS
+    #define mqttconfigOFFLINE_QUEUE_ACK_TIMEOUT_TICKS    ( pdMS_TO_TICKS( 10000 ) )
+#endif
+
 /**
  * @defgroup BufferPoolInterface The functions used by the MQTT client to get and return buffers.
  *
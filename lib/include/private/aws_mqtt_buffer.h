@@ -57,12 +57,19 @@ typedef void * MQTTBufferHandle_t;
  * broker or the operation times out. The packet identifier helps
  * in matching the received ACK with the transmitted message while
  * the recorded tick count and timeout ticks help in tracking timeout.
+ * The waiting ACK list is ordered by the deadline derived from them,
+ * which is not stored so as to keep the metadata small.
  */
 typedef struct MQTTBufferState
 {
-    uint64_t xRecordedTickCount; /**< The time-stamp when this packet was sent. */
-    uint32_t ulTimeoutTicks;     /**< The time interval after which this packet should timeout i.e. stop waiting for ACK. */
-    uint16_t usPacketIdentifier; /**< Packet identifier sent with this packet. */
+    uint64_t xRecordedTickCount;               /**< The time-stamp when this packet was sent, 0 until MQTT_Periodic first sees it if the user has not supplied the get ticks function. */
+    uint32_t ulTimeoutTicks;                   /**< The time interval after which this packet should timeout i.e. stop waiting for ACK. */
+    uint16_t usPacketIdentifier;               /**< Packet identifier sent with this packet. */
+    #if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+        uint64_t xRetransmitRecordedTickCount; /**< The time-stamp when this packet was last transmitted. */
+        const void * pvPayload;                /**< The payload which follows the data in the buffer, NULL if the payload was copied into the buffer. */
+        uint32_t ulPayloadLength;              /**< Length of pvPayload. */
+    #endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
 } MQTTBufferState_t;
 
 /**
@@ -79,6 +86,7 @@ typedef struct MQTTBufferMetadata
 {
     MQTTBufferState_t xBufferState; /**< State of the buffer. @see MQTTBufferState_t. */
     Link_t xLink;                   /**< Contains links to previous and next buffers in the list. */
+    Link_t xIdentifierLink;         /**< Contains links to previous and next Tx buffers whose packet identifiers share a bucket of the identifier index. */
     uint32_t ulBufferLength;        /**< The length of the buffer. */
     uint32_t ulDataLength;          /**< The length of the data in the buffer. */
 } MQTTBufferMetadata_t;
@@ -99,6 +107,22 @@ typedef struct MQTTBufferMetadata
  */
 #define mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink )              ( ( MQTTBufferHandle_t ) listCONTAINER( pxLink, MQTTBufferMetadata_t, xLink ) )
 
+/**
+ * @brief Given the buffer handle, extracts the link structure of the identifier
+ * index from the metadata portion of the buffer.
+ *
+ * @param[in] xBufferHandle The given buffer handle.
+ */
+#define mqttbufferGET_IDENTIFIER_LINK( xBufferHandle )               ( ( ( MQTTBufferMetadata_t * ) ( xBufferHandle ) )->xIdentifierLink )
+
+/**
+ * @brief Given the pointer to a link structure of the identifier index, finds
+ * the buffer handle containing the link.
+ *
+ * @param[in] pxLink The pointer to the link struct.
+ */
+#define mqttbufferGET_BUFFER_HANDLE_FROM_IDENTIFIER_LINK( pxLink )   ( ( MQTTBufferHandle_t ) listCONTAINER( pxLink, MQTTBufferMetadata_t, xIdentifierLink ) )
+
 /**
  * @brief Given the buffer handle, finds the pointer to the starting of
  * the buffer.
@@ -172,6 +196,33 @@ typedef struct MQTTBufferMetadata
  */
 #define mqttbufferGET_PACKET_TIMEOUT_TICKS( xBufferHandle )          ( ( ( MQTTBufferMetadata_t * ) ( xBufferHandle ) )->xBufferState.ulTimeoutTicks )
 
+#if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+
+/**
+ * @brief Given the buffer handle, extracts the tick count of the last
+ * transmission from the metadata portion of the buffer.
+ *
+ * @param[in] xBufferHandle The given buffer handle.
+ */
+    #define mqttbufferGET_PACKET_RETRANSMIT_RECORDED_TICK_COUNT( xBufferHandle )    ( ( ( MQTTBufferMetadata_t * ) ( xBufferHandle ) )->xBufferState.xRetransmitRecordedTickCount )
+
+/**
+ * @brief Given the buffer handle, extracts the payload which is not copied
+ * into the buffer from the metadata portion of the buffer.
+ *
+ * @param[in] xBufferHandle The given buffer handle.
+ */
+    #define mqttbufferGET_PACKET_PAYLOAD( xBufferHandle )                           ( ( ( MQTTBufferMetadata_t * ) ( xBufferHandle ) )->xBufferState.pvPayload )
+
+/**
+ * @brief Given the buffer handle, extracts the length of the payload which is
+ * not copied into the buffer from the metadata portion of the buffer.
+ *
+ * @param[in] xBufferHandle The given buffer handle.
+ */
+    #define mqttbufferGET_PACKET_PAYLOAD_LENGTH( xBufferHandle )                    ( ( ( MQTTBufferMetadata_t * ) ( xBufferHandle ) )->xBufferState.ulPayloadLength )
+#endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+
 /**
  * @brief Given a list head and a buffer handle, adds the buffer to the given
  * list.
@@ -200,6 +251,8 @@ typedef struct MQTTBufferMetadata
     {                                                                                \
         ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->xLink.pxPrev = NULL;           \
         ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->xLink.pxNext = NULL;           \
+        ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->xIdentifierLink.pxPrev = NULL; \
+        ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->xIdentifierLink.pxNext = NULL; \
         ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->ulBufferLength = ( ulLength ); \
         ( ( MQTTBufferMetadata_t * ) ( pucBuffer ) )->ulDataLength = 0;              \
     }
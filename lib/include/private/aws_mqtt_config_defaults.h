@@ -73,6 +73,88 @@
     #define mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS    ( 8 )
 #endif
 
+/**
+ * @brief Index the subscriptions in a trie of topic levels.
+ *
+ * If the user has enabled subscription management, setting this macro to 1
+ * makes the subscription manager keep a trie with one node per topic filter
+ * level, '+' and '#' levels included. A received publish message is then
+ * dispatched by walking the trie along the levels of its topic instead of
+ * matching the topic against every stored topic filter, so the cost depends
+ * on the depth of the topic rather than on the number of subscriptions.
+ */
+#ifndef mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE
+    #define mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE    ( 0 )
+#endif
+
+/**
+ * @brief Number of trie nodes available to the subscription manager.
+ *
+ * Only used if mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE is 1. Topic filters
+ * which start with the same levels share the nodes for those levels. The
+ * subscribe operation will fail if there are not enough free nodes left to
+ * store the levels of the topic filter.
+ */
+#ifndef mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES
+    #define mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES    ( mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS * 4 )
+#endif
+
+/**
+ * @brief Largest publish payload which is copied into the packet buffer.
+ *
+ * Larger payloads are not copied: the fixed header, topic and packet
+ * identifier are transmitted from the packet buffer and the payload is then
+ * transmitted directly from the memory supplied in MQTTPublishParams_t.
+ * Smaller payloads are copied so that the whole packet goes out in a single
+ * call to the send callback, as every call may cost a TLS record and a
+ * round trip to the network interface.
+ */
+#ifndef mqttconfigPUBLISH_COPY_THRESHOLD
+    #define mqttconfigPUBLISH_COPY_THRESHOLD    ( 128 )
+#endif
+
+/**
+ * @brief Maximum number of QoS1 publishes which can be waiting for PUBACK.
+ *
+ * MQTT_Publish returns eMQTTPublishWindowFull for a QoS1 publish while this
+ * many are waiting, so that the user can hold further publishes back until
+ * a PUBACK arrives or a publish times out. Set to 0 for no limit.
+ *
+ * It also bounds the cost of keeping the list of packets waiting for an ACK
+ * ordered by deadline, which is a linear search in the worst case.
+ */
+#ifndef mqttconfigPUBLISH_WINDOW_SIZE
+    #define mqttconfigPUBLISH_WINDOW_SIZE    ( 0 )
+#endif
+
+/**
+ * @brief Interval in ticks after which a QoS1 publish which has not been
+ * acknowledged is transmitted again with the DUP flag set.
+ *
+ * Retransmission continues at this interval until the PUBACK arrives or the
+ * timeout of the publish expires. Payloads which are not copied (see
+ * mqttconfigPUBLISH_COPY_THRESHOLD) are transmitted again from the memory
+ * supplied in MQTTPublishParams_t, which must therefore remain valid until
+ * the PUBACK or the timeout is reported. When enabled, the interval must be
+ * well above the round trip time to the broker, otherwise every publish is
+ * delivered twice. Set to 0 to disable retransmission.
+ */
+#ifndef mqttconfigPUBLISH_RETRANSMIT_TICKS
+    #define mqttconfigPUBLISH_RETRANSMIT_TICKS    ( 0 )
+#endif
+
+/**
+ * @brief Number of buckets of the index which finds the message an ACK
+ * acknowledges by its packet identifier.
+ *
+ * Must be a power of 2. Packet identifiers are taken modulo this number, so
+ * as long as no more messages than this are waiting for ACK, and they have
+ * consecutive identifiers, each ACK is matched without a search.
+ */
+#ifndef mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS
+    #define mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS    ( 8 )
+#endif
+
 /**
  * @brief Define mqttconfigASSERT to enable asserts.
  *
@@ -0,0 +1,74 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_offline_store_pal.h
+ * @brief Port specific persistent storage of the MQTT agent offline queue.
+ *
+ * The store is an area of mqttconfigMAX_BROKERS * mqttconfigOFFLINE_STORE_SIZE
+ * bytes which keeps its contents across a reset of the device, for example
+ * reserved flash.  Each connection of the MQTT agent uses its own
+ * mqttconfigOFFLINE_STORE_SIZE bytes of it.  Bytes which were never written may
+ * read back as any value.
+ */
+
+#ifndef _AWS_MQTT_OFFLINE_STORE_PAL_H_
+#define _AWS_MQTT_OFFLINE_STORE_PAL_H_
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* Standard includes. */
+#include <stdint.h>
+
+/**
+ * @brief Reads from the offline store.
+ *
+ * @param[in] ulOffset The offset in the store to read from.
+ * @param[out] pvData The buffer to read into.
+ * @param[in] ulLength The number of bytes to read.
+ *
+ * @return pdPASS if the bytes were read, pdFAIL otherwise.
+ */
+BaseType_t MQTT_OFFLINE_STORE_PAL_Read( uint32_t ulOffset,
+                                        void * pvData,
+                                        uint32_t ulLength );
+
+/**
+ * @brief Writes to the offline store.
+ *
+ * The bytes must have reached the store when the function returns.
+ *
+ * @param[in] ulOffset The offset in the store to write to.
+ * @param[in] pvData The bytes to write.
+ * @param[in] ulLength The number of bytes to write.
+ *
+ * @return pdPASS if the bytes were written, pdFAIL otherwise.
+ */
+BaseType_t MQTT_OFFLINE_STORE_PAL_Write( uint32_t ulOffset,
+                                         const void * pvData,
+                                         uint32_t ulLength );
+
+#endif /* _AWS_MQTT_OFFLINE_STORE_PAL_H_ */
@@ -0,0 +1,55 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file gcm_alt.h
+ * @brief GCM context used when mbedTLS is built with MBEDTLS_GCM_ALT.
+ *
+ * The functions are implemented in lib/crypto/aws_gcm_alt.c.
+ */
+
+#ifndef __GCM_ALT_H__
+#define __GCM_ALT_H__
+
+#include <stdint.h>
+
+/**
+ * @brief The GCM context structure.
+ */
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_cipher_context_t cipher_ctx;  /*!< The cipher context used. */
+    uint32_t HT[ 16 ][ 4 ];               /*!< Multiples of H for the 4-bit GHASH kernel. */
+    unsigned char H[ 16 ];                /*!< The hash key, for the accelerator. */
+    uint64_t len;                         /*!< The total length of the encrypted data. */
+    uint64_t add_len;                     /*!< The total length of the additional data. */
+    unsigned char base_ectr[ 16 ];        /*!< The first ECTR for tag. */
+    unsigned char y[ 16 ];                /*!< The Y working value. */
+    unsigned char buf[ 16 ];              /*!< The GHASH state. */
+    int mode;                             /*!< MBEDTLS_GCM_ENCRYPT or MBEDTLS_GCM_DECRYPT. */
+}
+mbedtls_gcm_context;
+
+#endif /* ifndef __GCM_ALT_H__ */
@@ -0,0 +1,53 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file sha256_alt.h
+ * @brief SHA-256 context used when mbedTLS is built with MBEDTLS_SHA256_ALT.
+ *
+ * The functions are implemented in lib/crypto/aws_sha256_alt.c.
+ */
+
+#ifndef __SHA256_ALT_H__
+#define __SHA256_ALT_H__
+
+#include <stdint.h>
+
+/**
+ * @brief The SHA-256 context structure.
+ *
+ * The layout is the one of the stock mbedTLS context, so the intermediate
+ * state can be handed to an accelerator as is.
+ */
+typedef struct mbedtls_sha256_context
+{
+    uint32_t total[ 2 ];          /*!< The number of Bytes processed. */
+    uint32_t state[ 8 ];          /*!< The intermediate digest state. */
+    unsigned char buffer[ 64 ];   /*!< The data block being processed. */
+    int is224;                    /*!< 0: SHA-256, or 1: SHA-224. */
+}
+mbedtls_sha256_context;
+
+#endif /* ifndef __SHA256_ALT_H__ */
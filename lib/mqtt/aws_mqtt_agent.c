@@ -49,6 +49,27 @@
 /* Standard includes. */
 #include <string.h>
 
+#if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+    #if ( mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE > mqttconfigTX_COALESCE_BUFFER_SIZE )
+        #error "mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE must not be more than mqttconfigTX_COALESCE_BUFFER_SIZE."
+    #endif
+
+    #if ( mqttconfigMAX_PARALLEL_OPS > 32 )
+        #error "mqttconfigMAX_PARALLEL_OPS must not be more than 32 when mqttconfigTX_COALESCE_BUFFER_SIZE is set."
+    #endif
+#endif
+
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+    #if ( mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH > mqttconfigPUBLISH_COPY_THRESHOLD )
+        #error "mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH must not be more than mqttconfigPUBLISH_COPY_THRESHOLD."
+    #endif
+
+    #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+        /* Offline store includes. */
+        #include "aws_mqtt_offline_store_pal.h"
+    #endif
+#endif
+
 /**
  * @brief The length of the command queue used to send commands from application
  * tasks to the MQTT task.
@@ -125,6 +146,57 @@
  * it to the user as an opaque handle.
  */
 #define mqttDECODE_BROKER_NUMBER( xBrokerNumber )    ( ( UBaseType_t ) xBrokerNumber - ( UBaseType_t ) 1 )
+
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+
+/**
+ * @defgroup OfflineQueue Macros related to the offline queue.
+ *
+ * Each publish in the offline queue is stored as a record made of the topic
+ * length and the data length, 2 bytes each, followed by the topic and the data.
+ * The records of a connection are kept in order, oldest first, in its persistent
+ * store and then in its RAM queue.
+ */
+/** @{ */
+    #define mqttOFFLINE_RECORD_HEADER_LENGTH    ( 2UL * sizeof( uint16_t ) )
+    #define mqttOFFLINE_RECORD_MAX_LENGTH       ( mqttOFFLINE_RECORD_HEADER_LENGTH + ( uint32_t ) mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH + ( uint32_t ) mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH )
+
+/**
+ * @brief The length of a record, given its topic length and data length.
+ *
+ * @param[in] pusLengths The topic length and the data length.
+ */
+    #define mqttOFFLINE_RECORD_LENGTH( pusLengths )    ( mqttOFFLINE_RECORD_HEADER_LENGTH + ( uint32_t ) ( pusLengths )[ 0 ] + ( uint32_t ) ( pusLengths )[ 1 ] )
+
+/**
+ * @brief Kept in place of the packet identifier of a publish sent from the
+ * offline queue, to mark that it must be sent (again) or that it was
+ * acknowledged before the publishes in front of it.
+ */
+    #define mqttOFFLINE_SEND     ( ( uint16_t ) 0x0000U )
+    #define mqttOFFLINE_ACKED    ( ( uint16_t ) 0xFFFFU )
+
+    #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+/**
+ * @brief Identifies a valid header at the start of the persistent store of a
+ * connection.
+ */
+        #define mqttOFFLINE_STORE_MAGIC    ( 0x4F51544DUL )
+
+/**
+ * @brief The offset in the offline store of a position in the records of a
+ * connection.
+ *
+ * @param[in] pxConnection The connection.
+ * @param[in] ulOffset The offset from the first record of the connection.
+ */
+        #define mqttOFFLINE_STORE_OFFSET( pxConnection, ulOffset )                                                        \
+    ( ( ( uint32_t ) ( ( pxConnection ) - xMQTTConnections ) * ( uint32_t ) mqttconfigOFFLINE_STORE_SIZE ) + \
+      ( uint32_t ) sizeof( MQTTOfflineStoreHeader_t ) + ( ulOffset ) )
+    #endif /* mqttconfigOFFLINE_STORE_SIZE */
+/** @} */
+#endif /* mqttconfigOFFLINE_QUEUE_SIZE */
 /*-----------------------------------------------------------*/
 
 /**
@@ -135,9 +207,9 @@ typedef enum
     eMQTTServiceSocket = 0,  /**< See if any of the active connections need servicing. */
     eMQTTConnectRequest,     /**< Initiate a connection to an MQTT broker. */
     eMQTTDisconnectRequest,  /**< Disconnect the connection to an MQTT broker. */
-    eMQTTSubscribeRequest,   /**< Initiate a subscribe to a topic.  _TODO_ Currently limited to one topic per subscribe message. */
-    eMQTTUnsubscribeRequest, /**< Initiate unsubscribe from a topic.  _TODO_ Currently limited to one topic per unsubscribe message. */
-    eMQTTPublishRequest      /**< Initiate a publish to a topic.  _TODO_ Currently limited to one topic per publish message. */
+    eMQTTSubscribeRequest,   /**< Initiate a subscribe to one or more topics. */
+    eMQTTUnsubscribeRequest, /**< Initiate unsubscribe from one or more topics. */
+    eMQTTPublishRequest      /**< Initiate a publish to a topic. */
 } MQTTAction_t;
 
 /**
@@ -164,7 +236,8 @@ typedef enum
     eMQTTBufferAdded = 28,                /**< Provided buffer was successfully added to the MQTT core library. */
     eMQTTBufferCouldNotBeAdded = 30,      /**< Provided buffer could not be added to the MQTT library. */
     eMQTTOperationTimedOut = 32,          /**< The requested operation could not be completed within the specified time. */
-    eMQTTClientGotDisconnected = 34       /**< The MQTT client got disconnect in the middle of an operation. */
+    eMQTTClientGotDisconnected = 34,      /**< The MQTT client got disconnect in the middle of an operation. */
+    eMQTTPUBQueued = 36                   /**< PUBLISH message stored in the offline queue, to be sent once connected. */
 } MQTTNotifyCodes_t;
 
 /**
@@ -173,8 +246,11 @@ typedef enum
  */
 typedef struct MQTTNotificationData
 {
-    TaskHandle_t xTaskToNotify;   /**< The handle of the task to notify. */
-    uint32_t ulMessageIdentifier; /**< Used to match a request going from application task to MQTT task with response going the other way. */
+    TaskHandle_t xTaskToNotify;                         /**< The handle of the task to notify. */
+    uint32_t ulMessageIdentifier;                       /**< Used to match a request going from application task to MQTT task with response going the other way. */
+    MQTTAgentCompletionCallback_t pxCompletionCallback; /**< If not NULL, invoked instead of notifying xTaskToNotify. Set for asynchronous operations. */
+    void * pvCallbackContext;                           /**< Passed to pxCompletionCallback. */
+    MQTTSubACKReturnCode_t * pxSubACKReturnCodes;       /**< Receives the return code of each topic filter of a subscribe from the SUBACK. NULL if not wanted, and for other operations. */
 } MQTTNotificationData_t;
 
 /**
@@ -191,16 +267,35 @@ typedef struct MQTTEventData
     MQTTNotificationData_t xNotificationData; /**< Information used to notify the task that initiated the operation when the operation is complete. */
     TimeOut_t xEventCreationTimestamp;        /**< Timestamp when this event was created. */
     TickType_t xTicksToWait;                  /**< Time in tick counts after which the operation should fail. */
+    uint32_t ulTopicCount;                    /**< The number of topic filters in a subscribe or unsubscribe. */
     /* Only one of the following is relevant based on the value of xEventType. */
     union
     {
         const MQTTAgentConnectParams_t * pxConnectParams;         /**< Connect Parameters. */
-        const MQTTAgentSubscribeParams_t * pxSubscribeParams;     /**< Subscribe Parameters. */
-        const MQTTAgentUnsubscribeParams_t * pxUnsubscribeParams; /**< Unsubscribe Parameters. */
+        const MQTTAgentSubscribeParams_t * pxSubscribeParams;     /**< Subscribe Parameters, one per topic filter. */
+        const MQTTAgentUnsubscribeParams_t * pxUnsubscribeParams; /**< Unsubscribe Parameters, one per topic filter. */
         const MQTTAgentPublishParams_t * pxPublishParams;         /**< Publish Parameters. */
     } u;
 } MQTTEventData_t;
 
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+/**
+ * @brief Kept at the start of the persistent store of each connection to
+ * describe the records which follow it.
+ *
+ * It is only written when records are moved to the store and when the store
+ * has been emptied, so ulHead may lag behind the records which were sent.
+ */
+    typedef struct MQTTOfflineStoreHeader
+    {
+        uint32_t ulMagic;   /**< mqttOFFLINE_STORE_MAGIC if the header is valid. */
+        uint32_t ulHead;    /**< Offset of the oldest record. */
+        uint32_t ulTail;    /**< Offset just past the newest record. */
+        uint32_t ulRecords; /**< Number of records. */
+    } MQTTOfflineStoreHeader_t;
+#endif
+
 /**
  * @brief Contains the state of a connection to MQTT broker.
  *
@@ -217,7 +312,33 @@ typedef struct MQTTBrokerConnection
     MQTTAgentCallback_t pxCallback;                                     /**< The callback to notify user of various events including the Publish messages received from the broker. */
     UBaseType_t uxFlags;                                                /**< Various properties of the connection - secured etc. */
     BaseType_t xConnectionInUse;                                        /**< Tracks whether or not the connection is in use. It is accessed from application tasks (prvGetFreeConnection and prvReturnConnection) and hence should be accessed in critical section. */
+    BaseType_t xWakeupCallbackSet;                                      /**< Whether the socket wakes the MQTT task when data is received, in which case the socket need not be polled. */
     uint8_t ucRxBuffer[ mqttconfigRX_BUFFER_SIZE ];                     /**< Buffers incoming messages. */
+    MQTTEventData_t xHeldPublish;                                       /**< A QoS1 publish which found the publish window or xWaitingTasks full, waiting for room. */
+    BaseType_t xPublishHeld;                                            /**< Whether xHeldPublish is valid. */
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        uint8_t ucTxBuffer[ mqttconfigTX_COALESCE_BUFFER_SIZE ];        /**< Collects the packets sent during one pass of the MQTT task so that they go out in one SOCKETS_Send. */
+        uint32_t ulTxBufferedLength;                                    /**< Number of bytes in ucTxBuffer. */
+        BaseType_t xTxBufferLost;                                       /**< Set if bytes in ucTxBuffer could not be sent, which leaves the connection unusable. */
+        uint32_t ulTxBufferPublishes;                                   /**< Bit x is set if xWaitingTasks[ x ] is a QoS0 publish in ucTxBuffer, reported once ucTxBuffer is sent. */
+    #endif
+    #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+        uint8_t ucOfflineQueue[ mqttconfigOFFLINE_QUEUE_SIZE ];         /**< Records of the QoS1 publishes to send once connected, newer than those in the persistent store. */
+        uint32_t ulOfflineQueueHead;                                    /**< Offset of the oldest record in ucOfflineQueue. */
+        uint32_t ulOfflineQueueTail;                                    /**< Offset just past the newest record in ucOfflineQueue. */
+        uint32_t ulOfflineQueueRecords;                                 /**< Number of records in ucOfflineQueue. */
+        uint16_t usOfflineInFlight[ mqttconfigMAX_PARALLEL_OPS ];       /**< For each of the oldest records, in order, the packet identifier it was sent with, mqttOFFLINE_SEND or mqttOFFLINE_ACKED. */
+        uint32_t ulOfflineInFlight;                                     /**< Number of valid entries in usOfflineInFlight. */
+        uint8_t ucInFlightPublishes[ mqttconfigMAX_PARALLEL_OPS ][ mqttOFFLINE_RECORD_MAX_LENGTH ]; /**< For each entry of xWaitingTasks, a record of the QoS1 publish waiting for PUBACK, stored in the offline queue if the connection drops. */
+        uint32_t ulInFlightPublishOrder[ mqttconfigMAX_PARALLEL_OPS ];  /**< For each entry of ucInFlightPublishes, the order in which it was sent, or 0 if it holds no publish. */
+        uint32_t ulNextInFlightPublishOrder;                            /**< The order given to the last publish copied to ucInFlightPublishes. */
+        #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+            uint32_t ulOfflineStoreHead;                                /**< Offset of the oldest record in the persistent store. */
+            uint32_t ulOfflineStoreTail;                                /**< Offset just past the newest record in the persistent store. */
+            uint32_t ulOfflineStoreRecords;                             /**< Number of records in the persistent store. */
+            uint8_t ucOfflineRecord[ mqttOFFLINE_RECORD_MAX_LENGTH ];   /**< A record read from the persistent store to be sent. */
+        #endif
+    #endif
 } MQTTBrokerConnection_t;
 /*-----------------------------------------------------------*/
 
@@ -266,6 +387,16 @@ static TaskHandle_t xMQTTTaskHandle = NULL;
  * MQTT task.
  */
 static uint32_t ulQueueMessageIdentifier = 0;
+
+#if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+
+/**
+ * @brief Set while the MQTT task processes a batch of commands and services the
+ * connections, during which sent packets are collected in the Tx buffer of each
+ * connection instead of being sent straight away.  Only accessed by the MQTT task.
+ */
+    static BaseType_t xCoalesceSends = pdFALSE;
+#endif
 /*-----------------------------------------------------------*/
 
 /**
@@ -284,6 +415,50 @@ static uint32_t prvMQTTSendCallback( void * pvSendContext,
                                      const uint8_t * const pucData,
                                      uint32_t ulDataLength );
 
+/**
+ * @brief Sends bytes on the socket of a connection, retrying until all are sent or
+ * mqttconfigTCP_SEND_TIMEOUT_MS elapses.
+ *
+ * @param[in] pxConnection The connection to send on.
+ * @param[in] pucData The data to transmit.
+ * @param[in] ulDataLength Length of the data.
+ *
+ * @return The number of actually transmitted bytes.
+ */
+static uint32_t prvSocketSend( MQTTBrokerConnection_t * const pxConnection,
+                               const uint8_t * const pucData,
+                               uint32_t ulDataLength );
+
+#if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+
+/**
+ * @brief Sends the packets collected in the Tx buffer of a connection.
+ *
+ * If they cannot all be sent, xTxBufferLost is set as the MQTT library has already
+ * been told they were.  Either way the QoS0 publishes which were in the buffer are
+ * then reported to the tasks which made them.
+ *
+ * @param[in] pxConnection The connection whose Tx buffer to send.
+ *
+ * @return pdPASS if the Tx buffer was sent or empty, pdFAIL otherwise.
+ */
+    static BaseType_t prvFlushTxBuffer( MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Reports a QoS0 publish as sent once the packet has left the Tx buffer.
+ *
+ * If the packet is still in the Tx buffer of the connection, the notification data
+ * is stored and the publish is reported when the buffer is sent.  If there is no
+ * free buffer to store the notification data in, the Tx buffer is sent straight
+ * away instead.
+ *
+ * @param[in] pxConnection The connection the publish was made on.
+ * @param[in] pxEventData The publish command.
+ */
+    static void prvNotifyPublishSent( MQTTBrokerConnection_t * const pxConnection,
+                                      MQTTEventData_t * const pxEventData );
+#endif
+
 /**
  * @brief The callback registered with the core MQTT library to receive various MQTT events.
  *
@@ -504,6 +679,17 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
                                      MQTTNotifyCodes_t xNotificationCode,
                                      UBaseType_t uxStatus );
 
+/**
+ * @brief Decodes the notification value sent by prvNotifyRequestingTask into
+ * the return code of the operation.
+ *
+ * @param[in] ulNotificationValue The notification value.
+ *
+ * @return eMQTTAgentSuccess if the operation passed, eMQTTAgentTimeout if it
+ * timed out and eMQTTAgentFailure otherwise.
+ */
+static MQTTAgentReturnCode_t prvGetReturnCode( uint32_t ulNotificationValue );
+
 /**
  * @brief Called on each iteration of the MQTT task to service connected sockets.
  *
@@ -515,6 +701,21 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
  */
 static TickType_t prvManageConnections( void );
 
+/**
+ * @brief Checks whether the socket of a connected client must be polled.
+ *
+ * Data can only arrive from the broker while a packet is waiting for its ACK,
+ * while a PINGREQ is waiting for its PINGRESP or, once subscribed, as a
+ * publish message.  If none of those is possible, or the socket wakes the MQTT
+ * task when data is received, the MQTT task can block until the next deadline
+ * of MQTT_Periodic instead of waking every mqttconfigMQTT_TASK_MAX_BLOCK_TICKS.
+ *
+ * @param[in] pxConnection The connection to check.
+ *
+ * @return pdTRUE if the socket must be polled, pdFALSE otherwise.
+ */
+static BaseType_t prvConnectionNeedsPolling( const MQTTBrokerConnection_t * const pxConnection );
+
 /**
  * @brief Initiates the MQTT Connect operation.
  *
@@ -580,10 +781,25 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData );
  * library. If that fails, it informs the application task and frees the buffer used to
  * store the notification data.
  *
+ * A QoS1 publish on a connected client which finds no free buffer, or finds
+ * mqttconfigPUBLISH_WINDOW_SIZE publishes waiting for PUBACK, is held in
+ * xHeldPublish instead of failing, and is retried by prvRetryHeldPublishes.
+ *
  * @param[in] pxEventData The event data as posted by application task to the command queue.
  */
 static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData );
 
+/**
+ * @brief Retries the publishes held by prvInitiateMQTTPublish.
+ *
+ * A held publish which has timed out in the meantime is failed with
+ * eMQTTOperationTimedOut.
+ *
+ * @return The number of ticks after which the earliest held publish times
+ * out, portMAX_DELAY if no publish is held any more.
+ */
+static TickType_t prvRetryHeldPublishes( void );
+
 /*
  * @brief Posts the event to the command queue and waits for the notification from the MQTT task.
  *
@@ -605,12 +821,204 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData );
  */
 static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEventData );
 
+/**
+ * @brief Sends the command to the MQTT task and returns without waiting for the
+ * result.
+ *
+ * The result is reported by invoking pxCompletionCallback from the MQTT task.
+ * The calling task's notification state is not used, so this may also be called
+ * from the MQTT task, in which case it does not wait for space in the command
+ * queue.
+ *
+ * @param[in] pxEventData The Event to be sent to the command queue.
+ * @param[in] pxCompletionCallback The callback to invoke when the operation completes.
+ * @param[in] pvCallbackContext Passed to pxCompletionCallback.
+ * @param[out] pxRequestHandle Receives the message identifier of the command. May be NULL.
+ *
+ * @return eMQTTAgentSuccess if the command was queued, eMQTTAgentFailure otherwise.
+ */
+static MQTTAgentReturnCode_t prvSendAsyncCommandToMQTTTask( MQTTEventData_t * pxEventData,
+                                                            MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                                            void * pvCallbackContext,
+                                                            MQTTAgentRequestHandle_t * const pxRequestHandle );
+
+/**
+ * @brief Returns the next message identifier to use for a command.
+ *
+ * A single identifier sequence is shared by all connections and tasks.
+ *
+ * @return The message identifier, which only uses the top 16-bits.
+ */
+static uint32_t prvGetNextMessageIdentifier( void );
+
+/**
+ * @brief Processes one command received from the command queue.
+ *
+ * @param[in] pxCommand The command to process.
+ */
+static void prvProcessCommand( MQTTEventData_t * const pxCommand );
+
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+
+/**
+ * @brief Returns the number of records in the offline queue of a connection,
+ * including those in its persistent store.
+ *
+ * @param[in] pxConnection The connection.
+ *
+ * @return The number of records.
+ */
+    static uint32_t prvOfflineQueueCount( const MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Appends a publish to the offline queue of a connection.
+ *
+ * If the RAM queue is full, its records are moved to the persistent store
+ * first.
+ *
+ * @param[in] pxConnection The connection.
+ * @param[in] pxPublishParams The publish to store.
+ *
+ * @return pdPASS if the publish was stored, pdFAIL if it is too large or there
+ * is no room for it.
+ */
+    static BaseType_t prvOfflineQueuePush( MQTTBrokerConnection_t * const pxConnection,
+                                           const MQTTAgentPublishParams_t * const pxPublishParams );
+
+/**
+ * @brief Keeps a copy of a QoS1 publish which is about to be sent, to store in
+ * the offline queue if the connection drops before its PUBACK arrives.
+ *
+ * The parameters supplied by the application need not stay valid after the
+ * publish is sent, hence the copy.  Publishes which are too large for the offline
+ * queue are not copied.
+ *
+ * @param[in] pxConnection The connection.
+ * @param[in] uxIndex The index in xWaitingTasks of the notification data of the
+ * publish.
+ * @param[in] pxPublishParams The publish.
+ */
+    static void prvOfflineCopyInFlightPublish( MQTTBrokerConnection_t * const pxConnection,
+                                               UBaseType_t uxIndex,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams );
+
+/**
+ * @brief Moves the copies of the QoS1 publishes still waiting for PUBACK to the
+ * offline queue of a connection which got disconnected.
+ *
+ * They are moved in the order in which they were sent, so that they are sent in
+ * that order again once connected.  The task which made each publish is notified
+ * whether it was queued.
+ *
+ * @param[in] pxConnection The connection.
+ */
+    static void prvOfflineQueueInFlightPublishes( MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Gets the topic and data of a record in the offline queue of a
+ * connection.
+ *
+ * @param[in] pxConnection The connection.
+ * @param[in] ulIndex The index of the record, 0 being the oldest.
+ * @param[out] pxPublishParams Receives the topic and the data, which stay valid
+ * until the queue is changed.
+ *
+ * @return pdPASS if the record was found, pdFAIL otherwise.
+ */
+    static BaseType_t prvOfflineQueuePeek( MQTTBrokerConnection_t * const pxConnection,
+                                           uint32_t ulIndex,
+                                           MQTTPublishParams_t * const pxPublishParams );
+
+/**
+ * @brief Removes the oldest record from the offline queue of a connection.
+ *
+ * @param[in] pxConnection The connection.
+ */
+    static void prvOfflineQueuePop( MQTTBrokerConnection_t * const pxConnection );
+
+    #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+/**
+ * @brief Reads the header of the persistent store of a connection to find the
+ * records left in it.
+ *
+ * @param[in] pxConnection The connection.
+ */
+        static void prvOfflineStoreLoad( MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Moves the records of the RAM queue of a connection to its persistent
+ * store.
+ *
+ * @param[in] pxConnection The connection.
+ *
+ * @return pdPASS if the records were moved, pdFAIL if they do not fit or could
+ * not be written.
+ */
+        static BaseType_t prvOfflineStoreSpill( MQTTBrokerConnection_t * const pxConnection );
+
+/**
+ * @brief Writes the header of the persistent store of a connection.
+ *
+ * @param[in] pxConnection The connection.
+ *
+ * @return pdPASS if the header was written, pdFAIL otherwise.
+ */
+        static BaseType_t prvOfflineStoreWriteHeader( const MQTTBrokerConnection_t * const pxConnection );
+    #endif /* mqttconfigOFFLINE_STORE_SIZE */
+
+/**
+ * @brief Stores a publish in the offline queue if it must not be sent now.
+ *
+ * QoS1 publishes go to the offline queue while the connection is not established,
+ * and while the queue is not empty so that they stay behind the publishes already
+ * in it.  The task which initiated the publish is informed of the result.
+ *
+ * @param[in] pxEventData The publish event.
+ *
+ * @return pdTRUE if the publish was handled here, pdFALSE if it is to be sent.
+ */
+    static BaseType_t prvQueueOfflinePublish( MQTTEventData_t * const pxEventData );
+
+/**
+ * @brief Sends the oldest publishes of the offline queue of each connected
+ * client which are not waiting for PUBACK, as far as the publish window allows.
+ *
+ * @return pdTRUE if any publish was sent, pdFALSE otherwise.
+ */
+    static BaseType_t prvSendOfflinePublishes( void );
+
+/**
+ * @brief Removes the publishes acknowledged by a PUBACK from the offline queue.
+ *
+ * Publishes are removed in order, so one acknowledged before those in front of
+ * it is removed along with them.
+ *
+ * @param[in] pxConnection The connection on which the PUBACK was received.
+ * @param[in] usPacketIdentifier The packet identifier of the PUBACK.
+ */
+    static void prvProcessOfflinePublishAck( MQTTBrokerConnection_t * const pxConnection,
+                                             uint16_t usPacketIdentifier );
+
+/**
+ * @brief Marks a publish from the offline queue which timed out to be sent again.
+ *
+ * @param[in] pxConnection The connection on which the publish timed out.
+ * @param[in] usPacketIdentifier The packet identifier of the publish.
+ */
+    static void prvProcessOfflinePublishTimeout( MQTTBrokerConnection_t * const pxConnection,
+                                                 uint16_t usPacketIdentifier );
+#endif /* mqttconfigOFFLINE_QUEUE_SIZE */
+
 /**
  * @brief Implements the task that manages the MQTT protocol.
  *
- * This function reads messages from the command queue and processes them.
- * It wakes up periodically and calls prvManageConnections() in order to
- * ensure regular timeout and keep alive processing by the MQTT Core library.
+ * Each time it wakes up, this function processes up to
+ * mqttconfigMQTT_TASK_MAX_COMMANDS_PER_WAKEUP commands from the command queue and
+ * then calls prvManageConnections() once, in order to receive data and ensure
+ * regular timeout and keep alive processing by the MQTT Core library.  The packets
+ * sent meanwhile go out together once it is done, see
+ * mqttconfigTX_COALESCE_BUFFER_SIZE.
  *
  * @param[in] pvParameters The parameters as specified when creating the task, NULL in this case.
  */
@@ -623,20 +1031,70 @@ static uint32_t prvMQTTSendCallback( void * pvSendContext,
 {
     MQTTBrokerConnection_t * pxConnection;
     UBaseType_t uxBrokerNumber = ( UBaseType_t ) pvSendContext; /*lint !e923 The cast is ok as we passed the index of the client before. */
-    int32_t lSendRetVal;
     uint32_t ulBytesSent = 0;
-    TimeOut_t xTimestamp;
-    TickType_t xTicksToWait = pdMS_TO_TICKS( mqttconfigTCP_SEND_TIMEOUT_MS );
+    BaseType_t xSendNow = pdTRUE;
 
     /* Broker number must be valid. */
     configASSERT( uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
 
-    /* Record the timestamp when this function was called. */
-    vTaskSetTimeOutState( &( xTimestamp ) );
-
     /* Get the actual connection to the broker. */
     pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
 
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        if( pxConnection->xTxBufferLost == pdTRUE )
+        {
+            /* Part of an earlier packet never went out, so the broker would
+             * misread anything sent after it.  Report this packet as not sent
+             * either - the MQTT task disconnects at the end of this pass. */
+            xSendNow = pdFALSE;
+        }
+        else if( xCoalesceSends == pdTRUE )
+        {
+            /* Send what was collected first if this segment is not collected
+             * or does not fit behind it, so that the packets stay in order. */
+            if( ( ulDataLength > ( uint32_t ) mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE ) ||
+                ( ( pxConnection->ulTxBufferedLength + ulDataLength ) > ( uint32_t ) mqttconfigTX_COALESCE_BUFFER_SIZE ) )
+            {
+                if( prvFlushTxBuffer( pxConnection ) == pdFAIL )
+                {
+                    xSendNow = pdFALSE;
+                }
+            }
+
+            /* Only collect short segments such as packet headers and ACKs.
+             * Larger segments, such as publish payloads, are sent from the
+             * memory they are in rather than being copied once more. */
+            if( ( xSendNow == pdTRUE ) && ( ulDataLength <= ( uint32_t ) mqttconfigTX_COALESCE_MAX_SEGMENT_SIZE ) )
+            {
+                memcpy( &( pxConnection->ucTxBuffer[ pxConnection->ulTxBufferedLength ] ), pucData, ( size_t ) ulDataLength );
+                pxConnection->ulTxBufferedLength += ulDataLength;
+                ulBytesSent = ulDataLength;
+                xSendNow = pdFALSE;
+            }
+        }
+    #endif /* mqttconfigTX_COALESCE_BUFFER_SIZE */
+
+    if( xSendNow == pdTRUE )
+    {
+        ulBytesSent = prvSocketSend( pxConnection, pucData, ulDataLength );
+    }
+
+    return ulBytesSent;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSocketSend( MQTTBrokerConnection_t * const pxConnection,
+                               const uint8_t * const pucData,
+                               uint32_t ulDataLength )
+{
+    int32_t lSendRetVal;
+    uint32_t ulBytesSent = 0;
+    TimeOut_t xTimestamp;
+    TickType_t xTicksToWait = pdMS_TO_TICKS( mqttconfigTCP_SEND_TIMEOUT_MS );
+
+    /* Record the timestamp when this function was called. */
+    vTaskSetTimeOutState( &( xTimestamp ) );
+
     /* Keep re-trying until timeout or any error
      * other than SOCKETS_EWOULDBLOCK occurs. */
     while( ulBytesSent < ulDataLength )
@@ -675,6 +1133,98 @@ static uint32_t prvMQTTSendCallback( void * pvSendContext,
     return ulBytesSent;
 }
 /*-----------------------------------------------------------*/
+
+#if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+
+    static BaseType_t prvFlushTxBuffer( MQTTBrokerConnection_t * const pxConnection )
+    {
+        BaseType_t xStatus = pdPASS;
+        UBaseType_t x;
+        uint32_t ulPublishes = pxConnection->ulTxBufferPublishes;
+
+        if( pxConnection->ulTxBufferedLength > 0U )
+        {
+            if( prvSocketSend( pxConnection, pxConnection->ucTxBuffer, pxConnection->ulTxBufferedLength ) != pxConnection->ulTxBufferedLength )
+            {
+                /* The MQTT library considers these packets sent, and the
+                 * broker may have received part of them. */
+                pxConnection->xTxBufferLost = pdTRUE;
+                xStatus = pdFAIL;
+            }
+
+            pxConnection->ulTxBufferedLength = 0;
+        }
+
+        /* Now that the outcome is known, report the QoS0 publishes which were
+         * in the buffer.  Each is reported here and nowhere else, as its
+         * notification data is freed by the report. */
+        pxConnection->ulTxBufferPublishes = 0;
+
+        for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; x++ )
+        {
+            if( ( ulPublishes & ( 1UL << x ) ) != 0U )
+            {
+                if( xStatus == pdPASS )
+                {
+                    prvNotifyRequestingTask( &( pxConnection->xWaitingTasks[ x ] ), eMQTTPUBSent, pdPASS );
+                }
+                else
+                {
+                    prvNotifyRequestingTask( &( pxConnection->xWaitingTasks[ x ] ), eMQTTPUBCouldNotBeSent, pdFAIL );
+                }
+            }
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvNotifyPublishSent( MQTTBrokerConnection_t * const pxConnection,
+                                      MQTTEventData_t * const pxEventData )
+    {
+        MQTTNotificationData_t * pxNotificationData = NULL;
+
+        /* The send callback only leaves bytes in the Tx buffer when the last
+         * segment of the publish went into it. */
+        if( pxConnection->ulTxBufferedLength > 0U )
+        {
+            pxNotificationData = prvStoreNotificationData( pxConnection, pxEventData );
+
+            /* Storing the notification data may have sent the Tx buffer to
+             * free a buffer for it, in which case report the publish now. */
+            if( ( pxNotificationData != NULL ) && ( pxConnection->ulTxBufferedLength > 0U ) )
+            {
+                pxConnection->ulTxBufferPublishes |= ( 1UL << ( uint32_t ) ( pxNotificationData - pxConnection->xWaitingTasks ) );
+            }
+            else
+            {
+                if( pxNotificationData != NULL )
+                {
+                    pxNotificationData->xTaskToNotify = NULL;
+                    pxNotificationData = NULL;
+                }
+
+                ( void ) prvFlushTxBuffer( pxConnection );
+            }
+        }
+
+        /* xTxBufferLost stays set until the MQTT task disconnects at the end
+         * of this pass, so it tells whether the publish went out. */
+        if( pxNotificationData == NULL )
+        {
+            if( pxConnection->xTxBufferLost == pdFALSE )
+            {
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBSent, pdPASS );
+            }
+            else
+            {
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBCouldNotBeSent, pdFAIL );
+            }
+        }
+    }
+
+#endif /* mqttconfigTX_COALESCE_BUFFER_SIZE */
+/*-----------------------------------------------------------*/
 static MQTTBool_t prvMQTTEventCallback( void * pvCallbackContext,
                                         const MQTTEventCallbackParams_t * const pxParams )
 {
@@ -812,27 +1362,56 @@ static MQTTNotificationData_t * prvStoreNotificationData( MQTTBrokerConnection_t
     {
         if( pxConnection->xWaitingTasks[ x ].xTaskToNotify == NULL )
         {
-            /* We found one unused buffer - copy the notification data
-             * and return. */
+            /* We found one unused buffer. */
             pxNotificationData = &( pxConnection->xWaitingTasks[ x ] );
-            memcpy( pxNotificationData, &( pxEventData->xNotificationData ), sizeof( MQTTNotificationData_t ) );
             break;
         }
     }
 
-    return pxNotificationData;
-}
-/*-----------------------------------------------------------*/
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        if( ( pxNotificationData == NULL ) && ( pxConnection->ulTxBufferPublishes != 0U ) )
+        {
+            /* Sending the Tx buffer frees the buffers of the QoS0 publishes in
+             * it, so do that rather than let them hold up this operation. */
+            x = 0;
 
-static MQTTNotificationData_t * prvRetrieveNotificationData( MQTTBrokerConnection_t * const pxConnection,
-                                                             uint16_t usPacketIdentifier )
-{
-    UBaseType_t x;
-    MQTTNotificationData_t * pxNotificationData = NULL;
+            while( ( pxConnection->ulTxBufferPublishes & ( 1UL << x ) ) == 0U )
+            {
+                x++;
+            }
 
-    /* Iterate over all the buffers to see if there is one matching the
-     * packet identifier. Note that the packet identifier constitutes of the
-     * top 16 bits of the message identifier stored in the notification data. */
+            ( void ) prvFlushTxBuffer( pxConnection );
+            pxNotificationData = &( pxConnection->xWaitingTasks[ x ] );
+        }
+    #endif
+
+    if( pxNotificationData != NULL )
+    {
+        /* Copy the notification data and return. */
+        memcpy( pxNotificationData, &( pxEventData->xNotificationData ), sizeof( MQTTNotificationData_t ) );
+
+        /* Set by the caller for the subscribes which want them. */
+        pxNotificationData->pxSubACKReturnCodes = NULL;
+
+        #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+            /* Set by the caller for the publishes to queue on disconnect. */
+            pxConnection->ulInFlightPublishOrder[ x ] = 0;
+        #endif
+    }
+
+    return pxNotificationData;
+}
+/*-----------------------------------------------------------*/
+
+static MQTTNotificationData_t * prvRetrieveNotificationData( MQTTBrokerConnection_t * const pxConnection,
+                                                             uint16_t usPacketIdentifier )
+{
+    UBaseType_t x;
+    MQTTNotificationData_t * pxNotificationData = NULL;
+
+    /* Iterate over all the buffers to see if there is one matching the
+     * packet identifier. Note that the packet identifier constitutes of the
+     * top 16 bits of the message identifier stored in the notification data. */
     for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; x++ )
     {
         if( ( pxConnection->xWaitingTasks[ x ].xTaskToNotify != NULL ) &&
@@ -887,12 +1466,20 @@ static BaseType_t prvSetupConnection( const MQTTEventData_t * const pxEventData
         if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
         {
             /* Set a callback function that will unblock the MQTT task when data
-             * is received on a socket. */
-            ( void ) SOCKETS_SetSockOpt( pxConnection->xSocket,
-                                         0,                                            /* Level - Unused. */
-                                         SOCKETS_SO_WAKEUP_CALLBACK,
-                                         ( void * ) prvMQTTClientSocketWakeupCallback, /*lint !e9087 !e9074 The cast is ok as we are setting the callback here. */
-                                         sizeof( &( prvMQTTClientSocketWakeupCallback ) ) );
+             * is received on a socket. Not all the secure sockets ports support
+             * it, so remember whether the socket has to be polled instead. */
+            if( SOCKETS_SetSockOpt( pxConnection->xSocket,
+                                    0,                                            /* Level - Unused. */
+                                    SOCKETS_SO_WAKEUP_CALLBACK,
+                                    ( void * ) prvMQTTClientSocketWakeupCallback, /*lint !e9087 !e9074 The cast is ok as we are setting the callback here. */
+                                    sizeof( &( prvMQTTClientSocketWakeupCallback ) ) ) == SOCKETS_ERROR_NONE )
+            {
+                pxConnection->xWakeupCallbackSet = pdTRUE;
+            }
+            else
+            {
+                pxConnection->xWakeupCallbackSet = pdFALSE;
+            }
 
             /* Set secure socket option if it is a secured connection. */
             if( ( pxConnection->uxFlags & mqttCONNECTION_SECURED ) == mqttCONNECTION_SECURED )
@@ -1014,6 +1601,13 @@ static void prvGracefulSocketClose( MQTTBrokerConnection_t * const pxConnection
      * entered. */
     vTaskSetTimeOutState( &xTimeOut );
 
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        /* Send any collected packets, such as a DISCONNECT, before shutting
+         * the socket down. */
+        ( void ) prvFlushTxBuffer( pxConnection );
+        pxConnection->xTxBufferLost = pdFALSE;
+    #endif
+
     /* Shutdown the connection. */
     ( void ) SOCKETS_Shutdown( pxConnection->xSocket, SOCKETS_SHUT_RDWR );
 
@@ -1058,6 +1652,10 @@ static void prvMQTTClientSocketWakeupCallback( Socket_t pxSocket )
      * created! */
     configASSERT( xMQTTTaskHandle );
 
+    /* The MQTT task waits for a notification instead of a command while it
+     * holds a publish, see prvRetryHeldPublishes. */
+    ( void ) xTaskNotifyGive( xMQTTTaskHandle );
+
     /* A socket used by the MQTT task may need attention.  Send an event
      * to the MQTT task to make sure the task is not blocked on xCommandQueue.
      * There is only any need to do this if there are no messages already in the
@@ -1110,6 +1708,7 @@ static void prvProcessReceivedSUBACK( MQTTBrokerConnection_t * const pxConnectio
                                       const MQTTEventCallbackParams_t * const pxParams )
 {
     MQTTNotificationData_t * pxNotificationData;
+    uint32_t x;
 
     /* Retrieve the notification data for the task which initiated the Subscribe operation.*/
     pxNotificationData = prvRetrieveNotificationData( pxConnection, pxParams->u.xMQTTSubACKData.usPacketIdentifier );
@@ -1117,6 +1716,15 @@ static void prvProcessReceivedSUBACK( MQTTBrokerConnection_t * const pxConnectio
     /* If there is no task waiting for it, ignore it. */
     if( pxNotificationData != NULL )
     {
+        /* Pass on the return code of each topic filter, if wanted. */
+        if( pxNotificationData->pxSubACKReturnCodes != NULL )
+        {
+            for( x = 0; x < pxParams->u.xMQTTSubACKData.ulReturnCodeCount; x++ )
+            {
+                pxNotificationData->pxSubACKReturnCodes[ x ] = ( MQTTSubACKReturnCode_t ) pxParams->u.xMQTTSubACKData.pucReturnCodes[ x ];
+            }
+        }
+
         if( pxParams->u.xMQTTSubACKData.xSubACKReturnCode != eMQTTSubACKFailure )
         {
             mqttconfigDEBUG_LOG( ( "MQTT Subscribe was accepted. Subscribed.\r\n" ) );
@@ -1164,6 +1772,14 @@ static void prvProcessReceivedPUBACK( MQTTBrokerConnection_t * const pxConnectio
         mqttconfigDEBUG_LOG( ( "MQTT Publish was successful.\r\n" ) );
         prvNotifyRequestingTask( pxNotificationData, eMQTTPUBACKReceived, pdPASS );
     }
+
+    #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+        else
+        {
+            /* It may acknowledge a publish sent from the offline queue. */
+            prvProcessOfflinePublishAck( pxConnection, pxParams->u.xMQTTPubACKData.usPacketIdentifier );
+        }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -1205,6 +1821,14 @@ static void prvProcessReceivedTimeout( MQTTBrokerConnection_t * const pxConnecti
         mqttconfigDEBUG_LOG( ( "MQTT Timeout.\r\n" ) );
         prvNotifyRequestingTask( pxNotificationData, eMQTTOperationTimedOut, pdFAIL );
     }
+
+    #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+        else
+        {
+            /* It may be a publish sent from the offline queue. */
+            prvProcessOfflinePublishTimeout( pxConnection, pxParams->u.xTimeoutData.usPacketIdentifier );
+        }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -1238,7 +1862,20 @@ static void prvProcessReceivedDisconnect( MQTTBrokerConnection_t * const pxConne
      * therefore we won't unblock the task from here. Instead the
      * task calling MQTT_AGENT_Disconnect gets unblocked from
      * prvInitiateMQTTDisconnect and therefore receives a success
-     * return code. */
+     * return code. QoS1 publishes move to the offline queue instead
+     * of failing, if there is room for them. */
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        /* prvGracefulSocketClose sent the Tx buffer if the socket was still
+         * open.  Otherwise its QoS0 publishes are reported below with the
+         * rest. */
+        pxConnection->ulTxBufferedLength = 0;
+        pxConnection->ulTxBufferPublishes = 0;
+    #endif
+
+    #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+        prvOfflineQueueInFlightPublishes( pxConnection );
+    #endif
+
     for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; x++ )
     {
         if( pxConnection->xWaitingTasks[ x ].xTaskToNotify != NULL )
@@ -1248,6 +1885,12 @@ static void prvProcessReceivedDisconnect( MQTTBrokerConnection_t * const pxConne
                                      pdFAIL );
         }
     }
+
+    #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+        /* The publishes sent from the offline queue will not be acknowledged
+         * either, so send them all again once connected. */
+        pxConnection->ulOfflineInFlight = 0;
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -1255,7 +1898,9 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
                                      MQTTNotifyCodes_t xNotificationCode,
                                      UBaseType_t uxStatus )
 {
-    if( pxNotificationData->xTaskToNotify != NULL )
+    TaskHandle_t xTaskToNotify = pxNotificationData->xTaskToNotify;
+
+    if( xTaskToNotify != NULL )
     {
         /* ulMessageIdentifier only uses the top 16-bits.  The status code uses
          * the low 16-bits, of which the least significant bit is used to indicate
@@ -1266,12 +1911,79 @@ static void prvNotifyRequestingTask( MQTTNotificationData_t * const pxNotificati
         pxNotificationData->ulMessageIdentifier |= ( UBaseType_t ) xNotificationCode;
         pxNotificationData->ulMessageIdentifier |= uxStatus;
 
-        /* Notify the task. */
-        ( void ) xTaskNotify( pxNotificationData->xTaskToNotify, pxNotificationData->ulMessageIdentifier, eSetValueWithoutOverwrite );
-
-        /* Free up the buffer for further use. */
+        /* Free up the buffer for further use before invoking any completion
+         * callback, so that the callback can start another operation. */
         pxNotificationData->xTaskToNotify = NULL;
+
+        if( pxNotificationData->pxCompletionCallback != NULL )
+        {
+            /* Asynchronous operation - nobody is waiting for a notification.
+             * The buffer is only reused by commands the MQTT task processes
+             * after this one, so its other members are still intact. */
+            pxNotificationData->pxCompletionCallback( pxNotificationData->pvCallbackContext,
+                                                      pxNotificationData->ulMessageIdentifier & mqttMESSAGE_IDENTIFIER_MASK,
+                                                      prvGetReturnCode( pxNotificationData->ulMessageIdentifier ) );
+        }
+        else
+        {
+            /* Notify the task. */
+            ( void ) xTaskNotify( xTaskToNotify, pxNotificationData->ulMessageIdentifier, eSetValueWithoutOverwrite );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static MQTTAgentReturnCode_t prvGetReturnCode( uint32_t ulNotificationValue )
+{
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+
+    /* The low 16-bits contain a status code, of which the least significant
+     * bit is 1 (pdPASS) if the status code indicates a pass, and 0 (pdFAIL) if
+     * the status code indicates a fail. */
+    if( ( ulNotificationValue & mqttNOTIFICATION_STATUS_MASK ) != ( uint32_t ) pdPASS )
+    {
+        /* The operation failed. Check if the failure reason was timeout. */
+        if( ( ulNotificationValue & mqttNOTIFICATION_CODE_MASK ) == ( uint32_t ) eMQTTOperationTimedOut )
+        {
+            xReturnCode = eMQTTAgentTimeout;
+        }
+    }
+    else
+    {
+        xReturnCode = eMQTTAgentSuccess;
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvConnectionNeedsPolling( const MQTTBrokerConnection_t * const pxConnection )
+{
+    BaseType_t xNeedsPolling = pdFALSE;
+
+    if( ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) && ( pxConnection->xWakeupCallbackSet == pdFALSE ) )
+    {
+        /* Is any packet waiting for an ACK or a PINGRESP? */
+        if( ( !listIS_EMPTY( &( pxConnection->xMQTTContext.xTxBufferListHead ) ) ) ||
+            ( pxConnection->xMQTTContext.xWaitingForPingResp == eMQTTTrue ) )
+        {
+            xNeedsPolling = pdTRUE;
+        }
+
+        #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+            /* Can the broker send a publish message? */
+            if( pxConnection->xMQTTContext.xSubscriptionManager.ulInUseSubscriptions != ( uint32_t ) 0 )
+            {
+                xNeedsPolling = pdTRUE;
+            }
+        #else
+            /* There is no record of the subscriptions, so assume the broker can
+             * send a publish message at any time. */
+            xNeedsPolling = pdTRUE;
+        #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
     }
+
+    return xNeedsPolling;
 }
 /*-----------------------------------------------------------*/
 
@@ -1279,7 +1991,7 @@ static TickType_t prvManageConnections( void )
 {
     UBaseType_t uxBrokerNumber;
     MQTTBrokerConnection_t * pxConnection;
-    BaseType_t xAnyConnectedClient = pdFALSE;
+    BaseType_t xAnyPolledClient = pdFALSE;
     int32_t lBytesReceived;
     TickType_t xNextMQTTPeriodicInvokeTicks, xNextTimeoutTicks = portMAX_DELAY;
     uint64_t xTickCount = 0;
@@ -1336,25 +2048,29 @@ static TickType_t prvManageConnections( void )
             }
         }
 
-        /* Is the client connected? */
-        if( ( xAnyConnectedClient == pdFALSE ) && ( pxConnection->xSocket != SOCKETS_INVALID_SOCKET ) )
-        {
-            xAnyConnectedClient = pdTRUE;
-        }
-
         /* Get the current tick count. */
         prvMQTTGetTicks( &xTickCount );
 
         /* Invoke MQTT_Periodic. */
         xNextMQTTPeriodicInvokeTicks = ( TickType_t ) MQTT_Periodic( &( pxConnection->xMQTTContext ), xTickCount );
 
+        /* Does the client's socket have to be polled? This is checked after
+         * MQTT_Periodic as it may have sent a PINGREQ or dropped timed out
+         * packets. */
+        if( ( xAnyPolledClient == pdFALSE ) && ( prvConnectionNeedsPolling( pxConnection ) == pdTRUE ) )
+        {
+            xAnyPolledClient = pdTRUE;
+        }
+
         /* Update the next timeout value. */
         xNextTimeoutTicks = configMIN( xNextTimeoutTicks, xNextMQTTPeriodicInvokeTicks );
     }
 
     /* The MQTT task must not block for more than mqttconfigMQTT_TASK_MAX_BLOCK_TICKS
-     * ticks if any client is connected. */
-    if( xAnyConnectedClient == pdTRUE )
+     * ticks if data can arrive on a socket which does not wake it. Otherwise it
+     * blocks until the next command or the next deadline of MQTT_Periodic, which
+     * lets a tickless idle keep the core asleep until then. */
+    if( xAnyPolledClient == pdTRUE )
     {
         xNextTimeoutTicks = configMIN( xNextTimeoutTicks, ( TickType_t ) mqttconfigMQTT_TASK_MAX_BLOCK_TICKS );
     }
@@ -1414,6 +2130,7 @@ static void prvInitiateMQTTConnect( MQTTEventData_t * const pxEventData )
             xConnectParams.ulPingRequestTimeoutTicks = mqttconfigKEEP_ALIVE_TIMEOUT_TICKS;
             xConnectParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
             xConnectParams.ulTimeoutTicks = pxEventData->xTicksToWait;
+            xConnectParams.xDeliverPublishesInPlace = ( ( pxEventData->u.pxConnectParams->xFlags & mqttagentDELIVER_PUBLISHES_IN_PLACE ) != 0 ) ? eMQTTTrue : eMQTTFalse;
 
             if( MQTT_Connect( &( pxConnection->xMQTTContext ), &( xConnectParams ) ) != eMQTTSuccess )
             {
@@ -1474,6 +2191,9 @@ static void prvInitiateMQTTSubscribe( MQTTEventData_t * const pxEventData )
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData;
     MQTTSubscribeParams_t xSubscribeParams;
+    MQTTSubscribeTopic_t xTopics[ mqttconfigSUBSCRIBE_MAX_TOPICS ];
+    const MQTTAgentSubscribeParams_t * pxTopic;
+    uint32_t x;
     MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
 
     /* Store notification data. */
@@ -1484,16 +2204,29 @@ static void prvInitiateMQTTSubscribe( MQTTEventData_t * const pxEventData )
      * immediately. */
     if( pxNotificationData != NULL )
     {
+        /* The return codes from the SUBACK are copied to the caller's array.
+         * It stays valid until the caller is notified: a blocking caller
+         * waits for the notification however long it takes, and an
+         * asynchronous caller keeps it until its callback is invoked. */
+        pxNotificationData->pxSubACKReturnCodes = pxEventData->xNotificationData.pxSubACKReturnCodes;
+
         /* Setup subscribe parameters and call the Core library subscribe function. */
-        xSubscribeParams.pucTopic = pxEventData->u.pxSubscribeParams->pucTopic;
-        xSubscribeParams.usTopicLength = pxEventData->u.pxSubscribeParams->usTopicLength;
-        xSubscribeParams.xQos = pxEventData->u.pxSubscribeParams->xQoS;
+        for( x = 0; x < pxEventData->ulTopicCount; x++ )
+        {
+            pxTopic = &( pxEventData->u.pxSubscribeParams[ x ] );
+            xTopics[ x ].pucTopic = pxTopic->pucTopic;
+            xTopics[ x ].usTopicLength = pxTopic->usTopicLength;
+            xTopics[ x ].xQos = pxTopic->xQoS;
+            #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+                xTopics[ x ].pvPublishCallbackContext = pxTopic->pvPublishCallbackContext;
+                xTopics[ x ].pxPublishCallback = pxTopic->pxPublishCallback;
+            #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+        }
+
+        xSubscribeParams.pxTopics = xTopics;
+        xSubscribeParams.ulTopicCount = pxEventData->ulTopicCount;
         xSubscribeParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
         xSubscribeParams.ulTimeoutTicks = pxEventData->xTicksToWait;
-        #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
-            xSubscribeParams.pvPublishCallbackContext = pxEventData->u.pxSubscribeParams->pvPublishCallbackContext;
-            xSubscribeParams.pxPublishCallback = pxEventData->u.pxSubscribeParams->pxPublishCallback;
-        #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
         if( MQTT_Subscribe( &( pxConnection->xMQTTContext ), &( xSubscribeParams ) ) == eMQTTSuccess )
         {
@@ -1529,6 +2262,8 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData )
     BaseType_t xStatus = pdFAIL;
     MQTTNotificationData_t * pxNotificationData;
     MQTTUnsubscribeParams_t xUnsubscribeParams;
+    MQTTUnsubscribeTopic_t xTopics[ mqttconfigSUBSCRIBE_MAX_TOPICS ];
+    uint32_t x;
     MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
 
     /* Store notification data. */
@@ -1541,8 +2276,14 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData )
     {
         /* Setup unsubscribe parameters and call the Core library unsubscribe
          * function. */
-        xUnsubscribeParams.pucTopic = pxEventData->u.pxUnsubscribeParams->pucTopic;
-        xUnsubscribeParams.usTopicLength = pxEventData->u.pxUnsubscribeParams->usTopicLength;
+        for( x = 0; x < pxEventData->ulTopicCount; x++ )
+        {
+            xTopics[ x ].pucTopic = pxEventData->u.pxUnsubscribeParams[ x ].pucTopic;
+            xTopics[ x ].usTopicLength = pxEventData->u.pxUnsubscribeParams[ x ].usTopicLength;
+        }
+
+        xUnsubscribeParams.pxTopics = xTopics;
+        xUnsubscribeParams.ulTopicCount = pxEventData->ulTopicCount;
         xUnsubscribeParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
         xUnsubscribeParams.ulTimeoutTicks = pxEventData->xTicksToWait;
 
@@ -1577,7 +2318,8 @@ static void prvInitiateMQTTUnSubscribe( MQTTEventData_t * const pxEventData )
 
 static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
 {
-    BaseType_t xStatus = pdFAIL;
+    BaseType_t xStatus = pdFAIL, xHold = pdFALSE;
+    MQTTReturnCode_t xReturnCode;
     MQTTNotificationData_t * pxNotificationData = NULL;
     MQTTPublishParams_t xPublishParams;
     MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
@@ -1587,6 +2329,17 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
     if( pxEventData->u.pxPublishParams->xQoS != eMQTTQoS0 )
     {
         pxNotificationData = prvStoreNotificationData( pxConnection, pxEventData );
+
+        #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+            /* A QoS1 publish still waiting for PUBACK when the connection
+             * drops goes to the offline queue. */
+            if( ( pxNotificationData != NULL ) && ( pxEventData->u.pxPublishParams->xQoS == eMQTTQoS1 ) )
+            {
+                prvOfflineCopyInFlightPublish( pxConnection,
+                                               ( UBaseType_t ) ( pxNotificationData - pxConnection->xWaitingTasks ),
+                                               pxEventData->u.pxPublishParams );
+            }
+        #endif
     }
 
     /* If a free buffer was not available to store the notification data
@@ -1604,25 +2357,60 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
         xPublishParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( pxEventData->xNotificationData.ulMessageIdentifier ) );
         xPublishParams.ulTimeoutTicks = pxEventData->xTicksToWait;
 
-        if( MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) ) == eMQTTSuccess )
+        xReturnCode = MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) );
+
+        if( xReturnCode == eMQTTSuccess )
         {
             xStatus = pdPASS;
         }
+        else if( xReturnCode == eMQTTPublishWindowFull )
+        {
+            xHold = pdTRUE;
+        }
         else
         {
             mqttconfigDEBUG_LOG( ( "MQTT_Publish failed!\r\n" ) );
         }
     }
+    else if( pxConnection->xMQTTContext.xConnectionState == eMQTTConnected )
+    {
+        /* All the buffers are taken by operations waiting for an ACK, one
+         * of which will complete or time out. */
+        xHold = pdTRUE;
+    }
     else
     {
         mqttconfigDEBUG_LOG( ( "Could not get a buffer to store notification data. Too many parallel tasks!\r\n" ) );
     }
 
+    if( xHold == pdTRUE )
+    {
+        /* Hold the publish until there is room for it.  The MQTT task takes
+         * no further commands meanwhile, so the tasks which publish block on
+         * the command queue once it fills up. */
+        mqttconfigDEBUG_LOG( ( "Holding publish until a PUBACK arrives.\r\n" ) );
+        configASSERT( pxConnection->xPublishHeld == pdFALSE );
+        pxConnection->xHeldPublish = *pxEventData;
+        pxConnection->xPublishHeld = pdTRUE;
+
+        if( pxNotificationData != NULL )
+        {
+            pxNotificationData->xTaskToNotify = NULL;
+        }
+
+        /* Neither passed nor failed yet. */
+        xStatus = pdPASS;
+    }
+
     /* In case of QoS0 successful publish, inform and unblock the task that
      * initiated the publish operation as no PUBACK is expected. */
-    if( ( xStatus == pdPASS ) && ( pxEventData->u.pxPublishParams->xQoS == eMQTTQoS0 ) )
+    if( ( xStatus == pdPASS ) && ( xHold == pdFALSE ) && ( pxEventData->u.pxPublishParams->xQoS == eMQTTQoS0 ) )
     {
-        prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBSent, pdPASS );
+        #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+            prvNotifyPublishSent( pxConnection, pxEventData );
+        #else
+            prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBSent, pdPASS );
+        #endif
     }
 
     if( xStatus == pdFAIL )
@@ -1640,6 +2428,53 @@ static void prvInitiateMQTTPublish( MQTTEventData_t * const pxEventData )
 }
 /*-----------------------------------------------------------*/
 
+static TickType_t prvRetryHeldPublishes( void )
+{
+    UBaseType_t uxBrokerNumber;
+    MQTTBrokerConnection_t * pxConnection;
+    MQTTEventData_t xPublish;
+    TickType_t xTicksToWait = portMAX_DELAY;
+    BaseType_t xQueued = pdFALSE;
+
+    for( uxBrokerNumber = 0; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber++ )
+    {
+        pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+
+        if( pxConnection->xPublishHeld == pdTRUE )
+        {
+            /* prvInitiateMQTTPublish holds the publish again if there is
+             * still no room for it. */
+            xPublish = pxConnection->xHeldPublish;
+            pxConnection->xPublishHeld = pdFALSE;
+
+            if( xTaskCheckForTimeOut( &( xPublish.xEventCreationTimestamp ), &( xPublish.xTicksToWait ) ) == pdTRUE )
+            {
+                prvNotifyRequestingTask( &( xPublish.xNotificationData ), eMQTTOperationTimedOut, pdFAIL );
+            }
+            else
+            {
+                #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+                    /* The connection may have dropped while the publish was held. */
+                    xQueued = prvQueueOfflinePublish( &( xPublish ) );
+                #endif
+
+                if( xQueued == pdFALSE )
+                {
+                    prvInitiateMQTTPublish( &( xPublish ) );
+                }
+            }
+
+            if( ( pxConnection->xPublishHeld == pdTRUE ) && ( xPublish.xTicksToWait < xTicksToWait ) )
+            {
+                xTicksToWait = xPublish.xTicksToWait;
+            }
+        }
+    }
+
+    return xTicksToWait;
+}
+/*-----------------------------------------------------------*/
+
 static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEventData )
 {
     BaseType_t xReturn;
@@ -1652,6 +2487,8 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
 
     /* Setup notification data. */
     pxEventData->xNotificationData.xTaskToNotify = xTaskGetCurrentTaskHandle();
+    pxEventData->xNotificationData.pxCompletionCallback = NULL;
+    pxEventData->xNotificationData.pvCallbackContext = NULL;
 
     /* Commands must not be sent from the MQTT task itself (which could be
      * the case if a command is sent from a callback function).  Otherwise
@@ -1659,22 +2496,7 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
      * resulting in deadlock. */
     if( pxEventData->xNotificationData.xTaskToNotify != xMQTTTaskHandle )
     {
-        taskENTER_CRITICAL();
-        {
-            /* The message identifier is used to know which message is being
-             * acknowledged.  A critical region is used as a single message identifier
-             * variable is used by all connections. The identifier uses the top 16-bits
-             * of the 32-bit word, leaving the lowest 16-bits free for use by the MQTT
-             * task to return a status code. */
-            pxEventData->xNotificationData.ulMessageIdentifier = ulQueueMessageIdentifier;
-            ulQueueMessageIdentifier += mqttMESSAGE_IDENTIFIER_MIN;
-
-            if( ulQueueMessageIdentifier >= mqttMESSAGE_IDENTIFIER_MAX )
-            {
-                ulQueueMessageIdentifier = mqttMESSAGE_IDENTIFIER_MIN;
-            }
-        }
-        taskEXIT_CRITICAL();
+        pxEventData->xNotificationData.ulMessageIdentifier = prvGetNextMessageIdentifier();
 
         /* Record the time at which this event is created. */
         vTaskSetTimeOutState( &( pxEventData->xEventCreationTimestamp ) );
@@ -1709,28 +2531,16 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
 
                 if( pxEventData->xNotificationData.ulMessageIdentifier == ( ulReceivedMessageIdentifier & mqttMESSAGE_IDENTIFIER_MASK ) )
                 {
-                    /* A reply to the message was received.  The low 16-bits
-                     * contain a status code, of which the least significant it
-                     * is 1 (pdPASS) if the status code indicates a pass, and
-                     * 0 (pdFAIL) if the status code indicates a fail. */
+                    /* A reply to the message was received. */
+                    xReturnCode = prvGetReturnCode( ulReceivedMessageIdentifier );
 
-                    if( ( ulReceivedMessageIdentifier & mqttNOTIFICATION_STATUS_MASK ) != ( uint32_t ) pdPASS )
+                    if( xReturnCode == eMQTTAgentSuccess )
                     {
-                        /* A reply to the message was received, but the operation
-                         * failed. Check if the failure reason was timeout. */
-                        if( ( ulReceivedMessageIdentifier & mqttNOTIFICATION_CODE_MASK ) == ( uint32_t ) eMQTTOperationTimedOut )
-                        {
-                            xReturnCode = eMQTTAgentTimeout;
-                        }
-
-                        mqttconfigDEBUG_LOG( ( "Command sent to MQTT task failed.\r\n" ) );
+                        mqttconfigDEBUG_LOG( ( "Command sent to MQTT task passed.\r\n" ) );
                     }
                     else
                     {
-                        /* A reply to the message was received and the operation
-                         * passed. */
-                        mqttconfigDEBUG_LOG( ( "Command sent to MQTT task passed.\r\n" ) );
-                        xReturnCode = eMQTTAgentSuccess;
+                        mqttconfigDEBUG_LOG( ( "Command sent to MQTT task failed.\r\n" ) );
                     }
 
                     break;
@@ -1757,130 +2567,788 @@ static MQTTAgentReturnCode_t prvSendCommandToMQTTTask( MQTTEventData_t * pxEvent
 }
 /*-----------------------------------------------------------*/
 
-static void prvMQTTTask( void * pvParameters )
+static MQTTAgentReturnCode_t prvSendAsyncCommandToMQTTTask( MQTTEventData_t * pxEventData,
+                                                            MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                                            void * pvCallbackContext,
+                                                            MQTTAgentRequestHandle_t * const pxRequestHandle )
 {
-    MQTTEventData_t xMQTTCommand;
-    TickType_t xNextTimeoutTicks = 0;
-
-    /* Remove compiler warnings about unused parameters. */
-    ( void ) pvParameters;
-
-    for( ; ; )
-    {
-        if( xQueueReceive( xCommandQueue, &xMQTTCommand, xNextTimeoutTicks ) != pdFALSE )
-        {
-            mqttconfigDEBUG_LOG( ( "Received message %x from queue.\r\n", xMQTTCommand.xNotificationData.ulMessageIdentifier ) );
-
-            /* The connection index identifies the broker to communicate with -
-             * starting from an index of 0.  Check the index is valid here so
-             * functions further down the call tree don't have to.  A check is
-             * performed before messages are sent to the command queue anyway. */
-            configASSERT( xMQTTCommand.uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+    TickType_t xTicksToWait = pxEventData->xTicksToWait;
 
-            /* Check if the timeout for the event has been reached.
-             * It means that the MQTT task picked up this command for
-             * processing too late and there is no point in proceeding.
-             * Fail the operation with timeout and unblock the waiting
-             * task. */
-            if( xTaskCheckForTimeOut( &( xMQTTCommand.xEventCreationTimestamp ), &( xMQTTCommand.xTicksToWait ) ) == pdTRUE )
-            {
-                /* Note that in case of eMQTTServiceSocket event, the
-                 * xMQTTCommand.xNotificationData.xTaskToNotify happens to
-                 * be NULL and therefore prvNotifyRequestingTask returns
-                 * without doing anything. */
-                prvNotifyRequestingTask( &( xMQTTCommand.xNotificationData ), eMQTTOperationTimedOut, pdFAIL );
-            }
-            else
-            {
-                /* Process the received command. Note that the xTicksToWait
-                 * has been updated in the previous call to xTaskCheckForTimeout
-                 * to ensure that we block only for the duration specified by the
-                 * user. */
-                switch( xMQTTCommand.xEventType )
-                {
-                    case eMQTTConnectRequest:
-                        prvInitiateMQTTConnect( &( xMQTTCommand ) );
-                        break;
+    /* Should not try to send commands until after the MQTT task has been
+     * initialized, in which case the command queue will have been created. */
+    configASSERT( xCommandQueue );
+    configASSERT( pxCompletionCallback );
 
-                    case eMQTTDisconnectRequest:
-                        prvInitiateMQTTDisconnect( &( xMQTTCommand ) );
-                        break;
+    /* xTaskToNotify only marks the notification data as in use, the task is
+     * never notified as the completion callback is invoked instead. */
+    pxEventData->xNotificationData.xTaskToNotify = xTaskGetCurrentTaskHandle();
+    pxEventData->xNotificationData.pxCompletionCallback = pxCompletionCallback;
+    pxEventData->xNotificationData.pvCallbackContext = pvCallbackContext;
+    pxEventData->xNotificationData.ulMessageIdentifier = prvGetNextMessageIdentifier();
 
-                    case eMQTTSubscribeRequest:
-                        prvInitiateMQTTSubscribe( &( xMQTTCommand ) );
-                        break;
+    /* The MQTT task must not wait for space in its own command queue. */
+    if( pxEventData->xNotificationData.xTaskToNotify == xMQTTTaskHandle )
+    {
+        xTicksToWait = 0;
+    }
 
-                    case eMQTTUnsubscribeRequest:
-                        prvInitiateMQTTUnSubscribe( &( xMQTTCommand ) );
-                        break;
+    /* Record the time at which this event is created. */
+    vTaskSetTimeOutState( &( pxEventData->xEventCreationTimestamp ) );
 
-                    case eMQTTPublishRequest:
-                        prvInitiateMQTTPublish( &( xMQTTCommand ) );
-                        break;
+    mqttconfigDEBUG_LOG( ( "Sending asynchronous command to MQTT task.\r\n" ) );
 
-                    default:
-                        /* Anything else is illegal. */
-                        mqttconfigDEBUG_LOG( ( "Unknown request received on command queue.\r\n" ) );
-                        break;
-                }
-            }
+    if( xQueueSendToBack( xCommandQueue, pxEventData, xTicksToWait ) != pdFALSE )
+    {
+        if( pxRequestHandle != NULL )
+        {
+            *pxRequestHandle = pxEventData->xNotificationData.ulMessageIdentifier;
         }
 
-        /* Process active connections each time the queue unblocks.  It might
-         * be that the queue read timed out because a connection needs service. */
-        xNextTimeoutTicks = prvManageConnections();
+        xReturnCode = eMQTTAgentSuccess;
+    }
+    else
+    {
+        mqttconfigDEBUG_LOG( ( "Attempt to write to the MQTT command queue failed.\r\n" ) );
     }
+
+    return xReturnCode;
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t MQTT_AGENT_Init( void )
+static uint32_t prvGetNextMessageIdentifier( void )
 {
-    /* The following variables must be static as they hold data that is used as
-     * long as the MQTT application is running. */
+    uint32_t ulMessageIdentifier;
 
-    /* The variable used to hold the queue's data structure. */
-    static StaticQueue_t xStaticQueue;
+    taskENTER_CRITICAL();
+    {
+        /* The message identifier is used to know which message is being
+         * acknowledged.  A critical region is used as a single message identifier
+         * variable is used by all connections. The identifier uses the top 16-bits
+         * of the 32-bit word, leaving the lowest 16-bits free for use by the MQTT
+         * task to return a status code. */
+        ulMessageIdentifier = ulQueueMessageIdentifier;
+        ulQueueMessageIdentifier += mqttMESSAGE_IDENTIFIER_MIN;
+
+        if( ulQueueMessageIdentifier >= mqttMESSAGE_IDENTIFIER_MAX )
+        {
+            ulQueueMessageIdentifier = mqttMESSAGE_IDENTIFIER_MIN;
+        }
+    }
+    taskEXIT_CRITICAL();
 
-    /* The array to use as the queue's storage area.  This must be at least
-     * uxQueueLength * uxItemSize bytes.  Again, must be static. */
-    static uint8_t ucQueueStorageArea[ mqttCOMMAND_QUEUE_LENGTH * sizeof( MQTTEventData_t ) ];
+    return ulMessageIdentifier;
+}
+/*-----------------------------------------------------------*/
 
-    /* The stack used by the MQTT task. */
-    static StackType_t xStack[ mqttconfigMQTT_TASK_STACK_DEPTH ];
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
 
-    /* The variable used to hold the MQTT task's data structures. */
-    static StaticTask_t xStaticTask;
+    static uint32_t prvOfflineQueueCount( const MQTTBrokerConnection_t * const pxConnection )
+    {
+        uint32_t ulCount = pxConnection->ulOfflineQueueRecords;
 
-    BaseType_t xReturnCode = pdPASS;
-    UBaseType_t x, y;
+        #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+            ulCount += pxConnection->ulOfflineStoreRecords;
+        #endif
 
-    /* If the command queue is not NULL then the queue and task have already
-     * been created. */
-    if( xCommandQueue == NULL )
+        return ulCount;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvOfflineQueuePush( MQTTBrokerConnection_t * const pxConnection,
+                                           const MQTTAgentPublishParams_t * const pxPublishParams )
     {
-        /* Ensure the connection structures start in a consistent state. */
-        memset( xMQTTConnections, 0x00, sizeof( xMQTTConnections ) );
+        BaseType_t xStatus = pdFAIL;
+        uint16_t usLengths[ 2 ];
+        uint32_t ulRecordLength;
+        uint8_t * pucRecord;
 
-        for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_BROKERS; x++ )
+        if( ( pxPublishParams->usTopicLength <= ( uint16_t ) mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH ) &&
+            ( pxPublishParams->ulDataLength <= ( uint32_t ) mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH ) )
         {
-            xMQTTConnections[ x ].xSocket = SOCKETS_INVALID_SOCKET;
+            usLengths[ 0 ] = pxPublishParams->usTopicLength;
+            usLengths[ 1 ] = ( uint16_t ) pxPublishParams->ulDataLength;
+            ulRecordLength = mqttOFFLINE_RECORD_LENGTH( usLengths );
 
-            /* Initialize user callback and data. These are provided during connect. */
-            xMQTTConnections[ x ].pvUserData = NULL;
-            xMQTTConnections[ x ].pxCallback = NULL;
+            /* Make room at the end of the queue by moving the records to
+             * the start, then by moving them to the persistent store. */
+            if( ( pxConnection->ulOfflineQueueTail + ulRecordLength ) > ( uint32_t ) mqttconfigOFFLINE_QUEUE_SIZE )
+            {
+                memmove( pxConnection->ucOfflineQueue,
+                         &( pxConnection->ucOfflineQueue[ pxConnection->ulOfflineQueueHead ] ),
+                         pxConnection->ulOfflineQueueTail - pxConnection->ulOfflineQueueHead );
+                pxConnection->ulOfflineQueueTail -= pxConnection->ulOfflineQueueHead;
+                pxConnection->ulOfflineQueueHead = 0;
+            }
 
-            /* Mark the connection "not in use". */
-            xMQTTConnections[ x ].xConnectionInUse = pdFALSE;
+            #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+                if( ( pxConnection->ulOfflineQueueTail + ulRecordLength ) > ( uint32_t ) mqttconfigOFFLINE_QUEUE_SIZE )
+                {
+                    ( void ) prvOfflineStoreSpill( pxConnection );
+                }
+            #endif
 
-            /* Initialize the MQTT Core Library context. */
-            MQTTInitParams_t xInitParams;
-            xInitParams.pvCallbackContext = ( void * ) x; /*lint !e923 The cast is ok as we are passing the index of the client. */
-            xInitParams.pxCallback = prvMQTTEventCallback;
-            xInitParams.pvSendContext = ( void * ) x;     /*lint !e923 The cast is ok as we are passing the index of the client. */
-            xInitParams.pxMQTTSendFxn = prvMQTTSendCallback;
-            xInitParams.pxGetTicksFxn = prvMQTTGetTicks;
-            xInitParams.xBufferPoolInterface.pxGetBufferFxn = mqttconfigGET_FREE_BUFFER_FXN;
-            xInitParams.xBufferPoolInterface.pxReturnBufferFxn = mqttconfigRETURN_BUFFER_FXN;
+            if( ( pxConnection->ulOfflineQueueTail + ulRecordLength ) <= ( uint32_t ) mqttconfigOFFLINE_QUEUE_SIZE )
+            {
+                pucRecord = &( pxConnection->ucOfflineQueue[ pxConnection->ulOfflineQueueTail ] );
+                memcpy( pucRecord, usLengths, mqttOFFLINE_RECORD_HEADER_LENGTH );
+                memcpy( &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH ] ), pxPublishParams->pucTopic, usLengths[ 0 ] );
+
+                if( usLengths[ 1 ] > 0U )
+                {
+                    memcpy( &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH + usLengths[ 0 ] ] ), pxPublishParams->pvData, usLengths[ 1 ] );
+                }
+
+                pxConnection->ulOfflineQueueTail += ulRecordLength;
+                pxConnection->ulOfflineQueueRecords++;
+                xStatus = pdPASS;
+            }
+            else
+            {
+                mqttconfigDEBUG_LOG( ( "Offline queue full.\r\n" ) );
+            }
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvOfflineCopyInFlightPublish( MQTTBrokerConnection_t * const pxConnection,
+                                               UBaseType_t uxIndex,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams )
+    {
+        uint16_t usLengths[ 2 ];
+        uint8_t * pucRecord = pxConnection->ucInFlightPublishes[ uxIndex ];
+
+        if( ( pxPublishParams->usTopicLength <= ( uint16_t ) mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH ) &&
+            ( pxPublishParams->ulDataLength <= ( uint32_t ) mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH ) )
+        {
+            /* Same layout as the records of the offline queue. */
+            usLengths[ 0 ] = pxPublishParams->usTopicLength;
+            usLengths[ 1 ] = ( uint16_t ) pxPublishParams->ulDataLength;
+            memcpy( pucRecord, usLengths, mqttOFFLINE_RECORD_HEADER_LENGTH );
+            memcpy( &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH ] ), pxPublishParams->pucTopic, usLengths[ 0 ] );
+
+            if( usLengths[ 1 ] > 0U )
+            {
+                memcpy( &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH + usLengths[ 0 ] ] ), pxPublishParams->pvData, usLengths[ 1 ] );
+            }
+
+            /* 0 marks an entry which holds no publish, so skip it when the
+             * order wraps. */
+            pxConnection->ulNextInFlightPublishOrder++;
+
+            if( pxConnection->ulNextInFlightPublishOrder == 0U )
+            {
+                pxConnection->ulNextInFlightPublishOrder++;
+            }
+
+            pxConnection->ulInFlightPublishOrder[ uxIndex ] = pxConnection->ulNextInFlightPublishOrder;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvOfflineQueueInFlightPublishes( MQTTBrokerConnection_t * const pxConnection )
+    {
+        UBaseType_t x, uxOldest;
+        uint16_t usLengths[ 2 ];
+        const uint8_t * pucRecord;
+        MQTTAgentPublishParams_t xPublishParams;
+
+        do
+        {
+            /* Find the oldest publish left.  The difference of the orders is
+             * taken so that the comparison still holds when they wrap. */
+            uxOldest = ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS;
+
+            for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; x++ )
+            {
+                if( ( pxConnection->xWaitingTasks[ x ].xTaskToNotify != NULL ) &&
+                    ( pxConnection->ulInFlightPublishOrder[ x ] != 0U ) &&
+                    ( ( uxOldest == ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS ) ||
+                      ( ( int32_t ) ( pxConnection->ulInFlightPublishOrder[ x ] - pxConnection->ulInFlightPublishOrder[ uxOldest ] ) < 0 ) ) )
+                {
+                    uxOldest = x;
+                }
+            }
+
+            if( uxOldest < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS )
+            {
+                pucRecord = pxConnection->ucInFlightPublishes[ uxOldest ];
+                memcpy( usLengths, pucRecord, mqttOFFLINE_RECORD_HEADER_LENGTH );
+
+                xPublishParams.pucTopic = &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH ] );
+                xPublishParams.usTopicLength = usLengths[ 0 ];
+                xPublishParams.xQoS = eMQTTQoS1;
+                xPublishParams.pvData = &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH + usLengths[ 0 ] ] );
+                xPublishParams.ulDataLength = usLengths[ 1 ];
+
+                pxConnection->ulInFlightPublishOrder[ uxOldest ] = 0;
+
+                if( prvOfflineQueuePush( pxConnection, &( xPublishParams ) ) == pdPASS )
+                {
+                    prvNotifyRequestingTask( &( pxConnection->xWaitingTasks[ uxOldest ] ),
+                                             eMQTTPUBQueued,
+                                             pdPASS );
+                }
+                else
+                {
+                    prvNotifyRequestingTask( &( pxConnection->xWaitingTasks[ uxOldest ] ),
+                                             eMQTTClientGotDisconnected,
+                                             pdFAIL );
+                }
+            }
+        } while( uxOldest < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS );
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvOfflineQueuePeek( MQTTBrokerConnection_t * const pxConnection,
+                                           uint32_t ulIndex,
+                                           MQTTPublishParams_t * const pxPublishParams )
+    {
+        BaseType_t xStatus = pdFAIL;
+        uint16_t usLengths[ 2 ];
+        uint32_t ulOffset, x;
+        const uint8_t * pucRecord = NULL;
+
+        #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+            if( ulIndex < pxConnection->ulOfflineStoreRecords )
+            {
+                /* Walk the records of the store up to the one requested,
+                 * checking each one lies within the store. */
+                ulOffset = pxConnection->ulOfflineStoreHead;
+
+                for( x = 0; x <= ulIndex; x++ )
+                {
+                    if( ( MQTT_OFFLINE_STORE_PAL_Read( mqttOFFLINE_STORE_OFFSET( pxConnection, ulOffset ), usLengths, mqttOFFLINE_RECORD_HEADER_LENGTH ) != pdPASS ) ||
+                        ( usLengths[ 0 ] > ( uint16_t ) mqttconfigOFFLINE_QUEUE_MAX_TOPIC_LENGTH ) ||
+                        ( usLengths[ 1 ] > ( uint16_t ) mqttconfigOFFLINE_QUEUE_MAX_DATA_LENGTH ) ||
+                        ( ( ulOffset + mqttOFFLINE_RECORD_LENGTH( usLengths ) ) > pxConnection->ulOfflineStoreTail ) )
+                    {
+                        break;
+                    }
+
+                    if( x == ulIndex )
+                    {
+                        if( MQTT_OFFLINE_STORE_PAL_Read( mqttOFFLINE_STORE_OFFSET( pxConnection, ulOffset ),
+                                                         pxConnection->ucOfflineRecord,
+                                                         mqttOFFLINE_RECORD_LENGTH( usLengths ) ) == pdPASS )
+                        {
+                            pucRecord = pxConnection->ucOfflineRecord;
+                        }
+                    }
+                    else
+                    {
+                        ulOffset += mqttOFFLINE_RECORD_LENGTH( usLengths );
+                    }
+                }
+
+                if( pucRecord == NULL )
+                {
+                    /* The store cannot be trusted, so drop what is left in it
+                     * and send the records which follow it from the start. */
+                    mqttconfigDEBUG_LOG( ( "Offline store corrupt, dropping %u publishes.\r\n", ( unsigned int ) pxConnection->ulOfflineStoreRecords ) );
+                    pxConnection->ulOfflineStoreHead = 0;
+                    pxConnection->ulOfflineStoreTail = 0;
+                    pxConnection->ulOfflineStoreRecords = 0;
+                    pxConnection->ulOfflineInFlight = 0;
+                    ( void ) prvOfflineStoreWriteHeader( pxConnection );
+                }
+            }
+            else
+            {
+                ulIndex -= pxConnection->ulOfflineStoreRecords;
+            }
+        #endif /* mqttconfigOFFLINE_STORE_SIZE */
+
+        if( ( pucRecord == NULL ) && ( ulIndex < pxConnection->ulOfflineQueueRecords ) )
+        {
+            ulOffset = pxConnection->ulOfflineQueueHead;
+
+            for( x = 0; x < ulIndex; x++ )
+            {
+                memcpy( usLengths, &( pxConnection->ucOfflineQueue[ ulOffset ] ), mqttOFFLINE_RECORD_HEADER_LENGTH );
+                ulOffset += mqttOFFLINE_RECORD_LENGTH( usLengths );
+            }
+
+            pucRecord = &( pxConnection->ucOfflineQueue[ ulOffset ] );
+        }
+
+        if( pucRecord != NULL )
+        {
+            memcpy( usLengths, pucRecord, mqttOFFLINE_RECORD_HEADER_LENGTH );
+            pxPublishParams->pucTopic = &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH ] );
+            pxPublishParams->usTopicLength = usLengths[ 0 ];
+            pxPublishParams->pvData = &( pucRecord[ mqttOFFLINE_RECORD_HEADER_LENGTH + usLengths[ 0 ] ] );
+            pxPublishParams->ulDataLength = usLengths[ 1 ];
+            xStatus = pdPASS;
+        }
+
+        return xStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvOfflineQueuePop( MQTTBrokerConnection_t * const pxConnection )
+    {
+        uint16_t usLengths[ 2 ];
+        BaseType_t xPopped = pdFALSE;
+
+        #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+            if( pxConnection->ulOfflineStoreRecords > 0U )
+            {
+                xPopped = pdTRUE;
+
+                /* The record was checked when it was sent. */
+                if( MQTT_OFFLINE_STORE_PAL_Read( mqttOFFLINE_STORE_OFFSET( pxConnection, pxConnection->ulOfflineStoreHead ), usLengths, mqttOFFLINE_RECORD_HEADER_LENGTH ) == pdPASS )
+                {
+                    pxConnection->ulOfflineStoreHead += mqttOFFLINE_RECORD_LENGTH( usLengths );
+                    pxConnection->ulOfflineStoreRecords--;
+                }
+                else
+                {
+                    pxConnection->ulOfflineStoreRecords = 0;
+                }
+
+                /* The header is only written once the store is empty, to
+                 * spare the storage. */
+                if( pxConnection->ulOfflineStoreRecords == 0U )
+                {
+                    pxConnection->ulOfflineStoreHead = 0;
+                    pxConnection->ulOfflineStoreTail = 0;
+                    ( void ) prvOfflineStoreWriteHeader( pxConnection );
+                }
+            }
+        #endif /* mqttconfigOFFLINE_STORE_SIZE */
+
+        if( ( xPopped == pdFALSE ) && ( pxConnection->ulOfflineQueueRecords > 0U ) )
+        {
+            memcpy( usLengths, &( pxConnection->ucOfflineQueue[ pxConnection->ulOfflineQueueHead ] ), mqttOFFLINE_RECORD_HEADER_LENGTH );
+            pxConnection->ulOfflineQueueHead += mqttOFFLINE_RECORD_LENGTH( usLengths );
+            pxConnection->ulOfflineQueueRecords--;
+
+            if( pxConnection->ulOfflineQueueRecords == 0U )
+            {
+                pxConnection->ulOfflineQueueHead = 0;
+                pxConnection->ulOfflineQueueTail = 0;
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    #if ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+        static void prvOfflineStoreLoad( MQTTBrokerConnection_t * const pxConnection )
+        {
+            MQTTOfflineStoreHeader_t xHeader;
+
+            /* An erased or half written store is taken to be empty. */
+            pxConnection->ulOfflineStoreHead = 0;
+            pxConnection->ulOfflineStoreTail = 0;
+            pxConnection->ulOfflineStoreRecords = 0;
+
+            if( ( MQTT_OFFLINE_STORE_PAL_Read( mqttOFFLINE_STORE_OFFSET( pxConnection, 0 ) - ( uint32_t ) sizeof( xHeader ), &xHeader, ( uint32_t ) sizeof( xHeader ) ) == pdPASS ) &&
+                ( xHeader.ulMagic == mqttOFFLINE_STORE_MAGIC ) &&
+                ( xHeader.ulHead <= xHeader.ulTail ) &&
+                ( xHeader.ulTail <= ( ( uint32_t ) mqttconfigOFFLINE_STORE_SIZE - ( uint32_t ) sizeof( xHeader ) ) ) &&
+                ( ( xHeader.ulRecords == 0U ) == ( xHeader.ulHead == xHeader.ulTail ) ) )
+            {
+                pxConnection->ulOfflineStoreHead = xHeader.ulHead;
+                pxConnection->ulOfflineStoreTail = xHeader.ulTail;
+                pxConnection->ulOfflineStoreRecords = xHeader.ulRecords;
+            }
+        }
+/*-----------------------------------------------------------*/
+
+        static BaseType_t prvOfflineStoreSpill( MQTTBrokerConnection_t * const pxConnection )
+        {
+            BaseType_t xStatus = pdFAIL;
+            uint32_t ulLength = pxConnection->ulOfflineQueueTail - pxConnection->ulOfflineQueueHead;
+
+            /* The space before the head of the store is only reclaimed once
+             * the store has been emptied. */
+            if( ( pxConnection->ulOfflineStoreTail + ulLength ) <= ( ( uint32_t ) mqttconfigOFFLINE_STORE_SIZE - ( uint32_t ) sizeof( MQTTOfflineStoreHeader_t ) ) )
+            {
+                /* Write the records before the header which makes them valid. */
+                if( MQTT_OFFLINE_STORE_PAL_Write( mqttOFFLINE_STORE_OFFSET( pxConnection, pxConnection->ulOfflineStoreTail ),
+                                                  &( pxConnection->ucOfflineQueue[ pxConnection->ulOfflineQueueHead ] ),
+                                                  ulLength ) == pdPASS )
+                {
+                    pxConnection->ulOfflineStoreTail += ulLength;
+                    pxConnection->ulOfflineStoreRecords += pxConnection->ulOfflineQueueRecords;
+                    xStatus = prvOfflineStoreWriteHeader( pxConnection );
+
+                    pxConnection->ulOfflineQueueHead = 0;
+                    pxConnection->ulOfflineQueueTail = 0;
+                    pxConnection->ulOfflineQueueRecords = 0;
+                }
+            }
+
+            if( xStatus != pdPASS )
+            {
+                mqttconfigDEBUG_LOG( ( "Could not move the offline queue to the store.\r\n" ) );
+            }
+
+            return xStatus;
+        }
+/*-----------------------------------------------------------*/
+
+        static BaseType_t prvOfflineStoreWriteHeader( const MQTTBrokerConnection_t * const pxConnection )
+        {
+            MQTTOfflineStoreHeader_t xHeader;
+
+            xHeader.ulMagic = mqttOFFLINE_STORE_MAGIC;
+            xHeader.ulHead = pxConnection->ulOfflineStoreHead;
+            xHeader.ulTail = pxConnection->ulOfflineStoreTail;
+            xHeader.ulRecords = pxConnection->ulOfflineStoreRecords;
+
+            return MQTT_OFFLINE_STORE_PAL_Write( mqttOFFLINE_STORE_OFFSET( pxConnection, 0 ) - ( uint32_t ) sizeof( xHeader ), &xHeader, ( uint32_t ) sizeof( xHeader ) );
+        }
+
+    #endif /* mqttconfigOFFLINE_STORE_SIZE */
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvQueueOfflinePublish( MQTTEventData_t * const pxEventData )
+    {
+        BaseType_t xQueued = pdFALSE;
+        MQTTBrokerConnection_t * pxConnection = &( xMQTTConnections[ pxEventData->uxBrokerNumber ] );
+
+        if( ( pxEventData->u.pxPublishParams->xQoS == eMQTTQoS1 ) &&
+            ( ( pxConnection->xMQTTContext.xConnectionState != eMQTTConnected ) ||
+              ( prvOfflineQueueCount( pxConnection ) > 0U ) ) )
+        {
+            xQueued = pdTRUE;
+
+            if( prvOfflineQueuePush( pxConnection, pxEventData->u.pxPublishParams ) == pdPASS )
+            {
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBQueued, pdPASS );
+            }
+            else
+            {
+                prvNotifyRequestingTask( &( pxEventData->xNotificationData ), eMQTTPUBCouldNotBeSent, pdFAIL );
+            }
+        }
+
+        return xQueued;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvSendOfflinePublishes( void )
+    {
+        UBaseType_t uxBrokerNumber;
+        uint32_t x, ulCount;
+        BaseType_t xSent = pdFALSE;
+        MQTTPublishParams_t xPublishParams;
+        MQTTBrokerConnection_t * pxConnection;
+
+        for( uxBrokerNumber = 0; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber++ )
+        {
+            pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+
+            if( pxConnection->xMQTTContext.xConnectionState != eMQTTConnected )
+            {
+                continue;
+            }
+
+            ulCount = prvOfflineQueueCount( pxConnection );
+
+            /* Keep up to mqttconfigMAX_PARALLEL_OPS of the oldest publishes in
+             * flight, which leaves the order of the others intact. */
+            for( x = 0; ( x < ( uint32_t ) mqttconfigMAX_PARALLEL_OPS ) && ( x < ulCount ); x++ )
+            {
+                if( x == pxConnection->ulOfflineInFlight )
+                {
+                    pxConnection->usOfflineInFlight[ x ] = mqttOFFLINE_SEND;
+                    pxConnection->ulOfflineInFlight++;
+                }
+
+                if( pxConnection->usOfflineInFlight[ x ] == mqttOFFLINE_SEND )
+                {
+                    if( prvOfflineQueuePeek( pxConnection, x, &( xPublishParams ) ) != pdPASS )
+                    {
+                        break;
+                    }
+
+                    xPublishParams.xQos = eMQTTQoS1;
+                    xPublishParams.usPacketIdentifier = ( uint16_t ) ( mqttMESSAGE_IDENTIFIER_EXTRACT( prvGetNextMessageIdentifier() ) );
+                    xPublishParams.ulTimeoutTicks = ( uint32_t ) mqttconfigOFFLINE_QUEUE_ACK_TIMEOUT_TICKS;
+
+                    /* The MQTT library copies the publish, as it is no larger
+                     * than mqttconfigPUBLISH_COPY_THRESHOLD.  If the publish
+                     * window is full, try again after the next PUBACK. */
+                    if( MQTT_Publish( &( pxConnection->xMQTTContext ), &( xPublishParams ) ) != eMQTTSuccess )
+                    {
+                        break;
+                    }
+
+                    pxConnection->usOfflineInFlight[ x ] = xPublishParams.usPacketIdentifier;
+                    xSent = pdTRUE;
+                }
+            }
+        }
+
+        return xSent;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvProcessOfflinePublishAck( MQTTBrokerConnection_t * const pxConnection,
+                                             uint16_t usPacketIdentifier )
+    {
+        uint32_t x;
+
+        for( x = 0; x < pxConnection->ulOfflineInFlight; x++ )
+        {
+            if( pxConnection->usOfflineInFlight[ x ] == usPacketIdentifier )
+            {
+                pxConnection->usOfflineInFlight[ x ] = mqttOFFLINE_ACKED;
+                break;
+            }
+        }
+
+        /* Remove the publishes at the front of the queue which have been
+         * acknowledged. */
+        while( ( pxConnection->ulOfflineInFlight > 0U ) && ( pxConnection->usOfflineInFlight[ 0 ] == mqttOFFLINE_ACKED ) )
+        {
+            prvOfflineQueuePop( pxConnection );
+            pxConnection->ulOfflineInFlight--;
+            memmove( pxConnection->usOfflineInFlight,
+                     &( pxConnection->usOfflineInFlight[ 1 ] ),
+                     pxConnection->ulOfflineInFlight * sizeof( uint16_t ) );
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvProcessOfflinePublishTimeout( MQTTBrokerConnection_t * const pxConnection,
+                                                 uint16_t usPacketIdentifier )
+    {
+        uint32_t x;
+
+        for( x = 0; x < pxConnection->ulOfflineInFlight; x++ )
+        {
+            if( pxConnection->usOfflineInFlight[ x ] == usPacketIdentifier )
+            {
+                pxConnection->usOfflineInFlight[ x ] = mqttOFFLINE_SEND;
+                break;
+            }
+        }
+    }
+
+#endif /* mqttconfigOFFLINE_QUEUE_SIZE */
+/*-----------------------------------------------------------*/
+
+static void prvProcessCommand( MQTTEventData_t * const pxCommand )
+{
+    mqttconfigDEBUG_LOG( ( "Received message %x from queue.\r\n", pxCommand->xNotificationData.ulMessageIdentifier ) );
+
+    /* The connection index identifies the broker to communicate with -
+     * starting from an index of 0.  Check the index is valid here so
+     * functions further down the call tree don't have to.  A check is
+     * performed before messages are sent to the command queue anyway. */
+    configASSERT( pxCommand->uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS );
+
+    /* Check if the timeout for the event has been reached.
+     * It means that the MQTT task picked up this command for
+     * processing too late and there is no point in proceeding.
+     * Fail the operation with timeout and unblock the waiting
+     * task. */
+    if( xTaskCheckForTimeOut( &( pxCommand->xEventCreationTimestamp ), &( pxCommand->xTicksToWait ) ) == pdTRUE )
+    {
+        /* Note that in case of eMQTTServiceSocket event, the
+         * pxCommand->xNotificationData.xTaskToNotify happens to
+         * be NULL and therefore prvNotifyRequestingTask returns
+         * without doing anything. */
+        prvNotifyRequestingTask( &( pxCommand->xNotificationData ), eMQTTOperationTimedOut, pdFAIL );
+    }
+    else
+    {
+        /* Process the received command. Note that the xTicksToWait
+         * has been updated in the previous call to xTaskCheckForTimeout
+         * to ensure that we block only for the duration specified by the
+         * user. */
+        switch( pxCommand->xEventType )
+        {
+            case eMQTTConnectRequest:
+                prvInitiateMQTTConnect( pxCommand );
+                break;
+
+            case eMQTTDisconnectRequest:
+                prvInitiateMQTTDisconnect( pxCommand );
+                break;
+
+            case eMQTTSubscribeRequest:
+                prvInitiateMQTTSubscribe( pxCommand );
+                break;
+
+            case eMQTTUnsubscribeRequest:
+                prvInitiateMQTTUnSubscribe( pxCommand );
+                break;
+
+            case eMQTTPublishRequest:
+
+                #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+                    if( prvQueueOfflinePublish( pxCommand ) == pdTRUE )
+                    {
+                        break;
+                    }
+                #endif
+
+                prvInitiateMQTTPublish( pxCommand );
+                break;
+
+            default:
+                /* Anything else is illegal. */
+                mqttconfigDEBUG_LOG( ( "Unknown request received on command queue.\r\n" ) );
+                break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvMQTTTask( void * pvParameters )
+{
+    MQTTEventData_t xMQTTCommand;
+    TickType_t xNextTimeoutTicks = 0, xHeldPublishTicks = portMAX_DELAY;
+    UBaseType_t uxCommands;
+
+    #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+        UBaseType_t uxBrokerNumber;
+        MQTTBrokerConnection_t * pxConnection;
+    #endif
+
+    /* Remove compiler warnings about unused parameters. */
+    ( void ) pvParameters;
+
+    for( ; ; )
+    {
+        /* Block until a command arrives or a connection needs service, then
+         * take any further commands that are already queued, up to the limit
+         * that keeps the connections from being starved. */
+        uxCommands = 0;
+
+        #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+            xCoalesceSends = pdTRUE;
+        #endif
+
+        if( xHeldPublishTicks != portMAX_DELAY )
+        {
+            /* A publish is held until a PUBACK makes room for it, so take no
+             * further commands.  Socket wakeups also notify this task, so the
+             * PUBACK is still seen straight away. */
+            ( void ) ulTaskNotifyTake( pdTRUE, ( xHeldPublishTicks < xNextTimeoutTicks ) ? xHeldPublishTicks : xNextTimeoutTicks );
+        }
+        else
+        {
+            while( ( uxCommands < ( UBaseType_t ) mqttconfigMQTT_TASK_MAX_COMMANDS_PER_WAKEUP ) &&
+                   ( xQueueReceive( xCommandQueue, &xMQTTCommand, ( uxCommands == 0U ) ? xNextTimeoutTicks : 0 ) != pdFALSE ) )
+            {
+                prvProcessCommand( &( xMQTTCommand ) );
+                uxCommands++;
+
+                /* Stop taking commands once one has to be held. */
+                if( xMQTTConnections[ xMQTTCommand.uxBrokerNumber ].xPublishHeld == pdTRUE )
+                {
+                    break;
+                }
+            }
+        }
+
+        /* Process active connections each time the queue unblocks.  It might
+         * be that the queue read timed out because a connection needs service. */
+        xNextTimeoutTicks = prvManageConnections();
+
+        /* A PUBACK or timeout processed above may have made room for a held
+         * publish. */
+        xHeldPublishTicks = prvRetryHeldPublishes();
+
+        #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 )
+            {
+                /* A CONNACK or PUBACK processed above may let more of the offline
+                 * queue be sent.  Service the connections again straight away so
+                 * that the timeouts of the publishes sent are accounted for. */
+                if( prvSendOfflinePublishes() == pdTRUE )
+                {
+                    xNextTimeoutTicks = 0;
+                }
+            }
+        #endif
+
+        #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+            {
+                /* Send what the commands and the connection service left in the
+                 * Tx buffers before blocking again. */
+                xCoalesceSends = pdFALSE;
+
+                for( uxBrokerNumber = 0; uxBrokerNumber < ( UBaseType_t ) mqttconfigMAX_BROKERS; uxBrokerNumber++ )
+                {
+                    pxConnection = &( xMQTTConnections[ uxBrokerNumber ] );
+
+                    if( pxConnection->xSocket != SOCKETS_INVALID_SOCKET )
+                    {
+                        ( void ) prvFlushTxBuffer( pxConnection );
+
+                        /* Packets the MQTT library believes were sent were lost
+                         * or cut short, so the connection cannot be trusted
+                         * any more. */
+                        if( pxConnection->xTxBufferLost == pdTRUE )
+                        {
+                            pxConnection->xTxBufferLost = pdFALSE;
+                            ( void ) MQTT_Disconnect( &( pxConnection->xMQTTContext ) );
+                        }
+                    }
+                }
+            }
+        #endif /* mqttconfigTX_COALESCE_BUFFER_SIZE */
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t MQTT_AGENT_Init( void )
+{
+    /* The following variables must be static as they hold data that is used as
+     * long as the MQTT application is running. */
+
+    /* The variable used to hold the queue's data structure. */
+    static StaticQueue_t xStaticQueue;
+
+    /* The array to use as the queue's storage area.  This must be at least
+     * uxQueueLength * uxItemSize bytes.  Again, must be static. */
+    static uint8_t ucQueueStorageArea[ mqttCOMMAND_QUEUE_LENGTH * sizeof( MQTTEventData_t ) ];
+
+    /* The stack used by the MQTT task. */
+    static StackType_t xStack[ mqttconfigMQTT_TASK_STACK_DEPTH ];
+
+    /* The variable used to hold the MQTT task's data structures. */
+    static StaticTask_t xStaticTask;
+
+    BaseType_t xReturnCode = pdPASS;
+    UBaseType_t x, y;
+
+    /* If the command queue is not NULL then the queue and task have already
+     * been created. */
+    if( xCommandQueue == NULL )
+    {
+        /* Ensure the connection structures start in a consistent state. */
+        memset( xMQTTConnections, 0x00, sizeof( xMQTTConnections ) );
+
+        for( x = 0; x < ( UBaseType_t ) mqttconfigMAX_BROKERS; x++ )
+        {
+            xMQTTConnections[ x ].xSocket = SOCKETS_INVALID_SOCKET;
+
+            /* Initialize user callback and data. These are provided during connect. */
+            xMQTTConnections[ x ].pvUserData = NULL;
+            xMQTTConnections[ x ].pxCallback = NULL;
+
+            /* Mark the connection "not in use". */
+            xMQTTConnections[ x ].xConnectionInUse = pdFALSE;
+
+            /* Initialize the MQTT Core Library context. */
+            MQTTInitParams_t xInitParams;
+            xInitParams.pvCallbackContext = ( void * ) x; /*lint !e923 The cast is ok as we are passing the index of the client. */
+            xInitParams.pxCallback = prvMQTTEventCallback;
+            xInitParams.pvSendContext = ( void * ) x;     /*lint !e923 The cast is ok as we are passing the index of the client. */
+            xInitParams.pxMQTTSendFxn = prvMQTTSendCallback;
+            xInitParams.pxGetTicksFxn = prvMQTTGetTicks;
+            xInitParams.xBufferPoolInterface.pxGetBufferFxn = mqttconfigGET_FREE_BUFFER_FXN;
+            xInitParams.xBufferPoolInterface.pxReturnBufferFxn = mqttconfigRETURN_BUFFER_FXN;
 
             if( MQTT_Init( &xMQTTConnections[ x ].xMQTTContext, &xInitParams ) != eMQTTSuccess )
             {
@@ -1888,6 +3356,20 @@ BaseType_t MQTT_AGENT_Init( void )
                 break;
             }
 
+            xMQTTConnections[ x ].xWakeupCallbackSet = pdFALSE;
+
+            #if ( mqttconfigTX_COALESCE_BUFFER_SIZE > 0 )
+                xMQTTConnections[ x ].ulTxBufferedLength = 0;
+                xMQTTConnections[ x ].ulTxBufferPublishes = 0;
+                xMQTTConnections[ x ].xTxBufferLost = pdFALSE;
+            #endif
+
+            #if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+                /* Pick up the publishes left in the persistent store before the
+                 * last reset. */
+                prvOfflineStoreLoad( &( xMQTTConnections[ x ] ) );
+            #endif
+
             /* Initialize waiting tasks list. */
             for( y = 0; y < ( UBaseType_t ) mqttconfigMAX_PARALLEL_OPS; y++ )
             {
@@ -2000,20 +3482,29 @@ MQTTAgentReturnCode_t MQTT_AGENT_Disconnect( MQTTAgentHandle_t xMQTTHandle,
 
 MQTTAgentReturnCode_t MQTT_AGENT_Subscribe( MQTTAgentHandle_t xMQTTHandle,
                                             const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                            uint32_t ulTopicCount,
+                                            MQTTSubACKReturnCode_t * const pxSubACKReturnCodes,
                                             TickType_t xTimeoutTicks )
 {
     MQTTEventData_t xEventData;
-    MQTTAgentReturnCode_t xReturnCode;
-
-    /* Setup the event to be sent to the command queue. */
-    xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
-    xEventData.xEventType = eMQTTSubscribeRequest;
-    xEventData.xTicksToWait = xTimeoutTicks;
-    xEventData.u.pxSubscribeParams = pxSubscribeParams;
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
 
-    /* Note that the notification data part of xEventData and
-     * xEventCreationTimestamp are set in the following call. */
-    xReturnCode = prvSendCommandToMQTTTask( &xEventData );
+    /* The MQTT task has room for at most mqttconfigSUBSCRIBE_MAX_TOPICS
+     * topic filters. */
+    if( ( ulTopicCount > 0 ) && ( ulTopicCount <= ( uint32_t ) mqttconfigSUBSCRIBE_MAX_TOPICS ) )
+    {
+        /* Setup the event to be sent to the command queue. */
+        xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+        xEventData.xEventType = eMQTTSubscribeRequest;
+        xEventData.xTicksToWait = xTimeoutTicks;
+        xEventData.ulTopicCount = ulTopicCount;
+        xEventData.u.pxSubscribeParams = pxSubscribeParams;
+        xEventData.xNotificationData.pxSubACKReturnCodes = pxSubACKReturnCodes;
+
+        /* Note that the rest of the notification data part of xEventData and
+         * xEventCreationTimestamp are set in the following call. */
+        xReturnCode = prvSendCommandToMQTTTask( &xEventData );
+    }
 
     /* Return the code to the user. */
     return xReturnCode;
@@ -2022,20 +3513,27 @@ MQTTAgentReturnCode_t MQTT_AGENT_Subscribe( MQTTAgentHandle_t xMQTTHandle,
 
 MQTTAgentReturnCode_t MQTT_AGENT_Unsubscribe( MQTTAgentHandle_t xMQTTHandle,
                                               const MQTTAgentUnsubscribeParams_t * const pxUnsubscribeParams,
+                                              uint32_t ulTopicCount,
                                               TickType_t xTimeoutTicks )
 {
     MQTTEventData_t xEventData;
-    MQTTAgentReturnCode_t xReturnCode;
-
-    /* Setup the event to be sent to the command queue. */
-    xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
-    xEventData.xEventType = eMQTTUnsubscribeRequest;
-    xEventData.xTicksToWait = xTimeoutTicks;
-    xEventData.u.pxUnsubscribeParams = pxUnsubscribeParams;
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
 
-    /* Note that the notification data part of xEventData and
-     * xEventCreationTimestamp are set in the following call. */
-    xReturnCode = prvSendCommandToMQTTTask( &xEventData );
+    /* The MQTT task has room for at most mqttconfigSUBSCRIBE_MAX_TOPICS
+     * topic filters. */
+    if( ( ulTopicCount > 0 ) && ( ulTopicCount <= ( uint32_t ) mqttconfigSUBSCRIBE_MAX_TOPICS ) )
+    {
+        /* Setup the event to be sent to the command queue. */
+        xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+        xEventData.xEventType = eMQTTUnsubscribeRequest;
+        xEventData.xTicksToWait = xTimeoutTicks;
+        xEventData.ulTopicCount = ulTopicCount;
+        xEventData.u.pxUnsubscribeParams = pxUnsubscribeParams;
+
+        /* Note that the notification data part of xEventData and
+         * xEventCreationTimestamp are set in the following call. */
+        xReturnCode = prvSendCommandToMQTTTask( &xEventData );
+    }
 
     /* Return the code to the user. */
     return xReturnCode;
@@ -2064,6 +3562,60 @@ MQTTAgentReturnCode_t MQTT_AGENT_Publish( MQTTAgentHandle_t xMQTTHandle,
 }
 /*-----------------------------------------------------------*/
 
+MQTTAgentReturnCode_t MQTT_AGENT_SubscribeAsync( MQTTAgentHandle_t xMQTTHandle,
+                                                 const MQTTAgentSubscribeParams_t * const pxSubscribeParams,
+                                                 uint32_t ulTopicCount,
+                                                 MQTTSubACKReturnCode_t * const pxSubACKReturnCodes,
+                                                 TickType_t xTimeoutTicks,
+                                                 MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                                 void * pvCallbackContext,
+                                                 MQTTAgentRequestHandle_t * const pxRequestHandle )
+{
+    MQTTEventData_t xEventData;
+    MQTTAgentReturnCode_t xReturnCode = eMQTTAgentFailure;
+
+    /* The MQTT task has room for at most mqttconfigSUBSCRIBE_MAX_TOPICS
+     * topic filters. */
+    if( ( ulTopicCount > 0 ) && ( ulTopicCount <= ( uint32_t ) mqttconfigSUBSCRIBE_MAX_TOPICS ) )
+    {
+        /* Setup the event to be sent to the command queue. */
+        xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+        xEventData.xEventType = eMQTTSubscribeRequest;
+        xEventData.xTicksToWait = xTimeoutTicks;
+        xEventData.ulTopicCount = ulTopicCount;
+        xEventData.u.pxSubscribeParams = pxSubscribeParams;
+        xEventData.xNotificationData.pxSubACKReturnCodes = pxSubACKReturnCodes;
+
+        /* Note that the rest of the notification data part of xEventData and
+         * xEventCreationTimestamp are set in the following call. */
+        xReturnCode = prvSendAsyncCommandToMQTTTask( &xEventData, pxCompletionCallback, pvCallbackContext, pxRequestHandle );
+    }
+
+    return xReturnCode;
+}
+/*-----------------------------------------------------------*/
+
+MQTTAgentReturnCode_t MQTT_AGENT_PublishAsync( MQTTAgentHandle_t xMQTTHandle,
+                                               const MQTTAgentPublishParams_t * const pxPublishParams,
+                                               TickType_t xTimeoutTicks,
+                                               MQTTAgentCompletionCallback_t pxCompletionCallback,
+                                               void * pvCallbackContext,
+                                               MQTTAgentRequestHandle_t * const pxRequestHandle )
+{
+    MQTTEventData_t xEventData;
+
+    /* Setup the event to be sent to the command queue. */
+    xEventData.uxBrokerNumber = ( UBaseType_t ) mqttDECODE_BROKER_NUMBER( xMQTTHandle ); /*lint !e923 Opaque pointer. */
+    xEventData.xEventType = eMQTTPublishRequest;
+    xEventData.xTicksToWait = xTimeoutTicks;
+    xEventData.u.pxPublishParams = pxPublishParams;
+
+    /* Note that the notification data part of xEventData and
+     * xEventCreationTimestamp are set in the following call. */
+    return prvSendAsyncCommandToMQTTTask( &xEventData, pxCompletionCallback, pvCallbackContext, pxRequestHandle );
+}
+/*-----------------------------------------------------------*/
+
 MQTTAgentReturnCode_t MQTT_AGENT_ReturnBuffer( MQTTAgentHandle_t xMQTTHandle,
                                                MQTTBufferHandle_t xBufferHandle )
 {
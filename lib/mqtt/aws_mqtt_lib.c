@@ -326,6 +326,28 @@
         ( srcIndex ) = ( uint32_t ) ( srcIndex ) + ( uint32_t ) ( byteCount );                           \
         ( dstIndex ) = ( uint32_t ) ( dstIndex ) + ( uint32_t ) ( byteCount );                           \
     }
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+
+/**
+ * @brief Index used for "no node" and "no subscription" in the topic trie.
+ */
+    #define mqttTOPIC_NODE_NONE    ( ( uint16_t ) 0xFFFF )
+
+/**
+ * @brief Returns the text of the level of a topic trie node.
+ *
+ * @param[in] pxManager The subscription manager.
+ * @param[in] pxNode The topic trie node.
+ */
+    #define mqttTOPIC_NODE_LEVEL( pxManager, pxNode ) \
+    ( &( ( pxManager )->xSubscriptions[ ( pxNode )->usTextOwner ].ucTopicFilter[ ( pxNode )->usLevelOffset ] ) )
+
+/* Node and subscription indexes must fit in a uint16_t. */
+    #if ( mqttconfigSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS >= 0xFFFF ) || ( mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES >= 0xFFFF )
+        #error "The topic trie supports less than 65535 subscriptions and topic nodes."
+    #endif
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
 /*-----------------------------------------------------------*/
 
 /**
@@ -357,6 +379,54 @@ static MQTTBufferHandle_t prvGetFreeBuffer( MQTTContext_t * pxMQTTContext,
 static void prvReturnBuffer( MQTTContext_t * pxMQTTContext,
                              MQTTBufferHandle_t xBuffer );
 
+/**
+ * @brief Calculates when MQTT_Periodic must next look at the given Tx buffer.
+ *
+ * That is when the operation times out or, for a publish which is
+ * retransmitted, when it is to be transmitted again if that is earlier.
+ *
+ * @param[in] xBuffer The Tx buffer.
+ *
+ * @return The tick count at which to look at the buffer, 0 if the buffer is
+ * yet to be time-stamped.
+ */
+static uint64_t prvGetTxBufferDeadline( MQTTBufferHandle_t xBuffer );
+
+/**
+ * @brief Inserts the given buffer into the Tx buffer list, keeping the list
+ * ordered by deadline.
+ *
+ * The list is searched from the tail as a newly sent packet usually has the
+ * latest deadline. Buffers with equal deadlines stay in the order in which
+ * they were inserted.
+ *
+ * The search is linear in the worst case. That is acceptable because the list
+ * only holds the packets waiting for an ACK: at most mqttconfigPUBLISH_WINDOW_SIZE
+ * publishes plus the few subscribes, unsubscribes and the connect in flight,
+ * and never more than the buffer pool holds. Publishes sent with the same
+ * timeout land at the tail straight away. A binary heap or a timer wheel would
+ * need an index or a slot number in MQTTBufferMetadata_t, which every pool
+ * buffer pays for, and gains nothing at these sizes.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] xBuffer The buffer to insert.
+ */
+static void prvInsertTxBufferByDeadline( MQTTContext_t * pxMQTTContext,
+                                         MQTTBufferHandle_t xBuffer );
+
+/**
+ * @brief Adds the given buffer to the Tx buffer list and to the identifier
+ * index.
+ *
+ * The packet identifier and the time-stamp must already be stored in the
+ * buffer.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] xBuffer The buffer to add.
+ */
+static void prvAddTxBuffer( MQTTContext_t * pxMQTTContext,
+                            MQTTBufferHandle_t xBuffer );
+
 /**
  * @brief Finds a Tx buffer containing the MQTT message matching the given packet
  * type and flags.
@@ -380,8 +450,8 @@ static MQTTBufferHandle_t prvPacketTypeFlagsGetTxBuffer( MQTTContext_t * pxMQTTC
  * @brief Finds a Tx buffer containing the MQTT message matching the given packet
  * type, flags and identifier.
  *
- * Iterates over all the buffers in the Tx buffer list to see if any buffer contains
- * a message in which:
+ * Iterates over the buffers in the bucket of the identifier index for the given
+ * identifier to see if any buffer contains a message in which:
  * 1. Top nibble of first byte matches the given packet type.
  * 2. Lower nibble of the first byte matches the given flags.
  * 3. The packet identifier in the buffer matches the given one.
@@ -402,8 +472,8 @@ static MQTTBufferHandle_t prvPacketTypeFlagsIdentifierGetTxBuffer( MQTTContext_t
  * @brief Finds a Tx buffer containing the MQTT message matching the given packet
  * type and identifier.
  *
- * Iterates over all the buffers in the Tx buffer list to see if any buffer contains
- * a message in which:
+ * Iterates over the buffers in the bucket of the identifier index for the given
+ * identifier to see if any buffer contains a message in which:
  * 1. Top nibble of first byte matches the given packet type.
  * 2. The packet identifier in the buffer matches the given one.
  *
@@ -490,6 +560,21 @@ static MQTTReturnCode_t prvSendData( MQTTContext_t * pxMQTTContext,
                                      const uint8_t * const pucData,
                                      uint32_t ulDataLength );
 
+#if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+
+/**
+ * @brief Transmits a QoS1 publish waiting for PUBACK again.
+ *
+ * The DUP flag is set in the fixed header before the packet is transmitted,
+ * followed by the payload if it was not copied into the buffer.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] xBuffer The Tx buffer containing the publish.
+ */
+    static void prvRetransmitPublish( MQTTContext_t * pxMQTTContext,
+                                      MQTTBufferHandle_t xBuffer );
+#endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+
 /**
  * @brief Decodes and processes the received MQTT message containing only fixed header.
  *
@@ -585,9 +670,14 @@ static void prvProcessReceivedPINGRESP( MQTTContext_t * pxMQTTContext );
  * free the buffer whenever done or supply it back for re-use by calling
  * MQTT_GiveBuffer.
  *
+ * If the message is parsed in place, pxMQTTContext->xRxBuffer is NULL and
+ * so is the buffer supplied in the callback.
+ *
  * @param[in] pxMQTTContext The MQTT context for which the message was received.
+ * @param[in] pucPacket The whole MQTT message, starting with the fixed header.
  */
-static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext );
+static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext,
+                                       const uint8_t * const pucPacket );
 
 /**
  * @brief Invokes the user supplied callback.
@@ -685,6 +775,23 @@ static uint8_t prvEncodeRemainingLength( uint32_t ulRemainingLength,
 static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemainingLength,
                                          uint32_t * const pulRemainingLength );
 
+/**
+ * @brief Finds a topic filter in an MQTT subscribe or unsubscribe message.
+ *
+ * The provided buffer must contain a valid MQTT subscribe or unsubscribe message,
+ * as constructed by MQTT_Subscribe or MQTT_Unsubscribe.
+ *
+ * @param[in] xBuffer The buffer containing the message.
+ * @param[in] ulIndex The index of the topic filter in the message.
+ * @param[out] pusTopicLength Receives the length of the topic filter.
+ *
+ * @return A pointer to the topic filter within the buffer, or NULL if the message
+ * contains no more than ulIndex topic filters.
+ */
+static const uint8_t * prvGetTopicFilter( MQTTBufferHandle_t xBuffer,
+                                          uint32_t ulIndex,
+                                          uint16_t * const pusTopicLength );
+
 /**
  * @brief Store the subscription in the subscription manager.
  *
@@ -734,21 +841,25 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
 /**
- * @brief Removes the subscription entry from the subscription manager corresponding
- * to the topic contained in the provided MQTT subscribe or unsubscribe message.
+ * @brief Removes the subscription entries from the subscription manager corresponding
+ * to the topics contained in the provided MQTT subscribe or unsubscribe message.
  *
  * The provided buffer must contain a valid MQTT subscribe or unsubscribe message.
- * It extracts the topic from the MQTT message and removes the corresponding entry
+ * It extracts the topics from the MQTT message and removes the corresponding entries
  * in the subscription manager by calling prvRemoveSubscription.
  *
- * @param[in] pxMQTTContext The MQTT context for which to remove the subscription.
+ * @param[in] pxMQTTContext The MQTT context for which to remove the subscriptions.
  * @param[in] xBuffer The provided buffer containing a valid MQTT subscribe or
  * unsubscribe message.
+ * @param[in] pucReturnCodes The return codes of the SUBACK received for the subscribe
+ * message, in which case only the topics the broker rejected are removed. NULL to
+ * remove all the topics.
  */
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
     static void prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( MQTTContext_t * pxMQTTContext,
-                                                                      MQTTBufferHandle_t xBuffer );
+                                                                      MQTTBufferHandle_t xBuffer,
+                                                                      const uint8_t * const pucReturnCodes );
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
@@ -830,14 +941,141 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
  *
  * @return eMQTTTrue if the topic matches the filter, eMQTTFalse otherwise.
  */
-#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 0 )
 
     static MQTTBool_t prvDoesTopicMatchTopicFilter( const uint8_t * const pucTopic,
                                                     uint16_t usTopicLength,
                                                     const uint8_t * const pucTopicFilter,
                                                     uint16_t usTopicFilterLength );
 
-#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && !mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+
+/**
+ * @brief Marks all the nodes of the topic trie as free.
+ *
+ * @param[in] pxManager The subscription manager.
+ */
+    static void prvResetTopicTrie( MQTTSubscriptionManager_t * pxManager );
+
+/**
+ * @brief Returns the index one past the end of the topic level starting at
+ * usLevelStart i.e. the index of the next '/' or the length of the topic.
+ *
+ * @param[in] pucTopic The topic or topic filter.
+ * @param[in] usTopicLength The length of the topic.
+ * @param[in] usLevelStart The index of the first character of the level.
+ *
+ * @return The end of the level.
+ */
+    static uint16_t prvGetTopicLevelEnd( const uint8_t * const pucTopic,
+                                         uint16_t usTopicLength,
+                                         uint16_t usLevelStart );
+
+/**
+ * @brief Finds the node for the given level text among the nodes of one
+ * topic level.
+ *
+ * @param[in] pxManager The subscription manager.
+ * @param[in] usFirstNode The first node of the topic level.
+ * @param[in] pucLevel The text of the level to find.
+ * @param[in] usLevelLength The length of the text.
+ *
+ * @return The index of the node, or mqttTOPIC_NODE_NONE if not found.
+ */
+    static uint16_t prvFindTopicNode( const MQTTSubscriptionManager_t * const pxManager,
+                                      uint16_t usFirstNode,
+                                      const uint8_t * const pucLevel,
+                                      uint16_t usLevelLength );
+
+/**
+ * @brief Finds the node at which the given topic filter ends.
+ *
+ * Levels are compared as text, so '+' and '#' only match themselves.
+ *
+ * @param[in] pxManager The subscription manager.
+ * @param[in] pucTopic The topic filter.
+ * @param[in] usTopicLength The length of the topic filter.
+ *
+ * @return The index of the node, or mqttTOPIC_NODE_NONE if not found.
+ */
+    static uint16_t prvLookupTopicNode( const MQTTSubscriptionManager_t * const pxManager,
+                                        const uint8_t * const pucTopic,
+                                        uint16_t usTopicLength );
+
+/**
+ * @brief Adds the levels of the topic filter of a subscription to the trie.
+ *
+ * Nothing is changed if there are not enough free nodes.
+ *
+ * @param[in] pxManager The subscription manager.
+ * @param[in] usSubscription The index of the subscription to add.
+ *
+ * @return eMQTTTrue if the subscription was added, eMQTTFalse otherwise.
+ */
+    static MQTTBool_t prvAddToTopicTrie( MQTTSubscriptionManager_t * pxManager,
+                                         uint16_t usSubscription );
+
+/**
+ * @brief Removes the levels of the topic filter of a subscription from the
+ * trie.
+ *
+ * Nodes no other subscription goes through are freed. Nodes which borrowed
+ * their text from the removed subscription borrow it from another one.
+ *
+ * @param[in] pxManager The subscription manager.
+ * @param[in] usSubscription The index of the subscription to remove.
+ */
+    static void prvRemoveFromTopicTrie( MQTTSubscriptionManager_t * pxManager,
+                                        uint16_t usSubscription );
+
+/**
+ * @brief Invokes the callback of a subscription, if it has one.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] usSubscription The index of the subscription, or
+ * mqttTOPIC_NODE_NONE in which case nothing is done.
+ * @param[in] pxPublishData The received publish message.
+ * @param[out] pxSubscriptionCallbackInvoked Set to eMQTTTrue if a callback
+ * was invoked.
+ * @param[out] pxBufferOwnershipTaken Set to the value returned by the
+ * callback.
+ */
+    static void prvInvokeSubscriptionCallback( MQTTContext_t * pxMQTTContext,
+                                               uint16_t usSubscription,
+                                               const MQTTPublishData_t * pxPublishData,
+                                               MQTTBool_t * pxSubscriptionCallbackInvoked,
+                                               MQTTBool_t * pxBufferOwnershipTaken );
+
+/**
+ * @brief Invokes the callbacks of the subscriptions which match the topic
+ * through at least one wild-card level.
+ *
+ * Walks the nodes of one topic level and recurses into the next level for
+ * each node matching the topic level starting at usLevelStart. The recursion
+ * is as deep as the deepest topic filter matching the topic.
+ *
+ * @param[in] pxMQTTContext The MQTT context.
+ * @param[in] usFirstNode The first node of the topic level.
+ * @param[in] pxPublishData The received publish message.
+ * @param[in] usLevelStart The start of the topic level to match, or one past
+ * the end of the topic if all the levels have been matched already.
+ * @param[in] xWildCardMatched Whether a wild-card level was matched already.
+ * @param[out] pxSubscriptionCallbackInvoked Set to eMQTTTrue if any callback
+ * was invoked.
+ * @param[in, out] pxBufferOwnershipTaken Set to eMQTTTrue if the user took the
+ * ownership of the MQTT buffer, which stops the walk.
+ */
+    static void prvInvokeWildCardSubscriptionCallbacks( MQTTContext_t * pxMQTTContext,
+                                                        uint16_t usFirstNode,
+                                                        const MQTTPublishData_t * pxPublishData,
+                                                        uint16_t usLevelStart,
+                                                        MQTTBool_t xWildCardMatched,
+                                                        MQTTBool_t * pxSubscriptionCallbackInvoked,
+                                                        MQTTBool_t * pxBufferOwnershipTaken );
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
 /*-----------------------------------------------------------*/
 
 static MQTTBufferHandle_t prvGetFreeBuffer( MQTTContext_t * pxMQTTContext,
@@ -879,8 +1117,10 @@ static void prvReturnBuffer( MQTTContext_t * pxMQTTContext,
         /* Clear the payload memory. */
         memset( mqttbufferGET_DATA( xBuffer ), 0x00, mqttbufferGET_EFFECTIVE_BUFFER_LENGTH( xBuffer ) );
 
-        /* If the buffer is part of Tx list, remove it. */
+        /* If the buffer is part of Tx list, remove it from the list and
+         * from the identifier index. */
         mqttbufferLIST_REMOVE( xBuffer );
+        listREMOVE( &( mqttbufferGET_IDENTIFIER_LINK( xBuffer ) ) );
 
         /* Return the buffer to the free buffer pool. */
         pxMQTTContext->xBufferPoolInterface.pxReturnBufferFxn( mqttbufferGET_RAW_BUFFER_FROM_HANDLE( xBuffer ) );
@@ -888,6 +1128,60 @@ static void prvReturnBuffer( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
+static uint64_t prvGetTxBufferDeadline( MQTTBufferHandle_t xBuffer )
+{
+    uint64_t xDeadlineTickCount = 0;
+
+    /* A buffer which is yet to be time-stamped is due straight away. */
+    if( mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) != ( uint64_t ) 0 )
+    {
+        xDeadlineTickCount = mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) + mqttbufferGET_PACKET_TIMEOUT_TICKS( xBuffer );
+
+        #if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+            if( ( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH )
+            {
+                xDeadlineTickCount = mqttMIN( xDeadlineTickCount,
+                                              mqttbufferGET_PACKET_RETRANSMIT_RECORDED_TICK_COUNT( xBuffer ) + ( uint64_t ) mqttconfigPUBLISH_RETRANSMIT_TICKS );
+            }
+        #endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+    }
+
+    return xDeadlineTickCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertTxBufferByDeadline( MQTTContext_t * pxMQTTContext,
+                                         MQTTBufferHandle_t xBuffer )
+{
+    Link_t * pxLink;
+    const uint64_t xDeadlineTickCount = prvGetTxBufferDeadline( xBuffer );
+
+    /* Find the last buffer which is due no later than this one. If there
+     * is none, pxLink ends up at the list head and the buffer becomes the
+     * first one. */
+    pxLink = pxMQTTContext->xTxBufferListHead.pxPrev;
+
+    while( ( pxLink != &( pxMQTTContext->xTxBufferListHead ) ) &&
+           ( prvGetTxBufferDeadline( mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink ) ) > xDeadlineTickCount ) )
+    {
+        pxLink = pxLink->pxPrev;
+    }
+
+    /* Insert the buffer after it. */
+    mqttbufferLIST_ADD( pxLink, xBuffer );
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddTxBuffer( MQTTContext_t * pxMQTTContext,
+                            MQTTBufferHandle_t xBuffer )
+{
+    uint32_t ulBucket = ( uint32_t ) mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) & ( ( uint32_t ) mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS - ( uint32_t ) 1 );
+
+    prvInsertTxBufferByDeadline( pxMQTTContext, xBuffer );
+    listADD( &( pxMQTTContext->xTxBufferIdentifierBuckets[ ulBucket ] ), &( mqttbufferGET_IDENTIFIER_LINK( xBuffer ) ) );
+}
+/*-----------------------------------------------------------*/
+
 static MQTTBufferHandle_t prvPacketTypeFlagsGetTxBuffer( MQTTContext_t * pxMQTTContext,
                                                          uint8_t ucPacketType,
                                                          uint8_t ucFlags )
@@ -930,10 +1224,11 @@ static MQTTBufferHandle_t prvPacketTypeFlagsIdentifierGetTxBuffer( MQTTContext_t
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTBool_t xFound = eMQTTFalse;
 
-    /* Iterate over all buffers in the Tx buffer list. */
-    listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferListHead ) )
+    /* Iterate over the buffers whose identifiers share the bucket of the
+     * given one. */
+    listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferIdentifierBuckets[ ( uint32_t ) usPacketIdentifier & ( ( uint32_t ) mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS - ( uint32_t ) 1 ) ] ) )
     {
-        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_IDENTIFIER_LINK( pxLink );
 
         /* Check that the first byte contains the given packet type
          * and flags and the packet identifier matches the given one. */
@@ -964,10 +1259,11 @@ static MQTTBufferHandle_t prvPacketTypeIdentifierGetTxBuffer( MQTTContext_t * px
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTBool_t xFound = eMQTTFalse;
 
-    /* Iterate over all buffers in the Tx buffer list. */
-    listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferListHead ) )
+    /* Iterate over the buffers whose identifiers share the bucket of the
+     * given one. */
+    listFOR_EACH( pxLink, &( pxMQTTContext->xTxBufferIdentifierBuckets[ ( uint32_t ) usPacketIdentifier & ( ( uint32_t ) mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS - ( uint32_t ) 1 ) ] ) )
     {
-        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_IDENTIFIER_LINK( pxLink );
 
         /* Check that the first byte contains the given packet type
          * and flags and the packet identifier matches the given one. */
@@ -1013,6 +1309,9 @@ static void prvResetMQTTContext( MQTTContext_t * pxMQTTContext )
     /* Set connection state to not connected. */
     pxMQTTContext->xConnectionState = eMQTTNotConnected;
 
+    /* No publish is waiting for PUBACK any more. */
+    pxMQTTContext->ulPublishesInFlight = 0;
+
     /* Return all Tx buffers to the free buffer pool. */
     listFOR_EACH_SAFE( pxLink, pxTempLink, &( pxMQTTContext->xTxBufferListHead ) )
     {
@@ -1037,6 +1336,10 @@ static void prvResetMQTTContext( MQTTContext_t * pxMQTTContext )
 
         /* Set the number of in-use subscription entries to zero. */
         pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions = 0;
+
+        #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+            prvResetTopicTrie( &( pxMQTTContext->xSubscriptionManager ) );
+        #endif
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 }
 /*-----------------------------------------------------------*/
@@ -1121,6 +1424,30 @@ static MQTTReturnCode_t prvSendData( MQTTContext_t * pxMQTTContext,
 }
 /*-----------------------------------------------------------*/
 
+#if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+
+    static void prvRetransmitPublish( MQTTContext_t * pxMQTTContext,
+                                      MQTTBufferHandle_t xBuffer )
+    {
+        MQTTReturnCode_t xReturnCode;
+
+        mqttconfigDEBUG_LOG( ( "Retransmitting publish %d.\r\n", mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) ) );
+
+        /* The broker may already have received the publish and only the
+         * PUBACK been lost, so mark the packet as a duplicate. */
+        mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] |= mqttFLAGS_PUBLISH_DUP;
+
+        xReturnCode = prvSendData( pxMQTTContext, mqttbufferGET_DATA( xBuffer ), mqttbufferGET_DATA_LENGTH( xBuffer ) );
+
+        if( ( xReturnCode == eMQTTSuccess ) && ( mqttbufferGET_PACKET_PAYLOAD( xBuffer ) != NULL ) )
+        {
+            ( void ) prvSendData( pxMQTTContext, ( const uint8_t * ) mqttbufferGET_PACKET_PAYLOAD( xBuffer ), mqttbufferGET_PACKET_PAYLOAD_LENGTH( xBuffer ) );
+        }
+    }
+
+#endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+/*-----------------------------------------------------------*/
+
 static void prvProcessReceivedFixedHeaderOnlyMQTTPacket( MQTTContext_t * pxMQTTContext )
 {
     MQTTEventCallbackParams_t xEventCallbackParams;
@@ -1151,7 +1478,7 @@ static void prvProcessReceivedMQTTPacket( MQTTContext_t * pxMQTTContext )
     /* Is this a publish message from broker? */
     if( ( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH )
     {
-        prvProcessReceivedPublish( pxMQTTContext );
+        prvProcessReceivedPublish( pxMQTTContext, mqttbufferGET_DATA( pxMQTTContext->xRxBuffer ) );
     }
     /* Is this a CONNACK? */
     else if( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_CONNACK | mqttFLAGS_CONNACK ) )
@@ -1348,8 +1675,9 @@ static void prvProcessReceivedSUBACK( MQTTContext_t * pxMQTTContext )
     MQTTBufferHandle_t xSubscribeTxBuffer;
     MQTTEventCallbackParams_t xEventCallbackParams;
     MQTTBool_t xMalformedPacket = eMQTTFalse;
-    uint8_t ucReturnCode;
-    uint16_t usPacketIdentifier;
+    const uint8_t * pucReturnCodes;
+    uint32_t x, ulReturnCodeCount;
+    uint16_t usPacketIdentifier, usTopicLength;
 
     /* Must have enough bytes to at least read out one return code. */
     if( mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) > ( uint32_t ) mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
@@ -1375,52 +1703,73 @@ static void prvProcessReceivedSUBACK( MQTTContext_t * pxMQTTContext )
         }
         else
         {
-            /* Extract the return code from the packet. */
-            ucReturnCode = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
-                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
+            /* The return codes take the rest of the packet, one for each
+             * topic filter of the subscribe message. */
+            pucReturnCodes = &( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
+                                                                                                   pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ] );
+            ulReturnCodeCount = mqttbufferGET_DATA_LENGTH( pxMQTTContext->xRxBuffer ) - ( uint32_t ) mqttADJUST_OFFSET( mqttSUBACK_RETURN_CODE_OFFSET,
+                                                                                                                         pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes );
+
+            if( ( prvGetTopicFilter( xSubscribeTxBuffer, ulReturnCodeCount - ( uint32_t ) 1, &usTopicLength ) == NULL ) ||
+                ( prvGetTopicFilter( xSubscribeTxBuffer, ulReturnCodeCount, &usTopicLength ) != NULL ) )
+            {
+                /* Malformed packet - not one return code per topic filter. */
+                xMalformedPacket = eMQTTTrue;
+            }
 
-            /* Return code must be valid. Note that QoS2 is not supported. */
-            if( ( ucReturnCode <= ( uint8_t ) 1 ) || ( ucReturnCode == ( uint8_t ) 128 ) )
+            /* Inform the user about the received SUBACK. */
+            xEventCallbackParams.xEventType = eMQTTSubACK;
+            xEventCallbackParams.u.xMQTTSubACKData.usPacketIdentifier = usPacketIdentifier;
+            xEventCallbackParams.u.xMQTTSubACKData.pucReturnCodes = pucReturnCodes;
+            xEventCallbackParams.u.xMQTTSubACKData.ulReturnCodeCount = ulReturnCodeCount;
+
+            /* Convert the return code of the first topic filter to a user
+             * friendly enum value. */
+            if( pucReturnCodes[ 0 ] == ( uint8_t ) 0 )
+            {
+                xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKSuccessQos0;
+            }
+            else
             {
-                /* Inform the user about the received SUBACK. */
-                xEventCallbackParams.xEventType = eMQTTSubACK;
+                xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKSuccessQos1;
+            }
 
-                /* Convert the return code to a user friendly enum value. */
-                if( ucReturnCode == ( uint8_t ) 0 )
+            for( x = 0; x < ulReturnCodeCount; x++ )
+            {
+                /* Return code must be valid. Note that QoS2 is not supported. */
+                if( pucReturnCodes[ x ] == ( uint8_t ) 128 )
                 {
-                    xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKSuccessQos0;
+                    xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKFailure;
                 }
-                else if( ucReturnCode == ( uint8_t ) 1 )
+                else if( pucReturnCodes[ x ] > ( uint8_t ) 1 )
                 {
-                    xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKSuccessQos1;
+                    /* Malformed packet - reserved return code. */
+                    xMalformedPacket = eMQTTTrue;
                 }
                 else
                 {
-                    xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode = eMQTTSubACKFailure;
+                    /* Subscription accepted. */
                 }
+            }
 
-                xEventCallbackParams.u.xMQTTSubACKData.usPacketIdentifier = usPacketIdentifier;
+            if( xMalformedPacket == eMQTTFalse )
+            {
                 ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
 
                 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-                    /* If the broker rejected the subscription request,
-                     * remove the subscription entry from the subscription
-                     * manager. */
-                    if( ucReturnCode == ( uint8_t ) 128 ) /* Subscription failure. */
+                    /* If the broker rejected any of the topic filters,
+                     * remove their subscription entries from the
+                     * subscription manager. */
+                    if( xEventCallbackParams.u.xMQTTSubACKData.xSubACKReturnCode == eMQTTSubACKFailure )
                     {
-                        prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xSubscribeTxBuffer );
+                        prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xSubscribeTxBuffer, pucReturnCodes );
                     }
                 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
                 /* Return the Tx Buffer to the pool. */
                 prvReturnBuffer( pxMQTTContext, xSubscribeTxBuffer );
             }
-            else
-            {
-                /* Malformed packet - reserved return code. */
-                xMalformedPacket = eMQTTTrue;
-            }
         }
     }
     else
@@ -1498,7 +1847,7 @@ static void prvProcessReceivedUNSUBACK( MQTTContext_t * pxMQTTContext )
                     /* If we successfully unsubscribed, remove the
                      * corresponding subscription entry from the subscription
                      * manager. */
-                    prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xUnsubscribeTxBuffer );
+                    prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xUnsubscribeTxBuffer, NULL );
                 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
                 /* Return the Tx Buffer to the pool. */
@@ -1583,6 +1932,7 @@ static void prvProcessReceivedPUBACK( MQTTContext_t * pxMQTTContext )
 
                 /* Return the Tx Buffer to the pool. */
                 prvReturnBuffer( pxMQTTContext, xPublishTxBuffer );
+                pxMQTTContext->ulPublishesInFlight--;
             }
         }
         else
@@ -1669,7 +2019,8 @@ static void prvProcessReceivedPINGRESP( MQTTContext_t * pxMQTTContext )
 }
 /*-----------------------------------------------------------*/
 
-static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
+static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext,
+                                       const uint8_t * const pucPacket )
 {
     MQTTEventCallbackParams_t xEventCallbackParams;
     uint8_t ucPacketIdentiferLength; /* Length in bytes taken by the packet identifier field in the received publish packet. */
@@ -1687,7 +2038,7 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
     xEventCallbackParams.xEventType = eMQTTPublish;
 
     /*_TODO_ Do we want to expose DUP and RETAIN? */
-    ucQos = mqttPUBLISH_QoS_BITS( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] );
+    ucQos = mqttPUBLISH_QoS_BITS( pucPacket[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] );
 
     /* QoS2 is not supported. */
     if( ( ucQos == ( uint8_t ) 0 /* QoS0. */ ) || ( ucQos == ( uint8_t ) 1 /* QoS1. */ ) )
@@ -1704,18 +2055,18 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
         }
 
         /* Extract Topic Length. */
-        xEventCallbackParams.u.xPublishData.usTopicLength = ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_MSB,
+        xEventCallbackParams.u.xPublishData.usTopicLength = ( uint16_t ) pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_MSB,
                                                                                                                                             pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
         xEventCallbackParams.u.xPublishData.usTopicLength <<= mqttBITS_PER_BYTE;
-        xEventCallbackParams.u.xPublishData.usTopicLength |= ( uint16_t ) mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_LSB,
+        xEventCallbackParams.u.xPublishData.usTopicLength |= ( uint16_t ) pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_LENGTH_LSB,
                                                                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ];
 
         /* Extract Topic. */
-        xEventCallbackParams.u.xPublishData.pucTopic = &( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+        xEventCallbackParams.u.xPublishData.pucTopic = &( pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
                                                                                                                              pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) ] );
 
         /* Extract Published Data. */
-        xEventCallbackParams.u.xPublishData.pvData = ( void * ) &( mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+        xEventCallbackParams.u.xPublishData.pvData = ( void * ) &( pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
                                                                                                                                       pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
                                                                                                                    xEventCallbackParams.u.xPublishData.usTopicLength +
                                                                                                                    ucPacketIdentiferLength ] ); /*lint !e9087 Publish data is provided as void* to the user. */
@@ -1737,10 +2088,10 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
         {
             /* Extract the packet identifier from the publish message
              * to set the same in PUBACK message. */
-            ucPUBACKPacket[ mqttPUBACK_PACKET_ID_MSB_OFFSET ] = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+            ucPUBACKPacket[ mqttPUBACK_PACKET_ID_MSB_OFFSET ] = pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
                                                                                                                                    pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
                                                                                                                 xEventCallbackParams.u.xPublishData.usTopicLength ];
-            ucPUBACKPacket[ mqttPUBACK_PACKET_ID_LSB_OFFSET ] = mqttbufferGET_DATA( pxMQTTContext->xRxBuffer )[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
+            ucPUBACKPacket[ mqttPUBACK_PACKET_ID_LSB_OFFSET ] = pucPacket[ mqttADJUST_OFFSET( mqttPUBLISH_TOPIC_STRING_OFFSET,
                                                                                                                                    pxMQTTContext->xRxMessageState.ucRemaingingLengthFieldBytes ) +
                                                                                                                 xEventCallbackParams.u.xPublishData.usTopicLength +
                                                                                                                 ( uint16_t ) 1 /* Packet ID LSB follows MSB. */ ];
@@ -1757,6 +2108,13 @@ static void prvProcessReceivedPublish( MQTTContext_t * pxMQTTContext )
         {
             prvReturnBuffer( pxMQTTContext, pxMQTTContext->xRxBuffer );
         }
+        else
+        {
+            /* A message delivered in place cannot be owned by the user as
+             * it lives in the memory passed to MQTT_ParseReceivedData.  Only
+             * connections which set xDeliverPublishesInPlace get here. */
+            mqttconfigASSERT( pxMQTTContext->xRxBuffer != NULL );
+        }
     }
     else
     {
@@ -1978,6 +2336,58 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 }
 /*-----------------------------------------------------------*/
 
+static const uint8_t * prvGetTopicFilter( MQTTBufferHandle_t xBuffer,
+                                          uint32_t ulIndex,
+                                          uint16_t * const pusTopicLength )
+{
+    const uint8_t * pucTopic = NULL;
+    uint8_t ucRemaingingLengthFieldBytes;
+    uint32_t x, ulOffset, ulEntryOverhead;
+    uint16_t usTopicLength = 0;
+
+    /* Get the number of bytes "Remaining Length" field spans
+     * from the subscribe or unsubscribe Tx buffer. */
+    ucRemaingingLengthFieldBytes = prvDecodeRemainingLength( &( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] ), NULL );
+
+    /* We must be able to successfully decode the remaining length
+     * as this MQTT packet was constructed by us. */
+    mqttconfigASSERT( ucRemaingingLengthFieldBytes > 0 );
+
+    /* Each topic filter is preceded by its length, and followed by the
+     * requested QoS in a subscribe message.  Note that the topics start
+     * at the same offset in both subscribe and unsubscribe message. */
+    if( ( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_SUBSCRIBE )
+    {
+        ulEntryOverhead = ( uint32_t ) mqttSTRLEN( 0 ) + ( uint32_t ) mqttSUBSCRIBE_REQUESTED_QOS_LENGTH;
+    }
+    else
+    {
+        ulEntryOverhead = ( uint32_t ) mqttSTRLEN( 0 );
+    }
+
+    ulOffset = ( uint32_t ) mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET, ucRemaingingLengthFieldBytes );
+
+    for( x = 0; ( ulOffset + ulEntryOverhead ) <= mqttbufferGET_DATA_LENGTH( xBuffer ); x++ )
+    {
+        usTopicLength = ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ ulOffset ] );
+        usTopicLength <<= mqttBITS_PER_BYTE;
+        usTopicLength |= ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ ulOffset + ( uint32_t ) 1 ] );
+
+        if( x == ulIndex )
+        {
+            pucTopic = &( mqttbufferGET_DATA( xBuffer )[ ulOffset + ( uint32_t ) 2 ] );
+            break;
+        }
+
+        ulOffset += ( uint32_t ) usTopicLength + ulEntryOverhead;
+    }
+
+    *pusTopicLength = usTopicLength;
+
+    return pucTopic;
+}
+/*-----------------------------------------------------------*/
+
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
     static MQTTBool_t prvStoreSubscription( MQTTContext_t * pxMQTTContext,
@@ -2023,6 +2433,18 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                             pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].pxPublishCallback = pxPublishCallback;
                             pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xTopicFilterType = xTopicFilterType;
 
+                            #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+
+                                /* Index the topic filter levels. */
+                                if( prvAddToTopicTrie( &( pxMQTTContext->xSubscriptionManager ), ( uint16_t ) x ) == eMQTTFalse )
+                                {
+                                    /* Topic trie full. */
+                                    mqttconfigDEBUG_LOG( ( "WARN: No free topic nodes left to store the subscription. Consider increasing mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES.\r\n" ) );
+                                    pxMQTTContext->xSubscriptionManager.xSubscriptions[ x ].xInUse = eMQTTFalse;
+                                    break;
+                                }
+                            #endif /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
+
                             /* Increase the in-use subscription entries count. */
                             pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions += ( uint32_t ) 1;
 
@@ -2065,6 +2487,30 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                                        const uint8_t * const pucTopic,
                                        uint16_t usTopicLength )
     {
+        #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+            uint16_t usNode, usSubscription;
+
+            /* The subscription, if any, is at the node where the topic
+             * filter ends. */
+            usNode = prvLookupTopicNode( &( pxMQTTContext->xSubscriptionManager ), pucTopic, usTopicLength );
+
+            if( usNode != mqttTOPIC_NODE_NONE )
+            {
+                usSubscription = pxMQTTContext->xSubscriptionManager.xTopicNodes[ usNode ].usSubscription;
+
+                if( usSubscription != mqttTOPIC_NODE_NONE )
+                {
+                    prvRemoveFromTopicTrie( &( pxMQTTContext->xSubscriptionManager ), usSubscription );
+
+                    /* Mark the subscription entry as free. */
+                    pxMQTTContext->xSubscriptionManager.xSubscriptions[ usSubscription ].xInUse = eMQTTFalse;
+
+                    /* Reduce the count of in-use subscription entries
+                     * in the subscription manager. */
+                    pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions -= ( uint32_t ) 1;
+                }
+            }
+        #else /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
         uint32_t x;
 
         /* Iterate over all the subscription entries in
@@ -2089,6 +2535,7 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                 }
             }
         }
+        #endif /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
     }
 
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2097,34 +2544,28 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
     static void prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( MQTTContext_t * pxMQTTContext,
-                                                                      MQTTBufferHandle_t xBuffer )
+                                                                      MQTTBufferHandle_t xBuffer,
+                                                                      const uint8_t * const pucReturnCodes )
     {
-        uint8_t ucRemaingingLengthFieldBytes;
+        const uint8_t * pucTopic;
         uint16_t usTopicLength;
+        uint32_t x;
 
-        /* Get the number of bytes "Remaining Length" field spans
-         * from the subscribe or unsubscribe Tx buffer. */
-        ucRemaingingLengthFieldBytes = prvDecodeRemainingLength( &( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_REMAINING_LENGTH_OFFSET ] ), NULL );
-
-        /* We must be able to successfully decode the remaining length
-         * as this MQTT packet was constructed by us. */
-        mqttconfigASSERT( ucRemaingingLengthFieldBytes > 0 );
-
-        /* Read the topic length which precedes the topic name
-         * in the MQTT subscribe packet. Note that the topic
-         * happens to be at the same offset in both subscribe
-         * and unsubscribe message and therefore there is no need
-         * to repeat the same code with different #defines. */
-        usTopicLength = ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET,
-                                                                                        ucRemaingingLengthFieldBytes ) ] );
-        usTopicLength <<= mqttBITS_PER_BYTE;
-        usTopicLength |= ( uint8_t ) ( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 1 ),
-                                                                                         ucRemaingingLengthFieldBytes ) ] );
+        /* Remove the subscription entry of each topic in the message, or
+         * of each topic the broker rejected. */
+        x = 0;
+        pucTopic = prvGetTopicFilter( xBuffer, x, &usTopicLength );
 
-        /* Remove the subscription entry from the subscription manager. */
-        prvRemoveSubscription( pxMQTTContext,
-                               &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( ( mqttSUBSCRIBE_TOPIC_OFFSET + 2 ), ucRemaingingLengthFieldBytes ) ] ),
-                               usTopicLength );
+        while( pucTopic != NULL )
+        {
+            if( ( pucReturnCodes == NULL ) || ( pucReturnCodes[ x ] == ( uint8_t ) eMQTTSubACKFailure ) )
+            {
+                prvRemoveSubscription( pxMQTTContext, pucTopic, usTopicLength );
+            }
+
+            x++;
+            pucTopic = prvGetTopicFilter( xBuffer, x, &usTopicLength );
+        }
     }
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 /*-----------------------------------------------------------*/
@@ -2136,6 +2577,40 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                                                       MQTTBool_t * pxSubscriptionCallbackInvoked )
     {
         MQTTBool_t xBufferOwnershipTaken = eMQTTFalse;
+
+        #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+            uint16_t usNode;
+
+            /* Set the output parameter to eMQTTFalse. It will
+             * be set to eMQTTTrue if any callback is invoked. */
+            *pxSubscriptionCallbackInvoked = eMQTTFalse;
+
+            /* The topic filter without any wild-cards which matches the
+             * topic ends at the node found by following the topic levels. */
+            usNode = prvLookupTopicNode( &( pxMQTTContext->xSubscriptionManager ), pxPublishData->pucTopic, pxPublishData->usTopicLength );
+
+            if( usNode != mqttTOPIC_NODE_NONE )
+            {
+                prvInvokeSubscriptionCallback( pxMQTTContext,
+                                               pxMQTTContext->xSubscriptionManager.xTopicNodes[ usNode ].usSubscription,
+                                               pxPublishData,
+                                               pxSubscriptionCallbackInvoked,
+                                               &( xBufferOwnershipTaken ) );
+            }
+
+            /* Then walk the branches of the trie which match the topic
+             * through wild-cards. */
+            if( xBufferOwnershipTaken == eMQTTFalse )
+            {
+                prvInvokeWildCardSubscriptionCallbacks( pxMQTTContext,
+                                                        pxMQTTContext->xSubscriptionManager.usFirstTopicNode,
+                                                        pxPublishData,
+                                                        0,
+                                                        eMQTTFalse,
+                                                        pxSubscriptionCallbackInvoked,
+                                                        &( xBufferOwnershipTaken ) );
+            }
+        #else /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
         MQTTSubscription_t * pxSubscription;
         uint32_t x;
 
@@ -2219,6 +2694,7 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
                 }
             }
         }
+        #endif /* mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
 
         /* Return whether or not the user has taken the
          * ownership of the MQTT buffer. */
@@ -2320,7 +2796,7 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 /*-----------------------------------------------------------*/
 
-#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 0 )
 
     static MQTTBool_t prvDoesTopicMatchTopicFilter( const uint8_t * const pucTopic,
                                                     uint16_t usTopicLength,
@@ -2417,12 +2893,367 @@ static uint8_t prvDecodeRemainingLength( const uint8_t * const pucEncodedRemaini
         return xTopicMatchesTopicFilter;
     }
 
-#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && !mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
+/*-----------------------------------------------------------*/
+
+#if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 ) && ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+
+    static void prvResetTopicTrie( MQTTSubscriptionManager_t * pxManager )
+    {
+        uint32_t x;
+
+        for( x = 0; x < ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES; x++ )
+        {
+            pxManager->xTopicNodes[ x ].usRefCount = 0;
+        }
+
+        pxManager->ulFreeTopicNodes = ( uint32_t ) mqttconfigSUBSCRIPTION_MANAGER_MAX_TOPIC_NODES;
+        pxManager->usFirstTopicNode = mqttTOPIC_NODE_NONE;
+    }
+/*-----------------------------------------------------------*/
+
+    static uint16_t prvGetTopicLevelEnd( const uint8_t * const pucTopic,
+                                         uint16_t usTopicLength,
+                                         uint16_t usLevelStart )
+    {
+        uint16_t usLevelEnd = usLevelStart;
+
+        while( ( usLevelEnd < usTopicLength ) && ( pucTopic[ usLevelEnd ] != ( uint8_t ) '/' ) )
+        {
+            usLevelEnd++;
+        }
+
+        return usLevelEnd;
+    }
+/*-----------------------------------------------------------*/
+
+    static uint16_t prvFindTopicNode( const MQTTSubscriptionManager_t * const pxManager,
+                                      uint16_t usFirstNode,
+                                      const uint8_t * const pucLevel,
+                                      uint16_t usLevelLength )
+    {
+        uint16_t usNode = usFirstNode;
+        const MQTTTopicNode_t * pxNode;
+
+        while( usNode != mqttTOPIC_NODE_NONE )
+        {
+            pxNode = &( pxManager->xTopicNodes[ usNode ] );
+
+            if( ( pxNode->usLevelLength == usLevelLength ) &&
+                ( memcmp( mqttTOPIC_NODE_LEVEL( pxManager, pxNode ), pucLevel, usLevelLength ) == 0 ) )
+            {
+                break;
+            }
+
+            usNode = pxNode->usNextSibling;
+        }
+
+        return usNode;
+    }
+/*-----------------------------------------------------------*/
+
+    static uint16_t prvLookupTopicNode( const MQTTSubscriptionManager_t * const pxManager,
+                                        const uint8_t * const pucTopic,
+                                        uint16_t usTopicLength )
+    {
+        uint16_t usLevelStart, usLevelEnd, usNode = mqttTOPIC_NODE_NONE, usFirstNode = pxManager->usFirstTopicNode;
+
+        /* Follow the levels of the topic down the trie. */
+        for( usLevelStart = 0; usLevelStart <= usTopicLength; usLevelStart = usLevelEnd + ( uint16_t ) 1 )
+        {
+            usLevelEnd = prvGetTopicLevelEnd( pucTopic, usTopicLength, usLevelStart );
+            usNode = prvFindTopicNode( pxManager, usFirstNode, &( pucTopic[ usLevelStart ] ), usLevelEnd - usLevelStart );
+
+            if( usNode == mqttTOPIC_NODE_NONE )
+            {
+                break;
+            }
+
+            usFirstNode = pxManager->xTopicNodes[ usNode ].usFirstChild;
+        }
+
+        return usNode;
+    }
+/*-----------------------------------------------------------*/
+
+    static MQTTBool_t prvAddToTopicTrie( MQTTSubscriptionManager_t * pxManager,
+                                         uint16_t usSubscription )
+    {
+        const uint8_t * const pucTopic = pxManager->xSubscriptions[ usSubscription ].ucTopicFilter;
+        const uint16_t usTopicLength = pxManager->xSubscriptions[ usSubscription ].usTopicFilterLength;
+        uint16_t usLevelStart, usLevelEnd, usNode = mqttTOPIC_NODE_NONE, usFreeNode = 0;
+        uint16_t * pusFirstNode;
+        uint32_t ulNewNodes = 0;
+        MQTTBool_t xAdded = eMQTTFalse;
+
+        /* Count the levels which do not have a node yet. */
+        pusFirstNode = &( pxManager->usFirstTopicNode );
+
+        for( usLevelStart = 0; usLevelStart <= usTopicLength; usLevelStart = usLevelEnd + ( uint16_t ) 1 )
+        {
+            usLevelEnd = prvGetTopicLevelEnd( pucTopic, usTopicLength, usLevelStart );
+
+            if( ulNewNodes == ( uint32_t ) 0 )
+            {
+                usNode = prvFindTopicNode( pxManager, *pusFirstNode, &( pucTopic[ usLevelStart ] ), usLevelEnd - usLevelStart );
+            }
+
+            if( ( ulNewNodes != ( uint32_t ) 0 ) || ( usNode == mqttTOPIC_NODE_NONE ) )
+            {
+                ulNewNodes++;
+            }
+            else
+            {
+                pusFirstNode = &( pxManager->xTopicNodes[ usNode ].usFirstChild );
+            }
+        }
+
+        if( ulNewNodes <= pxManager->ulFreeTopicNodes )
+        {
+            pusFirstNode = &( pxManager->usFirstTopicNode );
+
+            for( usLevelStart = 0; usLevelStart <= usTopicLength; usLevelStart = usLevelEnd + ( uint16_t ) 1 )
+            {
+                usLevelEnd = prvGetTopicLevelEnd( pucTopic, usTopicLength, usLevelStart );
+                usNode = prvFindTopicNode( pxManager, *pusFirstNode, &( pucTopic[ usLevelStart ] ), usLevelEnd - usLevelStart );
+
+                if( usNode == mqttTOPIC_NODE_NONE )
+                {
+                    /* Take a free node and put it first in this level. */
+                    while( pxManager->xTopicNodes[ usFreeNode ].usRefCount != ( uint16_t ) 0 )
+                    {
+                        usFreeNode++;
+                    }
+
+                    usNode = usFreeNode;
+                    pxManager->xTopicNodes[ usNode ].usFirstChild = mqttTOPIC_NODE_NONE;
+                    pxManager->xTopicNodes[ usNode ].usNextSibling = *pusFirstNode;
+                    pxManager->xTopicNodes[ usNode ].usSubscription = mqttTOPIC_NODE_NONE;
+                    pxManager->xTopicNodes[ usNode ].usTextOwner = usSubscription;
+                    pxManager->xTopicNodes[ usNode ].usLevelOffset = usLevelStart;
+                    pxManager->xTopicNodes[ usNode ].usLevelLength = usLevelEnd - usLevelStart;
+                    *pusFirstNode = usNode;
+                    pxManager->ulFreeTopicNodes -= ( uint32_t ) 1;
+                }
+
+                pxManager->xTopicNodes[ usNode ].usRefCount++;
+                pusFirstNode = &( pxManager->xTopicNodes[ usNode ].usFirstChild );
+            }
+
+            /* The topic filter ends at the node of its last level. */
+            pxManager->xTopicNodes[ usNode ].usSubscription = usSubscription;
+            xAdded = eMQTTTrue;
+        }
+
+        return xAdded;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvRemoveFromTopicTrie( MQTTSubscriptionManager_t * pxManager,
+                                        uint16_t usSubscription )
+    {
+        const uint8_t * const pucTopic = pxManager->xSubscriptions[ usSubscription ].ucTopicFilter;
+        const uint16_t usTopicLength = pxManager->xSubscriptions[ usSubscription ].usTopicFilterLength;
+        uint16_t usLevelStart, usLevelEnd, usNode, usOwner;
+        uint16_t * pusNode;
+        MQTTTopicNode_t * pxNode;
+
+        /* Drop the reference of the subscription on each node of its path.
+         * A node which is no longer referenced is unlinked from its level;
+         * the nodes below it were only referenced by this subscription too,
+         * so they are freed as the walk continues. */
+        pusNode = &( pxManager->usFirstTopicNode );
+
+        for( usLevelStart = 0; usLevelStart <= usTopicLength; usLevelStart = usLevelEnd + ( uint16_t ) 1 )
+        {
+            usLevelEnd = prvGetTopicLevelEnd( pucTopic, usTopicLength, usLevelStart );
+            usNode = prvFindTopicNode( pxManager, *pusNode, &( pucTopic[ usLevelStart ] ), usLevelEnd - usLevelStart );
+            mqttconfigASSERT( usNode != mqttTOPIC_NODE_NONE );
+            pxNode = &( pxManager->xTopicNodes[ usNode ] );
+
+            if( pxNode->usSubscription == usSubscription )
+            {
+                pxNode->usSubscription = mqttTOPIC_NODE_NONE;
+            }
+
+            pxNode->usRefCount--;
+
+            if( pxNode->usRefCount == ( uint16_t ) 0 )
+            {
+                while( *pusNode != usNode )
+                {
+                    pusNode = &( pxManager->xTopicNodes[ *pusNode ].usNextSibling );
+                }
+
+                *pusNode = pxNode->usNextSibling;
+                pxManager->ulFreeTopicNodes += ( uint32_t ) 1;
+            }
+
+            pusNode = &( pxNode->usFirstChild );
+        }
+
+        /* Nodes still in use which read their text from the topic filter of
+         * this subscription must read it from another one. Any subscription
+         * below the node has the same topic filter up to and including the
+         * level of the node, so the offset stays the same. */
+        usNode = pxManager->usFirstTopicNode;
+
+        for( usLevelStart = 0; usLevelStart <= usTopicLength; usLevelStart = usLevelEnd + ( uint16_t ) 1 )
+        {
+            usLevelEnd = prvGetTopicLevelEnd( pucTopic, usTopicLength, usLevelStart );
+            usNode = prvFindTopicNode( pxManager, usNode, &( pucTopic[ usLevelStart ] ), usLevelEnd - usLevelStart );
+
+            if( usNode == mqttTOPIC_NODE_NONE )
+            {
+                /* The rest of the path has been freed. */
+                break;
+            }
+
+            pxNode = &( pxManager->xTopicNodes[ usNode ] );
+
+            if( pxNode->usTextOwner == usSubscription )
+            {
+                /* A node in use either ends a topic filter or has children
+                 * in use, so this finds a subscription. */
+                usOwner = usNode;
+
+                while( pxManager->xTopicNodes[ usOwner ].usSubscription == mqttTOPIC_NODE_NONE )
+                {
+                    usOwner = pxManager->xTopicNodes[ usOwner ].usFirstChild;
+                }
+
+                pxNode->usTextOwner = pxManager->xTopicNodes[ usOwner ].usSubscription;
+            }
+
+            usNode = pxNode->usFirstChild;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvInvokeSubscriptionCallback( MQTTContext_t * pxMQTTContext,
+                                               uint16_t usSubscription,
+                                               const MQTTPublishData_t * pxPublishData,
+                                               MQTTBool_t * pxSubscriptionCallbackInvoked,
+                                               MQTTBool_t * pxBufferOwnershipTaken )
+    {
+        MQTTSubscription_t * pxSubscription;
+
+        if( usSubscription != mqttTOPIC_NODE_NONE )
+        {
+            pxSubscription = &( pxMQTTContext->xSubscriptionManager.xSubscriptions[ usSubscription ] );
+
+            /* If a callback is registered with the subscription,
+             * invoke it. */
+            if( pxSubscription->pxPublishCallback != NULL )
+            {
+                /* Note that a callback was invoked. */
+                *pxSubscriptionCallbackInvoked = eMQTTTrue;
+
+                /* Invoke callback. */
+                *pxBufferOwnershipTaken = pxSubscription->pxPublishCallback( pxSubscription->pvPublishCallbackContext, pxPublishData );
+            }
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvInvokeWildCardSubscriptionCallbacks( MQTTContext_t * pxMQTTContext,
+                                                        uint16_t usFirstNode,
+                                                        const MQTTPublishData_t * pxPublishData,
+                                                        uint16_t usLevelStart,
+                                                        MQTTBool_t xWildCardMatched,
+                                                        MQTTBool_t * pxSubscriptionCallbackInvoked,
+                                                        MQTTBool_t * pxBufferOwnershipTaken )
+    {
+        const MQTTSubscriptionManager_t * const pxManager = &( pxMQTTContext->xSubscriptionManager );
+        const MQTTTopicNode_t * pxNode;
+        const uint8_t * pucLevel;
+        uint16_t usNode = usFirstNode, usLevelEnd = 0;
+        MQTTBool_t xNodeMatched, xNodeWildCardMatched;
+
+        if( usLevelStart <= pxPublishData->usTopicLength )
+        {
+            usLevelEnd = prvGetTopicLevelEnd( pxPublishData->pucTopic, pxPublishData->usTopicLength, usLevelStart );
+        }
+
+        while( ( usNode != mqttTOPIC_NODE_NONE ) && ( *pxBufferOwnershipTaken == eMQTTFalse ) )
+        {
+            pxNode = &( pxManager->xTopicNodes[ usNode ] );
+            pucLevel = mqttTOPIC_NODE_LEVEL( pxManager, pxNode );
+            xNodeMatched = eMQTTFalse;
+            xNodeWildCardMatched = xWildCardMatched;
+
+            if( ( pxNode->usLevelLength == ( uint16_t ) 1 ) && ( pucLevel[ 0 ] == ( uint8_t ) '#' ) )
+            {
+                /* '#' matches all the remaining levels. It also matches
+                 * the parent level, so "sport/#" matches "sport" too. */
+                prvInvokeSubscriptionCallback( pxMQTTContext,
+                                               pxNode->usSubscription,
+                                               pxPublishData,
+                                               pxSubscriptionCallbackInvoked,
+                                               pxBufferOwnershipTaken );
+            }
+            else if( usLevelStart <= pxPublishData->usTopicLength )
+            {
+                if( ( pxNode->usLevelLength == ( uint16_t ) 1 ) && ( pucLevel[ 0 ] == ( uint8_t ) '+' ) )
+                {
+                    /* '+' matches exactly one level, even an empty one. */
+                    xNodeMatched = eMQTTTrue;
+                    xNodeWildCardMatched = eMQTTTrue;
+                }
+                else if( ( pxNode->usLevelLength == ( usLevelEnd - usLevelStart ) ) &&
+                         ( memcmp( pucLevel, &( pxPublishData->pucTopic[ usLevelStart ] ), pxNode->usLevelLength ) == 0 ) )
+                {
+                    xNodeMatched = eMQTTTrue;
+                }
+                else
+                {
+                    /* This node does not match the topic level. */
+                }
+            }
+            else
+            {
+                /* All the levels of the topic have been matched, only
+                 * '#' can match now. */
+            }
+
+            if( xNodeMatched == eMQTTTrue )
+            {
+                /* If this was the last level of the topic, the topic filter
+                 * ending here matches. Filters without wild-cards have
+                 * been handled already. */
+                if( ( usLevelEnd == pxPublishData->usTopicLength ) && ( xNodeWildCardMatched == eMQTTTrue ) )
+                {
+                    prvInvokeSubscriptionCallback( pxMQTTContext,
+                                                   pxNode->usSubscription,
+                                                   pxPublishData,
+                                                   pxSubscriptionCallbackInvoked,
+                                                   pxBufferOwnershipTaken );
+                }
+
+                if( *pxBufferOwnershipTaken == eMQTTFalse )
+                {
+                    prvInvokeWildCardSubscriptionCallbacks( pxMQTTContext,
+                                                            pxNode->usFirstChild,
+                                                            pxPublishData,
+                                                            usLevelEnd + ( uint16_t ) 1,
+                                                            xNodeWildCardMatched,
+                                                            pxSubscriptionCallbackInvoked,
+                                                            pxBufferOwnershipTaken );
+                }
+            }
+
+            usNode = pxNode->usNextSibling;
+        }
+    }
+
+#endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT && mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE */
 /*-----------------------------------------------------------*/
 
 MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
                             const MQTTInitParams_t * const pxInitParams )
 {
+    uint32_t ulBucket;
+
     #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
         uint32_t x;
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
@@ -2435,9 +3266,16 @@ MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
     mqttconfigASSERT( pxInitParams->xBufferPoolInterface.pxReturnBufferFxn != NULL );
     mqttconfigASSERT( pxInitParams != NULL );
 
-    /* Initialize Tx Buffer List. */
+    /* Initialize Tx Buffer List and the identifier index. */
     listINIT_HEAD( &( pxMQTTContext->xTxBufferListHead ) );
 
+    for( ulBucket = 0; ulBucket < ( uint32_t ) mqttconfigTX_BUFFER_IDENTIFIER_BUCKETS; ulBucket++ )
+    {
+        listINIT_HEAD( &( pxMQTTContext->xTxBufferIdentifierBuckets[ ulBucket ] ) );
+    }
+
+    pxMQTTContext->ulPublishesInFlight = 0;
+
     /* Initialize Rx State. */
     prvResetRxMessageState( pxMQTTContext );
 
@@ -2469,6 +3307,10 @@ MQTTReturnCode_t MQTT_Init( MQTTContext_t * pxMQTTContext,
 
         /* Set the number of in-use subscription entries to zero. */
         pxMQTTContext->xSubscriptionManager.ulInUseSubscriptions = 0;
+
+        #if ( mqttconfigSUBSCRIPTION_MANAGER_USE_TRIE == 1 )
+            prvResetTopicTrie( &( pxMQTTContext->xSubscriptionManager ) );
+        #endif
     #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
     return eMQTTSuccess;
@@ -2519,6 +3361,10 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
         pxMQTTContext->ulKeepAliveActualIntervalTicks = pxConnectParams->ulKeepAliveActualIntervalTicks;
         pxMQTTContext->ulPingRequestTimeoutTicks = pxConnectParams->ulPingRequestTimeoutTicks;
 
+        /* Store whether received publish messages may be delivered without
+         * being copied into buffers which the user can own. */
+        pxMQTTContext->xDeliverPublishesInPlace = pxConnectParams->xDeliverPublishesInPlace;
+
         /* Client ID and username length. */
         usClientIdLength = mqttSTRLEN( pxConnectParams->usClientIdLength );
         usUserNameLength = pxConnectParams->usUserNameLength > ( uint16_t ) 0 ? mqttSTRLEN( pxConnectParams->usUserNameLength ) : ( uint16_t ) 0;
@@ -2549,9 +3395,6 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
             }
             else
             {
-                /* Add the buffer to the Tx buffer list. */
-                mqttbufferLIST_ADD( &( pxMQTTContext->xTxBufferListHead ), xBuffer );
-
                 /* To help debugging only. */
                 memset( mqttbufferGET_DATA( xBuffer ), 0x00, mqttbufferGET_EFFECTIVE_BUFFER_LENGTH( xBuffer ) );
 
@@ -2604,6 +3447,9 @@ MQTTReturnCode_t MQTT_Connect( MQTTContext_t * pxMQTTContext,
                  * ACK later. */
                 mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) = pxConnectParams->usPacketIdentifier;
 
+                /* Add the buffer to the Tx buffer list. */
+                prvAddTxBuffer( pxMQTTContext, xBuffer );
+
                 /* Update the number of bytes written to the buffer. */
                 mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength;
 
@@ -2683,11 +3529,14 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
                                  const MQTTSubscribeParams_t * const pxSubscribeParams )
 {
     uint8_t * pucNextByte, * pucLastByteInBuffer, ucRemainingLengthFieldBytes;
-    uint32_t ulRemainingLength, ulTotalMessageLength;
-    uint16_t usTopicLength;
+    uint32_t x, ulRemainingLength, ulTotalMessageLength;
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTReturnCode_t xReturnCode = eMQTTFailure;
 
+    #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
+        uint32_t ulStoredTopics = 0;
+    #endif
+
     /* These are checked here once and are later used without
      * NULL checks. */
     mqttconfigASSERT( pxMQTTContext != NULL );
@@ -2695,8 +3544,14 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
     mqttconfigASSERT( pxMQTTContext->xBufferPoolInterface.pxGetBufferFxn != NULL );
     mqttconfigASSERT( pxMQTTContext->xBufferPoolInterface.pxReturnBufferFxn != NULL );
     mqttconfigASSERT( pxSubscribeParams != NULL );
-    mqttconfigASSERT( pxSubscribeParams->pucTopic != NULL );
-    mqttconfigASSERT( pxSubscribeParams->xQos != eMQTTQoS2 ); /* QoS2 is not supported. */
+    mqttconfigASSERT( pxSubscribeParams->pxTopics != NULL );
+    mqttconfigASSERT( pxSubscribeParams->ulTopicCount > ( uint32_t ) 0 );
+
+    for( x = 0; x < pxSubscribeParams->ulTopicCount; x++ )
+    {
+        mqttconfigASSERT( pxSubscribeParams->pxTopics[ x ].pucTopic != NULL );
+        mqttconfigASSERT( pxSubscribeParams->pxTopics[ x ].xQos != eMQTTQoS2 ); /* QoS2 is not supported. */
+    }
 
     mqttconfigDEBUG_LOG( ( "Initiating MQTT subscribe.\r\n" ) );
 
@@ -2710,30 +3565,42 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
     {
         #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-            /* Try to store the subscription in the subscription
+            /* Try to store the subscriptions in the subscription
              * manager. */
-            if( prvStoreSubscription( pxMQTTContext,
-                                      pxSubscribeParams->pucTopic,
-                                      pxSubscribeParams->usTopicLength,
-                                      pxSubscribeParams->pvPublishCallbackContext,
-                                      pxSubscribeParams->pxPublishCallback ) == eMQTTFalse )
+            while( ulStoredTopics < pxSubscribeParams->ulTopicCount )
+            {
+                if( prvStoreSubscription( pxMQTTContext,
+                                          pxSubscribeParams->pxTopics[ ulStoredTopics ].pucTopic,
+                                          pxSubscribeParams->pxTopics[ ulStoredTopics ].usTopicLength,
+                                          pxSubscribeParams->pxTopics[ ulStoredTopics ].pvPublishCallbackContext,
+                                          pxSubscribeParams->pxTopics[ ulStoredTopics ].pxPublishCallback ) == eMQTTFalse )
+                {
+                    break;
+                }
+
+                ulStoredTopics++;
+            }
+
+            if( ulStoredTopics < pxSubscribeParams->ulTopicCount )
             {
                 /* Fail the subscribe operation immediately, if we
-                 * fail to store the subscription in the subscription
+                 * fail to store the subscriptions in the subscription
                  * manager. */
                 xReturnCode = eMQTTSubscriptionManagerFull;
             }
             else
         #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
         {
-            /* Length of the topic in the actual MQTT message. */
-            usTopicLength = mqttSTRLEN( pxSubscribeParams->usTopicLength );
-
             /* Calculate the "Remaining Length" i.e. length of the packet
-             * excluding fixed header. */
-            ulRemainingLength = ( uint32_t ) mqttSUBSCRIBE_PACKET_IDENTIFER_LENGTH +
-                                ( uint32_t ) usTopicLength +
-                                ( uint32_t ) mqttSUBSCRIBE_REQUESTED_QOS_LENGTH;
+             * excluding fixed header.  Each topic is followed by its requested
+             * QoS in the actual MQTT message. */
+            ulRemainingLength = ( uint32_t ) mqttSUBSCRIBE_PACKET_IDENTIFER_LENGTH;
+
+            for( x = 0; x < pxSubscribeParams->ulTopicCount; x++ )
+            {
+                ulRemainingLength += ( uint32_t ) mqttSTRLEN( pxSubscribeParams->pxTopics[ x ].usTopicLength ) +
+                                     ( uint32_t ) mqttSUBSCRIBE_REQUESTED_QOS_LENGTH;
+            }
 
             /* Calculate the number of bytes occupied by the "Remaining Length" field. */
             ucRemainingLengthFieldBytes = prvSizeOfRemainingLength( ulRemainingLength );
@@ -2756,9 +3623,6 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
                 }
                 else
                 {
-                    /* Add the buffer to the Tx buffer list. */
-                    mqttbufferLIST_ADD( &( pxMQTTContext->xTxBufferListHead ), xBuffer );
-
                     /* To help debugging only. */
                     memset( mqttbufferGET_DATA( xBuffer ), 0x00, mqttbufferGET_EFFECTIVE_BUFFER_LENGTH( xBuffer ) );
 
@@ -2785,17 +3649,27 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
                     mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_PACKET_ID_LSB_OFFSET,
                                                                       ucRemainingLengthFieldBytes ) ] = ( uint8_t ) ( pxSubscribeParams->usPacketIdentifier );
 
-                    /* Write the topic into the message. */
+                    /* Write the topics into the message, each followed by its
+                     * Requested QoS. */
                     pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] );
-                    pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
 
-                    /* Write the Requested QoS into the message. */
-                    *pucNextByte = ( uint8_t ) pxSubscribeParams->xQos;
+                    for( x = 0; x < pxSubscribeParams->ulTopicCount; x++ )
+                    {
+                        pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxSubscribeParams->pxTopics[ x ].pucTopic, pxSubscribeParams->pxTopics[ x ].usTopicLength );
+                        *pucNextByte = ( uint8_t ) pxSubscribeParams->pxTopics[ x ].xQos;
+                        pucNextByte++;
+                    }
+
+                    /* MISRA compliance. */
+                    ( void ) pucNextByte;
 
                     /* Store the packet identifier in TxBuffer also for matching with
                      * the one received in ACK later. */
                     mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) = pxSubscribeParams->usPacketIdentifier;
 
+                    /* Add the buffer to the Tx buffer list. */
+                    prvAddTxBuffer( pxMQTTContext, xBuffer );
+
                     /* Update the number of bytes written to the buffer. */
                     mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength;
 
@@ -2823,13 +3697,11 @@ MQTTReturnCode_t MQTT_Subscribe( MQTTContext_t * pxMQTTContext,
 
         #if ( mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT == 1 )
 
-            /* Remove the subscription entry from the subscription manager.
-             * This if check is an optimization - If the subscribe failed because
-             * we could not store the subscription, there is not need to remove
-             * it as it was never stored. */
-            if( xReturnCode != eMQTTSubscriptionManagerFull )
+            /* Remove the subscription entries which were stored in the
+             * subscription manager. */
+            for( x = 0; x < ulStoredTopics; x++ )
             {
-                prvRemoveSubscription( pxMQTTContext, pxSubscribeParams->pucTopic, pxSubscribeParams->usTopicLength );
+                prvRemoveSubscription( pxMQTTContext, pxSubscribeParams->pxTopics[ x ].pucTopic, pxSubscribeParams->pxTopics[ x ].usTopicLength );
             }
         #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
     }
@@ -2842,8 +3714,7 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
                                    const MQTTUnsubscribeParams_t * const pxUnsubscribeParams )
 {
     uint8_t * pucNextByte, * pucLastByteInBuffer, ucRemainingLengthFieldBytes;
-    uint32_t ulRemainingLength, ulTotalMessageLength;
-    uint16_t usTopicLength;
+    uint32_t x, ulRemainingLength, ulTotalMessageLength;
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTReturnCode_t xReturnCode = eMQTTFailure;
 
@@ -2854,6 +3725,8 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
     mqttconfigASSERT( pxMQTTContext->xBufferPoolInterface.pxGetBufferFxn != NULL );
     mqttconfigASSERT( pxMQTTContext->xBufferPoolInterface.pxReturnBufferFxn != NULL );
     mqttconfigASSERT( pxUnsubscribeParams != NULL );
+    mqttconfigASSERT( pxUnsubscribeParams->pxTopics != NULL );
+    mqttconfigASSERT( pxUnsubscribeParams->ulTopicCount > ( uint32_t ) 0 );
 
     mqttconfigDEBUG_LOG( ( "Initiating MQTT unsubscribe.\r\n" ) );
 
@@ -2865,12 +3738,14 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
     }
     else
     {
-        /* Length of the topic in the actual MQTT message. */
-        usTopicLength = mqttSTRLEN( pxUnsubscribeParams->usTopicLength );
-
         /* Calculate the "Remaining Length" i.e. length of the packet
          * excluding fixed header. */
-        ulRemainingLength = ( uint32_t ) mqttUNSUBSCRIBE_PACKET_IDENTIFER_LENGTH + ( uint32_t ) usTopicLength;
+        ulRemainingLength = ( uint32_t ) mqttUNSUBSCRIBE_PACKET_IDENTIFER_LENGTH;
+
+        for( x = 0; x < pxUnsubscribeParams->ulTopicCount; x++ )
+        {
+            ulRemainingLength += ( uint32_t ) mqttSTRLEN( pxUnsubscribeParams->pxTopics[ x ].usTopicLength );
+        }
 
         /* Calculate the number of bytes occupied by the "Remaining Length" field. */
         ucRemainingLengthFieldBytes = prvSizeOfRemainingLength( ulRemainingLength );
@@ -2893,9 +3768,6 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
             }
             else
             {
-                /* Add the buffer to the Tx buffer list. */
-                mqttbufferLIST_ADD( &( pxMQTTContext->xTxBufferListHead ), xBuffer );
-
                 /* To help debugging only. */
                 memset( mqttbufferGET_DATA( xBuffer ), 0x00, mqttbufferGET_EFFECTIVE_BUFFER_LENGTH( xBuffer ) );
 
@@ -2922,9 +3794,13 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
                 mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_PACKET_ID_LSB_OFFSET,
                                                                   ucRemainingLengthFieldBytes ) ] = ( uint8_t ) ( pxUnsubscribeParams->usPacketIdentifier );
 
-                /* Write the topic into the message. */
+                /* Write the topics into the message. */
                 pucNextByte = &( mqttbufferGET_DATA( xBuffer )[ mqttADJUST_OFFSET( mqttUNSUBSCRIBE_TOPIC_OFFSET, ucRemainingLengthFieldBytes ) ] );
-                pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxUnsubscribeParams->pucTopic, pxUnsubscribeParams->usTopicLength );
+
+                for( x = 0; x < pxUnsubscribeParams->ulTopicCount; x++ )
+                {
+                    pucNextByte = prvWriteString( pucNextByte, pucLastByteInBuffer, pxUnsubscribeParams->pxTopics[ x ].pucTopic, pxUnsubscribeParams->pxTopics[ x ].usTopicLength );
+                }
 
                 /* MISRA compliance. */
                 ( void ) pucNextByte;
@@ -2933,6 +3809,9 @@ MQTTReturnCode_t MQTT_Unsubscribe( MQTTContext_t * pxMQTTContext,
                  * the one received in ACK later. */
                 mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) = pxUnsubscribeParams->usPacketIdentifier;
 
+                /* Add the buffer to the Tx buffer list. */
+                prvAddTxBuffer( pxMQTTContext, xBuffer );
+
                 /* Update the number of bytes written to the buffer. */
                 mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength;
 
@@ -2964,7 +3843,7 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
                                const MQTTPublishParams_t * const pxPublishParams )
 {
     uint8_t * pucNextByte, * pucLastByteInBuffer, ucRemainingLengthFieldBytes;
-    uint32_t ulRemainingLength, ulTotalMessageLength;
+    uint32_t ulRemainingLength, ulTotalMessageLength, ulBufferedLength = 0;
     uint16_t usTopicLength;
     MQTTBufferHandle_t xBuffer = NULL;
     MQTTReturnCode_t xReturnCode = eMQTTFailure;
@@ -2985,6 +3864,16 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
          * MQTT client is not connected. */
         xReturnCode = eMQTTClientNotConnected;
     }
+
+    #if ( mqttconfigPUBLISH_WINDOW_SIZE > 0 )
+        else if( ( pxPublishParams->xQos != eMQTTQoS0 ) &&
+                 ( pxMQTTContext->ulPublishesInFlight >= ( uint32_t ) mqttconfigPUBLISH_WINDOW_SIZE ) )
+        {
+            /* Hold the publish back until a PUBACK or a timeout makes
+             * room in the window. */
+            xReturnCode = eMQTTPublishWindowFull;
+        }
+    #endif /* mqttconfigPUBLISH_WINDOW_SIZE */
     else
     {
         /* Length of the topic in the actual MQTT message. */
@@ -3004,8 +3893,22 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
             /* Calculate total MQTT message length. */
             ulTotalMessageLength = mqttTOTAL_MESSAGE_LENGTH( ucRemainingLengthFieldBytes, ulRemainingLength );
 
+            /* The buffer only needs to hold the fixed header, the topic and
+             * the packet identifier, which is all that is needed to match the
+             * PUBACK.  The payload is transmitted straight from the user's
+             * memory, unless it is small enough that copying it is cheaper
+             * than a separate send. */
+            if( pxPublishParams->ulDataLength <= ( uint32_t ) mqttconfigPUBLISH_COPY_THRESHOLD )
+            {
+                ulBufferedLength = ulTotalMessageLength;
+            }
+            else
+            {
+                ulBufferedLength = ulTotalMessageLength - pxPublishParams->ulDataLength;
+            }
+
             /* Try to get a buffer from the free buffer pool. */
-            xBuffer = prvGetFreeBuffer( pxMQTTContext, ulTotalMessageLength );
+            xBuffer = prvGetFreeBuffer( pxMQTTContext, ulBufferedLength );
 
             if( xBuffer == NULL )
             {
@@ -3016,18 +3919,28 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
             }
             else
             {
-                /* Add the buffer to the Tx buffer list. */
-                mqttbufferLIST_ADD( &( pxMQTTContext->xTxBufferListHead ), xBuffer );
-
-                /* To help debugging only. */
-                memset( mqttbufferGET_DATA( xBuffer ), 0x00, mqttbufferGET_EFFECTIVE_BUFFER_LENGTH( xBuffer ) );
-
                 /* Record time-stamp and store timeout. */
                 mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) = prvGetCurrentTickCount( pxMQTTContext );
                 mqttbufferGET_PACKET_TIMEOUT_TICKS( xBuffer ) = pxPublishParams->ulTimeoutTicks;
 
-                /* Write Control Packet Type. */
-                /*_TODO_ Note!  DUP and RETAIN are all currently all set to 0. */
+                #if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+                    {
+                        /* Record when it was transmitted and what, as the
+                         * payload may not be copied. */
+                        mqttbufferGET_PACKET_RETRANSMIT_RECORDED_TICK_COUNT( xBuffer ) = mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer );
+                        mqttbufferGET_PACKET_PAYLOAD( xBuffer ) = NULL;
+                        mqttbufferGET_PACKET_PAYLOAD_LENGTH( xBuffer ) = 0;
+
+                        if( ulBufferedLength < ulTotalMessageLength )
+                        {
+                            mqttbufferGET_PACKET_PAYLOAD( xBuffer ) = pxPublishParams->pvData;
+                            mqttbufferGET_PACKET_PAYLOAD_LENGTH( xBuffer ) = pxPublishParams->ulDataLength;
+                        }
+                    }
+                #endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+
+                /* Write Control Packet Type. The DUP flag is only set when
+                 * the packet is retransmitted. RETAIN is always 0. */
                 mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] = mqttCONTROL_PUBLISH;
 
                 /* Set QoS. QoS2 is not supported.*/
@@ -3059,15 +3972,21 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
                     pucNextByte++;
                 }
 
-                /* Write the payload into the message. */
-                memcpy( pucNextByte, pxPublishParams->pvData, ( size_t ) pxPublishParams->ulDataLength );
+                /* Write the payload into the message, if it is copied. */
+                if( ulBufferedLength == ulTotalMessageLength )
+                {
+                    memcpy( pucNextByte, pxPublishParams->pvData, ( size_t ) pxPublishParams->ulDataLength );
+                }
 
                 /* Store the packet identifier in TxBuffer also for matching
                  * ACK later. */
                 mqttbufferGET_PACKET_IDENTIFIER( xBuffer ) = pxPublishParams->usPacketIdentifier;
 
+                /* Add the buffer to the Tx buffer list. */
+                prvAddTxBuffer( pxMQTTContext, xBuffer );
+
                 /* Update the number of bytes written to the buffer. */
-                mqttbufferGET_DATA_LENGTH( xBuffer ) = ulTotalMessageLength;
+                mqttbufferGET_DATA_LENGTH( xBuffer ) = ulBufferedLength;
 
                 /* MQTT packet created. */
                 xReturnCode = eMQTTSuccess;
@@ -3079,6 +3998,13 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
     if( xReturnCode == eMQTTSuccess )
     {
         xReturnCode = prvSendData( pxMQTTContext, mqttbufferGET_DATA( xBuffer ), mqttbufferGET_DATA_LENGTH( xBuffer ) );
+
+        /* The payload follows the header as a second segment if it was
+         * not copied into the buffer. */
+        if( ( xReturnCode == eMQTTSuccess ) && ( ulBufferedLength < ulTotalMessageLength ) )
+        {
+            xReturnCode = prvSendData( pxMQTTContext, ( const uint8_t * ) pxPublishParams->pvData, pxPublishParams->ulDataLength );
+        }
     }
 
     /* If some error occurred or QOS0 (No ACK is expected in case of QOS0),
@@ -3089,6 +4015,11 @@ MQTTReturnCode_t MQTT_Publish( MQTTContext_t * pxMQTTContext,
         /* Return the buffer to the free buffer pool. */
         prvReturnBuffer( pxMQTTContext, xBuffer );
     }
+    else
+    {
+        /* One more publish is waiting for PUBACK. */
+        pxMQTTContext->ulPublishesInFlight++;
+    }
 
     return xReturnCode;
 }
@@ -3101,6 +4032,7 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
     MQTTReturnCode_t xReturnCode = eMQTTSuccess;
     MQTTEventCallbackParams_t xEventCallbackParams;
     size_t xProcessedBytes = 0, xExpectedBytes, xUnprocessedBytes;
+    const uint8_t * pucPacketStart = NULL;
 
     /* These are checked here once and are later used without
      * NULL checks. */
@@ -3138,6 +4070,10 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
              * free buffer is available because we know how many bytes to drop before
              * the next packet starts. */
 
+            /* Remember where the packet starts, in case all of it is
+             * supplied in this call. */
+            pucPacketStart = &( pucReceivedData[ xProcessedBytes ] );
+
             /* Copy one byte containing packet type and flags. */
             mqttCOPY_BYTES( pucReceivedData, xProcessedBytes, pxMQTTContext->ucRxFixedHeaderBuffer, pxMQTTContext->ulRxMessageReceivedLength, 1 );
 
@@ -3194,6 +4130,23 @@ MQTTReturnCode_t MQTT_ParseReceivedData( MQTTContext_t * pxMQTTContext,
                      * the next. */
                     prvResetRxMessageState( pxMQTTContext );
                 }
+                else if( ( pucPacketStart != NULL ) &&
+                         ( pxMQTTContext->xDeliverPublishesInPlace == eMQTTTrue ) &&
+                         ( ( pxMQTTContext->ucRxFixedHeaderBuffer[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH ) &&
+                         ( ( xReceivedDataLength - xProcessedBytes ) >= ( pxMQTTContext->xRxMessageState.ulTotalMessageLength - pxMQTTContext->ulRxMessageReceivedLength ) ) )
+                {
+                    /* The whole publish message is in the supplied data, so
+                     * deliver it from there instead of copying it into a
+                     * buffer first. */
+                    xExpectedBytes = pxMQTTContext->xRxMessageState.ulTotalMessageLength - pxMQTTContext->ulRxMessageReceivedLength;
+                    xProcessedBytes += xExpectedBytes;
+                    pxMQTTContext->ulRxMessageReceivedLength += ( uint32_t ) xExpectedBytes;
+
+                    prvProcessReceivedPublish( pxMQTTContext, pucPacketStart );
+
+                    /* Reset Rx state to receive next packet. */
+                    prvResetRxMessageState( pxMQTTContext );
+                }
                 else
                 {
                     /* Get a buffer to store the received message. */
@@ -3304,10 +4257,12 @@ MQTTReturnCode_t MQTT_ReturnBuffer( MQTTContext_t * pxMQTTContext,
 uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
                         uint64_t xCurrentTickCount )
 {
-    Link_t * pxLink, * pxTempLink;
+    Link_t * pxLink, xWaitingListHead;
     MQTTBufferHandle_t xBuffer;
+    MQTTBool_t xConnectTimedOut = eMQTTFalse;
     MQTTEventCallbackParams_t xEventCallbackParams;
     uint32_t ulNextTimeoutTicks = UINT32_MAX;
+    uint64_t xDeadlineTickCount;
     static const uint8_t ucPingReqPacket[] =
     {
         mqttCONTROL_PINGREQ | mqttFLAGS_PINGREQ,
@@ -3319,31 +4274,51 @@ uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
     mqttconfigASSERT( pxMQTTContext != NULL );
     mqttconfigASSERT( pxMQTTContext->pxMQTTSendFxn != NULL );
 
-    /* Check if any of the sent packet timed out while waiting for ACK. */
-    listFOR_EACH_SAFE( pxLink, pxTempLink, &( pxMQTTContext->xTxBufferListHead ) )
+    listINIT_HEAD( &xWaitingListHead );
+
+    /* The Tx buffer list is ordered by deadline, so only the buffers at its
+     * head which are due need to be looked at. Those which are still waiting
+     * for ACK afterwards are put aside and inserted again at their new
+     * deadlines once all the due ones have been looked at. */
+    while( listIS_EMPTY( &( pxMQTTContext->xTxBufferListHead ) ) == 0 )
     {
         /* Get the buffer from the link. */
-        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxMQTTContext->xTxBufferListHead.pxNext );
 
+        /* If the first buffer is not due, none of the others is. Update
+         * when the next earliest timeout will happen. */
+        xDeadlineTickCount = prvGetTxBufferDeadline( xBuffer );
+
+        if( xDeadlineTickCount > xCurrentTickCount )
+        {
+            ulNextTimeoutTicks = ( uint32_t ) mqttMIN( ( uint64_t ) UINT32_MAX, xDeadlineTickCount - xCurrentTickCount );
+            break;
+        }
+
+        if( mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) == ( uint64_t ) 0 )
+        {
+            /* If recorded tick count is zero, this means that user has not
+             * supplied get ticks function and we should store tick count. The
+             * timeout will be measured from this moment onwards. */
+            mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) = xCurrentTickCount;
+
+            #if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+                mqttbufferGET_PACKET_RETRANSMIT_RECORDED_TICK_COUNT( xBuffer ) = xCurrentTickCount;
+            #endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+
+            mqttbufferLIST_REMOVE( xBuffer );
+            mqttbufferLIST_ADD( &xWaitingListHead, xBuffer );
+        }
         /* If the operation has timed out, inform the user and
          * return the buffer to the free buffer pool. */
-        if( prvIsTimeElapsed( &( mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) ), xCurrentTickCount, &( mqttbufferGET_PACKET_TIMEOUT_TICKS( xBuffer ) ) ) == eMQTTTrue )
+        else if( ( xCurrentTickCount - mqttbufferGET_PACKET_RECORDED_TICK_COUNT( xBuffer ) ) >= ( uint64_t ) mqttbufferGET_PACKET_TIMEOUT_TICKS( xBuffer ) )
         {
-            /* If a connect timed out, disconnect the client and inform
-             * the user about the same. */
+            /* If a connect timed out, disconnect the client once the
+             * buffers put aside are back in the Tx buffer list, so that
+             * all of them are returned to the buffer-pool. */
             if( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_CONNECT | mqttFLAGS_CONNECT ) )
             {
-                /* Disconnect. */
-                prvResetMQTTContext( pxMQTTContext );
-
-                /* Inform the user about disconnect. */
-                xEventCallbackParams.xEventType = eMQTTClientDisconnected;
-                xEventCallbackParams.u.xDisconnectData.xDisconnectReason = eMQTTDisconnectReasonConnectTimeout;
-                ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
-
-                /* No need to traverse the Tx list anymore as all
-                 * the packets have already been returned to the
-                 * buffer-pool in prvResetMQTTContext. */
+                xConnectTimedOut = eMQTTTrue;
                 break;
             }
             else
@@ -3354,10 +4329,16 @@ uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
                      * entry from the subscription manager. */
                     if( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] == ( uint8_t ) ( mqttCONTROL_SUBSCRIBE | mqttFLAGS_SUBSCRIBE ) )
                     {
-                        prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xBuffer );
+                        prvRemoveSubscriptionForSubscribeOrUnsubscribeBuffer( pxMQTTContext, xBuffer, NULL );
                     }
                 #endif /* mqttconfigENABLE_SUBSCRIPTION_MANAGEMENT */
 
+                /* A publish which timed out leaves the window. */
+                if( ( mqttbufferGET_DATA( xBuffer )[ mqttFIXED_HEADER_CONTROL_BYTE_OFFSET ] & mqttTOP_NIBBLE_MASK ) == mqttCONTROL_PUBLISH )
+                {
+                    pxMQTTContext->ulPublishesInFlight--;
+                }
+
                 /* Inform the user about the timeout. */
                 xEventCallbackParams.xEventType = eMQTTTimeout;
                 xEventCallbackParams.u.xTimeoutData.usPacketIdentifier = mqttbufferGET_PACKET_IDENTIFIER( xBuffer );
@@ -3369,12 +4350,40 @@ uint32_t MQTT_Periodic( MQTTContext_t * pxMQTTContext,
         }
         else
         {
-            /* If this Tx operation has not timed out yet, update when
-             * the next earliest timeout will happen. */
-            ulNextTimeoutTicks = mqttMIN( ulNextTimeoutTicks, mqttbufferGET_PACKET_TIMEOUT_TICKS( xBuffer ) );
+            #if ( mqttconfigPUBLISH_RETRANSMIT_TICKS > 0 )
+
+                /* Otherwise it is a publish still waiting for PUBACK whose
+                 * retransmit interval has passed, so transmit it again. */
+                prvRetransmitPublish( pxMQTTContext, xBuffer );
+                mqttbufferGET_PACKET_RETRANSMIT_RECORDED_TICK_COUNT( xBuffer ) = xCurrentTickCount;
+            #endif /* mqttconfigPUBLISH_RETRANSMIT_TICKS */
+
+            mqttbufferLIST_REMOVE( xBuffer );
+            mqttbufferLIST_ADD( &xWaitingListHead, xBuffer );
         }
     }
 
+    /* Insert the buffers put aside again at their new deadlines. */
+    while( listIS_EMPTY( &xWaitingListHead ) == 0 )
+    {
+        listPOP( &xWaitingListHead, pxLink );
+        xBuffer = mqttbufferGET_BUFFER_HANDLE_FROM_LINK( pxLink );
+        prvInsertTxBufferByDeadline( pxMQTTContext, xBuffer );
+
+        ulNextTimeoutTicks = ( uint32_t ) mqttMIN( ( uint64_t ) ulNextTimeoutTicks, prvGetTxBufferDeadline( xBuffer ) - xCurrentTickCount );
+    }
+
+    if( xConnectTimedOut == eMQTTTrue )
+    {
+        /* Disconnect. */
+        prvResetMQTTContext( pxMQTTContext );
+
+        /* Inform the user about disconnect. */
+        xEventCallbackParams.xEventType = eMQTTClientDisconnected;
+        xEventCallbackParams.u.xDisconnectData.xDisconnectReason = eMQTTDisconnectReasonConnectTimeout;
+        ( void ) prvInvokeCallback( pxMQTTContext, &xEventCallbackParams );
+    }
+
     /* Check if the previously sent keep alive timed out,
      * or it is time to send a keep alive message. */
     if( pxMQTTContext->xConnectionState == eMQTTConnected )
@@ -0,0 +1,128 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_offline_store_pal.c
+ * @brief Keeps the MQTT agent offline queue in a file on the host.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* MQTT agent includes. */
+#include "aws_mqtt_agent_config.h"
+#include "aws_mqtt_agent_config_defaults.h"
+#include "aws_mqtt_offline_store_pal.h"
+
+/* C runtime includes. */
+#include <stdio.h>
+#include <string.h>
+
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+/**
+ * @brief The file the store is kept in.
+ *
+ * The default is in the working directory of the simulator.
+ */
+    #ifndef mqttconfigOFFLINE_STORE_FILE_NAME
+        #define mqttconfigOFFLINE_STORE_FILE_NAME    "./FreeRTOS_MQTT_OfflineStore.dat"
+    #endif
+
+/**
+ * @brief The size of the store, in bytes.
+ */
+    #define mqttOFFLINE_STORE_TOTAL_SIZE    ( ( uint32_t ) mqttconfigMAX_BROKERS * ( uint32_t ) mqttconfigOFFLINE_STORE_SIZE )
+/*-----------------------------------------------------------*/
+
+    BaseType_t MQTT_OFFLINE_STORE_PAL_Read( uint32_t ulOffset,
+                                            void * pvData,
+                                            uint32_t ulLength )
+    {
+        BaseType_t xResult = pdFAIL;
+        FILE * pxFile;
+        size_t xBytesRead = 0;
+
+        if( ( ulOffset <= mqttOFFLINE_STORE_TOTAL_SIZE ) && ( ulLength <= ( mqttOFFLINE_STORE_TOTAL_SIZE - ulOffset ) ) )
+        {
+            pxFile = fopen( mqttconfigOFFLINE_STORE_FILE_NAME, "rb" );
+
+            if( pxFile != NULL )
+            {
+                if( fseek( pxFile, ( long ) ulOffset, SEEK_SET ) == 0 )
+                {
+                    xBytesRead = fread( pvData, 1, ( size_t ) ulLength, pxFile );
+                }
+
+                ( void ) fclose( pxFile );
+            }
+
+            /* Bytes beyond the end of the file, or of a file which does not
+             * exist yet, read as erased flash would. */
+            memset( ( uint8_t * ) pvData + xBytesRead, 0xFF, ( size_t ) ulLength - xBytesRead );
+            xResult = pdPASS;
+        }
+
+        return xResult;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t MQTT_OFFLINE_STORE_PAL_Write( uint32_t ulOffset,
+                                             const void * pvData,
+                                             uint32_t ulLength )
+    {
+        BaseType_t xResult = pdFAIL;
+        FILE * pxFile;
+
+        if( ( ulOffset <= mqttOFFLINE_STORE_TOTAL_SIZE ) && ( ulLength <= ( mqttOFFLINE_STORE_TOTAL_SIZE - ulOffset ) ) )
+        {
+            /* Update the file in place, creating it if it does not exist. */
+            pxFile = fopen( mqttconfigOFFLINE_STORE_FILE_NAME, "r+b" );
+
+            if( pxFile == NULL )
+            {
+                pxFile = fopen( mqttconfigOFFLINE_STORE_FILE_NAME, "w+b" );
+            }
+
+            if( pxFile != NULL )
+            {
+                if( ( fseek( pxFile, ( long ) ulOffset, SEEK_SET ) == 0 ) &&
+                    ( fwrite( pvData, 1, ( size_t ) ulLength, pxFile ) == ( size_t ) ulLength ) )
+                {
+                    xResult = pdPASS;
+                }
+
+                /* The bytes only count as written once they are in the file. */
+                if( fclose( pxFile ) != 0 )
+                {
+                    xResult = pdFAIL;
+                }
+            }
+        }
+
+        return xResult;
+    }
+
+#endif /* if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 ) */
@@ -0,0 +1,98 @@
+/*
+ * Amazon FreeRTOS
+ * Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+/**
+ * @file aws_mqtt_offline_store_pal.c
+ * @brief Keeps the MQTT agent offline queue in reserved flash of the
+ * STM32L475 discovery board.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+
+/* MQTT agent includes. */
+#include "aws_mqtt_agent_config.h"
+#include "aws_mqtt_agent_config_defaults.h"
+#include "aws_mqtt_offline_store_pal.h"
+
+/* flash driver includes. */
+#include "flash.h"
+
+/* Standard includes. */
+#include <string.h>
+
+#if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 )
+
+/**
+ * @brief The size of the store, in bytes.
+ */
+    #define mqttOFFLINE_STORE_TOTAL_SIZE    ( ( uint32_t ) mqttconfigMAX_BROKERS * ( uint32_t ) mqttconfigOFFLINE_STORE_SIZE )
+
+/**
+ * @brief The store, in the fixed location flash area which is not erased when
+ * the device is programmed.  It starts on a flash page so that it shares no
+ * page with the PKCS#11 objects.
+ */
+    static uint8_t ucOfflineStore[ mqttOFFLINE_STORE_TOTAL_SIZE ] __attribute__( ( section( "UNINIT_FIXED_LOC" ), aligned( 0x800 ) ) );
+/*-----------------------------------------------------------*/
+
+    BaseType_t MQTT_OFFLINE_STORE_PAL_Read( uint32_t ulOffset,
+                                            void * pvData,
+                                            uint32_t ulLength )
+    {
+        BaseType_t xResult = pdFAIL;
+
+        if( ( ulOffset <= mqttOFFLINE_STORE_TOTAL_SIZE ) && ( ulLength <= ( mqttOFFLINE_STORE_TOTAL_SIZE - ulOffset ) ) )
+        {
+            /* The flash is memory mapped. */
+            memcpy( pvData, &( ucOfflineStore[ ulOffset ] ), ( size_t ) ulLength );
+            xResult = pdPASS;
+        }
+
+        return xResult;
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t MQTT_OFFLINE_STORE_PAL_Write( uint32_t ulOffset,
+                                             const void * pvData,
+                                             uint32_t ulLength )
+    {
+        BaseType_t xResult = pdFAIL;
+
+        if( ( ulOffset <= mqttOFFLINE_STORE_TOTAL_SIZE ) && ( ulLength <= ( mqttOFFLINE_STORE_TOTAL_SIZE - ulOffset ) ) )
+        {
+            /* FLASH_update erases and writes back each page the bytes span,
+             * keeping the rest of the page, and returns the number of bytes
+             * written. */
+            if( FLASH_update( ( uint32_t ) &( ucOfflineStore[ ulOffset ] ), pvData, ulLength ) == ( int ) ulLength )
+            {
+                xResult = pdPASS;
+            }
+        }
+
+        return xResult;
+    }
+
+#endif /* if ( mqttconfigOFFLINE_QUEUE_SIZE > 0 ) && ( mqttconfigOFFLINE_STORE_SIZE > 0 ) */
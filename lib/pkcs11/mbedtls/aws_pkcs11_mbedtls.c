@@ -67,12 +67,24 @@ typedef int ( * pfnMbedTlsSign )( void * ctx,
 /* The size of the buffer malloc'ed for the exported public key in C_GenerateKeyPair */
 #define pkcs11KEY_GEN_MAX_DER_SIZE    200
 
+/**
+ * @brief Key parsed from an object, kept until the object is replaced.
+ */
+typedef struct P11KeyCache
+{
+    SemaphoreHandle_t xMutex; /* Protects the key from being modified while in use. */
+    CK_OBJECT_HANDLE xHandle; /* The object the key was parsed from, 0 if the cache is empty. */
+    mbedtls_pk_context xKey;
+} P11KeyCache_t;
+
 /* PKCS#11 Object */
 typedef struct P11Struct_t
 {
     CK_BBOOL xIsInitialized;
     mbedtls_ctr_drbg_context xMbedDrbgCtx;
     mbedtls_entropy_context xMbedEntropyContext;
+    P11KeyCache_t xSignKeyCache;   /* Signing key of the slot, shared by all sessions. */
+    P11KeyCache_t xVerifyKeyCache; /* Verification key of the slot, shared by all sessions. */
 } P11Struct_t, * P11Context_t;
 
 static P11Struct_t xP11Context;
@@ -90,10 +102,8 @@ typedef struct P11Session
     CK_BBOOL xFindObjectComplete;
     uint8_t * xFindObjectLabel;
     uint8_t xFindObjectLabelLength;
-    SemaphoreHandle_t xVerifyMutex; /* Protects the verification key from being modified while in use. */
-    mbedtls_pk_context xVerifyKey;
-    SemaphoreHandle_t xSignMutex;   /* Protects the signing key from being modified while in use. */
-    mbedtls_pk_context xSignKey;
+    CK_OBJECT_HANDLE xVerifyKeyHandle; /* Key given to C_VerifyInit, see xP11Context.xVerifyKeyCache. */
+    CK_OBJECT_HANDLE xSignKeyHandle;   /* Key given to C_SignInit, see xP11Context.xSignKeyCache. */
     mbedtls_sha256_context xSHA256Context;
 } P11Session_t, * P11SessionPtr_t;
 
@@ -253,6 +263,129 @@ P11SessionPtr_t prvSessionPointerFromHandle( CK_SESSION_HANDLE xSession )
     return ( P11SessionPtr_t ) xSession; /*lint !e923 Allow casting integer type to pointer for handle. */
 }
 
+/**
+ * @brief Sets up an empty key cache.
+ */
+static CK_RV prvKeyCacheInit( P11KeyCache_t * pxCache )
+{
+    CK_RV xResult = CKR_OK;
+
+    pxCache->xHandle = 0;
+    mbedtls_pk_init( &pxCache->xKey );
+    pxCache->xMutex = xSemaphoreCreateMutex();
+
+    if( NULL == pxCache->xMutex )
+    {
+        xResult = CKR_HOST_MEMORY;
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Releases the key and the mutex of a key cache.
+ */
+static void prvKeyCacheFree( P11KeyCache_t * pxCache )
+{
+    mbedtls_pk_free( &pxCache->xKey );
+    pxCache->xHandle = 0;
+
+    if( NULL != pxCache->xMutex )
+    {
+        vSemaphoreDelete( pxCache->xMutex );
+        pxCache->xMutex = NULL;
+    }
+}
+
+/**
+ * @brief Drops the cached key so that it is parsed again on next use.
+ *
+ * Object handles are tied to labels, so an object written again keeps its
+ * handle and the cached key has to go.
+ */
+static void prvKeyCacheInvalidate( P11KeyCache_t * pxCache )
+{
+    if( ( NULL != pxCache->xMutex ) &&
+        ( pdTRUE == xSemaphoreTake( pxCache->xMutex, portMAX_DELAY ) ) )
+    {
+        mbedtls_pk_free( &pxCache->xKey );
+        mbedtls_pk_init( &pxCache->xKey );
+        pxCache->xHandle = 0;
+
+        xSemaphoreGive( pxCache->xMutex );
+    }
+}
+
+/**
+ * @brief Makes sure the cache holds the key of the given object, fetching
+ * and parsing it only if it does not already.
+ *
+ * Must be called with the mutex of the cache held.
+ *
+ * @param[in] pxCache The key cache.
+ * @param[in] xKey The handle of the key object.
+ * @param[in] xIsPrivateKey CK_TRUE if a private key is expected, CK_FALSE if
+ * a public key is expected.
+ */
+static CK_RV prvKeyCacheLoad( P11KeyCache_t * pxCache,
+                              CK_OBJECT_HANDLE xKey,
+                              CK_BBOOL xIsPrivateKey )
+{
+    CK_RV xResult = CKR_OK;
+    CK_BBOOL xIsPrivate = CK_FALSE;
+    uint8_t * keyData = NULL;
+    uint32_t ulKeyDataLength = 0;
+    int32_t lMbedTLSParseResult;
+
+    if( ( 0 == xKey ) || ( pxCache->xHandle != xKey ) )
+    {
+        xResult = PKCS11_PAL_GetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
+
+        if( ( xResult == CKR_OK ) && ( xIsPrivate != xIsPrivateKey ) )
+        {
+            xResult = CKR_KEY_TYPE_INCONSISTENT;
+        }
+
+        if( xResult == CKR_OK )
+        {
+            /* Replace whatever key was cached before. */
+            mbedtls_pk_free( &pxCache->xKey );
+            mbedtls_pk_init( &pxCache->xKey );
+            pxCache->xHandle = 0;
+
+            if( CK_TRUE == xIsPrivateKey )
+            {
+                lMbedTLSParseResult = mbedtls_pk_parse_key( &pxCache->xKey, keyData, ulKeyDataLength, NULL, 0 );
+            }
+            else
+            {
+                lMbedTLSParseResult = mbedtls_pk_parse_public_key( &pxCache->xKey, keyData, ulKeyDataLength );
+
+                if( 0 != lMbedTLSParseResult )
+                {
+                    lMbedTLSParseResult = mbedtls_pk_parse_key( &pxCache->xKey, keyData, ulKeyDataLength, NULL, 0 );
+                }
+            }
+
+            if( 0 == lMbedTLSParseResult )
+            {
+                pxCache->xHandle = xKey;
+            }
+            else
+            {
+                xResult = CKR_KEY_HANDLE_INVALID;
+            }
+        }
+
+        if( NULL != keyData )
+        {
+            PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
+        }
+    }
+
+    return xResult;
+}
+
 
 /*
  * PKCS#11 module implementation.
@@ -368,10 +501,21 @@ CK_RV prvMbedTLS_Initialize( void )
         {
             xResult = CKR_FUNCTION_FAILED;
         }
-        else
-        {
-            xP11Context.xIsInitialized = CK_TRUE;
-        }
+    }
+
+    if( xResult == CKR_OK )
+    {
+        xResult = prvKeyCacheInit( &xP11Context.xSignKeyCache );
+    }
+
+    if( xResult == CKR_OK )
+    {
+        xResult = prvKeyCacheInit( &xP11Context.xVerifyKeyCache );
+    }
+
+    if( xResult == CKR_OK )
+    {
+        xP11Context.xIsInitialized = CK_TRUE;
     }
 
     return xResult;
@@ -419,6 +563,9 @@ CK_DEFINE_FUNCTION( CK_RV, C_Finalize )( CK_VOID_PTR pvReserved )
             mbedtls_ctr_drbg_free( &xP11Context.xMbedDrbgCtx );
         }
 
+        prvKeyCacheFree( &xP11Context.xSignKeyCache );
+        prvKeyCacheFree( &xP11Context.xVerifyKeyCache );
+
         xP11Context.xIsInitialized = CK_FALSE;
     }
 
@@ -528,20 +675,6 @@ CK_DEFINE_FUNCTION( CK_RV, C_OpenSession )( CK_SLOT_ID xSlotID,
         {
             memset( pxSessionObj, 0, sizeof( P11Session_t ) );
         }
-
-        pxSessionObj->xSignMutex = xSemaphoreCreateMutex();
-
-        if( NULL == pxSessionObj->xSignMutex )
-        {
-            xResult = CKR_HOST_MEMORY;
-        }
-
-        pxSessionObj->xVerifyMutex = xSemaphoreCreateMutex();
-
-        if( NULL == pxSessionObj->xVerifyMutex )
-        {
-            xResult = CKR_HOST_MEMORY;
-        }
     }
 
     if( CKR_OK == xResult )
@@ -588,30 +721,9 @@ CK_DEFINE_FUNCTION( CK_RV, C_CloseSession )( CK_SESSION_HANDLE xSession )
     if( NULL != pxSession )
     {
         /*
-         * Tear down the session.
+         * Tear down the session. The keys stay cached in the slot.
          */
 
-        if( NULL != pxSession->xSignKey.pk_ctx )
-        {
-            mbedtls_pk_free( &pxSession->xSignKey );
-        }
-
-        if( NULL != pxSession->xSignMutex )
-        {
-            vSemaphoreDelete( pxSession->xSignMutex );
-        }
-
-        /* Free the public key context if it exists. */
-        if( NULL != pxSession->xVerifyKey.pk_ctx )
-        {
-            mbedtls_pk_free( &pxSession->xVerifyKey );
-        }
-
-        if( NULL != pxSession->xVerifyMutex )
-        {
-            vSemaphoreDelete( pxSession->xVerifyMutex );
-        }
-
         if( NULL != &pxSession->xSHA256Context )
         {
             mbedtls_sha256_free( &pxSession->xSHA256Context );
@@ -804,6 +916,13 @@ CK_DEFINE_FUNCTION( CK_RV, C_CreateObject )( CK_SESSION_HANDLE xSession,
         }
     }
 
+    /* The object may have replaced a key which is cached. */
+    if( CKR_OK == xResult )
+    {
+        prvKeyCacheInvalidate( &xP11Context.xSignKeyCache );
+        prvKeyCacheInvalidate( &xP11Context.xVerifyKeyCache );
+    }
+
     return xResult;
 }
 
@@ -816,6 +935,11 @@ CK_DEFINE_FUNCTION( CK_RV, C_DestroyObject )( CK_SESSION_HANDLE xSession,
     /* TODO: Delete objects from NVM. */
     ( void ) xSession;
     ( void ) xObject;
+
+    /* Do not keep using a key whose object is gone. */
+    prvKeyCacheInvalidate( &xP11Context.xSignKeyCache );
+    prvKeyCacheInvalidate( &xP11Context.xVerifyKeyCache );
+
     return CKR_OK;
 }
 
@@ -1222,12 +1346,9 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
                                          CK_OBJECT_HANDLE xKey )
 {
     CK_RV xResult = CKR_OK;
-    CK_BBOOL xIsPrivate;
 
     /*lint !e9072 It's OK to have different parameter name. */
     P11SessionPtr_t pxSession = prvSessionPointerFromHandle( xSession );
-    uint8_t * keyData = NULL;
-    uint32_t ulKeyDataLength = 0;
 
     if( NULL == pxMechanism )
     {
@@ -1235,50 +1356,31 @@ CK_DEFINE_FUNCTION( CK_RV, C_SignInit )( CK_SESSION_HANDLE xSession,
     }
     else
     {
-        xResult = PKCS11_PAL_GetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
+        if( pdTRUE == xSemaphoreTake( xP11Context.xSignKeyCache.xMutex, portMAX_DELAY ) )
+        {
+            /* Only fetched and parsed if the slot does not hold this key
+             * already. */
+            xResult = prvKeyCacheLoad( &xP11Context.xSignKeyCache, xKey, CK_TRUE );
+
+            /* TODO: Check the mechanism.  Note: Currently, mechanism is being set to CKM_SHA256, rather than
+             * CKM_RSA_PKCS
+             * CKM_SHA256_RSA_PKCS
+             * CKM_ECDSA
+             * Calling function does not know whether key is RSA or ECDSA.
+             * xKeyType = mbedtls_pk_get_type( &xP11Context.xSignKeyCache.xKey );
+             */
 
-        if( xIsPrivate != CK_TRUE )
+            xSemaphoreGive( xP11Context.xSignKeyCache.xMutex );
+        }
+        else
         {
-            xResult = CKR_KEY_TYPE_INCONSISTENT;
+            xResult = CKR_CANT_LOCK;
         }
 
         if( xResult == CKR_OK )
         {
-            if( pdTRUE == xSemaphoreTake( pxSession->xSignMutex, portMAX_DELAY ) )
-            {
-                /* Free the private key context if it exists.
-                * TODO: Check if the key is the same as was used previously. */
-                if ( NULL != pxSession->xSignKey.pk_ctx )
-                {
-                    mbedtls_pk_free( &pxSession->xSignKey );
-                }
-
-                mbedtls_pk_init( &pxSession->xSignKey );
-
-                if( 0 == mbedtls_pk_parse_key( &pxSession->xSignKey, keyData, ulKeyDataLength, NULL, 0 ) )
-                {
-                    /* TODO: Check the mechanism.  Note: Currently, mechanism is being set to CKM_SHA256, rather than
-                     * CKM_RSA_PKCS
-                     * CKM_SHA256_RSA_PKCS
-                     * CKM_ECDSA
-                     * Calling function does not know whether key is RSA or ECDSA.
-                     * xKeyType = mbedtls_pk_get_type( &pxSession->xSignKey );
-                     */
-                }
-                else
-                {
-                    xResult = CKR_KEY_HANDLE_INVALID;
-                }
-
-                xSemaphoreGive( pxSession->xSignMutex );
-            }
-            else
-            {
-                xResult = CKR_CANT_LOCK;
-            }
+            pxSession->xSignKeyHandle = xKey;
         }
-
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
     }
 
     return xResult;
@@ -1326,23 +1428,30 @@ CK_DEFINE_FUNCTION( CK_RV, C_Sign )( CK_SESSION_HANDLE xSession,
 
             if( CKR_OK == xResult )
             {
-                if( pdTRUE == xSemaphoreTake( pxSessionObj->xSignMutex, portMAX_DELAY ) )
+                if( pdTRUE == xSemaphoreTake( xP11Context.xSignKeyCache.xMutex, portMAX_DELAY ) )
                 {
-                    BaseType_t x = mbedtls_pk_sign( &pxSessionObj->xSignKey,
-                                                    MBEDTLS_MD_SHA256,
-                                                    pucData,
-                                                    ulDataLen,
-                                                    pucSignature,
-                                                    ( size_t * ) pulSignatureLen,
-                                                    mbedtls_ctr_drbg_random,
-                                                    &xP11Context.xMbedDrbgCtx );
-
-                    if( x != CKR_OK )
+                    /* Another session may have replaced the cached key
+                     * since C_SignInit. */
+                    xResult = prvKeyCacheLoad( &xP11Context.xSignKeyCache, pxSessionObj->xSignKeyHandle, CK_TRUE );
+
+                    if( CKR_OK == xResult )
                     {
-                        xResult = CKR_FUNCTION_FAILED;
+                        BaseType_t x = mbedtls_pk_sign( &xP11Context.xSignKeyCache.xKey,
+                                                        MBEDTLS_MD_SHA256,
+                                                        pucData,
+                                                        ulDataLen,
+                                                        pucSignature,
+                                                        ( size_t * ) pulSignatureLen,
+                                                        mbedtls_ctr_drbg_random,
+                                                        &xP11Context.xMbedDrbgCtx );
+
+                        if( x != CKR_OK )
+                        {
+                            xResult = CKR_FUNCTION_FAILED;
+                        }
                     }
 
-                    xSemaphoreGive( pxSessionObj->xSignMutex );
+                    xSemaphoreGive( xP11Context.xSignKeyCache.xMutex );
                 }
                 else
                 {
@@ -1363,10 +1472,7 @@ CK_DEFINE_FUNCTION( CK_RV, C_VerifyInit )( CK_SESSION_HANDLE xSession,
                                            CK_OBJECT_HANDLE xKey )
 {
     CK_RV xResult = CKR_OK;
-    CK_BBOOL xIsPrivate = CK_TRUE;
     P11SessionPtr_t pxSession;
-    uint8_t * keyData = NULL;
-    uint32_t ulKeyDataLength = 0;
 
     /*lint !e9072 It's OK to have different parameter name. */
     ( void ) ( xSession );
@@ -1380,44 +1486,23 @@ CK_DEFINE_FUNCTION( CK_RV, C_VerifyInit )( CK_SESSION_HANDLE xSession,
 
     if( xResult == CKR_OK )
     {
-        xResult = PKCS11_PAL_GetObjectValue( xKey, &keyData, &ulKeyDataLength, &xIsPrivate );
-    }
-
-    if( ( xResult == CKR_OK ) && ( xIsPrivate != CK_FALSE ) )
-    {
-        xResult = CKR_KEY_TYPE_INCONSISTENT;
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
-    }
-
-    if( xResult == CKR_OK )
-    {
-        if( pdTRUE == xSemaphoreTake( pxSession->xVerifyMutex, portMAX_DELAY ) )
+        if( pdTRUE == xSemaphoreTake( xP11Context.xVerifyKeyCache.xMutex, portMAX_DELAY ) )
         {
-            /* Free the public key context if it exists.
-            * TODO: Check if the key is the same as used by last verify operation. */
-            if ( NULL != pxSession->xVerifyKey.pk_ctx )
-            {
-                mbedtls_pk_free( &pxSession->xVerifyKey );
-            }
+            /* Only fetched and parsed if the slot does not hold this key
+             * already. */
+            xResult = prvKeyCacheLoad( &xP11Context.xVerifyKeyCache, xKey, CK_FALSE );
 
-            mbedtls_pk_init( &pxSession->xVerifyKey );
-
-            if( 0 != mbedtls_pk_parse_public_key( &pxSession->xVerifyKey, keyData, ulKeyDataLength ) )
-            {
-                if( 0 != mbedtls_pk_parse_key( &pxSession->xVerifyKey, keyData, ulKeyDataLength, NULL, 0 ) )
-                {
-                    xResult = CKR_KEY_HANDLE_INVALID;
-                }
-            }
-
-            xSemaphoreGive( pxSession->xVerifyMutex );
+            xSemaphoreGive( xP11Context.xVerifyKeyCache.xMutex );
         }
         else
         {
             xResult = CKR_CANT_LOCK;
         }
+    }
 
-        PKCS11_PAL_GetObjectValueCleanup( keyData, ulKeyDataLength );
+    if( xResult == CKR_OK )
+    {
+        pxSession->xVerifyKeyHandle = xKey;
     }
 
     return xResult;
@@ -1448,23 +1533,28 @@ CK_DEFINE_FUNCTION( CK_RV, C_Verify )( CK_SESSION_HANDLE xSession,
     {
         pxSessionObj = prvSessionPointerFromHandle( xSession ); /*lint !e9072 It's OK to have different parameter name. */
 
-        if( pdTRUE == xSemaphoreTake( pxSessionObj->xVerifyMutex, portMAX_DELAY ) )
+        if( pdTRUE == xSemaphoreTake( xP11Context.xVerifyKeyCache.xMutex, portMAX_DELAY ) )
         {
-            /* Verify the signature. If a public key is present, use it. */
-            if( NULL != pxSessionObj->xVerifyKey.pk_ctx )
+            /* Verify the signature. If a public key is present, use it.
+             * Another session may have replaced the cached key since
+             * C_VerifyInit. */
+            if( 0 != pxSessionObj->xVerifyKeyHandle )
             {
-                if( 0 != mbedtls_pk_verify( &pxSessionObj->xVerifyKey,
-                                            MBEDTLS_MD_SHA256,
-                                            pucData,
-                                            ulDataLen,
-                                            pucSignature,
-                                            ulSignatureLen ) )
+                xResult = prvKeyCacheLoad( &xP11Context.xVerifyKeyCache, pxSessionObj->xVerifyKeyHandle, CK_FALSE );
+
+                if( ( CKR_OK == xResult ) &&
+                    ( 0 != mbedtls_pk_verify( &xP11Context.xVerifyKeyCache.xKey,
+                                              MBEDTLS_MD_SHA256,
+                                              pucData,
+                                              ulDataLen,
+                                              pucSignature,
+                                              ulSignatureLen ) ) )
                 {
                     xResult = CKR_SIGNATURE_INVALID;
                 }
             }
 
-            xSemaphoreGive( pxSessionObj->xVerifyMutex );
+            xSemaphoreGive( xP11Context.xVerifyKeyCache.xMutex );
         }
         else
         {
@@ -1555,6 +1645,10 @@ CK_DEFINE_FUNCTION( CK_RV, C_GenerateKeyPair )( CK_SESSION_HANDLE xSession,
         /* FIXME: This is a hack.*/
         *pxPublicKey = *pxPrivateKey + 1;
         xResult = CKR_OK;
+
+        /* The new key pair replaces any cached key with the same handles. */
+        prvKeyCacheInvalidate( &xP11Context.xSignKeyCache );
+        prvKeyCacheInvalidate( &xP11Context.xVerifyKeyCache );
     }
     else
     {
@@ -0,0 +1,341 @@
+/*
+ * Amazon FreeRTOS PKCS #11 PAL for Linux V1.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_pkcs11_pal.c
+ * @brief Amazon FreeRTOS device specific helper functions for
+ * PKCS#11 implementation based on mbedTLS.  Objects are kept in
+ * files on the host file system.  This file deviates from the
+ * FreeRTOS style standard for some function names and
+ * data types in order to maintain compliance with the PKCS#11 standard.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "aws_pkcs11.h"
+#include "aws_pkcs11_config.h"
+
+/* C runtime includes. */
+#include <stdio.h>
+#include <string.h>
+
+#define pkcs11OBJECT_MAX_SIZE    2048
+
+/**
+ * @brief Directory the object files are kept in.
+ *
+ * The default is the working directory of the simulator.
+ */
+#ifndef pkcs11configFILE_DIRECTORY
+    #define pkcs11configFILE_DIRECTORY    "."
+#endif
+
+#define pkcs11FILE_NAME_CLIENT_CERTIFICATE    pkcs11configFILE_DIRECTORY "/FreeRTOS_P11_Certificate.dat"
+#define pkcs11FILE_NAME_KEY                   pkcs11configFILE_DIRECTORY "/FreeRTOS_P11_Key.dat"
+#define pkcs11FILE_NAME_CODE_SIGN_KEY         pkcs11configFILE_DIRECTORY "/FreeRTOS_P11_CodeSignKey.dat"
+
+enum eObjectHandles
+{
+    eInvalidHandle = 0, /* From PKCS #11 spec: 0 is never a valid object handle.*/
+    eAwsDevicePrivateKey = 1,
+    eAwsDevicePublicKey,
+    eAwsDeviceCertificate,
+    eAwsCodeSigningKey
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Translates an object handle into the name of its file.
+ *
+ * The public key is derived from the private key, so both share a file.
+ *
+ * @param[in] xHandle The object handle.
+ *
+ * @return The file name, or NULL if the handle is not valid.
+ */
+static const char * prvHandleToFileName( CK_OBJECT_HANDLE xHandle );
+/*-----------------------------------------------------------*/
+
+static const char * prvHandleToFileName( CK_OBJECT_HANDLE xHandle )
+{
+    const char * pcFileName = NULL;
+
+    switch( xHandle )
+    {
+        case eAwsDeviceCertificate:
+            pcFileName = pkcs11FILE_NAME_CLIENT_CERTIFICATE;
+            break;
+
+        case eAwsDevicePrivateKey:
+        case eAwsDevicePublicKey:
+            pcFileName = pkcs11FILE_NAME_KEY;
+            break;
+
+        case eAwsCodeSigningKey:
+            pcFileName = pkcs11FILE_NAME_CODE_SIGN_KEY;
+            break;
+
+        default:
+            break;
+    }
+
+    return pcFileName;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Saves an object in non-volatile storage.
+ *
+ * Port-specific file write for cryptographic information.
+ *
+ * @param[in] pxLabel       The label of the object to be stored.
+ * @param[in] pucData       The object data to be saved
+ * @param[in] pulDataSize   Size (in bytes) of object data.
+ *
+ * @return The object handle if successful.
+ * eInvalidHandle = 0 if unsuccessful.
+ */
+CK_OBJECT_HANDLE PKCS11_PAL_SaveObject( CK_ATTRIBUTE_PTR pxLabel,
+                                        uint8_t * pucData,
+                                        uint32_t ulDataSize )
+{
+    CK_OBJECT_HANDLE xHandle = eInvalidHandle;
+    FILE * pxFile;
+
+    if( ulDataSize <= pkcs11OBJECT_MAX_SIZE )
+    {
+        if( strcmp( pxLabel->pValue,
+                    pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS ) == 0 )
+        {
+            xHandle = eAwsDeviceCertificate;
+        }
+        else if( strcmp( pxLabel->pValue,
+                         pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS ) == 0 )
+        {
+            xHandle = eAwsDevicePrivateKey;
+        }
+        else if( strcmp( pxLabel->pValue,
+                         pkcs11configLABEL_CODE_VERIFICATION_KEY ) == 0 )
+        {
+            xHandle = eAwsCodeSigningKey;
+        }
+    }
+
+    if( xHandle != eInvalidHandle )
+    {
+        /* Overwrite any previous version of the object. */
+        pxFile = fopen( prvHandleToFileName( xHandle ), "wb" );
+
+        if( pxFile == NULL )
+        {
+            xHandle = eInvalidHandle;
+        }
+        else
+        {
+            if( fwrite( pucData, 1, ulDataSize, pxFile ) != ulDataSize )
+            {
+                xHandle = eInvalidHandle;
+            }
+
+            if( fclose( pxFile ) != 0 )
+            {
+                xHandle = eInvalidHandle;
+            }
+        }
+    }
+
+    return xHandle;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Translates a PKCS #11 label into an object handle.
+ *
+ * Port-specific object handle retrieval.
+ *
+ *
+ * @param[in] pLabel         Pointer to the label of the object
+ *                           who's handle should be found.
+ * @param[in] usLength       The length of the label, in bytes.
+ *
+ * @return The object handle if operation was successful.
+ * Returns eInvalidHandle if unsuccessful.
+ */
+CK_OBJECT_HANDLE PKCS11_PAL_FindObject( uint8_t * pLabel,
+                                        uint8_t usLength )
+{
+    CK_OBJECT_HANDLE xHandle = eInvalidHandle;
+    FILE * pxFile;
+
+    if( 0 == memcmp( pLabel, pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS, usLength ) )
+    {
+        xHandle = eAwsDeviceCertificate;
+    }
+    else if( 0 == memcmp( pLabel, pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS, usLength ) )
+    {
+        xHandle = eAwsDevicePrivateKey;
+    }
+    else if( 0 == memcmp( pLabel, pkcs11configLABEL_CODE_VERIFICATION_KEY, usLength ) )
+    {
+        xHandle = eAwsCodeSigningKey;
+    }
+
+    /* The object only exists if its file does. */
+    if( xHandle != eInvalidHandle )
+    {
+        pxFile = fopen( prvHandleToFileName( xHandle ), "rb" );
+
+        if( pxFile == NULL )
+        {
+            xHandle = eInvalidHandle;
+        }
+        else
+        {
+            ( void ) fclose( pxFile );
+        }
+    }
+
+    return xHandle;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Gets the value of an object in storage, by handle.
+ *
+ * Port-specific file access for cryptographic information.
+ *
+ * This call dynamically allocates the buffer which object value
+ * data is copied into.  PKCS11_PAL_GetObjectValueCleanup()
+ * should be called after each use to free the dynamically allocated
+ * buffer.
+ *
+ * @sa PKCS11_PAL_GetObjectValueCleanup
+ *
+ * @param[in] xHandle       The handle of the object to be read.
+ * @param[out] ppucData     Pointer to buffer for file data.
+ * @param[out] pulDataSize  Size (in bytes) of data located in file.
+ * @param[out] pIsPrivate   Boolean indicating if value is private (CK_TRUE)
+ *                          or exportable (CK_FALSE)
+ *
+ * @return CKR_OK if operation was successful.  CKR_KEY_HANDLE_INVALID if
+ * no such object handle was found, CKR_DEVICE_MEMORY if memory for
+ * buffer could not be allocated, CKR_FUNCTION_FAILED for device driver
+ * error.
+ */
+CK_RV PKCS11_PAL_GetObjectValue( CK_OBJECT_HANDLE xHandle,
+                                 uint8_t ** ppucData,
+                                 uint32_t * pulDataSize,
+                                 CK_BBOOL * pIsPrivate )
+{
+    CK_RV ulReturn = CKR_OK;
+    const char * pcFileName = prvHandleToFileName( xHandle );
+    FILE * pxFile = NULL;
+    long lSize = 0;
+
+    *ppucData = NULL;
+
+    if( pcFileName == NULL )
+    {
+        ulReturn = CKR_OBJECT_HANDLE_INVALID;
+    }
+    else
+    {
+        pxFile = fopen( pcFileName, "rb" );
+
+        if( pxFile == NULL )
+        {
+            ulReturn = CKR_OBJECT_HANDLE_INVALID;
+        }
+    }
+
+    /* Find the size of the object. */
+    if( ulReturn == CKR_OK )
+    {
+        if( ( fseek( pxFile, 0, SEEK_END ) != 0 ) ||
+            ( ( lSize = ftell( pxFile ) ) <= 0 ) ||
+            ( lSize > pkcs11OBJECT_MAX_SIZE ) ||
+            ( fseek( pxFile, 0, SEEK_SET ) != 0 ) )
+        {
+            ulReturn = CKR_FUNCTION_FAILED;
+        }
+    }
+
+    if( ulReturn == CKR_OK )
+    {
+        *ppucData = pvPortMalloc( ( size_t ) lSize );
+
+        if( *ppucData == NULL )
+        {
+            ulReturn = CKR_DEVICE_MEMORY;
+        }
+    }
+
+    if( ulReturn == CKR_OK )
+    {
+        if( fread( *ppucData, 1, ( size_t ) lSize, pxFile ) == ( size_t ) lSize )
+        {
+            *pulDataSize = ( uint32_t ) lSize;
+            *pIsPrivate = ( xHandle == eAwsDevicePrivateKey ) ? CK_TRUE : CK_FALSE;
+        }
+        else
+        {
+            vPortFree( *ppucData );
+            *ppucData = NULL;
+            ulReturn = CKR_FUNCTION_FAILED;
+        }
+    }
+
+    if( pxFile != NULL )
+    {
+        ( void ) fclose( pxFile );
+    }
+
+    return ulReturn;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Cleanup after PKCS11_GetObjectValue().
+ *
+ * @param[in] pucData       The buffer to free.
+ *                          (*ppucData from PKCS11_PAL_GetObjectValue())
+ * @param[in] ulDataSize    The length of the buffer to free.
+ *                          (*pulDataSize from PKCS11_PAL_GetObjectValue())
+ */
+void PKCS11_PAL_GetObjectValueCleanup( uint8_t * pucData,
+                                       uint32_t ulDataSize )
+{
+    /* Unused parameters. */
+    ( void ) ulDataSize;
+
+    /* Free the buffer allocated by PKCS11_PAL_GetObjectValue. */
+    if( pucData != NULL )
+    {
+        vPortFree( pucData );
+    }
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,1039 @@
+/*
+ * Amazon FreeRTOS Secure Sockets for Linux V1.0.0
+ * Copyright (C) 2018 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+
+/**
+ * @file aws_secure_sockets.c
+ * @brief Secure Socket interface implementation on top of the host BSD sockets.
+ */
+
+/* Standard includes. */
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* TLS includes. */
+#include "aws_tls.h"
+
+/* Socket interface includes. */
+#include "aws_secure_sockets.h"
+
+/**
+ * @brief A Flag to indicate whether or not a socket is
+ * secure i.e. it uses TLS or not.
+ */
+#define linuxsecuresocketsSOCKET_SECURE_FLAG          ( 1UL << 0 )
+
+/**
+ * @brief A flag to indicate whether or not a socket is closed
+ * for receive.
+ */
+#define linuxsecuresocketsSOCKET_READ_CLOSED_FLAG     ( 1UL << 1 )
+
+/**
+ * @brief A flag to indicate whether or not a socket is closed
+ * for send.
+ */
+#define linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG    ( 1UL << 2 )
+
+/**
+ * @brief A flag to indicate whether or not the socket is connected.
+ */
+#define linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG    ( 1UL << 3 )
+
+/**
+ * @brief The maximum number of sockets that can be open at the same time.
+ */
+#ifndef socketsconfigMAX_SOCKETS
+    #define socketsconfigMAX_SOCKETS                  ( 8 )
+#endif
+
+/**
+ * @brief Delay used between network attempts when effecting a timeout.
+ *
+ * The host descriptors are always non-blocking. A task that blocked inside
+ * a host system call would look like a running task to the scheduler and
+ * would starve every lower priority task, so timeouts are mocked in the
+ * secure sockets layer instead and this constant sets the sleep time
+ * between each attempt during the timeout period.
+ */
+#define linuxsecuresocketsPOLL_DELAY                  ( pdMS_TO_TICKS( 1 ) )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Represents a secure socket.
+ */
+typedef struct LinuxSecureSocket
+{
+    uint8_t ucInUse;                    /**< Tracks whether the socket is in use or not. */
+    int iSocket;                        /**< Host socket descriptor, -1 when not allocated. */
+    uint32_t ulFlags;                   /**< Various properties of the socket (secured etc.). */
+    TickType_t xSendTimeout;            /**< Send timeout. */
+    TickType_t xReceiveTimeout;         /**< Receive timeout. */
+    char * pcDestination;               /**< Destination URL. Set using SOCKETS_SO_SERVER_NAME_INDICATION option in SOCKETS_SetSockOpt function. */
+    void * pvTLSContext;                /**< The TLS Context. */
+    char * pcServerCertificate;         /**< Server certificate. Set using SOCKETS_SO_TRUSTED_SERVER_CERTIFICATE option in SOCKETS_SetSockOpt function. */
+    uint32_t ulServerCertificateLength; /**< Length of the server certificate. */
+    char ** ppcAlpnProtocols;           /**< NULL terminated list of ALPN protocols. Set using SOCKETS_SO_ALPN_PROTOCOLS option in SOCKETS_SetSockOpt function. */
+    uint32_t ulAlpnProtocolsCount;      /**< Number of entries in ppcAlpnProtocols, not counting the NULL terminator. */
+} LinuxSecureSocket_t;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Secure socket objects.
+ *
+ * An index in this array is returned to the user from SOCKETS_Socket
+ * function.
+ */
+static LinuxSecureSocket_t xSockets[ socketsconfigMAX_SOCKETS ];
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a free socket from the free socket pool.
+ *
+ * Iterates over the xSockets array to see if it can find
+ * a free socket. A free or unused socket is indicated by
+ * the zero value of the ucInUse member of LinuxSecureSocket_t.
+ *
+ * @return Index of the socket in the xSockets array, if it is
+ * able to find a free socket, SOCKETS_INVALID_SOCKET otherwise.
+ */
+static uint32_t prvGetFreeSocket( void );
+
+/**
+ * @brief Returns the socket back to the free socket pool.
+ *
+ * Marks the socket as free by setting ucInUse member of the
+ * LinuxSecureSocket_t structure as zero.
+ */
+static void prvReturnSocket( uint32_t ulSocketNumber );
+
+/**
+ * @brief Checks whether or not the provided socket number is valid.
+ *
+ * Ensures that the provided number is less than socketsconfigMAX_SOCKETS
+ * and the socket is "in-use" i.e. ucInUse is set to non-zero in the
+ * socket structure.
+ *
+ * @param[in] ulSocketNumber The provided socket number to check.
+ *
+ * @return pdTRUE if the socket is valid, pdFALSE otherwise.
+ */
+static BaseType_t prvIsValidSocket( uint32_t ulSocketNumber );
+
+/**
+ * @brief Frees the option buffers attached to the socket.
+ *
+ * @param[in] pxSecureSocket The socket whose buffers are to be freed.
+ */
+static void prvFreeSocketOptions( LinuxSecureSocket_t * pxSecureSocket );
+
+/**
+ * @brief Sends the provided data over the host socket.
+ *
+ * @param[in] pvContext The caller context. Socket number in our case.
+ * @param[in] pucData The data to send.
+ * @param[in] xDataLength Length of the data.
+ *
+ * @return Number of bytes actually sent if successful, 0 if the send
+ * timeout expired before any data could be sent, SOCKETS_SOCKET_ERROR
+ * otherwise.
+ */
+static BaseType_t prvNetworkSend( void * pvContext,
+                                  const unsigned char * pucData,
+                                  size_t xDataLength );
+
+/**
+ * @brief Receives the data over the host socket.
+ *
+ * @param[in] pvContext The caller context. Socket number in our case.
+ * @param[out] pucReceiveBuffer The buffer to receive the data in.
+ * @param[in] xReceiveBufferLength The length of the provided buffer.
+ *
+ * @return The number of bytes actually received if successful, 0 if the
+ * receive timeout expired, SOCKETS_ECLOSED if the peer closed the
+ * connection, SOCKETS_SOCKET_ERROR otherwise.
+ */
+static BaseType_t prvNetworkRecv( void * pvContext,
+                                  unsigned char * pucReceiveBuffer,
+                                  size_t xReceiveBufferLength );
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetFreeSocket( void )
+{
+    uint32_t ulIndex;
+
+    /* Iterate over xSockets array to see if any free socket
+     * is available. */
+    for( ulIndex = 0; ulIndex < ( uint32_t ) socketsconfigMAX_SOCKETS; ulIndex++ )
+    {
+        /* Since multiple tasks can be accessing this simultaneously,
+         * this has to be in critical section. */
+        taskENTER_CRITICAL();
+
+        if( xSockets[ ulIndex ].ucInUse == 0U )
+        {
+            /* Mark the socket as "in-use". */
+            xSockets[ ulIndex ].ucInUse = 1;
+            taskEXIT_CRITICAL();
+
+            /* We have found a free socket, so stop. */
+            break;
+        }
+        else
+        {
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    /* Did we find a free socket? */
+    if( ulIndex == ( uint32_t ) socketsconfigMAX_SOCKETS )
+    {
+        /* Return SOCKETS_INVALID_SOCKET if we fail to
+         * find a free socket. */
+        ulIndex = ( uint32_t ) ( uintptr_t ) SOCKETS_INVALID_SOCKET;
+    }
+
+    return ulIndex;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReturnSocket( uint32_t ulSocketNumber )
+{
+    /* Since multiple tasks can be accessing this simultaneously,
+     * this has to be in critical section. */
+    taskENTER_CRITICAL();
+    {
+        /* Mark the socket as free. */
+        xSockets[ ulSocketNumber ].ucInUse = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIsValidSocket( uint32_t ulSocketNumber )
+{
+    BaseType_t xValid = pdFALSE;
+
+    /* Check that the provided socket number is within the valid
+     * index range. */
+    if( ulSocketNumber < ( uint32_t ) socketsconfigMAX_SOCKETS )
+    {
+        /* Since multiple tasks can be accessing this simultaneously,
+         * this has to be in critical section. */
+        taskENTER_CRITICAL();
+        {
+            /* Check that this socket is in use. */
+            if( xSockets[ ulSocketNumber ].ucInUse == 1U )
+            {
+                /* This is a valid socket number. */
+                xValid = pdTRUE;
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    return xValid;
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreeSocketOptions( LinuxSecureSocket_t * pxSecureSocket )
+{
+    uint32_t ulIndex;
+
+    /* Free the space allocated for pcDestination. */
+    if( pxSecureSocket->pcDestination != NULL )
+    {
+        vPortFree( pxSecureSocket->pcDestination );
+        pxSecureSocket->pcDestination = NULL;
+    }
+
+    /* Free the space allocated for pcServerCertificate. */
+    if( pxSecureSocket->pcServerCertificate != NULL )
+    {
+        vPortFree( pxSecureSocket->pcServerCertificate );
+        pxSecureSocket->pcServerCertificate = NULL;
+        pxSecureSocket->ulServerCertificateLength = 0;
+    }
+
+    /* Free the ALPN protocol list and every string it points to. */
+    if( pxSecureSocket->ppcAlpnProtocols != NULL )
+    {
+        for( ulIndex = 0; ulIndex < pxSecureSocket->ulAlpnProtocolsCount; ulIndex++ )
+        {
+            if( pxSecureSocket->ppcAlpnProtocols[ ulIndex ] != NULL )
+            {
+                vPortFree( pxSecureSocket->ppcAlpnProtocols[ ulIndex ] );
+            }
+        }
+
+        vPortFree( pxSecureSocket->ppcAlpnProtocols );
+        pxSecureSocket->ppcAlpnProtocols = NULL;
+        pxSecureSocket->ulAlpnProtocolsCount = 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvNetworkSend( void * pvContext,
+                                  const unsigned char * pucData,
+                                  size_t xDataLength )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) pvContext;
+    LinuxSecureSocket_t * pxSecureSocket;
+    TickType_t xTimeOnEntering = xTaskGetTickCount();
+    ssize_t xSentBytes;
+    BaseType_t xRetVal;
+
+    /* Shortcut for easy access. */
+    pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+    for( ; ; )
+    {
+        /* MSG_NOSIGNAL stops a reset connection from raising SIGPIPE,
+         * which would terminate the whole simulator. */
+        xSentBytes = send( pxSecureSocket->iSocket,
+                           pucData,
+                           xDataLength,
+                           MSG_DONTWAIT | MSG_NOSIGNAL );
+
+        if( xSentBytes >= 0 )
+        {
+            /* Success, return the number of bytes sent. */
+            xRetVal = ( BaseType_t ) xSentBytes;
+            break;
+        }
+        else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+        {
+            /* The host send buffer is full, but has the socket timeout
+             * expired too? A timeout of zero means wait forever. */
+            if( ( pxSecureSocket->xSendTimeout == 0 ) ||
+                ( ( xTaskGetTickCount() - xTimeOnEntering ) < pxSecureSocket->xSendTimeout ) )
+            {
+                /* Block for a short while to allow other tasks to run
+                 * before trying again. */
+                vTaskDelay( linuxsecuresocketsPOLL_DELAY );
+            }
+            else
+            {
+                /* Nothing could be sent before the timeout. */
+                xRetVal = 0;
+                break;
+            }
+        }
+        else
+        {
+            /* The connection is broken. */
+            xRetVal = SOCKETS_SOCKET_ERROR;
+            break;
+        }
+    }
+
+    return xRetVal;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvNetworkRecv( void * pvContext,
+                                  unsigned char * pucReceiveBuffer,
+                                  size_t xReceiveBufferLength )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) pvContext;
+    LinuxSecureSocket_t * pxSecureSocket;
+    TickType_t xTimeOnEntering = xTaskGetTickCount();
+    ssize_t xReceivedBytes;
+    BaseType_t xRetVal;
+
+    /* Shortcut for easy access. */
+    pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+    for( ; ; )
+    {
+        xReceivedBytes = recv( pxSecureSocket->iSocket,
+                               pucReceiveBuffer,
+                               xReceiveBufferLength,
+                               MSG_DONTWAIT );
+
+        if( xReceivedBytes > 0 )
+        {
+            /* Success, return the number of bytes received. */
+            xRetVal = ( BaseType_t ) xReceivedBytes;
+            break;
+        }
+        else if( xReceivedBytes == 0 )
+        {
+            /* The peer performed an orderly shutdown. */
+            xRetVal = SOCKETS_ECLOSED;
+            break;
+        }
+        else if( ( errno == EAGAIN ) || ( errno == EWOULDBLOCK ) || ( errno == EINTR ) )
+        {
+            /* No data yet, but has the socket timeout expired too? A
+             * timeout of zero means wait forever. */
+            if( ( pxSecureSocket->xReceiveTimeout == 0 ) ||
+                ( ( xTaskGetTickCount() - xTimeOnEntering ) < pxSecureSocket->xReceiveTimeout ) )
+            {
+                /* Block for a short while to allow other tasks to run
+                 * before trying again. */
+                vTaskDelay( linuxsecuresocketsPOLL_DELAY );
+            }
+            else
+            {
+                /* The socket read has timed out. Returning
+                 * SOCKETS_EWOULDBLOCK will cause mBedTLS to fail
+                 * and so we must return zero. */
+                xRetVal = 0;
+                break;
+            }
+        }
+        else
+        {
+            /* The connection is broken. */
+            xRetVal = SOCKETS_SOCKET_ERROR;
+            break;
+        }
+    }
+
+    return xRetVal;
+}
+/*-----------------------------------------------------------*/
+
+Socket_t SOCKETS_Socket( int32_t lDomain,
+                         int32_t lType,
+                         int32_t lProtocol )
+{
+    uint32_t ulSocketNumber;
+    int iSocket;
+
+    /* Ensure that only supported values are supplied. */
+    configASSERT( lDomain == SOCKETS_AF_INET );
+    configASSERT( ( lType == SOCKETS_SOCK_STREAM && lProtocol == SOCKETS_IPPROTO_TCP ) );
+
+    /* Try to get a free socket. */
+    ulSocketNumber = prvGetFreeSocket();
+
+    /* If we get a free socket, create the host socket backing it. */
+    if( ulSocketNumber != ( uint32_t ) ( uintptr_t ) SOCKETS_INVALID_SOCKET )
+    {
+        iSocket = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP );
+
+        if( iSocket >= 0 )
+        {
+            /* Initialize all the members to sane values. */
+            xSockets[ ulSocketNumber ].iSocket = iSocket;
+            xSockets[ ulSocketNumber ].ulFlags = 0;
+            xSockets[ ulSocketNumber ].xSendTimeout = pdMS_TO_TICKS( socketsconfigDEFAULT_SEND_TIMEOUT );
+            xSockets[ ulSocketNumber ].xReceiveTimeout = pdMS_TO_TICKS( socketsconfigDEFAULT_RECV_TIMEOUT );
+            xSockets[ ulSocketNumber ].pcDestination = NULL;
+            xSockets[ ulSocketNumber ].pvTLSContext = NULL;
+            xSockets[ ulSocketNumber ].pcServerCertificate = NULL;
+            xSockets[ ulSocketNumber ].ulServerCertificateLength = 0;
+            xSockets[ ulSocketNumber ].ppcAlpnProtocols = NULL;
+            xSockets[ ulSocketNumber ].ulAlpnProtocolsCount = 0;
+        }
+        else
+        {
+            /* The host is out of descriptors. */
+            prvReturnSocket( ulSocketNumber );
+            ulSocketNumber = ( uint32_t ) ( uintptr_t ) SOCKETS_INVALID_SOCKET;
+        }
+    }
+
+    /* If we fail to get a free socket, we return SOCKETS_INVALID_SOCKET. */
+    return ( Socket_t ) ( uintptr_t ) ulSocketNumber;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_Connect( Socket_t xSocket,
+                         SocketsSockaddr_t * pxAddress,
+                         Socklen_t xAddressLength )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    struct sockaddr_in xHostAddress;
+    struct pollfd xPollFd;
+    TickType_t xTimeOnEntering = xTaskGetTickCount();
+    int iError = 0, iOptionValue = 1;
+    socklen_t xErrorLength = sizeof( iError );
+    int32_t lRetVal = SOCKETS_ERROR_NONE;
+    TLSParams_t xTLSParams = { 0 };
+
+    /* Remove warning about unused parameters. */
+    ( void ) xAddressLength;
+
+    /* Ensure that a valid socket was passed. */
+    if( ( prvIsValidSocket( ulSocketNumber ) == pdTRUE ) && ( pxAddress != NULL ) )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        /* Check that the socket is not already connected. */
+        if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) != 0UL )
+        {
+            /* Connect attempted on an already connected socket. */
+            lRetVal = SOCKETS_SOCKET_ERROR;
+        }
+
+        if( lRetVal == SOCKETS_ERROR_NONE )
+        {
+            /* Both the port and the address are already in network byte
+             * order. */
+            memset( &( xHostAddress ), 0, sizeof( xHostAddress ) );
+            xHostAddress.sin_family = AF_INET;
+            xHostAddress.sin_port = pxAddress->usPort;
+            xHostAddress.sin_addr.s_addr = pxAddress->ulAddress;
+
+            if( connect( pxSecureSocket->iSocket,
+                         ( struct sockaddr * ) &( xHostAddress ),
+                         sizeof( xHostAddress ) ) != 0 )
+            {
+                if( errno == EINPROGRESS )
+                {
+                    /* Wait for the connection to complete, bounded by the
+                     * send timeout. */
+                    xPollFd.fd = pxSecureSocket->iSocket;
+                    xPollFd.events = POLLOUT;
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+
+                    while( ( pxSecureSocket->xSendTimeout == 0 ) ||
+                           ( ( xTaskGetTickCount() - xTimeOnEntering ) < pxSecureSocket->xSendTimeout ) )
+                    {
+                        if( poll( &( xPollFd ), 1, 0 ) > 0 )
+                        {
+                            /* The connection completed, find out whether it
+                             * succeeded. */
+                            if( ( getsockopt( pxSecureSocket->iSocket, SOL_SOCKET, SO_ERROR, &( iError ), &( xErrorLength ) ) == 0 ) &&
+                                ( iError == 0 ) )
+                            {
+                                lRetVal = SOCKETS_ERROR_NONE;
+                            }
+
+                            break;
+                        }
+
+                        vTaskDelay( linuxsecuresocketsPOLL_DELAY );
+                    }
+                }
+                else
+                {
+                    /* Connection failed. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+            }
+
+            if( lRetVal == SOCKETS_ERROR_NONE )
+            {
+                /* MQTT packets are small, so do not let Nagle hold them
+                 * back. */
+                ( void ) setsockopt( pxSecureSocket->iSocket, IPPROTO_TCP, TCP_NODELAY, &( iOptionValue ), sizeof( iOptionValue ) );
+
+                /* Mark that the socket is connected. */
+                pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG;
+            }
+        }
+    }
+    else
+    {
+        /* Invalid socket handle was passed. */
+        lRetVal = SOCKETS_EINVAL;
+    }
+
+    /* Initialize TLS only if the connection is successful. */
+    if( ( lRetVal == SOCKETS_ERROR_NONE ) &&
+        ( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_SECURE_FLAG ) != 0UL ) )
+    {
+        /* Setup TLS parameters. */
+        xTLSParams.ulSize = sizeof( xTLSParams );
+        xTLSParams.pcDestination = pxSecureSocket->pcDestination;
+        xTLSParams.pcServerCertificate = pxSecureSocket->pcServerCertificate;
+        xTLSParams.ulServerCertificateLength = pxSecureSocket->ulServerCertificateLength;
+        xTLSParams.ppcAlpnProtocols = ( const char ** ) pxSecureSocket->ppcAlpnProtocols;
+        xTLSParams.ulAlpnProtocolsCount = pxSecureSocket->ulAlpnProtocolsCount;
+        xTLSParams.pvCallerContext = ( void * ) xSocket;
+        xTLSParams.pxNetworkRecv = &( prvNetworkRecv );
+        xTLSParams.pxNetworkSend = &( prvNetworkSend );
+
+        /* Initialize TLS. */
+        if( TLS_Init( &( pxSecureSocket->pvTLSContext ), &( xTLSParams ) ) == pdFREERTOS_ERRNO_NONE )
+        {
+            /* Initiate TLS handshake. */
+            if( TLS_Connect( pxSecureSocket->pvTLSContext ) != pdFREERTOS_ERRNO_NONE )
+            {
+                /* TLS handshake failed. */
+                lRetVal = SOCKETS_TLS_HANDSHAKE_ERROR;
+            }
+        }
+        else
+        {
+            /* TLS Initialization failed. */
+            lRetVal = SOCKETS_TLS_INIT_ERROR;
+        }
+    }
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_Recv( Socket_t xSocket,
+                      void * pvBuffer,
+                      size_t xBufferLength,
+                      uint32_t ulFlags )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    int32_t lReceivedBytes = SOCKETS_SOCKET_ERROR;
+
+    /* Remove warning about unused parameters. */
+    ( void ) ulFlags;
+
+    /* Ensure that a valid socket was passed and the
+     * passed buffer is not NULL. */
+    if( ( prvIsValidSocket( ulSocketNumber ) == pdTRUE ) &&
+        ( pvBuffer != NULL ) )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        /* Check that receive is allowed on the socket. */
+        if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_READ_CLOSED_FLAG ) == 0UL )
+        {
+            if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_SECURE_FLAG ) != 0UL )
+            {
+                /* Receive through TLS pipe, if negotiated. */
+                lReceivedBytes = TLS_Recv( pxSecureSocket->pvTLSContext, pvBuffer, xBufferLength );
+
+                /* Convert the error code. */
+                if( lReceivedBytes < 0 )
+                {
+                    /* TLS_Recv failed. */
+                    lReceivedBytes = SOCKETS_TLS_RECV_ERROR;
+                }
+            }
+            else
+            {
+                /* Receive un-encrypted. */
+                lReceivedBytes = prvNetworkRecv( xSocket, pvBuffer, xBufferLength );
+            }
+        }
+        else
+        {
+            /* The socket has been closed for read. */
+            lReceivedBytes = SOCKETS_ECLOSED;
+        }
+    }
+
+    return lReceivedBytes;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_Send( Socket_t xSocket,
+                      const void * pvBuffer,
+                      size_t xDataLength,
+                      uint32_t ulFlags )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    int32_t lSentBytes = SOCKETS_SOCKET_ERROR;
+
+    /* Remove warning about unused parameters. */
+    ( void ) ulFlags;
+
+    /* Ensure that a valid socket was passed and the passed buffer
+     * is not NULL. */
+    if( ( prvIsValidSocket( ulSocketNumber ) == pdTRUE ) &&
+        ( pvBuffer != NULL ) )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        /* Check that send is allowed on the socket. */
+        if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG ) == 0UL )
+        {
+            if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_SECURE_FLAG ) != 0UL )
+            {
+                /* Send through TLS pipe, if negotiated. */
+                lSentBytes = TLS_Send( pxSecureSocket->pvTLSContext, pvBuffer, xDataLength );
+
+                /* Convert the error code. */
+                if( lSentBytes < 0 )
+                {
+                    /* TLS_Send failed. */
+                    lSentBytes = SOCKETS_TLS_SEND_ERROR;
+                }
+            }
+            else
+            {
+                /* Send un-encrypted. */
+                lSentBytes = prvNetworkSend( xSocket, pvBuffer, xDataLength );
+            }
+        }
+        else
+        {
+            /* The socket has been closed for write. */
+            lSentBytes = SOCKETS_ECLOSED;
+        }
+    }
+
+    return lSentBytes;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_Shutdown( Socket_t xSocket,
+                          uint32_t ulHow )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    int32_t lRetVal = SOCKETS_SOCKET_ERROR;
+
+    /* Ensure that a valid socket was passed. */
+    if( prvIsValidSocket( ulSocketNumber ) == pdTRUE )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        switch( ulHow )
+        {
+            case SOCKETS_SHUT_RD:
+                /* Further receive calls on this socket should return error. */
+                pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_READ_CLOSED_FLAG;
+                ( void ) shutdown( pxSecureSocket->iSocket, SHUT_RD );
+
+                /* Return success to the user. */
+                lRetVal = SOCKETS_ERROR_NONE;
+                break;
+
+            case SOCKETS_SHUT_WR:
+                /* Further send calls on this socket should return error. */
+                pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG;
+                ( void ) shutdown( pxSecureSocket->iSocket, SHUT_WR );
+
+                /* Return success to the user. */
+                lRetVal = SOCKETS_ERROR_NONE;
+                break;
+
+            case SOCKETS_SHUT_RDWR:
+                /* Further send or receive calls on this socket should return error. */
+                pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_READ_CLOSED_FLAG;
+                pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG;
+                ( void ) shutdown( pxSecureSocket->iSocket, SHUT_RDWR );
+
+                /* Return success to the user. */
+                lRetVal = SOCKETS_ERROR_NONE;
+                break;
+
+            default:
+                /* An invalid value was passed for ulHow. */
+                lRetVal = SOCKETS_EINVAL;
+                break;
+        }
+    }
+    else
+    {
+        /* Invalid socket was passed. */
+        lRetVal = SOCKETS_EINVAL;
+    }
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_Close( Socket_t xSocket )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    int32_t lRetVal;
+
+    /* Ensure that a valid socket was passed. */
+    if( prvIsValidSocket( ulSocketNumber ) == pdTRUE )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        /* Mark the socket as closed. */
+        pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_READ_CLOSED_FLAG;
+        pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG;
+
+        /* Free the buffers set through SOCKETS_SetSockOpt. */
+        prvFreeSocketOptions( pxSecureSocket );
+
+        /* Cleanup TLS. */
+        if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_SECURE_FLAG ) != 0UL )
+        {
+            TLS_Cleanup( pxSecureSocket->pvTLSContext );
+            pxSecureSocket->pvTLSContext = NULL;
+        }
+
+        /* Release the host descriptor. */
+        if( close( pxSecureSocket->iSocket ) == 0 )
+        {
+            /* Connection close successful. */
+            lRetVal = SOCKETS_ERROR_NONE;
+        }
+        else
+        {
+            /* Couldn't close the host descriptor. */
+            lRetVal = SOCKETS_SOCKET_ERROR;
+        }
+
+        pxSecureSocket->iSocket = -1;
+
+        /* Return the socket back to the free socket pool. */
+        prvReturnSocket( ulSocketNumber );
+    }
+    else
+    {
+        /* Bad argument. */
+        lRetVal = SOCKETS_EINVAL;
+    }
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
+int32_t SOCKETS_SetSockOpt( Socket_t xSocket,
+                            int32_t lLevel,
+                            int32_t lOptionName,
+                            const void * pvOptionValue,
+                            size_t xOptionLength )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) ( uintptr_t ) xSocket;
+    LinuxSecureSocket_t * pxSecureSocket;
+    int32_t lRetVal = SOCKETS_ERROR_NONE;
+    const char ** ppcAlpnIn;
+    size_t xLength;
+    uint32_t ulIndex;
+
+    /* Remove warning about unused parameters. */
+    ( void ) lLevel;
+
+    /* Ensure that a valid socket was passed. */
+    if( prvIsValidSocket( ulSocketNumber ) == pdTRUE )
+    {
+        /* Shortcut for easy access. */
+        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+
+        switch( lOptionName )
+        {
+            case SOCKETS_SO_SERVER_NAME_INDICATION:
+
+                if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) == 0 )
+                {
+                    /* Non-NULL destination string indicates that SNI extension should
+                     * be used during TLS negotiation. */
+                    pxSecureSocket->pcDestination = ( char * ) pvPortMalloc( 1U + xOptionLength );
+
+                    if( pxSecureSocket->pcDestination == NULL )
+                    {
+                        lRetVal = SOCKETS_ENOMEM;
+                    }
+                    else
+                    {
+                        memcpy( pxSecureSocket->pcDestination, pvOptionValue, xOptionLength );
+                        pxSecureSocket->pcDestination[ xOptionLength ] = '\0';
+                    }
+                }
+                else
+                {
+                    /* SNI must be set before connection is established. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+
+                break;
+
+            case SOCKETS_SO_TRUSTED_SERVER_CERTIFICATE:
+
+                if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) == 0 )
+                {
+                    /* Non-NULL server certificate field indicates that the default trust
+                     * list should not be used. */
+                    pxSecureSocket->pcServerCertificate = ( char * ) pvPortMalloc( xOptionLength );
+
+                    if( pxSecureSocket->pcServerCertificate == NULL )
+                    {
+                        lRetVal = SOCKETS_ENOMEM;
+                    }
+                    else
+                    {
+                        memcpy( pxSecureSocket->pcServerCertificate, pvOptionValue, xOptionLength );
+                        pxSecureSocket->ulServerCertificateLength = xOptionLength;
+                    }
+                }
+                else
+                {
+                    /* Trusted server certificate must be set before the connection is established. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+
+                break;
+
+            case SOCKETS_SO_ALPN_PROTOCOLS:
+
+                if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) == 0 )
+                {
+                    /* mbedTLS expects a NULL terminated list, so allocate
+                     * one extra slot for the terminator. */
+                    ppcAlpnIn = ( const char ** ) pvOptionValue;
+                    pxSecureSocket->ppcAlpnProtocols = ( char ** ) pvPortMalloc( ( 1U + xOptionLength ) * sizeof( char * ) );
+
+                    if( pxSecureSocket->ppcAlpnProtocols == NULL )
+                    {
+                        lRetVal = SOCKETS_ENOMEM;
+                    }
+                    else
+                    {
+                        memset( pxSecureSocket->ppcAlpnProtocols, 0, ( 1U + xOptionLength ) * sizeof( char * ) );
+                        pxSecureSocket->ulAlpnProtocolsCount = ( uint32_t ) xOptionLength;
+
+                        /* Copy each protocol string. */
+                        for( ulIndex = 0; ulIndex < ( uint32_t ) xOptionLength; ulIndex++ )
+                        {
+                            xLength = strlen( ppcAlpnIn[ ulIndex ] );
+                            pxSecureSocket->ppcAlpnProtocols[ ulIndex ] = ( char * ) pvPortMalloc( 1U + xLength );
+
+                            if( pxSecureSocket->ppcAlpnProtocols[ ulIndex ] == NULL )
+                            {
+                                lRetVal = SOCKETS_ENOMEM;
+                                break;
+                            }
+
+                            memcpy( pxSecureSocket->ppcAlpnProtocols[ ulIndex ], ppcAlpnIn[ ulIndex ], 1U + xLength );
+                        }
+                    }
+                }
+                else
+                {
+                    /* ALPN protocols must be set before the connection is established. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+
+                break;
+
+            case SOCKETS_SO_REQUIRE_TLS:
+
+                if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) == 0 )
+                {
+                    /* Mark that it is a secure socket. */
+                    pxSecureSocket->ulFlags |= linuxsecuresocketsSOCKET_SECURE_FLAG;
+                }
+                else
+                {
+                    /* Require TLS must be set before the connection is established. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+
+                break;
+
+            case SOCKETS_SO_SNDTIMEO:
+
+                /* Store send timeout. The option value is in milliseconds. */
+                pxSecureSocket->xSendTimeout = pdMS_TO_TICKS( *( ( const TickType_t * ) pvOptionValue ) );
+                break;
+
+            case SOCKETS_SO_RCVTIMEO:
+
+                /* Store receive timeout. The option value is in milliseconds. */
+                pxSecureSocket->xReceiveTimeout = pdMS_TO_TICKS( *( ( const TickType_t * ) pvOptionValue ) );
+                break;
+
+            case SOCKETS_SO_NONBLOCK:
+
+                if( ( pxSecureSocket->ulFlags & linuxsecuresocketsSOCKET_IS_CONNECTED_FLAG ) != 0 )
+                {
+                    /* The host descriptor is already non-blocking, so the
+                     * smallest timeout gives a single attempt per call. */
+                    pxSecureSocket->xReceiveTimeout = 1;
+                    pxSecureSocket->xSendTimeout = 1;
+                }
+                else
+                {
+                    /* Non blocking option must be set after the connection is
+                     * established. Non blocking connect is not supported. */
+                    lRetVal = SOCKETS_SOCKET_ERROR;
+                }
+
+                break;
+
+            default:
+
+                lRetVal = SOCKETS_ENOPROTOOPT;
+                break;
+        }
+    }
+    else
+    {
+        lRetVal = SOCKETS_SOCKET_ERROR;
+    }
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t SOCKETS_GetHostByName( const char * pcHostName )
+{
+    uint32_t ulIPAddres = 0;
+    struct addrinfo xHints = { 0 };
+    struct addrinfo * pxResult = NULL;
+
+    xHints.ai_family = AF_INET;
+    xHints.ai_socktype = SOCK_STREAM;
+
+    /* Do a DNS Lookup. The host resolver blocks, which is acceptable as
+     * this is only done once per connection. */
+    if( getaddrinfo( pcHostName, NULL, &( xHints ), &( pxResult ) ) == 0 )
+    {
+        /* Return the first address, in network byte order. */
+        ulIPAddres = ( ( struct sockaddr_in * ) pxResult->ai_addr )->sin_addr.s_addr;
+        freeaddrinfo( pxResult );
+    }
+
+    return ulIPAddres;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t SOCKETS_Init( void )
+{
+    uint32_t ulIndex;
+
+    /* Mark all the sockets as free and closed. */
+    for( ulIndex = 0; ulIndex < ( uint32_t ) socketsconfigMAX_SOCKETS; ulIndex++ )
+    {
+        xSockets[ ulIndex ].ucInUse = 0;
+        xSockets[ ulIndex ].iSocket = -1;
+        xSockets[ ulIndex ].ulFlags = 0;
+
+        xSockets[ ulIndex ].ulFlags |= linuxsecuresocketsSOCKET_READ_CLOSED_FLAG;
+        xSockets[ ulIndex ].ulFlags |= linuxsecuresocketsSOCKET_WRITE_CLOSED_FLAG;
+    }
+
+    return pdPASS;
+}
+/*-----------------------------------------------------------*/
@@ -103,6 +103,30 @@
  */
 #define stsecuresocketsONE_MILLISECOND             ( 1 )
 
+/**
+ * @brief Use the Cmd/Data ready interrupt of the Inventek module to wake
+ * a task blocked in receive.
+ *
+ * When enabled, the read timeout is handed to the module and the calling
+ * task sleeps in es_wifi_io.c until the module raises Cmd/Data ready,
+ * which happens as soon as data arrives or the module read times out.
+ * There is no fixed delay between empty polls, so inbound data is seen
+ * immediately.
+ */
+#ifndef wificonfigUSE_DATA_READY_NOTIFICATION
+    #define wificonfigUSE_DATA_READY_NOTIFICATION    ( 0 )
+#endif
+
+/**
+ * @brief The longest single read handed to the Inventek module in
+ * data ready notification mode.
+ *
+ * The WiFi semaphore is held for the whole module read, so longer receive
+ * timeouts are split into reads of this length to let other sockets use
+ * the module in between.
+ */
+#define stsecuresocketsMAX_MODULE_READ_TIME        ( 100 )
+
 /**
  * @brief The credential set to use for TLS on the Inventek module.
  *
@@ -409,6 +433,11 @@ static BaseType_t prvNetworkRecv( void * pvContext,
     BaseType_t xRetVal;
     ES_WIFI_Status_t xWiFiResult;
     TickType_t xTimeOnEntering = xTaskGetTickCount(), xSemaphoreWait;
+    uint32_t ulModuleReadTime = stsecuresocketsONE_MILLISECOND;
+
+    #if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+        TickType_t xElapsed;
+    #endif
 
     /* Shortcut for easy access. */
     pxSecureSocket = &( xSockets[ ulSocketNumber ] );
@@ -424,6 +453,28 @@ static BaseType_t prvNetworkRecv( void * pvContext,
 
     for( ; ; )
     {
+        #if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+            {
+                /* Let the module wait for the data, bounded by what is left
+                 * of the socket timeout. */
+                xElapsed = xTaskGetTickCount() - xTimeOnEntering;
+                ulModuleReadTime = stsecuresocketsMAX_MODULE_READ_TIME;
+
+                if( pxSecureSocket->ulReceiveTimeout != 0 )
+                {
+                    if( xElapsed >= pxSecureSocket->ulReceiveTimeout )
+                    {
+                        /* Only a final check for data is left. */
+                        ulModuleReadTime = stsecuresocketsONE_MILLISECOND;
+                    }
+                    else if( ( pxSecureSocket->ulReceiveTimeout - xElapsed ) < ulModuleReadTime )
+                    {
+                        ulModuleReadTime = pxSecureSocket->ulReceiveTimeout - xElapsed;
+                    }
+                }
+            }
+        #endif /* wificonfigUSE_DATA_READY_NOTIFICATION */
+
         /* Try to acquire the semaphore. */
         if( xSemaphoreTake( xWiFiModule.xSemaphoreHandle, xSemaphoreWait ) == pdTRUE )
         {
@@ -452,7 +503,7 @@ static BaseType_t prvNetworkRecv( void * pvContext,
                                                ( uint8_t * ) pucReceiveBuffer,
                                                ( uint16_t ) xReceiveBufferLength,
                                                &( usReceivedBytes ),
-                                               stsecuresocketsONE_MILLISECOND );
+                                               ulModuleReadTime );
 
             /* Return the semaphore. */
             ( void ) xSemaphoreGive( xWiFiModule.xSemaphoreHandle );
@@ -469,11 +520,18 @@ static BaseType_t prvNetworkRecv( void * pvContext,
                  * too? */
                 if( ( xTaskGetTickCount() - xTimeOnEntering ) < pxSecureSocket->ulReceiveTimeout )
                 {
-                    /* The socket has not timed out, but the driver supplied
-                     * with the board is polling, which would block other tasks, so
-                     * block for a short while to allow other tasks to run before
-                     * trying again. */
-                    vTaskDelay( stsecuresocketsFIVE_MILLISECONDS );
+                    #if ( wificonfigUSE_DATA_READY_NOTIFICATION == 1 )
+                        /* The module already waited, so read again straight
+                         * away.  Yield first so a task of equal priority that
+                         * is waiting for the semaphore gets its turn. */
+                        taskYIELD();
+                    #else
+                        /* The socket has not timed out, but the driver supplied
+                         * with the board is polling, which would block other tasks, so
+                         * block for a short while to allow other tasks to run before
+                         * trying again. */
+                        vTaskDelay( stsecuresocketsFIVE_MILLISECONDS );
+                    #endif
                 }
                 else
                 {
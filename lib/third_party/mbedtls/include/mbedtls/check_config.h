@@ -127,6 +127,11 @@
 #error "MBEDTLS_ECP_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECP_FIXED_BASE_TABLE) && ( !defined(MBEDTLS_ECP_C) || \
+    defined(MBEDTLS_ECP_ALT) )
+#error "MBEDTLS_ECP_FIXED_BASE_TABLE defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_ENTROPY_C) && (!defined(MBEDTLS_SHA512_C) &&      \
                                     !defined(MBEDTLS_SHA256_C))
 #error "MBEDTLS_ENTROPY_C defined, but not all prerequisites"
@@ -269,7 +269,7 @@
  *            digests and ciphers instead.
  *
  */
-//#define MBEDTLS_AES_ALT
+#define MBEDTLS_AES_ALT
 //#define MBEDTLS_ARC4_ALT
 //#define MBEDTLS_BLOWFISH_ALT
 //#define MBEDTLS_CAMELLIA_ALT
@@ -278,14 +278,14 @@
 //#define MBEDTLS_DES_ALT
 //#define MBEDTLS_DHM_ALT
 //#define MBEDTLS_ECJPAKE_ALT
-//#define MBEDTLS_GCM_ALT
+#define MBEDTLS_GCM_ALT
 //#define MBEDTLS_MD2_ALT
 //#define MBEDTLS_MD4_ALT
 //#define MBEDTLS_MD5_ALT
 //#define MBEDTLS_RIPEMD160_ALT
 //#define MBEDTLS_RSA_ALT
 //#define MBEDTLS_SHA1_ALT
-//#define MBEDTLS_SHA256_ALT
+#define MBEDTLS_SHA256_ALT
 //#define MBEDTLS_SHA512_ALT
 //#define MBEDTLS_XTEA_ALT
 /*
@@ -622,6 +622,24 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_FIXED_BASE_TABLE
+ *
+ * Multiply the generator with a comb table that was computed offline,
+ * rather than one computed by the first multiplication on each group.
+ * The table is looked up through mbedtls_ecp_fixed_base_table(), which the
+ * application provides, see ecp_internal.h.  A group without a table falls
+ * back to the run time table.
+ *
+ * Every entry of the table is still read on each step, so the
+ * multiplication stays constant time.
+ *
+ * Requires: MBEDTLS_ECP_C
+ *
+ * Comment this macro to always compute the comb table at run time.
+ */
+#define MBEDTLS_ECP_FIXED_BASE_TABLE
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -1414,7 +1432,7 @@
  *
  * Comment this macro to disable support for SSL session tickets
  */
-//#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_SESSION_TICKETS
 
 /**
  * \def MBEDTLS_SSL_EXPORT_KEYS
@@ -2799,6 +2817,8 @@
 
 /* SSL options */
 #define MBEDTLS_SSL_MAX_CONTENT_LEN             8192 /**< Maxium fragment length in bytes, determines the size of each of the two internal I/O buffers */
+#define MBEDTLS_SSL_IN_CONTENT_LEN              8192 /**< Size of the incoming record buffer, must hold the largest record the server sends */
+#define MBEDTLS_SSL_OUT_CONTENT_LEN             4096 /**< Size of the outgoing record buffer, must hold the whole client Certificate message */
 //#define MBEDTLS_SSL_DEFAULT_TICKET_LIFETIME     86400 /**< Lifetime of session tickets (if enabled) */
 //#define MBEDTLS_PSK_MAX_LEN               32 /**< Max size of TLS pre-shared keys, in bytes (default 256 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
@@ -289,5 +289,30 @@ int mbedtls_internal_ecp_normalize_mxz( const mbedtls_ecp_group *grp,
 
 #endif /* MBEDTLS_ECP_INTERNAL_ALT */
 
+#if defined(MBEDTLS_ECP_FIXED_BASE_TABLE)
+
+/**
+ * \brief           Look up a precomputed comb table for the generator.
+ *
+ *                  The table holds the 2^(w-1) points
+ *                  T[i] = i_{w-1} 2^{(w-1)d} G + ... + i_1 2^d G + G,
+ *                  with d = ceil( nbits / w ), in affine coordinates, which
+ *                  is the layout ecp_precompute_comb() builds in RAM.
+ *                  The table is only read, so it can live in flash.
+ *
+ * \param grp       The group whose generator is being multiplied.
+ * \param T         On success, receives the table.
+ * \param w         On success, receives the comb width, between 2 and 7.
+ *
+ * \return          0 if a table exists for \p grp, or
+ *                  #MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE to fall back to
+ *                  computing the table at run time.
+ */
+int mbedtls_ecp_fixed_base_table( const mbedtls_ecp_group *grp,
+                                  const mbedtls_ecp_point **T,
+                                  unsigned char *w );
+
+#endif /* MBEDTLS_ECP_FIXED_BASE_TABLE */
+
 #endif /* ecp_internal.h */
 
@@ -1356,6 +1356,7 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     size_t d;
     unsigned char k[COMB_MAX_D + 1];
     mbedtls_ecp_point *T;
+    const mbedtls_ecp_point *T_fixed = NULL;
     mbedtls_mpi M, mm;
 
     mbedtls_mpi_init( &M );
@@ -1377,14 +1378,16 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
      * Just adding one avoids upping the cost of the first mul too much,
      * and the memory cost too.
      */
-#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
+#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1 || defined(MBEDTLS_ECP_FIXED_BASE_TABLE)
     p_eq_g = ( mbedtls_mpi_cmp_mpi( &P->Y, &grp->G.Y ) == 0 &&
                mbedtls_mpi_cmp_mpi( &P->X, &grp->G.X ) == 0 );
-    if( p_eq_g )
-        w++;
 #else
     p_eq_g = 0;
 #endif
+#if MBEDTLS_ECP_FIXED_POINT_OPTIM == 1
+    if( p_eq_g )
+        w++;
+#endif
 
     /*
      * Make sure w is within bounds.
@@ -1395,6 +1398,16 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     if( w >= grp->nbits )
         w = 2;
 
+#if defined(MBEDTLS_ECP_FIXED_BASE_TABLE)
+    /*
+     * If P == G and a table was computed offline, use it as is: it costs
+     * neither RAM nor precomputation, and it fixes w. MBEDTLS_ECP_WINDOW_SIZE
+     * only bounds the size of the tables computed here, so it does not apply.
+     */
+    if( p_eq_g && mbedtls_ecp_fixed_base_table( grp, &T_fixed, &w ) != 0 )
+        T_fixed = NULL;
+#endif
+
     /* Other sizes that depend on w */
     pre_len = 1U << ( w - 1 );
     d = ( grp->nbits + w - 1 ) / w;
@@ -1405,6 +1418,9 @@ static int ecp_mul_comb( mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
      */
     T = p_eq_g ? grp->T : NULL;
 
+    if( T_fixed != NULL )
+        T = (mbedtls_ecp_point *) T_fixed;
+
     if( T == NULL )
     {
         T = mbedtls_calloc( pre_len, sizeof( mbedtls_ecp_point ) );
@@ -1449,9 +1465,9 @@ cleanup:
     /* There are two cases where T is not stored in grp:
      * - P != G
      * - An intermediate operation failed before setting grp->T
-     * In either case, T must be freed.
+     * In either case, T must be freed, unless it is the offline table.
      */
-    if( T != NULL && T != grp->T )
+    if( T != NULL && T != grp->T && T != T_fixed )
     {
         for( i = 0; i < pre_len; i++ )
             mbedtls_ecp_point_free( &T[i] );
@@ -836,6 +836,91 @@ static ES_WIFI_Status_t AT_RequestReceiveData(ES_WIFIObject_t *Obj, uint8_t* cmd
 }
 
 
+/**
+  * @brief  Forget the cached S2/R1/R2 values of the selected socket.
+  * @param  Obj: pointer to module handle
+  * @retval None.
+  */
+static void AT_InvalidateSocketParams(ES_WIFIObject_t *Obj)
+{
+  Obj->CmdCache.SendTimeout = ES_WIFI_CACHE_INVALID;
+  Obj->CmdCache.RecvLen = ES_WIFI_CACHE_INVALID;
+  Obj->CmdCache.RecvTimeout = ES_WIFI_CACHE_INVALID;
+}
+
+/**
+  * @brief  Forget all cached socket state, the next command re-sends P0.
+  * @param  Obj: pointer to module handle
+  * @retval None.
+  */
+static void AT_InvalidateCache(ES_WIFIObject_t *Obj)
+{
+  Obj->CmdCache.Socket = ES_WIFI_CACHE_INVALID;
+  AT_InvalidateSocketParams(Obj);
+}
+
+/**
+  * @brief  Select the socket the following commands apply to (P0).
+  * @param  Obj: pointer to module handle
+  * @param  Socket: number of the socket
+  * @retval Operation Status.
+  */
+static ES_WIFI_Status_t AT_SelectSocket(ES_WIFIObject_t *Obj, uint8_t Socket)
+{
+  ES_WIFI_Status_t ret;
+
+#if (ES_WIFI_USE_CMD_CACHE == 1)
+  if (Obj->CmdCache.Socket == Socket)
+  {
+    return ES_WIFI_STATUS_OK;
+  }
+#endif
+
+  /* The S2/R1/R2 values last sent belong to the previous socket. */
+  AT_InvalidateCache(Obj);
+
+  sprintf((char*)Obj->CmdData,"P0=%d\r", Socket);
+  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  if (ret == ES_WIFI_STATUS_OK)
+  {
+    Obj->CmdCache.Socket = Socket;
+  }
+  return ret;
+}
+
+/**
+  * @brief  Set a parameter of the selected socket unless it already has that value.
+  * @param  Obj: pointer to module handle
+  * @param  cmd: command name, "S2", "R1" or "R2"
+  * @param  cached: pointer to the cached value of the parameter
+  * @param  value: value to set
+  * @retval Operation Status.
+  */
+static ES_WIFI_Status_t AT_SetSocketParam(ES_WIFIObject_t *Obj, const char *cmd, uint32_t *cached, uint32_t value)
+{
+  ES_WIFI_Status_t ret;
+
+#if (ES_WIFI_USE_CMD_CACHE == 1)
+  if (*cached == value)
+  {
+    return ES_WIFI_STATUS_OK;
+  }
+#endif
+
+  sprintf((char*)Obj->CmdData,"%s=%lu\r", cmd, (unsigned long)value);
+  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  if (ret == ES_WIFI_STATUS_OK)
+  {
+    *cached = value;
+  }
+  else
+  {
+    /* The module state is unknown after a failed command. */
+    AT_InvalidateCache(Obj);
+  }
+  return ret;
+}
+
 /**
   * @brief  Initialize WIFI module.
   * @param  Obj: pointer to module handle
@@ -848,6 +933,7 @@ ES_WIFI_Status_t  ES_WIFI_Init(ES_WIFIObject_t *Obj)
   LOCK_WIFI();  
 
   Obj->Timeout = ES_WIFI_TIMEOUT;
+  AT_InvalidateCache(Obj);
 
   if (Obj->fops.IO_Init(ES_WIFI_INIT) == 0)
   {
@@ -1340,6 +1426,7 @@ ES_WIFI_Status_t ES_WIFI_ResetToFactoryDefault(ES_WIFIObject_t *Obj)
 {
   ES_WIFI_Status_t ret ;
   LOCK_WIFI();
+  AT_InvalidateCache(Obj);
   sprintf((char*)Obj->CmdData,"Z0\r");
   ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
   UNLOCK_WIFI();
@@ -1356,6 +1443,7 @@ ES_WIFI_Status_t ES_WIFI_ResetModule(ES_WIFIObject_t *Obj)
   int ret;
   LOCK_WIFI();  
 
+  AT_InvalidateCache(Obj);
   sprintf((char*)Obj->CmdData,"ZR\r");
   ret = Obj->fops.IO_Send(Obj->CmdData, strlen((char*)Obj->CmdData), Obj->Timeout);
 #if (ES_WIFI_USE_UART == 0)
@@ -1379,6 +1467,7 @@ ES_WIFI_Status_t ES_WIFI_HardResetModule(ES_WIFIObject_t *Obj)
 {
   int ret;
   LOCK_WIFI();  
+  AT_InvalidateCache(Obj);
   ret = Obj->fops.IO_Init(ES_WIFI_RESET);
   UNLOCK_WIFI();
   return (ret > 0) ? ES_WIFI_STATUS_OK : ES_WIFI_STATUS_ERROR;
@@ -1568,8 +1657,9 @@ ES_WIFI_Status_t ES_WIFI_StartClientConnection(ES_WIFIObject_t *Obj, ES_WIFI_Con
   
   LOCK_WIFI();  
 
-  sprintf((char*)Obj->CmdData,"P0=%d\r", conn->Number);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, conn->Number);
+  /* Opening or closing a connection may reset the socket parameters. */
+  AT_InvalidateSocketParams(Obj);
 
   if (ret == ES_WIFI_STATUS_OK)
   {
@@ -1623,8 +1713,8 @@ ES_WIFI_Status_t ES_WIFI_StopClientConnection(ES_WIFIObject_t *Obj, ES_WIFI_Conn
   ES_WIFI_Status_t ret;
   LOCK_WIFI();  
 
-  sprintf((char*)Obj->CmdData,"P0=%d\r", conn->Number);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, conn->Number);
+  AT_InvalidateSocketParams(Obj);
 
   if (ret == ES_WIFI_STATUS_OK)
   {
@@ -1648,8 +1738,8 @@ ES_WIFI_Status_t ES_WIFI_StartAWSClientConnection(ES_WIFIObject_t *Obj, ES_WIFI_
   ES_WIFI_Status_t ret;
   LOCK_WIFI();  
 
-  sprintf((char*)Obj->CmdData,"P0=%d\r", conn->Number);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, conn->Number);
+  AT_InvalidateSocketParams(Obj);
 
   if(ret == ES_WIFI_STATUS_OK)
   {
@@ -1711,8 +1801,8 @@ ES_WIFI_Status_t ES_WIFI_StartServerSingleConn(ES_WIFIObject_t *Obj, ES_WIFI_Con
   ES_WIFI_Status_t ret = ES_WIFI_STATUS_OK;
   LOCK_WIFI();  
     
-  sprintf((char*)Obj->CmdData,"P0=%d\r", conn->Number);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, conn->Number);
+  AT_InvalidateSocketParams(Obj);
   if(ret != ES_WIFI_STATUS_OK)
   {
     UNLOCK_WIFI();
@@ -1864,8 +1954,8 @@ ES_WIFI_Status_t ES_WIFI_CloseServerConnection(ES_WIFIObject_t *Obj, int socket)
 {
   ES_WIFI_Status_t ret;
   LOCK_WIFI();  
-  sprintf((char*)Obj->CmdData,"P0=%d\r", socket);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, socket);
+  AT_InvalidateSocketParams(Obj);
   if(ret != ES_WIFI_STATUS_OK)
   {
     DEBUG(" Can not select socket %s\n", Obj->CmdData);
@@ -1895,8 +1985,8 @@ ES_WIFI_Status_t ES_WIFI_StopServerSingleConn(ES_WIFIObject_t *Obj, int socket)
 {
   ES_WIFI_Status_t ret;
   LOCK_WIFI();  
-  sprintf((char*)Obj->CmdData,"P0=%d\r", socket);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, socket);
+  AT_InvalidateSocketParams(Obj);
   if(ret != ES_WIFI_STATUS_OK)
   {
     DEBUG("Selecting socket failed: %s\n", Obj->CmdData);
@@ -1933,8 +2023,8 @@ ES_WIFI_Status_t ES_WIFI_StartServerMultiConn(ES_WIFIObject_t *Obj, ES_WIFI_Conn
   ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
   if(ret == ES_WIFI_STATUS_OK)
   {
-    sprintf((char*)Obj->CmdData,"P0=%d\r", conn->Number);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SelectSocket(Obj, conn->Number);
+    AT_InvalidateSocketParams(Obj);
     if(ret == ES_WIFI_STATUS_OK)
     {
       sprintf((char*)Obj->CmdData,"P1=%d\r", conn->Type);
@@ -2052,12 +2142,10 @@ ES_WIFI_Status_t ES_WIFI_SendData(ES_WIFIObject_t *Obj, uint8_t Socket, uint8_t
   if(Reqlen >= ES_WIFI_PAYLOAD_SIZE ) Reqlen= ES_WIFI_PAYLOAD_SIZE;
 
   *SentLen = Reqlen;
-  sprintf((char*)Obj->CmdData,"P0=%d\r", Socket);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, Socket);
   if(ret == ES_WIFI_STATUS_OK)
   {
-    sprintf((char*)Obj->CmdData,"S2=%lu\r",Timeout);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SetSocketParam(Obj, "S2", &Obj->CmdCache.SendTimeout, Timeout);
 
     if(ret == ES_WIFI_STATUS_OK)
     {
@@ -2091,6 +2179,10 @@ ES_WIFI_Status_t ES_WIFI_SendData(ES_WIFIObject_t *Obj, uint8_t Socket, uint8_t
   {
     *SentLen = 0;
   }
+  if (ret != ES_WIFI_STATUS_OK)
+  {
+    AT_InvalidateCache(Obj);
+  }
   UNLOCK_WIFI();
   return ret;
 }
@@ -2100,8 +2192,7 @@ ES_WIFI_Status_t  ES_WIFI_SendDataTo(ES_WIFIObject_t *Obj, uint8_t Socket, uint8
   ES_WIFI_Status_t ret = ES_WIFI_STATUS_ERROR;
   LOCK_WIFI();  
 
-  sprintf((char*)Obj->CmdData,"P0=%d\r", Socket);
-  ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+  ret = AT_SelectSocket(Obj, Socket);
 
   if (ret == ES_WIFI_STATUS_OK)
   {
@@ -2132,8 +2223,7 @@ ES_WIFI_Status_t  ES_WIFI_SendDataTo(ES_WIFIObject_t *Obj, uint8_t Socket, uint8
 
   if(ret == ES_WIFI_STATUS_OK)
   {
-    sprintf((char*)Obj->CmdData, "S2=%lu\r", Timeout);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SetSocketParam(Obj, "S2", &Obj->CmdCache.SendTimeout, Timeout);
   }
 
   if(ret == ES_WIFI_STATUS_OK)
@@ -2166,6 +2256,7 @@ ES_WIFI_Status_t  ES_WIFI_SendDataTo(ES_WIFIObject_t *Obj, uint8_t Socket, uint8
   {
     DEBUG("Send error:\n%s\n", Obj->CmdData);
     *SentLen = 0;
+    AT_InvalidateCache(Obj);
   }
 
   UNLOCK_WIFI();
@@ -2188,17 +2279,14 @@ ES_WIFI_Status_t ES_WIFI_ReceiveData(ES_WIFIObject_t *Obj, uint8_t Socket, uint8
 
   if(Reqlen <= ES_WIFI_PAYLOAD_SIZE )
   {
-    sprintf((char*)Obj->CmdData,"P0=%d\r", Socket);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SelectSocket(Obj, Socket);
 
     if(ret == ES_WIFI_STATUS_OK)
     {
-      sprintf((char*)Obj->CmdData,"R1=%d\r", Reqlen);
-      ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+      ret = AT_SetSocketParam(Obj, "R1", &Obj->CmdCache.RecvLen, Reqlen);
       if(ret == ES_WIFI_STATUS_OK)
       {
-        sprintf((char*)Obj->CmdData,"R2=%lu\r", Timeout);
-        ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+        ret = AT_SetSocketParam(Obj, "R2", &Obj->CmdCache.RecvTimeout, Timeout);
         if(ret == ES_WIFI_STATUS_OK)
         {
           sprintf((char*)Obj->CmdData,"R0\r");
@@ -2225,6 +2313,10 @@ ES_WIFI_Status_t ES_WIFI_ReceiveData(ES_WIFIObject_t *Obj, uint8_t Socket, uint8
       issue15++;
     }
   }
+  if (ret != ES_WIFI_STATUS_OK)
+  {
+    AT_InvalidateCache(Obj);
+  }
   UNLOCK_WIFI();
   return ret;
 }
@@ -2238,14 +2330,12 @@ ES_WIFI_Status_t  ES_WIFI_ReceiveDataFrom(ES_WIFIObject_t *Obj, uint8_t Socket,
 
   if (Reqlen <= ES_WIFI_PAYLOAD_SIZE )
   {
-    sprintf((char*)Obj->CmdData, "P0=%d\r", Socket);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SelectSocket(Obj, Socket);
   }
 
   if(ret == ES_WIFI_STATUS_OK)
   {
-    sprintf((char*)Obj->CmdData,"R1=%d\r", Reqlen);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SetSocketParam(Obj, "R1", &Obj->CmdCache.RecvLen, Reqlen);
   }
   else
   {
@@ -2254,8 +2344,7 @@ ES_WIFI_Status_t  ES_WIFI_ReceiveDataFrom(ES_WIFIObject_t *Obj, uint8_t Socket,
 
   if(ret == ES_WIFI_STATUS_OK)
   {
-    sprintf((char*)Obj->CmdData,"R2=%lu\r", Timeout);
-    ret = AT_ExecuteCommand(Obj, Obj->CmdData, Obj->CmdData);
+    ret = AT_SetSocketParam(Obj, "R2", &Obj->CmdCache.RecvTimeout, Timeout);
   }
   else
   {
@@ -2303,6 +2392,7 @@ ES_WIFI_Status_t  ES_WIFI_ReceiveDataFrom(ES_WIFIObject_t *Obj, uint8_t Socket,
   {
     DEBUG("Read error:\n%s\n", Obj->CmdData);
     *Receivedlen = 0;
+    AT_InvalidateCache(Obj);
   }
   UNLOCK_WIFI();
   return ret;
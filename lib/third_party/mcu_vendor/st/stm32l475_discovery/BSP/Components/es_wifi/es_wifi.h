@@ -58,6 +58,15 @@
 
 /* Exported Constants --------------------------------------------------------*/
 #define ES_WIFI_PAYLOAD_SIZE     1200
+
+/* Remember the socket selected with P0 and the last S2/R1/R2 values so that
+   repeated send/receive calls on the same socket skip the matching AT
+   round-trips. */
+#ifndef ES_WIFI_USE_CMD_CACHE
+#define ES_WIFI_USE_CMD_CACHE    1
+#endif
+
+#define ES_WIFI_CACHE_INVALID    0xFFFFFFFFU
 /* Exported macro-------------------------------------------------------------*/
 #define MIN(a, b)  ((a) < (b) ? (a) : (b))
 
@@ -245,6 +254,13 @@ typedef struct {
   uint8_t            Backlog;
 } ES_WIFI_Conn_t;
 
+typedef struct {
+  uint32_t           Socket;       /* Socket selected by the last P0 command */
+  uint32_t           SendTimeout;  /* Last S2 value sent for that socket */
+  uint32_t           RecvLen;      /* Last R1 value sent for that socket */
+  uint32_t           RecvTimeout;  /* Last R2 value sent for that socket */
+} ES_WIFI_CmdCache_t;
+
 typedef struct {
   IO_Init_Func       IO_Init;
   IO_DeInit_Func     IO_DeInit;
@@ -268,6 +284,7 @@ typedef struct {
   uint8_t            CmdData[ES_WIFI_DATA_SIZE];
   uint32_t           Timeout;
   uint32_t           BufferSize;  
+  ES_WIFI_CmdCache_t CmdCache;
 } ES_WIFIObject_t;
 
 
@@ -31,6 +31,7 @@
 #include "aws_pkcs11.h"
 #include "aws_pkcs11_config.h"
 #include "task.h"
+#include "semphr.h"
 #include "aws_clientcredential.h"
 #include "aws_default_root_certificates.h"
 
@@ -52,6 +53,90 @@
 #include <time.h>
 #include <stdio.h>
 
+/**
+ * @brief Keep the parsed default root certificates once no connection uses them.
+ *
+ * When 1, the default CA chain is parsed by the first TLS_Connect() and then
+ * shared by every later handshake, so reconnecting does not parse the PEM
+ * certificates again.  When 0, the chain is freed as soon as the last
+ * handshake using it completes, which saves heap between connections.
+ */
+#ifndef tlsconfigKEEP_DEFAULT_ROOT_CERTIFICATES
+    #define tlsconfigKEEP_DEFAULT_ROOT_CERTIFICATES    ( 1 )
+#endif
+
+/**
+ * @brief Parse the default root certificates from their DER encoding.
+ *
+ * The DER arrays in aws_default_root_certificates.h hold the same
+ * certificates as the PEM strings and avoid the base64 decode.  Leave this at
+ * 0 if the PEM strings are replaced without regenerating the DER arrays.
+ */
+#ifndef tlsconfigUSE_DER_ROOT_CERTIFICATES
+    #define tlsconfigUSE_DER_ROOT_CERTIFICATES    ( 0 )
+#endif
+
+/**
+ * @brief Number of TLS sessions kept for resumption.
+ *
+ * After a full handshake the session, and the session ticket if the server
+ * sent one, is kept per server.  The next TLS_Connect() to that server offers
+ * it so the server can resume it with an abbreviated handshake that skips
+ * the key exchange and the client certificate signature.  Each entry holds a
+ * copy of the server certificate, so budget a little over 1 KB of heap per
+ * entry in use.  Set to 0 to always do full handshakes.
+ */
+#ifndef tlsconfigSESSION_CACHE_SIZE
+    #define tlsconfigSESSION_CACHE_SIZE    ( 1 )
+#endif
+
+/**
+ * @brief Largest record the server should send, unless TLS_Init() is given
+ * another value.
+ *
+ * When not 0, the client asks the server to send records of at most this many
+ * bytes with the max_fragment_length extension, and sends no larger records
+ * itself.  One of 512, 1024, 2048 or 4096, and no more than
+ * MBEDTLS_SSL_OUT_CONTENT_LEN.  A server which accepts the extension can then
+ * be used with MBEDTLS_SSL_IN_CONTENT_LEN reduced to the same value, saving
+ * heap for every connection.  Servers which ignore the extension still send
+ * records of up to 16 KB, so leave MBEDTLS_SSL_IN_CONTENT_LEN alone for them.
+ */
+#ifndef tlsconfigMAX_FRAGMENT_LENGTH
+    #define tlsconfigMAX_FRAGMENT_LENGTH    ( 0 )
+#endif
+
+/**
+ * @brief Keep the parsed device credentials once no connection uses them.
+ *
+ * When 1, the client certificate is read from PKCS#11 and parsed by the first
+ * TLS_Connect() and then shared by every later handshake, together with the
+ * handle and type of the private key.  Call TLS_ClearClientCredential() after
+ * provisioning new credentials.  When 0, the credentials are freed as soon as
+ * the last handshake using them completes, which saves heap between
+ * connections.
+ */
+#ifndef tlsconfigKEEP_CLIENT_CREDENTIAL
+    #define tlsconfigKEEP_CLIENT_CREDENTIAL    ( 1 )
+#endif
+
+/**
+ * @brief Device credentials read from PKCS#11.
+ *
+ * @param[in] xCertificateChain The client certificate, followed by the JITR
+ * issuer certificate if there is one.
+ * @param[in] xKeyAlgo Type of the private key.
+ * @param[in] xPrivateKey PKCS#11 handle of the private key.
+ * @param[in] uxUsers Number of handshakes using the credentials.
+ */
+typedef struct TLSClientCredential
+{
+    mbedtls_x509_crt xCertificateChain;
+    mbedtls_pk_type_t xKeyAlgo;
+    CK_OBJECT_HANDLE xPrivateKey;
+    UBaseType_t uxUsers;
+} TLSClientCredential_t;
+
 /**
  * @brief Internal context structure.
  *
@@ -65,7 +150,15 @@
  * @param[out] xMbedSslCtx Connection context for mbedTLS.
  * @param[out] xMbedSslConfig Configuration context for mbedTLS.
  * @param[out] xMbedX509CA Server certificate context for mbedTLS.
- * @param[out] xMbedX509Cli Client certificate context for mbedTLS.
+ * @param[out] pxMbedX509CAChain CA chain used for the handshake, either
+ * xMbedX509CA or the shared default chain.
+ * @param[out] xUsesDefaultCAChain Indicates whether a reference to the shared
+ * default chain is held.
+ * @param[out] pxClientCredential Device credentials used for the handshake.
+ * @param[out] ulSessionCacheKey Key of the session cache entry for this
+ * destination.
+ * @param[in] ulMaxFragmentLength Largest record the server should send, 0 to
+ * not negotiate the max_fragment_length extension.
  * @param[out] mbedPkAltCtx RSA crypto implementation context for mbedTLS.
  * @param[out] xP11FunctionList PKCS#11 function list structure.
  * @param[out] xP11Session PKCS#11 session context.
@@ -88,9 +181,13 @@ typedef struct TLSContext
     mbedtls_ssl_context xMbedSslCtx;
     mbedtls_ssl_config xMbedSslConfig;
     mbedtls_x509_crt xMbedX509CA;
-    mbedtls_x509_crt xMbedX509Cli;
+    mbedtls_x509_crt * pxMbedX509CAChain;
+    BaseType_t xUsesDefaultCAChain;
+    TLSClientCredential_t * pxClientCredential;
     mbedtls_pk_context xMbedPkCtx;
     mbedtls_pk_info_t xMbedPkInfo;
+    uint32_t ulSessionCacheKey;
+    uint32_t ulMaxFragmentLength;
 
     /* PKCS#11. */
     CK_FUNCTION_LIST_PTR xP11FunctionList;
@@ -98,6 +195,83 @@ typedef struct TLSContext
     CK_OBJECT_HANDLE xP11PrivateKey;
 } TLSContext_t;
 
+/**
+ * @brief A root certificate trusted when the caller does not provide one.
+ */
+typedef struct TLSRootCertificate
+{
+    const unsigned char * pucCertificate;
+    size_t xLength;
+} TLSRootCertificate_t;
+
+/**
+ * @brief Root certificates making up the default CA chain.
+ *
+ * Lengths use sizeof on the arrays, because the tls*_LENGTH objects are not
+ * constant expressions and cannot appear in a static initializer.
+ */
+static const TLSRootCertificate_t xDefaultRootCertificates[] =
+{
+#if ( tlsconfigUSE_DER_ROOT_CERTIFICATES == 1 )
+    { tlsVERISIGN_ROOT_CERTIFICATE_DER,  sizeof( tlsVERISIGN_ROOT_CERTIFICATE_DER )  },
+    { tlsATS1_ROOT_CERTIFICATE_DER,      sizeof( tlsATS1_ROOT_CERTIFICATE_DER )      },
+    { tlsSTARFIELD_ROOT_CERTIFICATE_DER, sizeof( tlsSTARFIELD_ROOT_CERTIFICATE_DER ) }
+#else
+    { ( const unsigned char * ) tlsVERISIGN_ROOT_CERTIFICATE_PEM,  sizeof( tlsVERISIGN_ROOT_CERTIFICATE_PEM )  },
+    { ( const unsigned char * ) tlsATS1_ROOT_CERTIFICATE_PEM,      sizeof( tlsATS1_ROOT_CERTIFICATE_PEM )      },
+    { ( const unsigned char * ) tlsSTARFIELD_ROOT_CERTIFICATE_PEM, sizeof( tlsSTARFIELD_ROOT_CERTIFICATE_PEM ) }
+#endif
+};
+
+/**
+ * @brief Default CA chain shared by all TLS contexts.
+ *
+ * Only read by mbedTLS during a handshake, so concurrent handshakes can use
+ * it at the same time.  Parsing, freeing and the reference count are guarded
+ * by xTLSSharedMutex.
+ */
+static mbedtls_x509_crt xDefaultCAChain;
+static BaseType_t xDefaultCAChainParsed = pdFALSE;
+static UBaseType_t uxDefaultCAChainUsers = 0;
+
+#if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+
+/**
+ * @brief A session saved after a full handshake, for resuming later.
+ *
+ * @param[in] ulKey Hash of the destination and trusted server certificate.
+ * @param[in] xLastUsed Tick count of the last save or resume, for eviction.
+ * @param[in] xValid Indicates whether xSession holds a session.
+ * @param[in] xSession The session, including its ticket if the server
+ * issued one.
+ */
+    typedef struct TLSSessionCacheEntry
+    {
+        uint32_t ulKey;
+        TickType_t xLastUsed;
+        BaseType_t xValid;
+        mbedtls_ssl_session xSession;
+    } TLSSessionCacheEntry_t;
+
+/**
+ * @brief Sessions shared by all TLS contexts, guarded by xTLSSharedMutex.
+ */
+    static TLSSessionCacheEntry_t xSessionCache[ tlsconfigSESSION_CACHE_SIZE ];
+#endif /* if ( tlsconfigSESSION_CACHE_SIZE > 0 ) */
+
+/**
+ * @brief Device credentials given to new handshakes, guarded by
+ * xTLSSharedMutex.
+ *
+ * Credentials which are replaced while a handshake uses them are freed by the
+ * last handshake to release them.
+ */
+static TLSClientCredential_t * pxCurrentClientCredential = NULL;
+
+/**
+ * @brief Guards the state shared between TLS contexts.
+ */
+static SemaphoreHandle_t xTLSSharedMutex = NULL;
 
 #define TLS_PRINT( X )    vLoggingPrintf X
 
@@ -130,6 +304,301 @@ static void prvFreeContext( TLSContext_t * pxCtx )
     }
 }
 
+/**
+ * @brief Lock the state shared between TLS contexts, creating the mutex on
+ * first use.
+ *
+ * @return pdTRUE if the lock was taken, pdFALSE if the mutex could not be
+ * created.
+ */
+static BaseType_t prvLockSharedState( void )
+{
+    BaseType_t xResult = pdFALSE;
+
+    /* The scheduler is suspended so that two tasks connecting at the same
+     * time do not both create the mutex. */
+    if( NULL == xTLSSharedMutex )
+    {
+        vTaskSuspendAll();
+        {
+            if( NULL == xTLSSharedMutex )
+            {
+                xTLSSharedMutex = xSemaphoreCreateMutex();
+            }
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+    if( NULL != xTLSSharedMutex )
+    {
+        xResult = xSemaphoreTake( xTLSSharedMutex, portMAX_DELAY );
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Unlock the state locked by prvLockSharedState().
+ */
+static void prvUnlockSharedState( void )
+{
+    ( void ) xSemaphoreGive( xTLSSharedMutex );
+}
+
+/**
+ * @brief Take a reference to the default CA chain, parsing it if needed.
+ *
+ * @param[out] ppxCAChain Set to the shared chain on success.
+ *
+ * @return Zero on success.
+ */
+static BaseType_t prvAcquireDefaultCAChain( mbedtls_x509_crt ** ppxCAChain )
+{
+    BaseType_t xResult = 0;
+    size_t xIndex;
+
+    if( pdFALSE == prvLockSharedState() )
+    {
+        xResult = MBEDTLS_ERR_X509_ALLOC_FAILED;
+    }
+    else
+    {
+        if( pdFALSE == xDefaultCAChainParsed )
+        {
+            mbedtls_x509_crt_init( &xDefaultCAChain );
+
+            for( xIndex = 0;
+                 ( 0 == xResult ) && ( xIndex < ( sizeof( xDefaultRootCertificates ) / sizeof( xDefaultRootCertificates[ 0 ] ) ) );
+                 xIndex++ )
+            {
+                xResult = mbedtls_x509_crt_parse( &xDefaultCAChain,
+                                                  xDefaultRootCertificates[ xIndex ].pucCertificate,
+                                                  xDefaultRootCertificates[ xIndex ].xLength );
+            }
+
+            if( 0 == xResult )
+            {
+                xDefaultCAChainParsed = pdTRUE;
+            }
+            else
+            {
+                mbedtls_x509_crt_free( &xDefaultCAChain );
+            }
+        }
+
+        if( 0 == xResult )
+        {
+            uxDefaultCAChainUsers++;
+            *ppxCAChain = &xDefaultCAChain;
+        }
+
+        prvUnlockSharedState();
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Drop a reference taken by prvAcquireDefaultCAChain().
+ */
+static void prvReleaseDefaultCAChain( void )
+{
+    /* The mutex exists, it was created when the reference was taken. */
+    ( void ) prvLockSharedState();
+
+    configASSERT( uxDefaultCAChainUsers > 0 );
+    uxDefaultCAChainUsers--;
+
+    #if ( tlsconfigKEEP_DEFAULT_ROOT_CERTIFICATES == 0 )
+        if( 0 == uxDefaultCAChainUsers )
+        {
+            mbedtls_x509_crt_free( &xDefaultCAChain );
+            xDefaultCAChainParsed = pdFALSE;
+        }
+    #endif
+
+    prvUnlockSharedState();
+}
+
+#if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+
+/**
+ * @brief Compute the session cache key of a context.
+ *
+ * A session may only be resumed with the server it was negotiated with, and
+ * only while the same certificate is trusted for it, because resumption skips
+ * the server certificate check.  The key therefore covers both.
+ *
+ * @param[in] pxCtx TLS context with a destination set.
+ *
+ * @return FNV-1a hash of the destination and the custom server certificate.
+ */
+    static uint32_t prvSessionCacheKey( TLSContext_t * pxCtx )
+    {
+        uint32_t ulHash = 2166136261UL;
+        const unsigned char * pucByte;
+        uint32_t ulIndex;
+
+        for( pucByte = ( const unsigned char * ) pxCtx->pcDestination; *pucByte != '\0'; pucByte++ )
+        {
+            ulHash = ( ulHash ^ *pucByte ) * 16777619UL;
+        }
+
+        if( NULL != pxCtx->pcServerCertificate )
+        {
+            pucByte = ( const unsigned char * ) pxCtx->pcServerCertificate;
+
+            for( ulIndex = 0; ulIndex < pxCtx->ulServerCertificateLength; ulIndex++ )
+            {
+                ulHash = ( ulHash ^ pucByte[ ulIndex ] ) * 16777619UL;
+            }
+        }
+
+        return ulHash;
+    }
+
+/**
+ * @brief Find the cache entry holding the session of a key.
+ *
+ * Must be called with the shared state locked.
+ *
+ * @param[in] ulKey Session cache key.
+ *
+ * @return The entry, or NULL if no session is cached for the key.
+ */
+    static TLSSessionCacheEntry_t * prvFindSession( uint32_t ulKey )
+    {
+        TLSSessionCacheEntry_t * pxEntry = NULL;
+        UBaseType_t uxIndex;
+
+        for( uxIndex = 0; uxIndex < tlsconfigSESSION_CACHE_SIZE; uxIndex++ )
+        {
+            if( ( pdTRUE == xSessionCache[ uxIndex ].xValid ) &&
+                ( ulKey == xSessionCache[ uxIndex ].ulKey ) )
+            {
+                pxEntry = &xSessionCache[ uxIndex ];
+                break;
+            }
+        }
+
+        return pxEntry;
+    }
+
+/**
+ * @brief Offer the cached session of a context to the server.
+ *
+ * The server decides whether to resume it.  If it does not, a full handshake
+ * is done as if no session had been offered.
+ *
+ * @param[in] pxCtx TLS context that has been set up but not connected.
+ */
+    static void prvLoadSession( TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry;
+
+        if( pdTRUE == prvLockSharedState() )
+        {
+            pxEntry = prvFindSession( pxCtx->ulSessionCacheKey );
+
+            /* mbedTLS copies the session, so the entry stays in the cache
+             * for other contexts. */
+            if( ( NULL != pxEntry ) &&
+                ( 0 == mbedtls_ssl_set_session( &pxCtx->xMbedSslCtx, &pxEntry->xSession ) ) )
+            {
+                pxEntry->xLastUsed = xTaskGetTickCount();
+            }
+
+            prvUnlockSharedState();
+        }
+    }
+
+/**
+ * @brief Save the session of a context after a successful handshake.
+ *
+ * Replaces the session cached for the same key, or else the least recently
+ * used one.
+ *
+ * @param[in] pxCtx TLS context that completed the handshake.
+ */
+    static void prvSaveSession( TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry;
+        UBaseType_t uxIndex;
+        TickType_t xNow = xTaskGetTickCount();
+
+        if( pdTRUE == prvLockSharedState() )
+        {
+            pxEntry = prvFindSession( pxCtx->ulSessionCacheKey );
+
+            if( NULL == pxEntry )
+            {
+                pxEntry = &xSessionCache[ 0 ];
+
+                for( uxIndex = 0; uxIndex < tlsconfigSESSION_CACHE_SIZE; uxIndex++ )
+                {
+                    if( pdFALSE == xSessionCache[ uxIndex ].xValid )
+                    {
+                        pxEntry = &xSessionCache[ uxIndex ];
+                        break;
+                    }
+
+                    if( ( xNow - xSessionCache[ uxIndex ].xLastUsed ) > ( xNow - pxEntry->xLastUsed ) )
+                    {
+                        pxEntry = &xSessionCache[ uxIndex ];
+                    }
+                }
+            }
+
+            if( pdTRUE == pxEntry->xValid )
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+                pxEntry->xValid = pdFALSE;
+            }
+
+            mbedtls_ssl_session_init( &pxEntry->xSession );
+
+            if( 0 == mbedtls_ssl_get_session( &pxCtx->xMbedSslCtx, &pxEntry->xSession ) )
+            {
+                pxEntry->ulKey = pxCtx->ulSessionCacheKey;
+                pxEntry->xLastUsed = xNow;
+                pxEntry->xValid = pdTRUE;
+            }
+            else
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+            }
+
+            prvUnlockSharedState();
+        }
+    }
+
+/**
+ * @brief Forget the cached session of a context.
+ *
+ * Used when a handshake fails, so that the next attempt does not offer a
+ * session the server may be rejecting.
+ *
+ * @param[in] pxCtx TLS context whose handshake failed.
+ */
+    static void prvDropSession( TLSContext_t * pxCtx )
+    {
+        TLSSessionCacheEntry_t * pxEntry;
+
+        if( pdTRUE == prvLockSharedState() )
+        {
+            pxEntry = prvFindSession( pxCtx->ulSessionCacheKey );
+
+            if( NULL != pxEntry )
+            {
+                mbedtls_ssl_session_free( &pxEntry->xSession );
+                pxEntry->xValid = pdFALSE;
+            }
+
+            prvUnlockSharedState();
+        }
+    }
+#endif /* if ( tlsconfigSESSION_CACHE_SIZE > 0 ) */
+
 /**
  * @brief Network send callback shim.
  *
@@ -320,60 +789,39 @@ static int prvPrivateKeySigningCallback( void * pvContext,
 }
 
 /**
- * @brief Helper for setting up potentially hardware-based cryptographic context
- * for the client TLS certificate and private key.
+ * @brief Read the device credentials from the PKCS#11 module.
  *
- * @param Caller context.
+ * Finds the private key and gets its type, then exports and parses the
+ * client certificate.
+ *
+ * @param[in] pxCtx TLS context with an open PKCS#11 session.
+ * @param[out] pxCredential Credentials to fill in, with an initialized
+ * certificate chain.
  *
  * @return Zero on success.
  */
-static int prvInitializeClientCredential( TLSContext_t * pxCtx )
+static BaseType_t prvReadClientCredential( TLSContext_t * pxCtx,
+                                           TLSClientCredential_t * pxCredential )
 {
     BaseType_t xResult = 0;
-    CK_SLOT_ID xSlotId = 0;
     CK_ULONG xCount = 1;
     CK_ATTRIBUTE xTemplate = { 0 };
     CK_OBJECT_HANDLE xCertObj = 0;
     CK_BYTE * pxCertificate = NULL;
-    mbedtls_pk_type_t xKeyAlgo = ( mbedtls_pk_type_t ) ~0;
     CK_KEY_TYPE xKeyType = ( CK_KEY_TYPE ) ~0;
 
-    /* Initialize the mbed contexts. */
-    mbedtls_x509_crt_init( &pxCtx->xMbedX509Cli );
-
-    /* Get the default private key storage ID. */
-    if( CKR_OK == xResult )
-    {
-        xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_GetSlotList( CK_TRUE,
-                                                                         &xSlotId,
-                                                                         &xCount );
-    }
-
-    /* Start a private session with the P#11 module. */
-    if( 0 == xResult )
-    {
-        xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_OpenSession( xSlotId,
-                                                                         CKF_SERIAL_SESSION,
-                                                                         NULL,
-                                                                         NULL,
-                                                                         &pxCtx->xP11Session );
-    }
-
     /* Get the handle of the device private key. */
-    if( 0 == xResult )
-    {
-        xTemplate.type = CKA_LABEL;
-        xTemplate.ulValueLen = sizeof( pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS );
-        xTemplate.pValue = &pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS;
-        xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_FindObjectsInit( pxCtx->xP11Session,
-                                                                             &xTemplate,
-                                                                             1 );
-    }
+    xTemplate.type = CKA_LABEL;
+    xTemplate.ulValueLen = sizeof( pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS );
+    xTemplate.pValue = &pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS;
+    xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_FindObjectsInit( pxCtx->xP11Session,
+                                                                         &xTemplate,
+                                                                         1 );
 
     if( 0 == xResult )
     {
         xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_FindObjects( pxCtx->xP11Session,
-                                                                         &pxCtx->xP11PrivateKey,
+                                                                         &pxCredential->xPrivateKey,
                                                                          1,
                                                                          &xCount );
     }
@@ -389,7 +837,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         xTemplate.pValue = &xKeyType;
         xTemplate.ulValueLen = sizeof( CK_KEY_TYPE );
         xResult = pxCtx->xP11FunctionList->C_GetAttributeValue( pxCtx->xP11Session,
-                                                                pxCtx->xP11PrivateKey,
+                                                                pxCredential->xPrivateKey,
                                                                 &xTemplate,
                                                                 1 );
     }
@@ -399,11 +847,11 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         switch( xKeyType )
         {
             case CKK_RSA:
-                xKeyAlgo = MBEDTLS_PK_RSA;
+                pxCredential->xKeyAlgo = MBEDTLS_PK_RSA;
                 break;
 
             case CKK_EC:
-                xKeyAlgo = MBEDTLS_PK_ECKEY;
+                pxCredential->xKeyAlgo = MBEDTLS_PK_ECKEY;
                 break;
 
             default:
@@ -412,15 +860,6 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         }
     }
 
-    if( xResult == CKR_OK )
-    {
-        memcpy( &pxCtx->xMbedPkInfo, mbedtls_pk_info_from_type( xKeyAlgo ), sizeof( mbedtls_pk_info_t ) );
-
-        pxCtx->xMbedPkInfo.sign_func = prvPrivateKeySigningCallback;
-        pxCtx->xMbedPkCtx.pk_info = &pxCtx->xMbedPkInfo;
-        pxCtx->xMbedPkCtx.pk_ctx = pxCtx;
-    }
-
     if( 0 == xResult )
     {
         /* Enumerate the first client certificate. */
@@ -481,7 +920,7 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
     /* Decode the client certificate. */
     if( 0 == xResult )
     {
-        xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509Cli,
+        xResult = mbedtls_x509_crt_parse( &pxCredential->xCertificateChain,
                                           ( const unsigned char * ) pxCertificate,
                                           xTemplate.ulValueLen );
     }
@@ -495,29 +934,239 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
         /* Decode the JITR issuer. The device client certificate will get
          * inserted as the first certificate in this chain below. */
         xResult = mbedtls_x509_crt_parse(
-            &pxCtx->xMbedX509Cli,
+            &pxCredential->xCertificateChain,
             ( const unsigned char * ) clientcredentialJITR_DEVICE_CERTIFICATE_AUTHORITY_PEM,
             1 + strlen( clientcredentialJITR_DEVICE_CERTIFICATE_AUTHORITY_PEM ) );
     }
 
+    if( NULL != pxCertificate )
+    {
+        vPortFree( pxCertificate );
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Free device credentials read by prvReadClientCredential().
+ *
+ * @param[in] pxCredential Credentials no handshake uses.
+ */
+static void prvFreeClientCredential( TLSClientCredential_t * pxCredential )
+{
+    mbedtls_x509_crt_free( &pxCredential->xCertificateChain );
+    vPortFree( pxCredential );
+}
+
+/**
+ * @brief Take a reference to the device credentials, reading them if needed.
+ *
+ * @param[in] pxCtx TLS context with an open PKCS#11 session.  Its
+ * pxClientCredential is set on success.
+ *
+ * @return Zero on success.
+ */
+static BaseType_t prvAcquireClientCredential( TLSContext_t * pxCtx )
+{
+    BaseType_t xResult = 0;
+    TLSClientCredential_t * pxCredential;
+
+    if( pdFALSE == prvLockSharedState() )
+    {
+        xResult = ( BaseType_t ) CKR_HOST_MEMORY;
+    }
+    else
+    {
+        if( NULL == pxCurrentClientCredential )
+        {
+            pxCredential = ( TLSClientCredential_t * ) pvPortMalloc( sizeof( TLSClientCredential_t ) ); /*lint !e9087 !e9079 Allow casting void* to other types. */
+
+            if( NULL == pxCredential )
+            {
+                xResult = ( BaseType_t ) CKR_HOST_MEMORY;
+            }
+            else
+            {
+                memset( pxCredential, 0, sizeof( TLSClientCredential_t ) );
+                mbedtls_x509_crt_init( &pxCredential->xCertificateChain );
+
+                xResult = prvReadClientCredential( pxCtx, pxCredential );
+
+                if( 0 == xResult )
+                {
+                    pxCurrentClientCredential = pxCredential;
+                }
+                else
+                {
+                    prvFreeClientCredential( pxCredential );
+                }
+            }
+        }
+
+        if( 0 == xResult )
+        {
+            pxCurrentClientCredential->uxUsers++;
+            pxCtx->pxClientCredential = pxCurrentClientCredential;
+        }
+
+        prvUnlockSharedState();
+    }
+
+    return xResult;
+}
+
+/**
+ * @brief Drop a reference taken by prvAcquireClientCredential().
+ *
+ * @param[in] pxCtx TLS context holding the reference.
+ * @param[in] xForget pdTRUE to read the credentials again on the next
+ * connection, e.g. because the handshake failed.
+ */
+static void prvReleaseClientCredential( TLSContext_t * pxCtx,
+                                        BaseType_t xForget )
+{
+    TLSClientCredential_t * pxCredential = pxCtx->pxClientCredential;
+
+    /* The mutex exists, it was created when the reference was taken. */
+    ( void ) prvLockSharedState();
+
+    configASSERT( pxCredential->uxUsers > 0 );
+    pxCredential->uxUsers--;
+
+    #if ( tlsconfigKEEP_CLIENT_CREDENTIAL == 0 )
+        xForget = pdTRUE;
+    #endif
+
+    if( ( pdTRUE == xForget ) && ( pxCredential == pxCurrentClientCredential ) )
+    {
+        pxCurrentClientCredential = NULL;
+    }
+
+    if( ( 0 == pxCredential->uxUsers ) && ( pxCredential != pxCurrentClientCredential ) )
+    {
+        prvFreeClientCredential( pxCredential );
+    }
+
+    prvUnlockSharedState();
+
+    pxCtx->pxClientCredential = NULL;
+}
+
+/**
+ * @brief Helper for setting up potentially hardware-based cryptographic context
+ * for the client TLS certificate and private key.
+ *
+ * @param Caller context.
+ *
+ * @return Zero on success.
+ */
+static int prvInitializeClientCredential( TLSContext_t * pxCtx )
+{
+    BaseType_t xResult = 0;
+    CK_SLOT_ID xSlotId = 0;
+    CK_ULONG xCount = 1;
+
+    /* Get the default private key storage ID. */
+    if( CKR_OK == xResult )
+    {
+        xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_GetSlotList( CK_TRUE,
+                                                                         &xSlotId,
+                                                                         &xCount );
+    }
+
+    /* Start a private session with the P#11 module. */
+    if( 0 == xResult )
+    {
+        xResult = ( BaseType_t ) pxCtx->xP11FunctionList->C_OpenSession( xSlotId,
+                                                                         CKF_SERIAL_SESSION,
+                                                                         NULL,
+                                                                         NULL,
+                                                                         &pxCtx->xP11Session );
+    }
+
+    /* The certificate and the key handle are only read from the module by
+     * the first connection. */
+    if( 0 == xResult )
+    {
+        xResult = prvAcquireClientCredential( pxCtx );
+    }
+
+    if( xResult == CKR_OK )
+    {
+        pxCtx->xP11PrivateKey = pxCtx->pxClientCredential->xPrivateKey;
+
+        memcpy( &pxCtx->xMbedPkInfo, mbedtls_pk_info_from_type( pxCtx->pxClientCredential->xKeyAlgo ), sizeof( mbedtls_pk_info_t ) );
+
+        pxCtx->xMbedPkInfo.sign_func = prvPrivateKeySigningCallback;
+        pxCtx->xMbedPkCtx.pk_info = &pxCtx->xMbedPkInfo;
+        pxCtx->xMbedPkCtx.pk_ctx = pxCtx;
+    }
+
     /*
      * Attach the client certificate and private key to the TLS configuration.
      */
     if( 0 == xResult )
     {
         xResult = mbedtls_ssl_conf_own_cert( &pxCtx->xMbedSslConfig,
-                                             &pxCtx->xMbedX509Cli,
+                                             &pxCtx->pxClientCredential->xCertificateChain,
                                              &pxCtx->xMbedPkCtx );
     }
 
-    if( NULL != pxCertificate )
+    if( CKR_OK != xResult )
     {
-        vPortFree( pxCertificate );
+        TLS_PRINT( ( "ERROR: Loading credentials from flash into TLS context failed with error %d.\r\n", xResult ) );
     }
 
-    if( CKR_OK != xResult )
+    return xResult;
+}
+
+/**
+ * @brief Ask the server for records no larger than the context allows.
+ *
+ * @param[in] pxCtx TLS context with the protocol defaults set.
+ *
+ * @return Zero on success, MBEDTLS_ERR_SSL_BAD_INPUT_DATA if the length is
+ * not one the extension can express or exceeds the record buffers.
+ */
+static int prvConfigureMaxFragmentLength( TLSContext_t * pxCtx )
+{
+    int xResult = 0;
+    unsigned char ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+
+    switch( pxCtx->ulMaxFragmentLength )
     {
-        TLS_PRINT( ( "ERROR: Loading credentials from flash into TLS context failed with error %d.\r\n", xResult ) );
+        case 0:
+            break;
+
+        case 512:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_512;
+            break;
+
+        case 1024:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+            break;
+
+        case 2048:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+            break;
+
+        case 4096:
+            ucCode = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+            break;
+
+        default:
+            xResult = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+            break;
+    }
+
+    if( ( 0 == xResult ) && ( MBEDTLS_SSL_MAX_FRAG_LEN_NONE != ucCode ) )
+    {
+        xResult = mbedtls_ssl_conf_max_frag_len( &pxCtx->xMbedSslConfig, ucCode );
+    }
+
+    if( 0 != xResult )
+    {
+        TLS_PRINT( ( "ERROR: Unsupported maximum fragment length %u.\r\n", ( unsigned ) pxCtx->ulMaxFragmentLength ) );
     }
 
     return xResult;
@@ -551,6 +1200,12 @@ BaseType_t TLS_Init( void ** ppvContext,
         pxCtx->xNetworkRecv = pxParams->pxNetworkRecv;
         pxCtx->xNetworkSend = pxParams->pxNetworkSend;
         pxCtx->pvCallerContext = pxParams->pvCallerContext;
+        pxCtx->ulMaxFragmentLength = pxParams->ulMaxFragmentLength;
+
+        if( 0 == pxCtx->ulMaxFragmentLength )
+        {
+            pxCtx->ulMaxFragmentLength = tlsconfigMAX_FRAGMENT_LENGTH;
+        }
 
         /* Get the function pointer list for the PKCS#11 module. */
         xCkGetFunctionList = C_GetFunctionList;
@@ -621,32 +1276,26 @@ BaseType_t TLS_Connect( void * pvContext )
         {
             TLS_PRINT( ( "ERROR: Failed to parse custom server certificates %d \r\n", xResult ) );
         }
+        else
+        {
+            pxCtx->pxMbedX509CAChain = &pxCtx->xMbedX509CA;
+        }
     }
     else
     {
-        xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                          ( const unsigned char * ) tlsVERISIGN_ROOT_CERTIFICATE_PEM,
-                                          tlsVERISIGN_ROOT_CERTIFICATE_LENGTH );
-
-        if( 0 == xResult )
-        {
-            xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                              ( const unsigned char * ) tlsATS1_ROOT_CERTIFICATE_PEM,
-                                              tlsATS1_ROOT_CERTIFICATE_LENGTH );
-
-            if( 0 == xResult )
-            {
-                xResult = mbedtls_x509_crt_parse( &pxCtx->xMbedX509CA,
-                                                  ( const unsigned char * ) tlsSTARFIELD_ROOT_CERTIFICATE_PEM,
-                                                  tlsSTARFIELD_ROOT_CERTIFICATE_LENGTH );
-            }
-        }
+        /* The default certificates are parsed once and shared by all
+         * contexts. */
+        xResult = prvAcquireDefaultCAChain( &pxCtx->pxMbedX509CAChain );
 
         if( 0 != xResult )
         {
             /* Default root certificates should be in aws_default_root_certificate.h */
             TLS_PRINT( ( "ERROR: Failed to parse default server certificates %d \r\n", xResult ) );
         }
+        else
+        {
+            pxCtx->xUsesDefaultCAChain = pdTRUE;
+        }
     }
 
     /* Start with protocol defaults. */
@@ -672,8 +1321,14 @@ BaseType_t TLS_Connect( void * pvContext )
         mbedtls_ssl_conf_rng( &pxCtx->xMbedSslConfig, &prvGenerateRandomBytes, pxCtx ); /*lint !e546 Nothing wrong here. */
 
         /* Set issuer certificate. */
-        mbedtls_ssl_conf_ca_chain( &pxCtx->xMbedSslConfig, &pxCtx->xMbedX509CA, NULL );
+        mbedtls_ssl_conf_ca_chain( &pxCtx->xMbedSslConfig, pxCtx->pxMbedX509CAChain, NULL );
+
+        /* Limit the size of the records the server sends, if requested. */
+        xResult = prvConfigureMaxFragmentLength( pxCtx );
+    }
 
+    if( 0 == xResult )
+    {
         /* Configure the SSL context for the device credentials. */
         xResult = prvInitializeClientCredential( pxCtx );
     }
@@ -707,6 +1362,15 @@ BaseType_t TLS_Connect( void * pvContext )
         xResult = mbedtls_ssl_set_hostname( &pxCtx->xMbedSslCtx, pxCtx->pcDestination );
     }
 
+    #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+        /* Offer the session of the last connection to this server. */
+        if( ( 0 == xResult ) && ( NULL != pxCtx->pcDestination ) )
+        {
+            pxCtx->ulSessionCacheKey = prvSessionCacheKey( pxCtx );
+            prvLoadSession( pxCtx );
+        }
+    #endif
+
     /* Set the socket callbacks. */
     if( 0 == xResult )
     {
@@ -726,6 +1390,14 @@ BaseType_t TLS_Connect( void * pvContext )
                  * ensure that upstream clean-up code doesn't accidentally use
                  * a context that failed the handshake. */
                 prvFreeContext( pxCtx );
+
+                #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+                    if( NULL != pxCtx->pcDestination )
+                    {
+                        prvDropSession( pxCtx );
+                    }
+                #endif
+
                 TLS_PRINT( ( "ERROR: Handshake failed with error code %d \r\n", xResult ) );
                 break;
             }
@@ -736,6 +1408,13 @@ BaseType_t TLS_Connect( void * pvContext )
     if( 0 == xResult )
     {
         pxCtx->xTLSHandshakeSuccessful = pdTRUE;
+
+        #if ( tlsconfigSESSION_CACHE_SIZE > 0 )
+            if( NULL != pxCtx->pcDestination )
+            {
+                prvSaveSession( pxCtx );
+            }
+        #endif
     }
     else if( xResult > 0 )
     {
@@ -746,7 +1425,21 @@ BaseType_t TLS_Connect( void * pvContext )
 
     /* Free up allocated memory. */
     mbedtls_x509_crt_free( &pxCtx->xMbedX509CA );
-    mbedtls_x509_crt_free( &pxCtx->xMbedX509Cli );
+
+    if( NULL != pxCtx->pxClientCredential )
+    {
+        /* After a failed handshake, read the credentials again next time in
+         * case they were the reason. */
+        prvReleaseClientCredential( pxCtx, ( 0 == xResult ) ? pdFALSE : pdTRUE );
+    }
+
+    if( pdTRUE == pxCtx->xUsesDefaultCAChain )
+    {
+        prvReleaseDefaultCAChain();
+        pxCtx->xUsesDefaultCAChain = pdFALSE;
+    }
+
+    pxCtx->pxMbedX509CAChain = NULL;
 
     return xResult;
 }
@@ -856,6 +1549,26 @@ BaseType_t TLS_Send( void * pvContext,
 
 /*-----------------------------------------------------------*/
 
+void TLS_ClearClientCredential( void )
+{
+    if( pdTRUE == prvLockSharedState() )
+    {
+        /* Credentials still used by a handshake are freed when it
+         * releases them. */
+        if( ( NULL != pxCurrentClientCredential ) &&
+            ( 0 == pxCurrentClientCredential->uxUsers ) )
+        {
+            prvFreeClientCredential( pxCurrentClientCredential );
+        }
+
+        pxCurrentClientCredential = NULL;
+
+        prvUnlockSharedState();
+    }
+}
+
+/*-----------------------------------------------------------*/
+
 void TLS_Cleanup( void * pvContext )
 {
     TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
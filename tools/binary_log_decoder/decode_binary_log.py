@@ -0,0 +1,396 @@
+#!/usr/bin/env python3
+"""
+Amazon FreeRTOS
+Copyright (C) 2017 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+http://aws.amazon.com/freertos
+http://www.FreeRTOS.org
+
+Decodes the binary log output of the logging task.
+
+With configLOGGING_OUTPUT_BINARY set to 1, the logging task outputs each
+message as the address of its format string and its raw arguments, see
+demos/common/logging/aws_logging_task_dynamic_buffers.c for the frame
+layout.  This script reads the format strings from the ELF file the firmware
+was built as, and prints the messages as the text output would have,
+except that they are not cut to configLOGGING_MAX_MESSAGE_LENGTH
+characters.  String arguments are still cut to the room the logging task
+had for them.
+
+Usage:
+    decode_binary_log.py <firmware.elf> [log file]
+
+The log is read from standard input if no file is given, so it can be fed
+from a serial port, for example:
+    stty -F /dev/ttyACM0 115200 raw
+    decode_binary_log.py aws_demos.elf /dev/ttyACM0
+
+Only the Python 3 standard library is needed.
+"""
+
+import re
+import struct
+import sys
+
+FRAME_STREAM = 0
+FRAME_TASK = 1
+FRAME_MESSAGE = 2
+FRAME_DROPPED = 3
+STREAM_VERSION = 1
+FLAG_NO_PREFIX = 0x01
+
+# Anchor symbol whose address is in the stream frame.
+ANCHOR_SYMBOL = 'xLoggingTaskInitialize'
+
+# Same grammar as prvParseSpecifier().
+SPECIFIER = re.compile(r'%([-+ #0]*)(\*|[0-9]*)(?:\.(\*|[0-9]*))?(hh|h|ll|l|z|j|t|L)?([%diouxXceEfFgGaApsn]?)')
+
+
+class ElfFile:
+    """The allocated sections and the symbols of an ELF file."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError('%s is not an ELF file' % path)
+
+        self.is64 = self.data[4] == 2
+        self.endian = '<' if self.data[5] == 1 else '>'
+
+        if self.is64:
+            shoff, = struct.unpack_from(self.endian + 'Q', self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x3A)
+            section = self.endian + 'IIQQQQIIQQ'
+        else:
+            shoff, = struct.unpack_from(self.endian + 'I', self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x2E)
+            section = self.endian + 'IIIIIIIIII'
+
+        self.sections = []
+
+        for i in range(shnum):
+            (name, sh_type, flags, addr, offset, size,
+             link, info, align, entsize) = struct.unpack_from(section, self.data, shoff + i * shentsize)
+            self.sections.append({'type': sh_type, 'flags': flags, 'addr': addr, 'offset': offset,
+                                  'size': size, 'link': link, 'entsize': entsize})
+
+    def symbol(self, wanted):
+        """Returns the value of a symbol from .symtab, or None."""
+        for s in self.sections:
+            # SHT_SYMTAB.
+            if s['type'] != 2:
+                continue
+
+            strtab = self.sections[s['link']]
+
+            for offset in range(s['offset'], s['offset'] + s['size'], s['entsize']):
+                if self.is64:
+                    name, info, other, shndx, value, size = struct.unpack_from(self.endian + 'IBBHQQ', self.data, offset)
+                else:
+                    name, value, size, info, other, shndx = struct.unpack_from(self.endian + 'IIIBBH', self.data, offset)
+
+                start = strtab['offset'] + name
+
+                if self.data[start:self.data.index(b'\0', start)].decode('ascii', 'replace') == wanted:
+                    # Clear the Thumb bit of ARM function symbols.
+                    return value & ~1 if (info & 0xF) == 2 else value
+
+        return None
+
+    def string(self, address):
+        """Returns the NULL terminated string at a link address, or None."""
+        for s in self.sections:
+            # SHF_ALLOC, and not SHT_NOBITS.
+            if (s['flags'] & 2) and s['type'] != 8 and s['addr'] <= address < s['addr'] + s['size']:
+                start = s['offset'] + address - s['addr']
+                end = self.data.find(b'\0', start, s['offset'] + s['size'])
+
+                if end < 0:
+                    return None
+
+                return self.data[start:end].decode('latin-1')
+
+        return None
+
+
+def cobs_decode(encoded):
+    """Returns the frame encoded by prvSendFrame(), or None if it is damaged."""
+    out = bytearray()
+    i = 0
+
+    while i < len(encoded):
+        code = encoded[i]
+
+        if code == 0 or i + code > len(encoded):
+            return None
+
+        out += encoded[i + 1:i + code]
+        i += code
+
+        if code != 0xFF and i < len(encoded):
+            out.append(0)
+
+    return bytes(out)
+
+
+def long_double(raw, size, endian):
+    """Converts a long double of the target to a float."""
+    if size == 8:
+        return struct.unpack(endian + 'd', raw)[0]
+
+    # x87 extended precision, padded to 12 or 16 bytes.
+    mantissa, exponent = struct.unpack(endian + 'QH', raw[:10])
+    sign = -1.0 if exponent & 0x8000 else 1.0
+    exponent &= 0x7FFF
+
+    if exponent == 0x7FFF:
+        return sign * (float('inf') if (mantissa << 1) & 0xFFFFFFFFFFFFFFFF == 0 else float('nan'))
+
+    try:
+        return sign * mantissa * 2.0 ** (max(exponent, 1) - 16383 - 63)
+    except OverflowError:
+        return sign * float('inf')
+
+
+class Decoder:
+    """Turns frames into text, keeping the state carried between frames."""
+
+    def __init__(self, elf, output):
+        self.elf = elf
+        self.output = output
+        self.stream = None
+        self.tasks = {}
+        self.message_number = 0
+        self.anchor = elf.symbol(ANCHOR_SYMBOL)
+
+        if self.anchor is None:
+            raise ValueError('%s is not in the ELF file, was it built with the binary logging task?' % ANCHOR_SYMBOL)
+
+    def frame(self, frame):
+        if len(frame) == 0:
+            return
+
+        kind = frame[0]
+
+        if kind == FRAME_STREAM:
+            self.stream_frame(frame)
+        elif self.stream is None:
+            # Nothing can be decoded before the first stream frame.
+            pass
+        elif kind == FRAME_TASK:
+            number, = struct.unpack_from(self.stream['endian'] + 'H', frame, 1)
+            self.tasks[number] = frame[3:].split(b'\0')[0].decode('latin-1')
+        elif kind == FRAME_MESSAGE:
+            self.message_frame(frame)
+        elif kind == FRAME_DROPPED:
+            count, = struct.unpack_from(self.stream['endian'] + 'I', frame, 1)
+            self.output.write('[Logging] %u messages dropped, the log buffer was full.\r\n' % count)
+
+    def stream_frame(self, frame):
+        if len(frame) < 13 or frame[1] != STREAM_VERSION or len(frame) < 17 + frame[10]:
+            self.stream = None
+            return
+
+        sizes = frame[2:11]
+        endian = '<' if frame[11:13] == b'\x02\x01' else '>'
+        pointer = sizes[8]
+        integer = {4: 'I', 8: 'Q'}[pointer]
+        address, self.message_number = struct.unpack_from(endian + integer + 'I', frame, 13)
+
+        self.stream = {
+            'endian': endian,
+            'int': sizes[0], 'long': sizes[1], 'longlong': sizes[2], 'size': sizes[3],
+            'intmax': sizes[4], 'ptrdiff': sizes[5], 'double': sizes[6], 'longdouble': sizes[7],
+            'pointer': pointer, 'pointer_format': integer,
+            'bias': address - self.anchor,
+        }
+
+    def message_frame(self, frame):
+        stream = self.stream
+        endian = stream['endian']
+        pointer = stream['pointer']
+        flags = frame[1]
+        task, tick = struct.unpack_from(endian + 'HI', frame, 2)
+        address, = struct.unpack_from(endian + stream['pointer_format'], frame, 8)
+        arguments = frame[8 + pointer:]
+
+        fmt = self.elf.string(address - stream['bias'])
+
+        if fmt is None:
+            text = '<unknown format string at 0x%x>\r\n' % address
+        else:
+            text = self.format(fmt, arguments)
+
+        if not (flags & FLAG_NO_PREFIX):
+            text = '%u %u [%s] %s' % (self.message_number, tick, self.tasks.get(task, '#%u' % task), text)
+
+        self.output.write(text)
+        self.message_number += 1
+
+    def integer(self, arguments, offset, size, signed):
+        raw = arguments[offset:offset + size]
+
+        if len(raw) < size:
+            raise IndexError
+
+        return int.from_bytes(raw, 'little' if self.stream['endian'] == '<' else 'big', signed=signed), offset + size
+
+    def format(self, fmt, arguments):
+        """Same walk as prvFormatRecord(), stopping where the arguments do."""
+        stream = self.stream
+        out = []
+        offset = 0
+        position = 0
+
+        try:
+            for match in SPECIFIER.finditer(fmt):
+                out.append(fmt[position:match.start()])
+                position = match.start()
+                flags, width, precision, length, conversion = match.groups()
+                length = length or ''
+
+                if conversion == '':
+                    # An unknown conversion ends the output.
+                    return ''.join(out)
+
+                if conversion == '%':
+                    out.append('%')
+                    position = match.end()
+                    continue
+
+                if width == '*':
+                    value, offset = self.integer(arguments, offset, stream['int'], True)
+                    width = str(value)
+
+                if precision == '*':
+                    value, offset = self.integer(arguments, offset, stream['int'], True)
+                    precision = str(value) if value >= 0 else None
+
+                spec = '%' + flags + width + ('.' + precision if precision is not None else '')
+
+                if conversion in 'diouxXc':
+                    size = {'ll': 'longlong', 'l': 'long', 'z': 'size', 'j': 'intmax', 't': 'ptrdiff'}.get(length, 'int')
+                    signed = conversion in 'dic'
+                    value, offset = self.integer(arguments, offset, stream[size], signed)
+
+                    if length in ('h', 'hh'):
+                        bits = 16 if length == 'h' else 8
+                        value &= (1 << bits) - 1
+
+                        if signed and value >= 1 << (bits - 1):
+                            value -= 1 << bits
+
+                    if conversion == 'c':
+                        out.append(('%' + ('-' if '-' in flags else '') + width + 's') % chr(value & 0xFF))
+                    elif conversion == 'o' and '#' in flags:
+                        # Python would prefix "0o" rather than "0".
+                        out.append((spec.replace('#', '') + 's') % ('0%o' % value if value else '0'))
+                    else:
+                        out.append((spec + ('d' if conversion in 'iu' else conversion)) % value)
+                elif conversion in 'eEfFgGaA':
+                    size = stream['longdouble'] if length == 'L' else stream['double']
+                    raw = arguments[offset:offset + size]
+
+                    if len(raw) < size:
+                        raise IndexError
+
+                    offset += size
+                    value = long_double(raw, size, stream['endian'])
+
+                    if conversion in 'aA':
+                        # C drops the trailing zeros of the mantissa.
+                        mantissa, exponent = value.hex().split('p')
+                        text = mantissa.rstrip('0').rstrip('.') + 'p' + exponent
+                        out.append(text.upper() if conversion == 'A' else text)
+                    else:
+                        out.append((spec + conversion) % value)
+                elif conversion == 'p':
+                    value, offset = self.integer(arguments, offset, stream['pointer'], False)
+                    out.append((spec + 's') % ('0x%x' % value if value else '(nil)'))
+                elif conversion == 's':
+                    end = arguments.find(b'\0', offset)
+
+                    if end < 0:
+                        raise IndexError
+
+                    out.append((spec + 's') % arguments[offset:end].decode('latin-1'))
+                    offset = end + 1
+
+                # 'n' has no stored argument and writes nothing.
+                position = match.end()
+
+            out.append(fmt[position:])
+        except IndexError:
+            # The arguments were truncated to fit the buffer, so the message
+            # is too, as on the target.
+            pass
+
+        return ''.join(out)
+
+
+def frames(stream):
+    """Yields the COBS decoded frames of a byte stream."""
+    pending = bytearray()
+
+    while True:
+        chunk = stream.read1(4096) if hasattr(stream, 'read1') else stream.read(4096)
+
+        if not chunk:
+            break
+
+        pending += chunk
+
+        while True:
+            end = pending.find(b'\0')
+
+            if end < 0:
+                break
+
+            frame = cobs_decode(bytes(pending[:end]))
+            del pending[:end + 1]
+
+            if frame is not None:
+                yield frame
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__[__doc__.index('Usage:'):])
+        return 2
+
+    decoder = Decoder(ElfFile(argv[1]), sys.stdout)
+
+    if len(argv) == 3:
+        log = open(argv[2], 'rb', buffering=0)
+    else:
+        log = sys.stdin.buffer
+
+    with log:
+        for frame in frames(log):
+            decoder.frame(frame)
+            sys.stdout.flush()
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))